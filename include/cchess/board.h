@@ -15,8 +15,8 @@ typedef enum
     Piece_Bishop = 2,
     Piece_Rook = 3,
     Piece_Queen = 4,
-    Piece_King = 5
-
+    Piece_King = 5,
+    Piece_None = 6,
 } Piece;
 
 #define PIECE_WHITE 0
@@ -33,25 +33,46 @@ typedef enum
     BoardState_WhiteToPlay = 0x20,
     BoardState_HasCheck = 0x40,
     BoardState_HasMate = 0x80,
+    BoardState_EnPassantFile = 0x700,
 } BoardState;
 
-typedef struct Board 
+#define BOARD_STATE_CASTLE_MASK 0xF
+#define BOARD_STATE_EN_PASSANT_FILE_SHIFT 8
+
+/*
+    The pieces are stored by type, both sides in the same bitboard, and by
+    side, all types in the same bitboard: the pieces of a type and side are
+    the intersection of both. The eight bitboards fill the first cache line,
+    the state, the counters, the key and the eval terms the second one.
+    Boards are copied on every move, aligning them keeps a copy on two lines.
+    Boards allocated on the heap need platform_alloc_aligned
+*/
+#define BOARD_ALIGNMENT 64
+
+typedef struct CCHESS_ALIGNED(BOARD_ALIGNMENT) Board
 {
-    uint64_t pawns[2];
-    uint64_t knights[2];
-    uint64_t bishops[2];
-    uint64_t rooks[2];
-    uint64_t queens[2];
-    uint64_t kings[2];
+    /* Indexed by Piece */
+    uint64_t pieces[6];
+    /* Indexed by side */
+    uint64_t sides[2];
+
+    /* Zobrist key of zobrist.h, kept up to date by board_make_move */
+    uint64_t key;
 
-    uint64_t whites;
-    uint64_t blacks;
+    /* BoardState flags */
+    uint16_t state;
 
-    uint64_t all;
+    uint16_t halfmove_clock;
+    uint16_t fullmove_number;
 
-    uint32_t state;
+    /* Midgame and endgame scores for white and game phase, kept up to date for eval.h */
+    int16_t psqt_mg;
+    int16_t psqt_eg;
+    int32_t phase;
 } Board;
 
+STATIC_ASSERT(sizeof(Board) == 128);
+
 #define SIDE_TO_PLAY_WHITE 0
 #define SIDE_TO_PLAY_BLACK 1
 
@@ -59,45 +80,43 @@ typedef struct Board
 
 #define BOARD_GET_SIDE_TO_PLAY(board) (!((board).state & BoardState_WhiteToPlay))
 #define BOARD_TOGGLE_SIDE_TO_PLAY(board) ((board).state ^= BoardState_WhiteToPlay)
-#define BOARD_SET_CHECK(board) ((board).state &= BoardState_HasCheck)
-#define BOARD_SET_MATE(board) ((board).state &= BoardState_HasMate)
+#define BOARD_SET_CHECK(board) ((board).state |= BoardState_HasCheck)
+#define BOARD_SET_MATE(board) ((board).state |= BoardState_HasMate)
 #define BOARD_HAS_CHECK(board) ((board).state & BoardState_HasCheck)
 #define BOARD_HAS_MATE(board) ((board).state & BoardState_HasMate)
 
 #define BOARD_PTR_GET_SIDE_TO_PLAY(board) (!(board->state & BoardState_WhiteToPlay))
 #define BOARD_PTR_TOGGLE_SIDE_TO_PLAY(board) (board->state ^= BoardState_WhiteToPlay)
-#define BOARD_PTR_SET_CHECK(board) (board->state &= BoardState_HasCheck)
-#define BOARD_PTR_SET_MATE(board) (board->state &= BoardState_HasMate)
+#define BOARD_PTR_SET_CHECK(board) (board->state |= BoardState_HasCheck)
+#define BOARD_PTR_SET_MATE(board) (board->state |= BoardState_HasMate)
 #define BOARD_PTR_HAS_CHECK(board) (board->state & BoardState_HasCheck)
 #define BOARD_PTR_HAS_MATE(board) (board->state & BoardState_HasMate)
 
-#define BOARD_GET_WHITE_PIECES(board) ((board).pawns[0] |   \
-                                       (board).knights[0] | \
-                                       (board).bishops[0] | \
-                                       (board).rooks[0] |   \
-                                       (board).queens[0] |  \
-                                       (board).kings[0])
-
-#define BOARD_PTR_GET_WHITE_PIECES(board) (board->pawns[0] |   \
-                                           board->knights[0] | \
-                                           board->bishops[0] | \
-                                           board->rooks[0] |   \
-                                           board->queens[0] |  \
-                                           board->kings[0])
-
-#define BOARD_GET_BLACK_PIECES(board) ((board).pawns[1] |   \
-                                       (board).knights[1] | \
-                                       (board).bishops[1] | \
-                                       (board).rooks[1] |   \
-                                       (board).queens[1] |  \
-                                       (board).kings[1])
-
-#define BOARD_PTR_GET_BLACK_PIECES(board) (board->pawns[1] |   \
-                                           board->knights[1] | \
-                                           board->bishops[1] | \
-                                           board->rooks[1] |   \
-                                           board->queens[1] |  \
-                                           board->kings[1])
+/* 
+    The en passant target square is stored as a file in the state, its rank 
+    is given by the side to play
+*/
+#define BOARD_HAS_EN_PASSANT(board) ((board).state & BoardState_EnPassantAvailable)
+#define BOARD_GET_EN_PASSANT_FILE(board) (((board).state & BoardState_EnPassantFile) >> BOARD_STATE_EN_PASSANT_FILE_SHIFT)
+#define BOARD_GET_EN_PASSANT_SQUARE(board) (BOARD_GET_EN_PASSANT_FILE(board) + (BOARD_GET_SIDE_TO_PLAY(board) == SIDE_TO_PLAY_WHITE ? 40 : 16))
+#define BOARD_SET_EN_PASSANT_FILE(board, file) ((board).state = (uint16_t)(((board).state & ~BoardState_EnPassantFile) | \
+                                                                            BoardState_EnPassantAvailable |                  \
+                                                                            ((uint32_t)(file) << BOARD_STATE_EN_PASSANT_FILE_SHIFT)))
+#define BOARD_CLEAR_EN_PASSANT(board) ((board).state &= ~(BoardState_EnPassantAvailable | BoardState_EnPassantFile))
+
+#define BOARD_PTR_HAS_EN_PASSANT(board) (board->state & BoardState_EnPassantAvailable)
+#define BOARD_PTR_GET_EN_PASSANT_FILE(board) ((board->state & BoardState_EnPassantFile) >> BOARD_STATE_EN_PASSANT_FILE_SHIFT)
+#define BOARD_PTR_GET_EN_PASSANT_SQUARE(board) (BOARD_PTR_GET_EN_PASSANT_FILE(board) + (BOARD_PTR_GET_SIDE_TO_PLAY(board) == SIDE_TO_PLAY_WHITE ? 40 : 16))
+#define BOARD_PTR_SET_EN_PASSANT_FILE(board, file) (board->state = (uint16_t)((board->state & ~BoardState_EnPassantFile) | \
+                                                                               BoardState_EnPassantAvailable |             \
+                                                                               ((uint32_t)(file) << BOARD_STATE_EN_PASSANT_FILE_SHIFT)))
+#define BOARD_PTR_CLEAR_EN_PASSANT(board) (board->state &= ~(BoardState_EnPassantAvailable | BoardState_EnPassantFile))
+
+#define BOARD_GET_WHITE_PIECES(board) ((board).sides[PIECE_WHITE])
+#define BOARD_PTR_GET_WHITE_PIECES(board) (board->sides[PIECE_WHITE])
+
+#define BOARD_GET_BLACK_PIECES(board) ((board).sides[PIECE_BLACK])
+#define BOARD_PTR_GET_BLACK_PIECES(board) (board->sides[PIECE_BLACK])
 
 typedef enum
 {
@@ -113,96 +132,190 @@ CCHESS_API Board board_init();
 
 CCHESS_API Board board_from_fen(const char* fen);
 
-CCHESS_FORCE_INLINE uint64_t board_get_pawns(Board* board, const uint64_t side)
+/* 
+    Parses a FEN string into board and returns the number of characters consumed,
+    or 0 if the string is not a valid position. The move counters are optional 
+    so the first four fields of an EPD record can be parsed too
+*/
+CCHESS_API size_t board_parse_fen(Board* board, const char* fen);
+
+/* Enough for the longest possible FEN, including the null terminator */
+#define BOARD_FEN_MAX_SIZE 96
+
+/* 
+    Writes the FEN of board in fen, that must be at least BOARD_FEN_MAX_SIZE
+    bytes long. Returns the length of the string, without the null terminator
+*/
+CCHESS_API size_t board_to_fen(Board* board, char* fen);
+
+/* Pieces of a type and side */
+CCHESS_FORCE_INLINE uint64_t board_get_pieces(const Board* board, const uint32_t piece, const uint32_t side)
+{
+    return board->pieces[piece] & board->sides[side];
+}
+
+CCHESS_FORCE_INLINE uint64_t board_get_pawns(const Board* board, const uint64_t side)
+{
+    return board->pieces[Piece_Pawn] & board->sides[side];
+}
+
+CCHESS_FORCE_INLINE uint64_t board_num_pawns(const Board* board, const uint64_t side)
+{
+    return popcount_u64(board_get_pawns(board, side));
+}
+
+CCHESS_FORCE_INLINE uint64_t board_get_knights(const Board* board, const uint64_t side)
 {
-    return board->pawns[side];
+    return board->pieces[Piece_Knight] & board->sides[side];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_num_pawns(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_num_knights(const Board* board, const uint64_t side)
 {
-    return popcount_u64(board->pawns[side]);
+    return popcount_u64(board_get_knights(board, side));
 }
 
-CCHESS_FORCE_INLINE uint64_t board_get_knights(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_get_bishops(const Board* board, const uint64_t side)
 {
-    return board->knights[side];
+    return board->pieces[Piece_Bishop] & board->sides[side];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_num_knights(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_num_bishops(const Board* board, const uint64_t side)
 {
-    return popcount_u64(board->knights[side]);
+    return popcount_u64(board_get_bishops(board, side));
 }
 
-CCHESS_FORCE_INLINE uint64_t board_get_bishops(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_get_rooks(const Board* board, const uint64_t side)
 {
-    return board->bishops[side];
+    return board->pieces[Piece_Rook] & board->sides[side];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_num_bishops(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_num_rooks(const Board* board, const uint64_t side)
 {
-    return popcount_u64(board->bishops[side]);
+    return popcount_u64(board_get_rooks(board, side));
 }
 
-CCHESS_FORCE_INLINE uint64_t board_get_rooks(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_get_queens(const Board* board, const uint64_t side)
 {
-    return board->rooks[side];
+    return board->pieces[Piece_Queen] & board->sides[side];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_num_rooks(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_num_queens(const Board* board, const uint64_t side)
 {
-    return popcount_u64(board->rooks[side]);
+    return popcount_u64(board_get_queens(board, side));
 }
 
-CCHESS_FORCE_INLINE uint64_t board_get_queens(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_get_king(const Board* board, const uint64_t side)
 {
-    return board->queens[side];
+    return board->pieces[Piece_King] & board->sides[side];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_num_queens(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_get_white(const Board* board)
 {
-    return popcount_u64(board->queens[side]);
+    return board->sides[PIECE_WHITE];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_get_king(Board* board, const uint64_t side)
+CCHESS_FORCE_INLINE uint64_t board_get_black(const Board* board)
 {
-    return board->kings[side];
+    return board->sides[PIECE_BLACK];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_get_white(Board* board)
+CCHESS_FORCE_INLINE uint64_t board_get_all(const Board* board)
 {
-    return board->whites;
+    return board->sides[PIECE_WHITE] | board->sides[PIECE_BLACK];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_get_black(Board* board)
+CCHESS_FORCE_INLINE uint64_t board_get_side(const Board* board, const uint32_t side)
 {
-    return board->blacks;
+    return board->sides[side];
 }
 
-CCHESS_FORCE_INLINE uint64_t board_get_all(Board* board)
+/* Returns the type of the piece of side standing on square, or Piece_None */
+CCHESS_FORCE_INLINE uint32_t board_get_piece_on(const Board* board, const uint32_t square, const uint32_t side)
 {
-    return board->all;
+    if(((board->sides[side] >> square) & 1) == 0)
+    {
+        return Piece_None;
+    }
+
+    uint32_t piece = 0;
+
+    for(uint32_t i = 1; i < 6; i++)
+    {
+        piece |= (uint32_t)((board->pieces[i] >> square) & 1) * i;
+    }
+
+    return piece;
 }
 
-CCHESS_FORCE_INLINE bool board_has_piece(Board* board,
+CCHESS_FORCE_INLINE bool board_has_piece(const Board* board,
                                          const uint32_t piece,
                                          const uint32_t square,
                                          const uint32_t side)
 {
-    const uint64_t piece_mask = 1ULL << square;
+    return (board_get_pieces(board, piece, side) >> square) & 1;
+}
 
-    uint64_t* board_as_ptr = (uint64_t*)board;
+/*
+    Adds or removes a piece, for the code setting up boards. The eval terms
+    and the key are computed once all the pieces are set with
+    board_init_derived
+*/
+CCHESS_FORCE_INLINE void board_put_piece(Board* board, const uint32_t piece, const uint32_t side, const uint32_t square)
+{
+    board->pieces[piece] |= BIT64(square);
+    board->sides[side] |= BIT64(square);
+}
 
-    return board_as_ptr[piece * 2UL + side] & piece_mask;
+CCHESS_FORCE_INLINE void board_remove_piece(Board* board, const uint32_t piece, const uint32_t side, const uint32_t square)
+{
+    board->pieces[piece] &= ~BIT64(square);
+    board->sides[side] &= ~BIT64(square);
 }
 
+/* Computes the eval terms and the key of a board set up piece by piece */
+CCHESS_API void board_init_derived(Board* board);
+
 CCHESS_API void board_get_moves(Board* board, Move* moves, size_t* moves_count);
 
+/*
+    Generates the legal moves of the side to play, castling, en passant and
+    the four promotions included. moves must hold BOARD_MAX_MOVES moves
+*/
+CCHESS_API void board_get_legal_moves(Board* board, Move* moves, size_t* moves_count);
+
+/*
+    Same as board_get_legal_moves restricted to captures, en passant and
+    promotions, the moves searched by a quiescence search
+*/
+CCHESS_API void board_get_legal_noisy_moves(Board* board, Move* moves, size_t* moves_count);
+
+/*
+    Same as board_get_legal_moves restricted to the moves checking the enemy
+    king, directly or by discovery, the moves of the attacker of a mate
+    search
+*/
+CCHESS_API void board_get_legal_checks(Board* board, Move* moves, size_t* moves_count);
+
+/*
+    Full legality check of a move for the side to play, including castling
+    through attacked squares and leaving the king in check
+*/
 CCHESS_API bool board_move_is_legal(Board* board, const Move move);
 
+/* Same as board_move_is_legal for a move in standard algebraic notation (Nf3, exd8=Q, O-O) */
 CCHESS_API bool board_move_is_legal_algebraic(Board* board, const char* move);
 
+/*
+    Plays a move without checking its legality. Castling is a king move of
+    two squares, en passant a pawn capture on the en passant square, and a
+    promotion a pawn move whose piece is the promoted piece
+*/
 CCHESS_API uint32_t board_make_move(Board* board, const Move move);
 
+/* Passes, for the null move pruning of the search. The side to play must not be in check */
+CCHESS_API void board_make_null_move(Board* board);
+
+/* Plays a move in standard algebraic notation, returns false and leaves the board untouched if it is not legal */
 CCHESS_API bool board_make_move_algebraic(Board* board, const char* move);
 
 CCHESS_API bool board_has_check_from_last_move(Board* board, const Move last_move);
@@ -213,6 +326,35 @@ CCHESS_API bool board_has_mate_from_last_move(Board* board, const Move last_move
 
 CCHESS_API bool board_has_mate(Board* board);
 
+CCHESS_API bool board_has_stalemate(Board* board);
+
+/* 
+    Returns true as soon as one legal move is found for the side to play, 
+    without generating the whole move list
+*/
+CCHESS_API bool board_has_legal_move(Board* board);
+
+/* Pieces of the given side attacking square, sliders are blocked by occupancy */
+CCHESS_API uint64_t board_attackers_to(Board* board,
+                                       const uint32_t square,
+                                       const uint32_t side,
+                                       const uint64_t occupancy);
+
+/* Pieces giving check to the king of the side to play */
+CCHESS_API uint64_t board_get_checkers(Board* board);
+
+/* Pieces of the given side that are pinned to their own king */
+CCHESS_API uint64_t board_get_pinned(Board* board, const uint32_t side);
+
+/*
+    Static exchange evaluation of a move of the side to play, in centipawns:
+    the material won once both sides captured on the destination square
+    with their least valuable piece, each side being free to stop. Sliders
+    behind the attackers join the exchange as the pieces in front of them
+    leave. Pins and checks are ignored
+*/
+CCHESS_API int32_t board_see(Board* board, const Move move);
+
 typedef enum
 {
     BoardMoveIteratorFlag_PieceWhite = 0x1,
@@ -232,6 +374,7 @@ CCHESS_API BoardMoveIterator board_move_iterator_init();
 
 CCHESS_API bool board_legal_moves_iterator(Board* board, Move* move, BoardMoveIterator* it);
 
+/* Number of leaf nodes of the legal move tree of the given depth */
 CCHESS_API uint64_t board_perft(Board* board, uint32_t num_plies);
 
 CCHESS_API void board_debug(Board* board);
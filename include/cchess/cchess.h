@@ -106,13 +106,13 @@
 #define CONCAT(prefix, suffix)      CONCAT_(prefix, suffix)
 
 #define CCHESS_ASSERT(expr) assert(expr)
-#define STATIC_ASSERT(expr)                             \
-    struct CONCAT(__outscope_assert_, __COUNTER__)      \
-    {                                                   \
-        char                                            \
-        outscope_assert                                 \
-        [2*(expr)-1];                                   \
-                                                        \
+#define STATIC_ASSERT(expr)                                 \
+    typedef struct CONCAT(__outscope_assert_, __COUNTER__)  \
+    {                                                       \
+        char                                                \
+        outscope_assert                                     \
+        [2*(expr)-1];                                       \
+                                                            \
     } CONCAT(__outscope_assert_, __COUNTER__)
 
 #define CCHESS_NOT_IMPLEMENTED "Function "CCHESS_FUNCTION" not implemented" 
@@ -125,6 +125,12 @@
 #define CCHESS_PACKED_STRUCT(__struct__) __struct__
 #endif /* defined(CCHESS_MSVC) */
 
+#if defined(CCHESS_MSVC)
+#define CCHESS_ALIGNED(alignment) __declspec(align(alignment))
+#else
+#define CCHESS_ALIGNED(alignment) __attribute__((aligned(alignment)))
+#endif /* defined(CCHESS_MSVC) */
+
 #if defined(CCHESS_MSVC)
 #define dump_struct(s) 
 #elif defined(CCHESS_CLANG)
@@ -0,0 +1,82 @@
+#pragma once
+
+#if !defined(__DFPN)
+#define __DFPN
+
+#include "cchess/board.h"
+
+/*
+    Mate solver by depth-first proof-number search (df-pn). The side to play
+    is the attacker, a node where it plays is an OR node, proven when one of
+    its moves is, and a node where the defender plays an AND node, proven
+    when all its moves are. Each node has a proof number, the minimum number
+    of leaves to prove to prove it, and a disproof number, the minimum to
+    disprove it. The search always expands the most proving node, walking
+    down to it by depth-first iterations bounded by thresholds on both
+    numbers, instead of keeping the tree in memory: the numbers of the
+    children are read from the transposition table.
+
+    The attacker plays only checks, or any legal move without checks_only,
+    and the defender every evasion. A mate in N is searched by bounding the
+    attacker to N moves, the entries of the table keeping the number of
+    moves left with the numbers: a proof holds for more moves and a
+    disproof for less.
+
+    Repetitions and the fifty moves rule are ignored, a mate being found
+    through them is still a mate
+*/
+
+/* Longest mate searched, in moves of the attacker */
+#define DFPN_MAX_MOVES 64
+#define DFPN_MAX_PV (2 * DFPN_MAX_MOVES)
+
+/* Proof or disproof number of a node proven or disproven */
+#define DFPN_INFINITE 0x7FFFFFFFU
+
+/* Size of the table allocated when none is given */
+#define DFPN_DEFAULT_TT_SIZE_MB 16
+
+typedef enum
+{
+    DfpnResult_Unknown,
+    /* The attacker mates within the given number of moves */
+    DfpnResult_Proven,
+    /* It does not, or not with checks only */
+    DfpnResult_Disproven,
+} DfpnResult;
+
+typedef struct
+{
+    /* Mate in at most this number of moves, up to DFPN_MAX_MOVES */
+    uint32_t max_moves;
+    /* Node budget, 0 for no limit. The result is unknown once spent */
+    uint64_t max_nodes;
+    /* The attacker only plays checks */
+    bool checks_only;
+    /* 0 for DFPN_DEFAULT_TT_SIZE_MB */
+    size_t tt_size_mb;
+} DfpnLimits;
+
+typedef struct
+{
+    DfpnResult result;
+    /* The mate found, the defender resisting the longest within the proof tree */
+    uint32_t pv_length;
+    Move pv[DFPN_MAX_PV];
+    /* Nodes expanded */
+    uint64_t nodes;
+    /* Nodes of the proof tree of a proven position, a transposed subtree counting once per path */
+    uint64_t proof_tree_size;
+    uint64_t elapsed_ns;
+} DfpnInfo;
+
+/* Mate in 5 by checks, no node budget */
+CCHESS_API void dfpn_limits_init(DfpnLimits* limits);
+
+/*
+    Proves or disproves a mate for the side to play. Returns false if the
+    table or the move stack could not be allocated
+*/
+CCHESS_API bool dfpn_solve(Board* board, const DfpnLimits* limits, DfpnInfo* info);
+
+#endif /* !defined(__DFPN) */
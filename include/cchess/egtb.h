@@ -0,0 +1,132 @@
+#pragma once
+
+#if !defined(__EGTB)
+#define __EGTB
+
+#include "cchess/board.h"
+#include "cchess/platform.h"
+
+/*
+    Endgame tables generator and prober, for the 3 to 5 pieces endgames.
+
+    A table holds the win/draw/loss value of every position of one material
+    (e.g. "KRPvKR", white pieces first), for the side to play, 2 bits per
+    position. Positions are indexed by the squares of their pieces, the white
+    king being mirrored to the a1-d1-d4 triangle (a-d files when there are
+    pawns), so the index space is 2 * 10 * 64^(n - 1) positions (2 * 32 *
+    64^(n - 1) with pawns). Identical pieces are sorted by square and indices
+    that are not the canonical index of their position are left unused.
+
+    Generation is a retrograde analysis: mates and the positions decided by a
+    capture or a promotion into the smaller tables (generated first, in
+    memory) are resolved, then every pass walks back the moves leading to the
+    positions resolved by the previous one with an unmove generator. A
+    predecessor of a loss is a win, a predecessor of a win is a loss once all
+    its moves are verified to lose. The passes run over all the cores, the
+    values being updated with atomic operations on the packed arrays, and
+    stop when no position was resolved: the remaining ones are draws.
+
+    Tables are written in blocks of EGTB_BLOCK_SIZE positions, each one run
+    length encoded: unused positions take the value of the run they fall in,
+    so that they never break a run, and a block holding a single value is
+    one byte. Blocks whose runs would not be smaller than their packed
+    values are stored packed, so no table is larger than its packed values
+    and the 32 bits block offsets. The file is memory mapped when opened and
+    probed in place, a probe decoding the runs of its block.
+
+    Castling rights are not part of the tables. En passant captures are not
+    indexed: the generator searches them, the prober fails on the positions
+    where one is available as it leaves the table
+*/
+
+#define EGTB_MAX_PIECES 5
+
+/* Positions per block, small as a probe decodes the runs of its block from its start */
+#define EGTB_BLOCK_SIZE 512
+
+#define EGTB_MAGIC 0x42544745
+#define EGTB_VERSION 2
+
+typedef enum
+{
+    EgtbWdl_Loss = -1,
+    EgtbWdl_Draw = 0,
+    EgtbWdl_Win = 1,
+} EgtbWdl;
+
+/* Material of a table, the pieces are stored as piece | side << 3 */
+typedef struct
+{
+    uint64_t key;
+    /* Key of the material with the colors swapped */
+    uint64_t key2;
+    uint64_t num_positions;
+    uint32_t num_pieces;
+    bool has_pawns;
+    /* White king, black king, white pieces and black pieces, queens first */
+    uint8_t pieces[EGTB_MAX_PIECES];
+} EgtbMaterial;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_pieces;
+    uint8_t pieces[8];
+    uint32_t block_size;
+    uint64_t num_positions;
+    uint64_t num_blocks;
+    uint64_t reserved[3];
+} EgtbHeader;
+
+typedef struct
+{
+    FileMapping mapping;
+    EgtbMaterial material;
+    const EgtbHeader* header;
+    /* num_blocks + 1 offsets into data */
+    const uint32_t* offsets;
+    const uint8_t* data;
+} Egtb;
+
+typedef struct
+{
+    /* Size of the index space */
+    uint64_t num_positions;
+    uint64_t num_legal;
+    /* Values for the side to play */
+    uint64_t num_wins;
+    uint64_t num_draws;
+    uint64_t num_losses;
+    /* Retrograde passes, the longest win being about as many plies */
+    uint32_t num_passes;
+    /* Tables generated, the smaller ones included */
+    uint32_t num_tables;
+    uint64_t file_size;
+    uint64_t elapsed_ns;
+} EgtbGenStats;
+
+/* Parses a material name such as "KQvK", returns false if it is invalid or too large */
+CCHESS_API bool egtb_parse_material(EgtbMaterial* material, const char* name);
+
+/*
+    Generates the table of the given material and writes it to path, the
+    tables it captures or promotes into are generated too but not written.
+    stats can be NULL. Returns false if the material is invalid or the file
+    can't be written
+*/
+CCHESS_API bool egtb_generate(const char* material, const char* path, EgtbGenStats* stats);
+
+CCHESS_API bool egtb_open(Egtb* egtb, const char* path);
+
+CCHESS_API void egtb_close(Egtb* egtb);
+
+/*
+    Win/draw/loss value of the position for the side to play, the table
+    material being found in the position with either colors. Returns false if
+    the material differs, the position is not legal, castling rights are set
+    or an en passant capture is available. Thread-safe
+*/
+CCHESS_API bool egtb_probe_wdl(const Egtb* egtb, Board* board, EgtbWdl* wdl);
+
+#endif /* !defined(__EGTB) */
@@ -0,0 +1,74 @@
+#pragma once
+
+#if !defined(__EPD)
+#define __EPD
+
+#include "cchess/board.h"
+
+/*
+    EPD/FEN batch loading. Files are memory mapped and split in chunks of
+    whole lines that are parsed in parallel (when built with OpenMP), without
+    any allocation per line. Each non-empty line holds a FEN (with or without
+    move counters) optionally followed by EPD operations such as
+    bm Nf3; id "test 1"; D1 20; D2 400;
+*/
+
+#define EPD_MAX_PERFT_DEPTH 16
+
+typedef struct
+{
+    Board board;
+
+    /* Operands of bm/am and id, pointing into the parsed text (not null terminated) */
+    const char* best_moves;
+    const char* avoid_moves;
+    const char* id;
+
+    uint32_t best_moves_length;
+    uint32_t avoid_moves_length;
+    uint32_t id_length;
+
+    /* perft[d - 1] holds the node count of the Dd operation */
+    uint32_t perft_depth;
+    uint64_t perft[EPD_MAX_PERFT_DEPTH];
+} EpdRecord;
+
+typedef struct
+{
+    size_t num_records;
+    size_t num_errors;
+    size_t num_bytes;
+    uint64_t elapsed_ns;
+    double records_per_second;
+    double megabytes_per_second;
+} EpdLoadStats;
+
+/*
+    Called once per parsed record, with the index of the record in the file
+    (empty lines and comments are not counted). Calls happen concurrently
+    from several threads
+*/
+typedef void (*epd_record_func)(const EpdRecord* record, size_t record_index, void* user_data);
+
+/* Parses a single line, that does not need to be null terminated */
+CCHESS_API bool epd_parse_line(EpdRecord* record, const char* line, const size_t length);
+
+/*
+    Parses every record of the file at path into boards, in file order.
+    num_boards receives the number of records in the file, records beyond
+    max_boards are not written. Lines that fail to parse give a zeroed board
+    and are counted in the stats errors. stats can be NULL
+*/
+CCHESS_API bool epd_load_boards(const char* path,
+                                Board* boards,
+                                const size_t max_boards,
+                                size_t* num_boards,
+                                EpdLoadStats* stats);
+
+/* Parses every record of the file at path and passes it to func. stats can be NULL */
+CCHESS_API bool epd_load(const char* path,
+                         epd_record_func func,
+                         void* user_data,
+                         EpdLoadStats* stats);
+
+#endif /* !defined(__EPD) */
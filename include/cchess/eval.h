@@ -0,0 +1,85 @@
+#pragma once
+
+#if !defined(__EVAL)
+#define __EVAL
+
+#include "cchess/board.h"
+
+/*
+    Tapered material and piece-square evaluation. The midgame and endgame
+    scores are sums over the pieces of their value on their square, and are
+    blended by the game phase, from EVAL_PHASE_MAX with all the pieces on
+    the board down to 0 with only kings and pawns.
+
+    The scores and the phase are kept in the board, for white, and updated
+    by board_make_move with the few pieces a move adds and removes, so
+    evaluating a position does not loop over its pieces. Boards built by
+    hand from bitboards need eval_init_board, called by board_init_derived
+*/
+
+#define EVAL_PHASE_MAX 24
+
+CCHESS_API extern const int16_t eval_piece_values_mg[6];
+CCHESS_API extern const int16_t eval_piece_values_eg[6];
+
+CCHESS_API extern const int32_t eval_phase_weights[6];
+
+/* From the point of view of white, rank 8 first */
+CCHESS_API extern const int16_t eval_psqt_mg[6][64];
+CCHESS_API extern const int16_t eval_psqt_eg[6][64];
+
+/* Value of a piece on a square, including its material, negative for black */
+CCHESS_FORCE_INLINE int32_t eval_get_psqt_mg(const uint32_t piece, const uint32_t side, const uint32_t square)
+{
+    return side == PIECE_WHITE ? eval_piece_values_mg[piece] + eval_psqt_mg[piece][square ^ 56] :
+                                 -(eval_piece_values_mg[piece] + eval_psqt_mg[piece][square]);
+}
+
+CCHESS_FORCE_INLINE int32_t eval_get_psqt_eg(const uint32_t piece, const uint32_t side, const uint32_t square)
+{
+    return side == PIECE_WHITE ? eval_piece_values_eg[piece] + eval_psqt_eg[piece][square ^ 56] :
+                                 -(eval_piece_values_eg[piece] + eval_psqt_eg[piece][square]);
+}
+
+/* Incremental updates, called by board_make_move */
+
+CCHESS_FORCE_INLINE void eval_add_piece(Board* board, const uint32_t piece, const uint32_t side, const uint32_t square)
+{
+    board->psqt_mg += (int16_t)eval_get_psqt_mg(piece, side, square);
+    board->psqt_eg += (int16_t)eval_get_psqt_eg(piece, side, square);
+    board->phase += eval_phase_weights[piece];
+}
+
+CCHESS_FORCE_INLINE void eval_remove_piece(Board* board, const uint32_t piece, const uint32_t side, const uint32_t square)
+{
+    board->psqt_mg -= (int16_t)eval_get_psqt_mg(piece, side, square);
+    board->psqt_eg -= (int16_t)eval_get_psqt_eg(piece, side, square);
+    board->phase -= eval_phase_weights[piece];
+}
+
+CCHESS_FORCE_INLINE void eval_move_piece(Board* board, const uint32_t piece, const uint32_t side, const uint32_t from, const uint32_t to)
+{
+    board->psqt_mg += (int16_t)(eval_get_psqt_mg(piece, side, to) - eval_get_psqt_mg(piece, side, from));
+    board->psqt_eg += (int16_t)(eval_get_psqt_eg(piece, side, to) - eval_get_psqt_eg(piece, side, from));
+}
+
+/* Score of the position for the side to play */
+CCHESS_FORCE_INLINE int32_t eval_evaluate(const Board* board)
+{
+    /* Promotions can raise the phase above its maximum */
+    const int32_t phase = board->phase < EVAL_PHASE_MAX ? board->phase : EVAL_PHASE_MAX;
+    const int32_t score = (board->psqt_mg * phase + board->psqt_eg * (EVAL_PHASE_MAX - phase)) / EVAL_PHASE_MAX;
+
+    return BOARD_PTR_GET_SIDE_TO_PLAY(board) == PIECE_WHITE ? score : -score;
+}
+
+/* Full computation of the scores and phase from the bitboards */
+CCHESS_API void eval_compute(const Board* board, int16_t* psqt_mg, int16_t* psqt_eg, int32_t* phase);
+
+/* Sets the incremental scores of a board built from its bitboards */
+CCHESS_API void eval_init_board(Board* board);
+
+/* Debug check of the incremental scores against a full computation */
+CCHESS_API bool eval_board_is_valid(const Board* board);
+
+#endif /* !defined(__EVAL) */
@@ -0,0 +1,133 @@
+#pragma once
+
+#if !defined(__GAME_DB)
+#define __GAME_DB
+
+#include "cchess/platform.h"
+#include "cchess/pgn.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    On-disk game database, made of two files sharing a path prefix
+
+    <path>.games  append-only sequence of games, each one a small header, the
+                  packed starting position if it is not the initial one, and
+                  the moves as 16 bits Move values
+    <path>.index  game offsets in the games file, followed by the sorted
+                  position keys of every position reached in every game and
+                  the matching game ids. A fence array holding the first key
+                  of every page of keys is searched first, so a lookup
+                  touches two pages of the mapping and the database is never
+                  loaded in memory
+
+    Game ids are the index of the game in insertion order
+*/
+
+#define GAME_DB_MAX_PATH_SIZE 1024
+
+/* Number of keys per fence, 4096 bytes of keys */
+#define GAME_DB_KEYS_PER_FENCE 512
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t num_games;
+    uint64_t num_entries;
+    uint64_t num_fences;
+    uint64_t reserved[4];
+} GameDbIndexHeader;
+
+typedef struct
+{
+    FileMapping games_mapping;
+    FileMapping index_mapping;
+
+    const GameDbIndexHeader* header;
+    const uint64_t* offsets;
+    const uint64_t* fences;
+    const uint64_t* keys;
+    const uint32_t* game_ids;
+} GameDb;
+
+typedef struct
+{
+    Board board;
+    PgnResult result;
+    uint32_t num_moves;
+
+    /* Points into the mapping, read with game_db_game_get_move */
+    const uint8_t* moves;
+} GameDbGame;
+
+typedef struct
+{
+    uint64_t key;
+    uint64_t game_id;
+} GameDbEntry;
+
+typedef struct
+{
+    char path[GAME_DB_MAX_PATH_SIZE];
+
+    FILE* games_file;
+    uint64_t games_size;
+
+    uint64_t* offsets;
+    size_t num_games;
+    size_t offsets_capacity;
+
+    GameDbEntry* entries;
+    size_t num_entries;
+    size_t entries_capacity;
+} GameDbWriter;
+
+/*
+    Opens a database for appending games, creating it if it does not exist.
+    The keys of the games already in the database are loaded back so the
+    index can be rebuilt when closing
+*/
+CCHESS_API bool game_db_writer_open(GameDbWriter* writer, const char* path);
+
+/* Appends a game, and records the key of every position reached, the final one included */
+CCHESS_API bool game_db_writer_add_game(GameDbWriter* writer,
+                                        const Board* start,
+                                        const Move* moves,
+                                        const uint32_t num_moves,
+                                        const PgnResult result);
+
+/* Sorts the keys and writes the index, the writer can't be used afterwards */
+CCHESS_API bool game_db_writer_close(GameDbWriter* writer);
+
+CCHESS_API bool game_db_open(GameDb* db, const char* path);
+
+CCHESS_API void game_db_close(GameDb* db);
+
+CCHESS_FORCE_INLINE size_t game_db_num_games(const GameDb* db)
+{
+    return db->header != NULL ? (size_t)db->header->num_games : 0;
+}
+
+/*
+    Finds the games that reached the position with the given key. Writes at
+    most max_game_ids ids, in increasing order, and returns the total number
+    of games found
+*/
+CCHESS_API size_t game_db_find_games(const GameDb* db,
+                                     const uint64_t key,
+                                     uint32_t* game_ids,
+                                     const size_t max_game_ids);
+
+CCHESS_API bool game_db_get_game(const GameDb* db, const uint32_t game_id, GameDbGame* game);
+
+CCHESS_FORCE_INLINE Move game_db_game_get_move(const GameDbGame* game, const uint32_t index)
+{
+    Move move;
+    memcpy(&move, game->moves + index * sizeof(Move), sizeof(Move));
+
+    return move;
+}
+
+#endif /* !defined(__GAME_DB) */
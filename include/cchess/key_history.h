@@ -0,0 +1,86 @@
+#pragma once
+
+#if !defined(__KEY_HISTORY)
+#define __KEY_HISTORY
+
+#include "cchess/board.h"
+
+/*
+    Zobrist keys of the positions of a game, the last one being the current
+    position, for the detection of repetitions. Each key comes with the
+    number of plies since the last irreversible move (a capture, a pawn move
+    or a null move of the search), as a repetition can't cross one: the
+    scans go back that far only, two plies at a time since the side to play
+    must be the same.
+
+    The keys are kept in a ring, the older ones being overwritten by a long
+    game. They are never needed past the fifty moves rule and the depth of
+    the search. The search writes the key of the position at each ply at
+    its own index in the ring, truncating the history to its ply first so
+    nothing has to be popped
+*/
+
+#define KEY_HISTORY_SIZE 512
+#define KEY_HISTORY_MASK (KEY_HISTORY_SIZE - 1)
+
+STATIC_ASSERT((KEY_HISTORY_SIZE & KEY_HISTORY_MASK) == 0);
+
+typedef struct
+{
+    uint64_t keys[KEY_HISTORY_SIZE];
+    uint16_t reversible_plies[KEY_HISTORY_SIZE];
+    /* Keys pushed since the reset, only the last KEY_HISTORY_SIZE are kept */
+    uint32_t size;
+} KeyHistory;
+
+CCHESS_FORCE_INLINE void key_history_reset(KeyHistory* history)
+{
+    history->size = 0;
+}
+
+/* Pushes the key of the position reached by an irreversible move or not, or of the first position */
+CCHESS_FORCE_INLINE void key_history_push(KeyHistory* history, const uint64_t key, const bool irreversible)
+{
+    const uint32_t index = history->size & KEY_HISTORY_MASK;
+    const uint32_t previous = (history->size - 1) & KEY_HISTORY_MASK;
+
+    const uint32_t reversible_plies = irreversible || history->size == 0 ? 0 : history->reversible_plies[previous] + 1;
+
+    history->keys[index] = key;
+    history->reversible_plies[index] = reversible_plies < UINT16_MAX ? (uint16_t)reversible_plies : UINT16_MAX;
+    history->size++;
+}
+
+/* Plies of the last position that can be scanned back for a repetition */
+CCHESS_FORCE_INLINE uint32_t key_history_scan_plies(const KeyHistory* history)
+{
+    if(history->size == 0)
+    {
+        return 0;
+    }
+
+    const uint32_t reversible_plies = history->reversible_plies[(history->size - 1) & KEY_HISTORY_MASK];
+    const uint32_t available_plies = history->size - 1 < KEY_HISTORY_MASK ? history->size - 1 : KEY_HISTORY_MASK;
+
+    return reversible_plies < available_plies ? reversible_plies : available_plies;
+}
+
+/*
+    Returns true if the last position is a draw by repetition, for a search
+    at ply from its root: a position repeated once after the root is scored
+    as a draw, as the side that could avoid it would have done so earlier,
+    while a repetition of the positions before the root has to be the third
+    occurrence
+*/
+CCHESS_API bool key_history_is_repetition(const KeyHistory* history, const uint32_t ply);
+
+/*
+    Returns true if the side to play can move back to a position of the
+    search, the board being the last position. The difference of the two
+    keys is looked up in the cuckoo table of the reversible moves of
+    zobrist.h, and the move must not be blocked. Costs a few comparisons
+    for each other ply since the last irreversible move
+*/
+CCHESS_API bool key_history_has_upcoming_repetition(const KeyHistory* history, const Board* board, const uint32_t ply);
+
+#endif /* !defined(__KEY_HISTORY) */
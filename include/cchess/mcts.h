@@ -0,0 +1,111 @@
+#pragma once
+
+#if !defined(__MCTS)
+#define __MCTS
+
+#include "cchess/board.h"
+
+/*
+    Monte Carlo tree search. Each playout walks down the tree from the root,
+    picking at every node the child with the best UCT or PUCT value, expands
+    the leaf it reaches once the leaf was visited before, then plays a game
+    from it to its end and backs the result up the path. The best move is
+    the most visited child of the root.
+
+    Playouts play random legal moves, or moves picked by a light policy
+    favoring captures and promotions. A playout ends on a mate, a stalemate,
+    the fifty moves rule or kings alone; after MCTS_PLAYOUT_MAX_PLIES it is
+    scored by the static evaluation instead. Repetitions are not detected.
+
+    The nodes live in a pool allocated once, the children of a node being
+    contiguous in it. When the pool is full the leaves are no longer
+    expanded, the playouts go on from them.
+
+    Several threads grow the same tree without locks. The statistics are
+    updated atomically, and a node is expanded by the thread that claims it
+    first, the others playing out from it meanwhile. A thread walking down
+    a node adds a virtual loss to it, visits without result, so the other
+    threads walk down other paths until its playout is backed up.
+
+    Results are in [0, 1] for the side to play, 1 for a win
+*/
+
+#define MCTS_PLAYOUT_MAX_PLIES 200
+/* Longest path from the root, the playouts start from deeper leaves */
+#define MCTS_MAX_DEPTH 128
+#define MCTS_MAX_PV 32
+
+/* Size of the pool allocated when none is given */
+#define MCTS_DEFAULT_MAX_NODES (1U << 22)
+
+/* Playouts between two checks of the clock and of the stop flag */
+#define MCTS_CHECK_INTERVAL 64
+
+typedef enum
+{
+    /* Mean result plus an exploration term in the square root of the log of the parent visits */
+    MctsSelection_Uct,
+    /* Mean result plus an exploration term weighted by the light policy prior of the move */
+    MctsSelection_Puct,
+} MctsSelection;
+
+typedef enum
+{
+    MctsPlayout_Random,
+    /* Captures and promotions are more likely, the more valuable the victim the more */
+    MctsPlayout_Light,
+} MctsPlayout;
+
+typedef struct
+{
+    /* 0 for no limit, at least one limit or a stop flag is needed */
+    uint64_t max_playouts;
+    uint64_t max_time_ns;
+    /* Raised by another thread to stop the search, can be NULL */
+    volatile uint32_t* stop;
+    /* 0 or 1 for a single thread */
+    uint32_t num_threads;
+    /* Size of the node pool, 0 for MCTS_DEFAULT_MAX_NODES */
+    uint32_t max_nodes;
+    MctsSelection selection;
+    MctsPlayout playout;
+    /* Weight of the exploration term */
+    float exploration;
+    /* Visits added to the nodes of a path until its playout is backed up, at least 1 */
+    uint32_t virtual_loss;
+    uint64_t seed;
+} MctsLimits;
+
+typedef struct
+{
+    /* Most visited moves from the root */
+    uint32_t pv_length;
+    Move pv[MCTS_MAX_PV];
+    /* Mean result of the best move for the side to play */
+    float score;
+    uint64_t playouts;
+    /* Moves played by the playouts, out of the tree */
+    uint64_t playout_plies;
+    uint32_t num_nodes;
+    uint64_t elapsed_ns;
+    uint64_t playouts_per_second;
+} MctsInfo;
+
+/* UCT, light playouts, one thread and no limit */
+CCHESS_API void mcts_limits_init(MctsLimits* limits);
+
+/*
+    Plays a game from the position with the given policy, returns its
+    result for the side to play. random is the state of the generator of
+    the calling thread, num_plies receives the number of moves played
+*/
+CCHESS_API float mcts_playout(const Board* board, const MctsPlayout playout, uint64_t* random, uint32_t* num_plies);
+
+/*
+    Searches the position until a limit is reached, info holding the best
+    move as the first move of its principal variation. Returns false if the
+    side to play has no legal move or the pool could not be allocated
+*/
+CCHESS_API bool mcts_run(Board* board, const MctsLimits* limits, MctsInfo* info);
+
+#endif /* !defined(__MCTS) */
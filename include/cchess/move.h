@@ -5,6 +5,8 @@
 
 #include "cchess/cchess.h"
 
+#include <string.h>
+
 /* 
     A move is represented using 16 bits
 
@@ -31,7 +33,13 @@ typedef uint16_t Move;
 #define MOVE_SET_TO_SQUARE(m, r) ((m) = (((m) & ~0x3F) | (r)))
 */
 
-/* Easier to read and maintain using a struct with bitfields */
+/* 
+    Easier to read and maintain using a struct with bitfields
+
+    piece is the piece standing on the destination square once the move is
+    played, a promotion stores the promoted piece. Castling is a king move of
+    two squares and en passant a capturing pawn move to the en passant square
+*/
 
 typedef struct 
 {
@@ -53,6 +61,28 @@ typedef struct
 #define MOVE_SET_FROM_SQUARE(m, r) ((m).from = (uint16_t)(r))
 #define MOVE_SET_TO_SQUARE(m, r) ((m).to = (uint16_t)(r))
 
+/* Raw 16 bits of a move, in the layout described above */
+CCHESS_FORCE_INLINE uint16_t move_to_u16(const Move move)
+{
+    uint16_t value;
+    memcpy(&value, &move, sizeof(uint16_t));
+
+    return value;
+}
+
+CCHESS_FORCE_INLINE Move move_from_u16(const uint16_t value)
+{
+    Move move;
+    memcpy(&move, &value, sizeof(uint16_t));
+
+    return move;
+}
+
+CCHESS_FORCE_INLINE bool move_equal(const Move a, const Move b)
+{
+    return move_to_u16(a) == move_to_u16(b);
+}
+
 typedef uint64_t (*move_gen_func)(const uint32_t, 
                                   const uint32_t,
                                   const uint64_t,
@@ -88,6 +118,31 @@ CCHESS_API uint64_t move_gen_king(const uint32_t square,
                                   const uint64_t blockers_white,
                                   const uint64_t blockers_black);
 
+/*
+    Attack masks, they do not depend on the side to move and include the
+    first blocker of sliding pieces whatever its color. Used for check, pin
+    and mate detection
+*/
+
+CCHESS_API uint64_t move_gen_pawn_attacks(const uint32_t square, const uint32_t side);
+
+CCHESS_API uint64_t move_gen_knight_attacks(const uint32_t square);
+
+CCHESS_API uint64_t move_gen_bishop_attacks(const uint32_t square, const uint64_t occupancy);
+
+CCHESS_API uint64_t move_gen_rook_attacks(const uint32_t square, const uint64_t occupancy);
+
+CCHESS_API uint64_t move_gen_queen_attacks(const uint32_t square, const uint64_t occupancy);
+
+CCHESS_API uint64_t move_gen_king_attacks(const uint32_t square);
+
+/* Squares strictly between from and to, 0 if they are not on the same line */
+CCHESS_API uint64_t move_gen_between(const uint32_t from, const uint32_t to);
+
+/* Full rank, file or diagonal going through from and to, 0 if they are not aligned */
+CCHESS_API uint64_t move_gen_line(const uint32_t from, const uint32_t to);
+
+/* Builds the move and attack lookup tables, and the zobrist keys */
 CCHESS_API void move_gen_init(void);
 
 CCHESS_API void move_gen_destroy(void);
@@ -0,0 +1,138 @@
+#pragma once
+
+#if !defined(__MOVE_ORDER)
+#define __MOVE_ORDER
+
+#include "cchess/board.h"
+
+/*
+    Move ordering for the search. Moves are scored into a list of packed 32
+    bits values, the score in the high half and the move in the low one, so
+    comparing two values compares their scores. The moves are then picked
+    one at a time by a selection of the best remaining one: a cutoff after
+    the first few moves leaves the rest of the list unsorted.
+
+    Scores rank, from the first:
+    - the hash or principal variation move
+    - captures and promotions, the most valuable victim first and then the
+      least valuable attacker (MVV-LVA)
+    - the two killer moves of the ply, quiet moves that caused a cutoff in
+      a sibling node, kept by the caller in its stack of plies
+    - the counter move, the quiet move that last refuted the previous move
+    - the other quiet moves by their butterfly history, a from-to score
+      raised when the move causes a cutoff and lowered when another one
+      does after it was tried
+
+    The tables are per thread and need no synchronization
+*/
+
+#define MOVE_ORDER_SCORE_FIRST 30000
+#define MOVE_ORDER_SCORE_CAPTURE 20000
+#define MOVE_ORDER_SCORE_KILLER_1 15000
+#define MOVE_ORDER_SCORE_KILLER_2 14000
+#define MOVE_ORDER_SCORE_COUNTER 13000
+
+/* Bound of the history scores, kept below the counter move */
+#define MOVE_ORDER_HISTORY_MAX 8192
+
+typedef int32_t ScoredMove;
+
+typedef struct
+{
+    ScoredMove moves[BOARD_MAX_MOVES];
+    uint32_t size;
+    /* Moves before it were already picked */
+    uint32_t next;
+} ScoredMoveList;
+
+typedef struct
+{
+    /* Indexed by side, from and to squares */
+    int16_t history[2][64][64];
+    /* Indexed by the side, piece and destination of the previous move */
+    Move counter_moves[2][6][64];
+} MoveOrderTables;
+
+CCHESS_FORCE_INLINE ScoredMove scored_move_make(const Move move, const int32_t score)
+{
+    return (ScoredMove)((uint32_t)score << 16) | (ScoredMove)move_to_u16(move);
+}
+
+CCHESS_FORCE_INLINE Move scored_move_get_move(const ScoredMove scored_move)
+{
+    return move_from_u16((uint16_t)scored_move);
+}
+
+CCHESS_FORCE_INLINE int32_t scored_move_get_score(const ScoredMove scored_move)
+{
+    return (int32_t)(int16_t)(uint16_t)((uint32_t)scored_move >> 16);
+}
+
+/* Captures, en passant and promotions are not quiet */
+CCHESS_FORCE_INLINE bool move_order_is_quiet(const Board* board, const Move move)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    return !MOVE_GET_IS_CAPTURING(move) &&
+           !(MOVE_GET_PIECE(move) != Piece_Pawn && (board_get_pawns(board, side) & BIT64(MOVE_GET_FROM_SQUARE(move))));
+}
+
+CCHESS_API void move_order_clear(MoveOrderTables* tables);
+
+/* MVV-LVA score of a capture or promotion, from 0 */
+CCHESS_API int32_t move_order_mvv_lva(Board* board, const Move move);
+
+/*
+    Scores the legal moves of the position, first_move (can be NULL) being
+    ranked first. killers are the two killer moves of the ply searched.
+    previous_move is the move leading to the position, EMPTY_MOVE for the
+    root or after a null move
+*/
+CCHESS_API void move_order_score_moves(const MoveOrderTables* tables,
+                                       Board* board,
+                                       const Move* moves,
+                                       const size_t num_moves,
+                                       const Move* first_move,
+                                       const Move* killers,
+                                       const Move previous_move,
+                                       ScoredMoveList* list);
+
+/* Swaps the best remaining move to the front of the remaining ones and returns it, false when all were picked */
+CCHESS_FORCE_INLINE bool move_order_pick(ScoredMoveList* list, Move* move)
+{
+    if(list->next >= list->size)
+    {
+        return false;
+    }
+
+    uint32_t best = list->next;
+
+    for(uint32_t i = list->next + 1; i < list->size; i++)
+    {
+        best = list->moves[i] > list->moves[best] ? i : best;
+    }
+
+    const ScoredMove picked = list->moves[best];
+    list->moves[best] = list->moves[list->next];
+    list->moves[list->next++] = picked;
+
+    *move = scored_move_get_move(picked);
+
+    return true;
+}
+
+/*
+    Updates the tables and the two killers of the ply after the quiet move
+    best_move caused a cutoff at depth, the quiet moves tried before it
+    being lowered in the history
+*/
+CCHESS_API void move_order_update_quiet(MoveOrderTables* tables,
+                                        const Board* board,
+                                        Move* killers,
+                                        const int32_t depth,
+                                        const Move best_move,
+                                        const Move* tried_quiets,
+                                        const size_t num_tried_quiets,
+                                        const Move previous_move);
+
+#endif /* !defined(__MOVE_ORDER) */
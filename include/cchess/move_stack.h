@@ -0,0 +1,52 @@
+#pragma once
+
+#if !defined(__MOVE_STACK)
+#define __MOVE_STACK
+
+#include "cchess/board.h"
+
+/*
+    Contiguous arena of moves shared by the plies of a recursive search. A
+    position generates its moves at the top of the stack, pushes as many as
+    it got and pops them when done, so the moves of consecutive plies are
+    packed together instead of each ply holding BOARD_MAX_MOVES of them.
+    The arena is allocated once, one per thread, and is not grown: its
+    capacity must keep BOARD_MAX_MOVES free at the top for the deepest ply
+    that generates moves
+*/
+
+typedef struct
+{
+    Move* moves;
+    size_t size;
+    size_t capacity;
+} MoveStack;
+
+/* Returns false if the arena could not be allocated */
+CCHESS_API bool move_stack_init(MoveStack* stack, const size_t capacity);
+
+CCHESS_API void move_stack_release(MoveStack* stack);
+
+/* Where the next moves are written, with room for BOARD_MAX_MOVES, they belong to the stack once pushed */
+CCHESS_FORCE_INLINE Move* move_stack_top(MoveStack* stack)
+{
+    CCHESS_ASSERT(stack->capacity - stack->size >= BOARD_MAX_MOVES);
+
+    return stack->moves + stack->size;
+}
+
+CCHESS_FORCE_INLINE void move_stack_push(MoveStack* stack, const size_t num_moves)
+{
+    CCHESS_ASSERT(stack->size + num_moves <= stack->capacity);
+
+    stack->size += num_moves;
+}
+
+CCHESS_FORCE_INLINE void move_stack_pop(MoveStack* stack, const size_t num_moves)
+{
+    CCHESS_ASSERT(num_moves <= stack->size);
+
+    stack->size -= num_moves;
+}
+
+#endif /* !defined(__MOVE_STACK) */
@@ -0,0 +1,143 @@
+#pragma once
+
+#if !defined(__NNUE)
+#define __NNUE
+
+#include "cchess/board.h"
+
+/*
+    Efficiently updatable neural network evaluation.
+
+    The first layer (the feature transformer) has one input per king square,
+    piece and square, from the point of view of each side: HalfKP leaves the
+    kings out of the pieces, HalfKA includes them. Squares are flipped for
+    black so both sides share the weights. Its NNUE_L1_SIZE outputs per side
+    are accumulated in int16: a move only adds and removes the columns of
+    the few features it changes, unless it moves the king of that side,
+    which refreshes the whole accumulator.
+
+    The accumulators of the side to play and of the other side, clipped to
+    [0, 127], feed two int8 dense layers with clipped ReLU activations and
+    the int8 output layer.
+
+    The accumulators are kept on a stack following the search: a push after
+    every move computes the new accumulators from the previous ones and the
+    bitboards before and after the move, a pop undoes it.
+
+    The kernels use AVX2 when the library is built for it, and scalar code
+    otherwise. Both compute the same integers, the scalar kernels stay
+    available through use_simd for testing.
+
+    Networks are loaded from files made of an NnueHeader followed, for each
+    layer in order, by its biases and its weights, in the layout of the Nnue
+    struct, little endian
+*/
+
+#define NNUE_L1_SIZE 256
+#define NNUE_L2_SIZE 32
+#define NNUE_L3_SIZE 32
+
+#define NNUE_MAGIC 0x45554E43
+#define NNUE_VERSION 1
+
+/* Enough for the plies of a search */
+#define NNUE_STACK_SIZE 256
+
+/* Right shift of the dense layers sums, their weights being scaled by 64 */
+#define NNUE_WEIGHT_SHIFT 6
+
+/* Divisor of the output, giving centipawns */
+#define NNUE_OUTPUT_SCALE 16
+
+#define NNUE_CLIP_MAX 127
+
+typedef enum
+{
+    NnueFeatureSet_HalfKP = 0,
+    NnueFeatureSet_HalfKA = 1,
+} NnueFeatureSet;
+
+/* Features per king square */
+#define NNUE_HALFKP_PIECE_FEATURES (10 * 64)
+#define NNUE_HALFKA_PIECE_FEATURES (12 * 64)
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t feature_set;
+    uint32_t l1_size;
+    uint32_t l2_size;
+    uint32_t l3_size;
+    uint32_t reserved[2];
+} NnueHeader;
+
+typedef struct
+{
+    NnueFeatureSet feature_set;
+    uint32_t num_features;
+
+    /* num_features rows of NNUE_L1_SIZE, on huge pages when available */
+    int16_t* ft_weights;
+    size_t ft_weights_size;
+    bool huge_pages;
+
+    /* Kernels used, false for the scalar ones */
+    bool use_simd;
+
+    CCHESS_ALIGNED(32) int16_t ft_biases[NNUE_L1_SIZE];
+
+    CCHESS_ALIGNED(32) int8_t l1_weights[NNUE_L2_SIZE][2 * NNUE_L1_SIZE];
+    CCHESS_ALIGNED(32) int32_t l1_biases[NNUE_L2_SIZE];
+
+    CCHESS_ALIGNED(32) int8_t l2_weights[NNUE_L3_SIZE][NNUE_L2_SIZE];
+    CCHESS_ALIGNED(32) int32_t l2_biases[NNUE_L3_SIZE];
+
+    CCHESS_ALIGNED(32) int8_t output_weights[NNUE_L3_SIZE];
+    int32_t output_bias;
+} Nnue;
+
+typedef struct
+{
+    /* Indexed by the side whose point of view it is */
+    CCHESS_ALIGNED(32) int16_t values[2][NNUE_L1_SIZE];
+} NnueAccumulator;
+
+typedef struct
+{
+    NnueAccumulator accumulators[NNUE_STACK_SIZE];
+    uint32_t size;
+} NnueStack;
+
+/* Returns false if the file can't be read or does not hold a network of the built sizes */
+CCHESS_API bool nnue_load(Nnue* nnue, const char* path);
+
+CCHESS_API bool nnue_save(const Nnue* nnue, const char* path);
+
+/* Random weights of plausible magnitudes, for tests and benchmarks */
+CCHESS_API bool nnue_init_random(Nnue* nnue, const NnueFeatureSet feature_set, uint64_t seed);
+
+CCHESS_API void nnue_release(Nnue* nnue);
+
+/* Whether the library was built with the AVX2 kernels */
+CCHESS_API bool nnue_has_simd(void);
+
+/* Empties the stack and computes the accumulators of the root position */
+CCHESS_API void nnue_stack_reset(const Nnue* nnue, NnueStack* stack, const Board* board);
+
+/* Pushes the accumulators of after, reached by one move (or a null move) from before */
+CCHESS_API void nnue_stack_push(const Nnue* nnue, NnueStack* stack, const Board* before, const Board* after);
+
+CCHESS_FORCE_INLINE void nnue_stack_pop(NnueStack* stack)
+{
+    CCHESS_ASSERT(stack->size > 1);
+    stack->size--;
+}
+
+/* Score in centipawns for the side to play of board, the position of the top of the stack */
+CCHESS_API int32_t nnue_evaluate(const Nnue* nnue, const NnueStack* stack, const Board* board);
+
+/* Full computation of the accumulator of one side, to verify the incremental ones */
+CCHESS_API void nnue_compute_accumulator(const Nnue* nnue, const Board* board, const uint32_t side, int16_t* values);
+
+#endif /* !defined(__NNUE) */
@@ -0,0 +1,48 @@
+#pragma once
+
+#if !defined(__NOTATION)
+#define __NOTATION
+
+#include "cchess/board.h"
+
+/*
+    Conversions between Move and text. The board is the position before the
+    move is played, and is used to resolve what the text does not say (the
+    moving piece, captures, promotions). Nothing is allocated
+*/
+
+/* Long algebraic notation used by UCI, e2e4, e7e8q, e1g1 for castling */
+
+#define MOVE_UCI_MAX_SIZE 6
+
+/* Writes at most MOVE_UCI_MAX_SIZE bytes including the null terminator, returns the length */
+CCHESS_API size_t move_to_uci(Board* board, const Move move, char* uci);
+
+/*
+    Parses a move for the side to play, returns false if the text is not a
+    move or if no piece of the side to play stands on the origin square.
+    The legality of the move is not verified, see board_move_is_legal
+*/
+CCHESS_API bool move_from_uci(Board* board, const char* uci, Move* move);
+
+/* 
+    Standard algebraic notation used by PGN, Nbxd7+, exd8=Q#, O-O-O. 
+    The origin square is found with reverse attack lookups from the
+    destination square, restricted to the named piece, without generating
+    the moves of the side to play
+*/
+
+#define MOVE_SAN_MAX_SIZE 8
+
+/* Writes at most MOVE_SAN_MAX_SIZE bytes including the null terminator, returns the length */
+CCHESS_API size_t move_to_san(Board* board, const Move move, char* san);
+
+/*
+    Parses a move for the side to play. Parsing stops at the first character
+    that can't be part of a SAN move (space, null terminator...), check and
+    annotation suffixes are accepted and ignored. Returns false if the text
+    is not a move or if it does not match exactly one piece
+*/
+CCHESS_API bool move_from_san(Board* board, const char* san, Move* move);
+
+#endif /* !defined(__NOTATION) */
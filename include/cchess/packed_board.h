@@ -0,0 +1,42 @@
+#pragma once
+
+#if !defined(__PACKED_BOARD)
+#define __PACKED_BOARD
+
+#include "cchess/board.h"
+
+/*
+    Fixed size binary position record, 32 bytes
+
+    occupancy        64 bits, squares holding a piece
+    pieces          128 bits, one nibble per occupied square in square order,
+                              holding the board index of the piece (piece * 2 + side)
+    state            32 bits, Board state
+    halfmove clock   16 bits
+    fullmove number  16 bits
+
+    A position with more than 32 pieces can't be packed
+*/
+
+#define PACKED_BOARD_MAX_PIECES 32
+
+typedef struct
+{
+    uint64_t occupancy;
+    uint64_t pieces[2];
+    uint32_t state;
+    uint16_t halfmove_clock;
+    uint16_t fullmove_number;
+} PackedBoard;
+
+/* Returns false if the board holds more than PACKED_BOARD_MAX_PIECES pieces */
+CCHESS_API bool packed_board_encode(PackedBoard* packed, const Board* board);
+
+CCHESS_API void packed_board_decode(Board* board, const PackedBoard* packed);
+
+/* Encodes count boards, returns the number of boards that could not be packed */
+CCHESS_API size_t packed_board_encode_bulk(PackedBoard* packed, const Board* boards, const size_t count);
+
+CCHESS_API void packed_board_decode_bulk(Board* boards, const PackedBoard* packed, const size_t count);
+
+#endif /* !defined(__PACKED_BOARD) */
@@ -0,0 +1,83 @@
+#pragma once
+
+#if !defined(__PGN)
+#define __PGN
+
+#include "cchess/board.h"
+
+/*
+    PGN ingestion. Files are memory mapped and split in chunks starting on a
+    game boundary ([Event tag at the beginning of a line), and chunks are
+    handed out to OpenMP threads. This is data parallel, not a pipeline of
+    stages with queues between them: a thread runs every step of a game
+    itself, tokenizing it, resolving and replaying its SAN moves and calling
+    back the consumer for every position, before moving to the next game.
+    Different threads work on different games at the same time, and share
+    nothing but the read only mapping. Comments, variations, NAGs and
+    escaped lines are skipped, a FEN tag sets the starting position
+*/
+
+/* Games with more plies than this are truncated and counted as errors */
+#define PGN_MAX_PLIES 1024
+
+typedef enum
+{
+    PgnResult_Unknown = 0,
+    PgnResult_WhiteWins = 1,
+    PgnResult_BlackWins = 2,
+    PgnResult_Draw = 3,
+} PgnResult;
+
+typedef struct
+{
+    /* Position before the move */
+    const Board* board;
+    uint64_t key;
+
+    Move move;
+    uint16_t ply;
+
+    /* Result of the game, from the Result tag or the game termination marker */
+    PgnResult result;
+
+    /* Offset of the game in the parsed text, identifies the game */
+    uint64_t game_offset;
+} PgnPosition;
+
+typedef struct
+{
+    size_t num_games;
+    size_t num_positions;
+    size_t num_errors;
+    size_t num_bytes;
+    uint64_t elapsed_ns;
+    double games_per_second;
+    double positions_per_second;
+    double megabytes_per_second;
+} PgnLoadStats;
+
+/*
+    Called once per move played, with the position it is played from. Calls
+    happen concurrently from several threads, and calls for a given game are
+    made in order from the same thread
+*/
+typedef void (*pgn_position_func)(const PgnPosition* position, void* user_data);
+
+/*
+    Parses the games of a text that does not need to be null terminated, on
+    the calling thread. A game whose moves can't be resolved stops at the
+    first invalid move and is counted in the stats errors. stats can be NULL
+*/
+CCHESS_API void pgn_parse(const char* text,
+                          const size_t length,
+                          pgn_position_func func,
+                          void* user_data,
+                          PgnLoadStats* stats);
+
+/* Parses every game of the file at path in parallel. stats can be NULL */
+CCHESS_API bool pgn_load(const char* path,
+                         pgn_position_func func,
+                         void* user_data,
+                         PgnLoadStats* stats);
+
+#endif /* !defined(__PGN) */
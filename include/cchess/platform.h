@@ -0,0 +1,176 @@
+#pragma once
+
+#if !defined(__PLATFORM)
+#define __PLATFORM
+
+#include "cchess/cchess.h"
+
+/*
+    Operating system abstractions used by the library: read-only file
+    mappings, large page allocations, monotonic time, processor count,
+    threads and the few atomic operations needed by structures shared
+    between threads
+*/
+
+#if defined(CCHESS_MSVC)
+#include <intrin.h>
+#endif /* defined(CCHESS_MSVC) */
+
+typedef enum
+{
+    FileMappingAccess_Sequential = 0,
+    FileMappingAccess_Random = 1,
+} FileMappingAccess;
+
+typedef struct
+{
+    const char* data;
+    size_t size;
+
+#if defined(CCHESS_WIN)
+    void* file_handle;
+    void* mapping_handle;
+#endif /* defined(CCHESS_WIN) */
+} FileMapping;
+
+/*
+    Maps a whole file read-only in memory. Empty files are mapped with data
+    set to NULL and size to 0. The access pattern is given as a hint to the
+    kernel paging
+*/
+CCHESS_API bool platform_map_file(FileMapping* mapping,
+                                  const char* path,
+                                  const FileMappingAccess access);
+
+CCHESS_API void platform_unmap_file(FileMapping* mapping);
+
+/* Monotonic clock, in nanoseconds */
+CCHESS_API uint64_t platform_get_time_ns(void);
+
+CCHESS_API uint32_t platform_get_num_cpus(void);
+
+/* Gives the rest of the time slice of the calling thread to the other threads */
+CCHESS_API void platform_yield_thread(void);
+
+CCHESS_API void platform_sleep_ms(const uint32_t ms);
+
+typedef void (*PlatformThreadFunc)(void* user_data);
+
+/* Kept alive by the caller until the thread is joined */
+typedef struct
+{
+    PlatformThreadFunc func;
+    void* user_data;
+    void* handle;
+} PlatformThread;
+
+/* Starts func(user_data) on a new thread, returns false if it could not be created */
+CCHESS_API bool platform_thread_start(PlatformThread* thread, PlatformThreadFunc func, void* user_data);
+
+/* Waits for the thread to return and releases it */
+CCHESS_API void platform_thread_join(PlatformThread* thread);
+
+/*
+    Allocates zeroed memory aligned to a page, backed by huge pages when the
+    system grants them (huge_pages is set to tell), by regular pages hinted
+    for transparent huge pages otherwise. Returns NULL on failure
+*/
+CCHESS_API void* platform_alloc_large(const size_t size, bool* huge_pages);
+
+CCHESS_API void platform_free_large(void* ptr, const size_t size);
+
+/*
+    Allocates zeroed memory aligned to alignment, a power of two, for the
+    structs aligned above what malloc guarantees, like Board. Returns NULL
+    on failure
+*/
+CCHESS_API void* platform_alloc_aligned(const size_t size, const size_t alignment);
+
+CCHESS_API void platform_free_aligned(void* ptr);
+
+/* Loads are acquire operations, stores are release operations */
+
+CCHESS_FORCE_INLINE uint32_t platform_atomic_load_u32(volatile uint32_t* ptr)
+{
+#if defined(CCHESS_MSVC)
+    const uint32_t value = *ptr;
+    _ReadWriteBarrier();
+
+    return value;
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif /* defined(CCHESS_MSVC) */
+}
+
+CCHESS_FORCE_INLINE void platform_atomic_store_u32(volatile uint32_t* ptr, const uint32_t value)
+{
+#if defined(CCHESS_MSVC)
+    _ReadWriteBarrier();
+    *ptr = value;
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif /* defined(CCHESS_MSVC) */
+}
+
+CCHESS_FORCE_INLINE uint64_t platform_atomic_load_u64(volatile uint64_t* ptr)
+{
+#if defined(CCHESS_MSVC)
+    const uint64_t value = *ptr;
+    _ReadWriteBarrier();
+
+    return value;
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif /* defined(CCHESS_MSVC) */
+}
+
+/* Sets *ptr to desired if it holds expected, returns true if it did */
+CCHESS_FORCE_INLINE bool platform_atomic_cas_u32(volatile uint32_t* ptr, uint32_t expected, const uint32_t desired)
+{
+#if defined(CCHESS_MSVC)
+    return (uint32_t)_InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)expected) == expected;
+#else
+    return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif /* defined(CCHESS_MSVC) */
+}
+
+CCHESS_FORCE_INLINE bool platform_atomic_cas_u64(volatile uint64_t* ptr, uint64_t expected, const uint64_t desired)
+{
+#if defined(CCHESS_MSVC)
+    return (uint64_t)_InterlockedCompareExchange64((volatile long long*)ptr, (long long)desired, (long long)expected) == expected;
+#else
+    return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif /* defined(CCHESS_MSVC) */
+}
+
+/* Returns the previous value */
+CCHESS_FORCE_INLINE uint32_t platform_atomic_fetch_add_u32(volatile uint32_t* ptr, const uint32_t value)
+{
+#if defined(CCHESS_MSVC)
+    return (uint32_t)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+#else
+    return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+#endif /* defined(CCHESS_MSVC) */
+}
+
+/* Returns the previous value */
+CCHESS_FORCE_INLINE uint64_t platform_atomic_fetch_add_u64(volatile uint64_t* ptr, const uint64_t value)
+{
+#if defined(CCHESS_MSVC)
+    return (uint64_t)_InterlockedExchangeAdd64((volatile long long*)ptr, (long long)value);
+#else
+    return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+#endif /* defined(CCHESS_MSVC) */
+}
+
+/* Returns the previous value */
+CCHESS_FORCE_INLINE uint64_t platform_atomic_fetch_or_u64(volatile uint64_t* ptr, const uint64_t value)
+{
+#if defined(CCHESS_MSVC)
+    return (uint64_t)_InterlockedOr64((volatile long long*)ptr, (long long)value);
+#else
+    return __atomic_fetch_or(ptr, value, __ATOMIC_ACQ_REL);
+#endif /* defined(CCHESS_MSVC) */
+}
+
+#endif /* !defined(__PLATFORM) */
@@ -0,0 +1,76 @@
+#pragma once
+
+#if !defined(__POLYGLOT)
+#define __POLYGLOT
+
+#include "cchess/board.h"
+#include "cchess/platform.h"
+
+/*
+    Polyglot opening books (.bin). A book is a sorted array of 16 bytes
+    big-endian entries (key, move, weight, learn), memory mapped and
+    searched in place.
+
+    Position keys follow the Polyglot key schedule: 781 random values
+    indexed by piece and square, castling rights, en passant file (only when
+    a pawn of the side to play can capture) and side to play. The random
+    values are the Random64 array published with the Polyglot book format
+    specification, built in. Other values can be installed with
+    polyglot_init
+*/
+
+#define POLYGLOT_NUM_RANDOM64 781
+
+typedef struct
+{
+    Move move;
+    uint16_t weight;
+    uint32_t learn;
+} PolyglotMove;
+
+typedef struct
+{
+    FileMapping mapping;
+    const uint8_t* entries;
+    size_t num_entries;
+} PolyglotBook;
+
+/*
+    Installs the random values of the key schedule, NULL for the standard
+    ones used by default. Returns true if they give the keys of the
+    specification test positions, false if they are not the standard
+    Polyglot values (keys are still computed with them, but won't match the
+    books found in the wild)
+*/
+CCHESS_API bool polyglot_init(const uint64_t* random64);
+
+CCHESS_API uint64_t polyglot_hash_board(Board* board);
+
+/* Decodes a book move for the side to play. Castling is stored as the king taking its own rook */
+CCHESS_API Move polyglot_decode_move(Board* board, const uint16_t move);
+
+CCHESS_API bool polyglot_book_open(PolyglotBook* book, const char* path);
+
+CCHESS_API void polyglot_book_close(PolyglotBook* book);
+
+/*
+    Finds the book moves of a position, in book order (decreasing weight for
+    books built by Polyglot). Writes at most max_moves moves and returns the
+    total number of entries found
+*/
+CCHESS_API size_t polyglot_book_probe(const PolyglotBook* book,
+                                      Board* board,
+                                      PolyglotMove* moves,
+                                      const size_t max_moves);
+
+/*
+    Picks a book move with a probability proportional to its weight, random
+    being any uniformly distributed value. Returns false if the position is
+    not in the book
+*/
+CCHESS_API bool polyglot_book_pick_move(const PolyglotBook* book,
+                                        Board* board,
+                                        const uint64_t random,
+                                        Move* move);
+
+#endif /* !defined(__POLYGLOT) */
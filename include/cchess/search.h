@@ -0,0 +1,112 @@
+#pragma once
+
+#if !defined(__SEARCH)
+#define __SEARCH
+
+#include "cchess/board.h"
+#include "cchess/tt.h"
+#include "cchess/nnue.h"
+#include "cchess/time_manager.h"
+#include "cchess/key_history.h"
+
+/*
+    Alpha-beta search. Iterative deepening runs a principal variation search
+    at increasing depths, each iteration searching the principal variation
+    of the previous one first, within an aspiration window around its score
+    from the fourth iteration. Null-move pruning cuts the nodes where passing
+    still fails high, and the late quiet moves are searched at a reduced
+    depth first, then again at full depth if they beat alpha. At the
+    horizon, a quiescence search resolves the captures, promotions and
+    check evasions.
+
+    The search stops at the given depth, node count or time, or when the
+    stop flag is raised by another thread. The result of an interrupted
+    iteration is discarded, except for the first one. Given a clock, the
+    time manager of time_manager.h decides after each iteration whether to
+    start another one, and sets the time at which the search is interrupted.
+
+    Several threads search the same position (lazy SMP), sharing the
+    transposition table. The helper threads skip some depths so that they
+    do not all search the same tree, and stop when the main thread does.
+    The result of a helper replaces the main thread one when it completed a
+    deeper iteration with a better score.
+
+    Scores are in centipawns for the side to play, mates being scored
+    SEARCH_SCORE_MATE minus their distance in plies
+*/
+
+#define SEARCH_MAX_PLY 128
+
+#define SEARCH_SCORE_INFINITE 32001
+#define SEARCH_SCORE_MATE 32000
+#define SEARCH_SCORE_MATE_BOUND (SEARCH_SCORE_MATE - SEARCH_MAX_PLY)
+#define SEARCH_SCORE_DRAW 0
+
+#define SEARCH_SCORE_IS_MATE(score) ((score) >= SEARCH_SCORE_MATE_BOUND || (score) <= -SEARCH_SCORE_MATE_BOUND)
+
+/* Nodes searched between two checks of the clock and of the stop flag */
+#define SEARCH_CHECK_INTERVAL 1024
+
+/* Size of the table allocated for a search when none is given */
+#define SEARCH_DEFAULT_TT_SIZE_MB 16
+
+typedef struct
+{
+    uint32_t depth;
+    /* Deepest ply reached */
+    uint32_t selective_depth;
+    int32_t score;
+    uint64_t nodes;
+    /* Nodes of the quiescence search, counted in nodes too */
+    uint64_t quiescence_nodes;
+    uint64_t nps;
+    uint64_t elapsed_ns;
+    /* Permille of the transposition table used by this search */
+    uint32_t hashfull;
+    /* Time at which the search was to be interrupted, 0 without a time limit */
+    uint64_t time_limit_ns;
+    uint32_t pv_length;
+    Move pv[SEARCH_MAX_PLY];
+} SearchInfo;
+
+typedef void (*SearchCallback)(const SearchInfo* info, void* user_data);
+
+typedef struct
+{
+    /* 0 for no limit. The node limit counts the nodes of the main thread */
+    uint32_t max_depth;
+    uint64_t max_nodes;
+    uint64_t max_time_ns;
+    /* Clock of the side to play, unset to only use max_time_ns. The lowest time limit applies */
+    TimeControl time_control;
+    /* Raised by another thread to stop the search, can be NULL */
+    volatile uint32_t* stop;
+    /*
+        While raised, the time limit is not enforced. Lowered by another
+        thread when pondering ends, the search then stops as soon as the time
+        since its start is over. Can be NULL
+    */
+    volatile uint32_t* ponder;
+    /* Called after every completed iteration, can be NULL */
+    SearchCallback callback;
+    void* user_data;
+    /* 0 or 1 for a single thread */
+    uint32_t num_threads;
+    /* Kept between searches, NULL to use a table allocated for the search */
+    TranspositionTable* tt;
+    /* NULL to evaluate with the piece-square tables of eval.h */
+    const Nnue* nnue;
+    /* Keys of the positions played before the one searched, for the repetitions. Can be NULL */
+    const KeyHistory* history;
+} SearchLimits;
+
+CCHESS_API void search_limits_init(SearchLimits* limits);
+
+/*
+    Searches the position until a limit is reached. info holds the last
+    completed iteration, the best move being the first move of its principal
+    variation. Returns false if the side to play has no legal move
+*/
+CCHESS_API bool search_run(Board* board, const SearchLimits* limits, SearchInfo* info);
+
+#endif /* !defined(__SEARCH) */
@@ -0,0 +1,81 @@
+#pragma once
+
+#if !defined(__SYZYGY)
+#define __SYZYGY
+
+#include "cchess/board.h"
+
+/*
+    Syzygy endgame tablebases probing, from the .rtbw (win/draw/loss) and
+    .rtbz (distance to zeroing move) files found on the local disk.
+
+    syzygy_init looks for the tables of every material combination in the
+    given directories and registers them by material signature, without
+    opening them. A table is memory mapped and its headers decoded the first
+    time a position with its material is probed. After that a probe only
+    does one atomic load to find the table ready, and indexes the position
+    from its bitboards straight into the mapping: probing is thread-safe and
+    lock-free once the tables have been set up, the threads probing a table
+    while another one is setting it up wait for it.
+
+    The tables do not hold positions with castling rights, probes fail on
+    them, and captures (en passant included) are resolved by a small search
+    as the tables store "don't care" values when a winning capture exists
+*/
+
+#define SYZYGY_MAX_PIECES 7
+
+typedef enum
+{
+    SyzygyWdl_Loss = -2,
+    /* Loss, but draw under the fifty-move rule */
+    SyzygyWdl_BlessedLoss = -1,
+    SyzygyWdl_Draw = 0,
+    /* Win, but draw under the fifty-move rule */
+    SyzygyWdl_CursedWin = 1,
+    SyzygyWdl_Win = 2,
+} SyzygyWdl;
+
+/*
+    Registers the tables found in paths, a list of directories separated by
+    ':' (';' on Windows). Tables registered by a previous call are released.
+    Returns the number of tables found. Not thread-safe, it must not run
+    while probing
+*/
+CCHESS_API size_t syzygy_init(const char* paths);
+
+CCHESS_API void syzygy_release(void);
+
+/* Number of pieces of the largest table found, 0 if there is none */
+CCHESS_API uint32_t syzygy_get_max_pieces(void);
+
+/*
+    Material signature of a position: the number of pieces of each type and
+    side, kings excluded, 4 bits each
+*/
+CCHESS_API uint64_t syzygy_material_key(const Board* board);
+
+/*
+    Win/draw/loss value of the position for the side to play. Returns false
+    if the position can't be probed (too many pieces, castling rights, table
+    missing or corrupted)
+*/
+CCHESS_API bool syzygy_probe_wdl(Board* board, SyzygyWdl* wdl);
+
+/*
+    Distance to zeroing move in plies, for the side to play, assuming the
+    fifty-move counter is 0:
+
+            n < -100 : loss, but draw under the fifty-move rule
+    -100 <= n < -1   : loss in n plies
+            -1       : the side to play is mated
+             0       : draw
+        1 < n <= 100 : win in n plies
+      100 < n        : win, but draw under the fifty-move rule
+
+    As in the tables, n can be off by one ply. Returns false if the position
+    can't be probed
+*/
+CCHESS_API bool syzygy_probe_dtz(Board* board, int32_t* dtz);
+
+#endif /* !defined(__SYZYGY) */
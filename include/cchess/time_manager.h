@@ -0,0 +1,106 @@
+#pragma once
+
+#if !defined(__TIME_MANAGER)
+#define __TIME_MANAGER
+
+#include "cchess/move.h"
+
+/*
+    Time management of a search under a clock. Two limits are computed from
+    the clock of the side to play, its increment and the moves to play
+    until the next time control:
+    - the optimum (soft) limit, the time the move should take. No iteration
+      is started once most of it is used, as it would likely not complete
+      before it is over
+    - the maximum (hard) limit, at which the search is interrupted whatever
+      it is doing
+
+    After each completed iteration, the optimum is scaled: a best move that
+    stays the same iteration after iteration shrinks it, a best move that
+    just changed or a score dropping from the previous iteration extend it,
+    never past the maximum.
+
+    The search reads the clock every SEARCH_CHECK_INTERVAL nodes, counted by
+    each thread, and not on every node. The overshoot of the maximum limit
+    depends on that interval and on the time spent returning from the
+    search: TimeStats keeps the overshoots of the last searches to measure
+    its percentiles
+*/
+
+/* Time kept on the clock for the communication with the GUI, by default */
+#define TIME_MANAGER_DEFAULT_OVERHEAD_NS 30000000ULL
+
+/* Moves the remaining time is shared between when the time control does not tell */
+#define TIME_MANAGER_DEFAULT_MOVES_TO_GO 30
+
+typedef struct
+{
+    /* Remaining time and increment of the side to play, 0 for no clock */
+    uint64_t time_ns;
+    uint64_t increment_ns;
+    /* Moves until the next time control, 0 for sudden death */
+    uint32_t moves_to_go;
+    /* Fixed time for the move, used instead of the clock when not 0 */
+    uint64_t move_time_ns;
+    /* Time kept for the communication, 0 for TIME_MANAGER_DEFAULT_OVERHEAD_NS */
+    uint64_t overhead_ns;
+} TimeControl;
+
+typedef struct
+{
+    uint64_t optimum_ns;
+    uint64_t maximum_ns;
+
+    /* Optimum scaled by the last completed iteration */
+    uint64_t target_ns;
+
+    Move best_move;
+    /* Completed iterations since the best move last changed */
+    uint32_t stability;
+    int32_t score;
+    bool has_iteration;
+} TimeManager;
+
+/* Returns true if the time control has a clock or a fixed time for the move */
+CCHESS_FORCE_INLINE bool time_control_is_set(const TimeControl* control)
+{
+    return control->time_ns > 0 || control->move_time_ns > 0;
+}
+
+CCHESS_API void time_manager_init(TimeManager* manager, const TimeControl* control);
+
+/*
+    Updates the target with the result of the iteration completed after
+    elapsed_ns, and returns true if no other iteration should be started
+*/
+CCHESS_API bool time_manager_iteration_done(TimeManager* manager,
+                                            const uint32_t depth,
+                                            const Move best_move,
+                                            const int32_t score,
+                                            const uint64_t elapsed_ns);
+
+/* Overshoots of the last TIME_STATS_MAX_SAMPLES searches */
+
+#define TIME_STATS_MAX_SAMPLES 4096
+
+typedef struct
+{
+    /* Time used past the limit, negative if the search returned before */
+    int64_t overshoots_ns[TIME_STATS_MAX_SAMPLES];
+    uint32_t num_samples;
+    uint32_t next;
+
+    /* Since the stats were reset */
+    uint64_t num_searches;
+    uint64_t num_overshoots;
+    int64_t max_overshoot_ns;
+} TimeStats;
+
+CCHESS_API void time_stats_reset(TimeStats* stats);
+
+CCHESS_API void time_stats_add(TimeStats* stats, const uint64_t elapsed_ns, const uint64_t limit_ns);
+
+/* Overshoot below which percentile percent of the kept samples fall, 0 without samples */
+CCHESS_API int64_t time_stats_percentile(const TimeStats* stats, const double percentile);
+
+#endif /* !defined(__TIME_MANAGER) */
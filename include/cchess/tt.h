@@ -0,0 +1,94 @@
+#pragma once
+
+#if !defined(__TT)
+#define __TT
+
+#include "cchess/move.h"
+
+/*
+    Transposition table shared by the search threads, without locks.
+
+    Entries are 16 bytes, four to a 64 bytes bucket aligned on a cache line,
+    so a probe touches one line. An entry stores its data and its key xored
+    with its data: the threads read and write entries without
+    synchronization, and an entry torn by two concurrent writes no longer
+    verifies against its key, it is seen as a miss.
+
+    Every search starts a new generation. Storing in a full bucket replaces
+    the entry with the lowest depth, entries of past generations being seen
+    as shallower the older they are
+*/
+
+#define TT_ENTRIES_PER_BUCKET 4
+
+typedef enum
+{
+    TTBound_None = 0,
+    /* The score is at least the stored one */
+    TTBound_Lower = 1,
+    /* The score is at most the stored one */
+    TTBound_Upper = 2,
+    TTBound_Exact = 3,
+} TTBound;
+
+typedef struct
+{
+    Move move;
+    int16_t score;
+    int16_t eval;
+    uint8_t depth;
+    uint8_t bound;
+} TTEntry;
+
+typedef struct
+{
+    volatile uint64_t key;
+    volatile uint64_t data;
+} TTSlot;
+
+typedef struct
+{
+    TTSlot slots[TT_ENTRIES_PER_BUCKET];
+} TTBucket;
+
+typedef struct
+{
+    TTBucket* buckets;
+    /* A power of two */
+    uint64_t num_buckets;
+    size_t size;
+    uint32_t generation;
+    bool huge_pages;
+} TranspositionTable;
+
+/* Allocates the largest power of two number of buckets fitting in size_mb megabytes */
+CCHESS_API bool tt_init(TranspositionTable* tt, const size_t size_mb);
+
+CCHESS_API void tt_release(TranspositionTable* tt);
+
+/* Parallel clear of the entries */
+CCHESS_API void tt_clear(TranspositionTable* tt);
+
+/* Starts a new generation, called once per search before the threads start */
+CCHESS_API void tt_new_search(TranspositionTable* tt);
+
+CCHESS_FORCE_INLINE TTBucket* tt_get_bucket(const TranspositionTable* tt, const uint64_t key)
+{
+    return tt->buckets + (key & (tt->num_buckets - 1));
+}
+
+/* Returns false if the position is not stored */
+CCHESS_API bool tt_probe(const TranspositionTable* tt, const uint64_t key, TTEntry* entry);
+
+CCHESS_API void tt_store(TranspositionTable* tt,
+                         const uint64_t key,
+                         const Move move,
+                         const int32_t score,
+                         const int32_t eval,
+                         const uint32_t depth,
+                         const TTBound bound);
+
+/* Permille of the entries written by the current search, sampled on the first buckets */
+CCHESS_API uint32_t tt_hashfull(const TranspositionTable* tt);
+
+#endif /* !defined(__TT) */
@@ -0,0 +1,64 @@
+#pragma once
+
+#if !defined(__ZOBRIST)
+#define __ZOBRIST
+
+#include "cchess/board.h"
+
+/*
+    Zobrist hashing of positions. Keys are xored for every piece on its
+    square, the castling rights, the en passant file when a pawn of the side
+    to play stands next to the pawn pushed two squares (pins aside, like
+    Polyglot) and the side to play. The random keys are generated from a
+    fixed seed in zobrist_init (called by move_gen_init), so hashes are
+    stable across runs and platforms
+*/
+
+/* Indexed by piece * 2 + side and square, filled by zobrist_init */
+CCHESS_API extern uint64_t zobrist_piece_keys[12][64];
+/* Indexed by the castling rights of the state */
+CCHESS_API extern uint64_t zobrist_castling_keys[16];
+CCHESS_API extern uint64_t zobrist_en_passant_keys[8];
+CCHESS_API extern uint64_t zobrist_side_key;
+
+CCHESS_FORCE_INLINE uint64_t zobrist_get_piece_key(const uint32_t piece, const uint32_t side, const uint32_t square)
+{
+    return zobrist_piece_keys[piece * 2 + side][square];
+}
+
+/*
+    Whether the en passant file is keyed. Without a pawn to capture, the
+    position is the one it would be without the en passant square
+*/
+CCHESS_FORCE_INLINE bool zobrist_has_en_passant_key(const Board* board)
+{
+    if(!BOARD_PTR_HAS_EN_PASSANT(board))
+    {
+        return false;
+    }
+
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint32_t file = BOARD_PTR_GET_EN_PASSANT_FILE(board);
+    const uint32_t pushed_square = file + (side == PIECE_WHITE ? 32 : 24);
+
+    const uint64_t neighbours = (file > 0 ? BIT64(pushed_square - 1) : 0ULL) | (file < 7 ? BIT64(pushed_square + 1) : 0ULL);
+
+    return (board_get_pawns(board, side) & neighbours) != 0ULL;
+}
+
+CCHESS_API void zobrist_init(void);
+
+/* Full computation of the key, board_make_move keeps Board.key up to date instead */
+CCHESS_API uint64_t zobrist_hash_board(const Board* board);
+
+/*
+    Cuckoo table of the reversible moves, built in zobrist_init: for every
+    knight, bishop, rook, queen and king move of both sides between two
+    squares of an empty board, the xor of the keys of the piece on both
+    squares and of the side. Two positions whose keys differ by one of them
+    are that move apart, when nothing stands between the squares. Returns
+    true with the squares of the move, in any order, if the key is one
+*/
+CCHESS_API bool zobrist_cuckoo_find(const uint64_t move_key, uint32_t* square_a, uint32_t* square_b);
+
+#endif /* !defined(__ZOBRIST) */
@@ -1,51 +1,28 @@
 #include "cchess/board.h"
+#include "cchess/notation.h"
 #include "cchess/char_utils.h"
 #include "cchess/board_macros.h"
+#include "cchess/eval.h"
+#include "cchess/zobrist.h"
+#include "cchess/move_stack.h"
 
 #include <stdio.h>
 #include <string.h>
 
-#define BOARD_INIT_GROUPED_MASKS(board) \
-    board.whites = 0ULL;                \
-    board.whites |= board.pawns[0];     \
-    board.whites |= board.knights[0];   \
-    board.whites |= board.bishops[0];   \
-    board.whites |= board.rooks[0];     \
-    board.whites |= board.queens[0];    \
-    board.whites |= board.kings[0];     \
-    board.blacks = 0ULL;                \
-    board.blacks |= board.pawns[1];     \
-    board.blacks |= board.knights[1];   \
-    board.blacks |= board.bishops[1];   \
-    board.blacks |= board.rooks[1];     \
-    board.blacks |= board.queens[1];    \
-    board.blacks |= board.kings[1];     \
-    board.all = (board.whites | board.blacks)
-
 Board board_init()
 {
     Board b;
     memset(&b, 0, sizeof(b));
 
-    b.pawns[0] |= RANK2;
-    b.pawns[1] |= RANK7;
-
-    b.knights[0] |= INITIAL_WHITE_KNIGHTS;
-    b.knights[1] |= INITIAL_BLACK_KNIGHTS;
-
-    b.bishops[0] |= INITIAL_WHITE_BISHOPS;
-    b.bishops[1] |= INITIAL_BLACK_BISHOPS;
-
-    b.rooks[0] |= INITIAL_WHITE_ROOKS;
-    b.rooks[1] |= INITIAL_BLACK_ROOKS;
+    b.pieces[Piece_Pawn] = RANK2 | RANK7;
+    b.pieces[Piece_Knight] = INITIAL_WHITE_KNIGHTS | INITIAL_BLACK_KNIGHTS;
+    b.pieces[Piece_Bishop] = INITIAL_WHITE_BISHOPS | INITIAL_BLACK_BISHOPS;
+    b.pieces[Piece_Rook] = INITIAL_WHITE_ROOKS | INITIAL_BLACK_ROOKS;
+    b.pieces[Piece_Queen] = INITIAL_WHITE_QUEEN | INITIAL_BLACK_QUEEN;
+    b.pieces[Piece_King] = INITIAL_WHITE_KING | INITIAL_BLACK_KING;
 
-    b.queens[0] |= INITIAL_WHITE_QUEEN;
-    b.queens[1] |= INITIAL_BLACK_QUEEN;
-
-    b.kings[0] |= INITIAL_WHITE_KING;
-    b.kings[1] |= INITIAL_BLACK_KING;
-
-    BOARD_INIT_GROUPED_MASKS(b);
+    b.sides[PIECE_WHITE] = RANK1 | RANK2;
+    b.sides[PIECE_BLACK] = RANK7 | RANK8;
 
     b.state |= BoardState_WhiteKingSideCastleAvailable;
     b.state |= BoardState_WhiteQueenSideCastleAvailable;
@@ -53,348 +30,1453 @@ Board board_init()
     b.state |= BoardState_BlackQueenSideCastleAvailable;
     b.state |= BoardState_WhiteToPlay;
 
-    return b;
+    b.fullmove_number = 1;
+
+    board_init_derived(&b);
+
+    return b;
+}
+
+void board_init_derived(Board* board)
+{
+    eval_init_board(board);
+
+    board->key = zobrist_hash_board(board);
+}
+
+/* 
+    FEN lookup tables, indexed by character. Pieces map to their bitboard 
+    index + 1, other characters to 0. Board characters also map to the 
+    number of squares they advance the parsing cursor by
+*/
+
+static const uint8_t _fen_piece_lookup[256] = {
+    ['P'] = 1, ['p'] = 2,
+    ['N'] = 3, ['n'] = 4,
+    ['B'] = 5, ['b'] = 6,
+    ['R'] = 7, ['r'] = 8,
+    ['Q'] = 9, ['q'] = 10,
+    ['K'] = 11, ['k'] = 12,
+};
+
+static const int8_t _fen_square_advance[256] = {
+    ['P'] = 1, ['p'] = 1,
+    ['N'] = 1, ['n'] = 1,
+    ['B'] = 1, ['b'] = 1,
+    ['R'] = 1, ['r'] = 1,
+    ['Q'] = 1, ['q'] = 1,
+    ['K'] = 1, ['k'] = 1,
+    ['1'] = 1, ['2'] = 2, ['3'] = 3, ['4'] = 4,
+    ['5'] = 5, ['6'] = 6, ['7'] = 7, ['8'] = 8,
+    ['/'] = -16,
+};
+
+static const uint8_t _fen_castling_lookup[256] = {
+    ['K'] = BoardState_WhiteKingSideCastleAvailable,
+    ['Q'] = BoardState_WhiteQueenSideCastleAvailable,
+    ['k'] = BoardState_BlackKingSideCastleAvailable,
+    ['q'] = BoardState_BlackQueenSideCastleAvailable,
+};
+
+CCHESS_FORCE_INLINE const char* board_parse_fen_counter(const char* s, uint16_t* counter)
+{
+    uint32_t value = 0;
+
+    while(is_digit((unsigned char)*s))
+    {
+        value = value * 10 + to_digit((unsigned char)*s);
+        s++;
+    }
+
+    *counter = (uint16_t)(value > UINT16_MAX ? UINT16_MAX : value);
+
+    return s;
+}
+
+size_t board_parse_fen(Board* board, const char* fen)
+{
+    memset(board, 0, sizeof(Board));
+
+    /* The first bitboard absorbs the writes of the non-piece characters */
+    uint64_t bitboards[13] = { 0 };
+
+    const char* s = fen;
+
+    uint32_t square = 56;
+
+    /* Squares of the current rank, each rank has exactly 8 */
+    uint32_t rank_squares = 0;
+
+    while(_fen_square_advance[(unsigned char)*s] != 0)
+    {
+        const unsigned char c = (unsigned char)*s;
+
+        if(c == '/')
+        {
+            if(rank_squares != 8)
+            {
+                return 0;
+            }
+
+            rank_squares = 0;
+        }
+        else
+        {
+            rank_squares += (uint32_t)_fen_square_advance[c];
+
+            if(rank_squares > 8)
+            {
+                return 0;
+            }
+        }
+
+        bitboards[_fen_piece_lookup[c]] |= BIT64(square & 63);
+
+        square += _fen_square_advance[c];
+
+        if(square > 64)
+        {
+            return 0;
+        }
+
+        s++;
+    }
+
+    if(square != 8 || rank_squares != 8)
+    {
+        return 0;
+    }
+
+    for(uint32_t i = 0; i < 12; i++)
+    {
+        board->pieces[i / 2] |= bitboards[i + 1];
+        board->sides[i % 2] |= bitboards[i + 1];
+    }
+
+    if(popcount_u64(board_get_king(board, PIECE_WHITE)) != 1 || popcount_u64(board_get_king(board, PIECE_BLACK)) != 1)
+    {
+        return 0;
+    }
+
+    if(s[0] != ' ' || (s[1] != 'w' && s[1] != 'b') || s[2] != ' ')
+    {
+        return 0;
+    }
+
+    board->state |= s[1] == 'w' ? BoardState_WhiteToPlay : 0;
+
+    s += 3;
+
+    if(*s == '-')
+    {
+        s++;
+    }
+    else
+    {
+        const char* castling_start = s;
+
+        while(_fen_castling_lookup[(unsigned char)*s])
+        {
+            board->state |= _fen_castling_lookup[(unsigned char)*s];
+            s++;
+        }
+
+        if(s == castling_start)
+        {
+            return 0;
+        }
+    }
+
+    if(*s != ' ')
+    {
+        return 0;
+    }
+
+    s++;
+
+    if(*s == '-')
+    {
+        s++;
+    }
+    else
+    {
+        const uint32_t file = (uint32_t)(*s - 'a');
+
+        /* The square behind the pawn that just moved, so the rank depends on the side to play */
+        const char rank = board->state & BoardState_WhiteToPlay ? '6' : '3';
+
+        if(file > 7 || s[1] != rank)
+        {
+            return 0;
+        }
+
+        BOARD_PTR_SET_EN_PASSANT_FILE(board, file);
+
+        s += 2;
+    }
+
+    board->fullmove_number = 1;
+
+    /* Optional move counters, EPD records stop before them */
+    if(s[0] == ' ' && is_digit((unsigned char)s[1]))
+    {
+        s = board_parse_fen_counter(s + 1, &board->halfmove_clock);
+
+        if(s[0] == ' ' && is_digit((unsigned char)s[1]))
+        {
+            s = board_parse_fen_counter(s + 1, &board->fullmove_number);
+        }
+    }
+
+    board_init_derived(board);
+
+    return (size_t)(s - fen);
+}
+
+Board board_from_fen(const char* fen)
+{
+    Board b;
+
+    board_parse_fen(&b, fen);
+
+    return b;
+}
+
+#define PIECES_STRING ("PpNnBbRrQqKk")
+
+CCHESS_FORCE_INLINE char* board_write_fen_counter(char* s, uint32_t counter)
+{
+    char digits[5];
+    uint32_t num_digits = 0;
+
+    do
+    {
+        digits[num_digits++] = (char)('0' + counter % 10);
+        counter /= 10;
+    } while(counter > 0);
+
+    while(num_digits > 0)
+    {
+        *s++ = digits[--num_digits];
+    }
+
+    return s;
+}
+
+size_t board_to_fen(Board* board, char* fen)
+{
+    char mailbox[64];
+    memset(mailbox, 0, sizeof(mailbox));
+
+    for(uint32_t i = 0; i < 12; i++)
+    {
+        uint64_t b = board_get_pieces(board, i / 2, i % 2);
+
+        while(b)
+        {
+            mailbox[ctz_u64(b)] = PIECES_STRING[i];
+            b = clsb_u64(b);
+        }
+    }
+
+    char* s = fen;
+
+    for(int32_t rank = 7; rank >= 0; rank--)
+    {
+        uint32_t empty = 0;
+
+        for(uint32_t file = 0; file < 8; file++)
+        {
+            const char c = mailbox[rank * 8 + file];
+
+            if(c == 0)
+            {
+                empty++;
+                continue;
+            }
+
+            if(empty > 0)
+            {
+                *s++ = (char)('0' + empty);
+                empty = 0;
+            }
+
+            *s++ = c;
+        }
+
+        if(empty > 0)
+        {
+            *s++ = (char)('0' + empty);
+        }
+
+        *s++ = rank > 0 ? '/' : ' ';
+    }
+
+    *s++ = board->state & BoardState_WhiteToPlay ? 'w' : 'b';
+    *s++ = ' ';
+
+    if((board->state & BOARD_STATE_CASTLE_MASK) == 0)
+    {
+        *s++ = '-';
+    }
+    else
+    {
+        if(board->state & BoardState_WhiteKingSideCastleAvailable) *s++ = 'K';
+        if(board->state & BoardState_WhiteQueenSideCastleAvailable) *s++ = 'Q';
+        if(board->state & BoardState_BlackKingSideCastleAvailable) *s++ = 'k';
+        if(board->state & BoardState_BlackQueenSideCastleAvailable) *s++ = 'q';
+    }
+
+    *s++ = ' ';
+
+    if(BOARD_PTR_HAS_EN_PASSANT(board))
+    {
+        const uint32_t en_passant_square = BOARD_PTR_GET_EN_PASSANT_SQUARE(board);
+
+        *s++ = (char)('a' + BOARD_FILE_FROM_POS(en_passant_square));
+        *s++ = (char)('1' + BOARD_RANK_FROM_POS(en_passant_square));
+    }
+    else
+    {
+        *s++ = '-';
+    }
+
+    *s++ = ' ';
+    s = board_write_fen_counter(s, board->halfmove_clock);
+    *s++ = ' ';
+    s = board_write_fen_counter(s, board->fullmove_number);
+    *s = '\0';
+
+    return (size_t)(s - fen);
+}
+
+/* Moves */
+
+move_gen_func __move_gen_funcs[6] = {
+    move_gen_pawn,
+    move_gen_knight,
+    move_gen_bishop,
+    move_gen_rook,
+    move_gen_queen,
+    move_gen_king
+};
+
+CCHESS_FORCE_INLINE uint64_t board_piece_attacks(const uint32_t piece,
+                                                 const uint32_t square,
+                                                 const uint32_t side,
+                                                 const uint64_t occupancy)
+{
+    switch(piece)
+    {
+        case Piece_Pawn:
+            return move_gen_pawn_attacks(square, side);
+        case Piece_Knight:
+            return move_gen_knight_attacks(square);
+        case Piece_Bishop:
+            return move_gen_bishop_attacks(square, occupancy);
+        case Piece_Rook:
+            return move_gen_rook_attacks(square, occupancy);
+        case Piece_Queen:
+            return move_gen_queen_attacks(square, occupancy);
+        case Piece_King:
+            return move_gen_king_attacks(square);
+        default:
+            return 0ULL;
+    }
+}
+
+uint64_t board_get_move_mask_all_pieces(Board* board, const uint32_t side)
+{
+    const uint64_t pieces_white = BOARD_PTR_GET_WHITE_PIECES(board);
+    const uint64_t pieces_black = BOARD_PTR_GET_BLACK_PIECES(board);
+
+    uint64_t mask = 0;
+
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        uint64_t pieces = board_get_pieces(board, i, side);
+
+        while(pieces > 0)
+        {
+            const uint32_t square = ctz_u64(pieces);
+
+            mask |= __move_gen_funcs[i](square, side, pieces_white, pieces_black);
+
+            UNSET_BIT(pieces, BIT64(square));
+        }
+    }
+
+    return mask;
+}
+
+void board_get_white_moves(Board* board, Move* moves, size_t* moves_count)
+{
+    *moves_count = 0;
+
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        uint64_t b = board_get_pieces(board, i, SIDE_TO_PLAY_WHITE);
+
+        const uint32_t piece = i;
+        const uint32_t side = SIDE_TO_PLAY_WHITE;
+
+        MOVE_SET_PIECE(moves[*moves_count], piece);
+
+        const uint64_t num_pieces = popcount_u64(b);
+
+        for(uint32_t j = 0; j < num_pieces; j++)
+        {
+            const uint32_t from_square = ctz_u64(b);
+
+            uint64_t move_mask = __move_gen_funcs[piece](from_square,
+                                                         side,
+                                                         board->sides[PIECE_WHITE],
+                                                         board->sides[PIECE_BLACK]);
+
+            const uint64_t num_moves = popcount_u64(move_mask);
+
+            while(move_mask)
+            {
+                const uint32_t to_square = ctz_u64(move_mask);
+
+                MOVE_SET_FROM_SQUARE(moves[*moves_count], from_square);
+                MOVE_SET_TO_SQUARE(moves[*moves_count], to_square);
+
+                MOVE_SET_IS_CAPTURING(moves[*moves_count], BIT64(to_square) & board->sides[PIECE_BLACK]);
+
+                (*moves_count)++;
+
+                UNSET_BIT(move_mask, BIT64(to_square));
+            }
+
+            UNSET_BIT(b, BIT64(from_square));
+        }
+    }
+}
+
+void board_get_black_moves(Board* board, Move* moves, size_t* moves_count)
+{
+    *moves_count = 0;
+
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        uint64_t b = board_get_pieces(board, i, SIDE_TO_PLAY_BLACK);
+
+        const uint32_t piece = i;
+        const uint32_t side = SIDE_TO_PLAY_BLACK;
+
+        MOVE_SET_PIECE(moves[*moves_count], piece);
+
+        const uint64_t num_pieces = popcount_u64(b);
+
+        for(uint32_t j = 0; j < num_pieces; j++)
+        {
+            const uint32_t from_square = ctz_u64(b);
+
+            uint64_t move_mask = __move_gen_funcs[piece](from_square,
+                                                         side,
+                                                         board->sides[PIECE_WHITE],
+                                                         board->sides[PIECE_BLACK]);
+
+            const uint64_t num_moves = popcount_u64(move_mask);
+
+            while(move_mask)
+            {
+                const uint32_t to_square = ctz_u64(move_mask);
+
+                MOVE_SET_FROM_SQUARE(moves[*moves_count], from_square);
+                MOVE_SET_TO_SQUARE(moves[*moves_count], to_square);
+
+                MOVE_SET_IS_CAPTURING(moves[*moves_count], BIT64(to_square) & board->sides[PIECE_WHITE]);
+
+                (*moves_count)++;
+
+                UNSET_BIT(move_mask, BIT64(to_square));
+            }
+
+            UNSET_BIT(b, BIT64(from_square));
+        }
+    }
+}
+
+typedef void (*get_moves_func)(Board*, Move*, size_t*);
+
+get_moves_func moves_func[2] = {
+    board_get_white_moves,
+    board_get_black_moves
+};
+
+void board_get_moves(Board* board, Move* moves, size_t* moves_count)
+{
+    *moves_count = 0;
+
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    moves_func[side](board, moves, moves_count);
+}
+
+static CCHESS_FORCE_INLINE void board_push_moves(Move* moves,
+                                                 size_t* moves_count,
+                                                 const uint32_t piece,
+                                                 const uint32_t from_square,
+                                                 uint64_t targets,
+                                                 const uint64_t enemy_pieces)
+{
+    while(targets)
+    {
+        const uint32_t to_square = (uint32_t)ctz_u64(targets);
+
+        MOVE_SET_FROM_SQUARE(moves[*moves_count], from_square);
+        MOVE_SET_TO_SQUARE(moves[*moves_count], to_square);
+        MOVE_SET_PIECE(moves[*moves_count], piece);
+        MOVE_SET_IS_CAPTURING(moves[*moves_count], (enemy_pieces & BIT64(to_square)) != 0ULL);
+
+        (*moves_count)++;
+
+        targets = clsb_u64(targets);
+    }
+}
+
+/* Pawn moves reaching the last rank are pushed once per promoted piece */
+static CCHESS_FORCE_INLINE void board_push_pawn_moves(Move* moves,
+                                                      size_t* moves_count,
+                                                      const uint32_t from_square,
+                                                      const uint64_t targets,
+                                                      const uint64_t enemy_pieces)
+{
+    const uint64_t last_ranks = RANK1 | RANK8;
+
+    board_push_moves(moves, moves_count, Piece_Pawn, from_square, targets & ~last_ranks, enemy_pieces);
+
+    for(uint32_t piece = Piece_Queen; piece >= Piece_Knight; piece--)
+    {
+        board_push_moves(moves, moves_count, piece, from_square, targets & last_ranks, enemy_pieces);
+    }
+}
+
+/*
+    Same approach as board_has_legal_move_with_checkers: king moves are
+    verified against the attackers with the king removed from the occupancy,
+    the other pieces are restricted to the capture/block mask of a single
+    checker and pinned pieces to the line of their pin. En passant is
+    verified on the resulting occupancy. With noisy_only, the moves are
+    restricted to captures, en passant and promotions
+*/
+static CCHESS_FORCE_INLINE void board_generate_legal_moves(Board* board,
+                                                           Move* moves,
+                                                           size_t* moves_count,
+                                                           const bool noisy_only)
+{
+    *moves_count = 0;
+
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint64_t king = board_get_king(board, side);
+    const uint32_t king_square = (uint32_t)ctz_u64(king);
+    const uint64_t own_pieces = board_get_side(board, side);
+    const uint64_t enemy_pieces = board_get_side(board, !side);
+    const uint64_t occupancy = board_get_all(board);
+    const uint64_t checkers = board_attackers_to(board, king_square, !side, occupancy);
+
+    /* Destinations of the moves of the pieces other than pawns */
+    const uint64_t allowed = noisy_only ? enemy_pieces : ~own_pieces;
+
+    uint64_t escapes = move_gen_king_attacks(king_square) & allowed;
+    uint64_t safe_escapes = 0ULL;
+
+    while(escapes)
+    {
+        const uint32_t to_square = (uint32_t)ctz_u64(escapes);
+
+        if(board_attackers_to(board, to_square, !side, occupancy ^ king) == 0ULL)
+        {
+            safe_escapes |= BIT64(to_square);
+        }
+
+        escapes = clsb_u64(escapes);
+    }
+
+    board_push_moves(moves, moves_count, Piece_King, king_square, safe_escapes, enemy_pieces);
+
+    if(clsb_u64(checkers) != 0ULL)
+    {
+        return;
+    }
+
+    if(!noisy_only && checkers == 0ULL && king_square == (side == PIECE_WHITE ? 4U : 60U))
+    {
+        const uint32_t king_side_flag = side == PIECE_WHITE ? BoardState_WhiteKingSideCastleAvailable :
+                                                              BoardState_BlackKingSideCastleAvailable;
+        const uint32_t queen_side_flag = side == PIECE_WHITE ? BoardState_WhiteQueenSideCastleAvailable :
+                                                               BoardState_BlackQueenSideCastleAvailable;
+
+        if((board->state & king_side_flag) &&
+           (board_get_rooks(board, side) & BIT64(king_square + 3)) &&
+           (occupancy & (BIT64(king_square + 1) | BIT64(king_square + 2))) == 0ULL &&
+           board_attackers_to(board, king_square + 1, !side, occupancy) == 0ULL &&
+           board_attackers_to(board, king_square + 2, !side, occupancy) == 0ULL)
+        {
+            board_push_moves(moves, moves_count, Piece_King, king_square, BIT64(king_square + 2), 0ULL);
+        }
+
+        if((board->state & queen_side_flag) &&
+           (board_get_rooks(board, side) & BIT64(king_square - 4)) &&
+           (occupancy & (BIT64(king_square - 1) | BIT64(king_square - 2) | BIT64(king_square - 3))) == 0ULL &&
+           board_attackers_to(board, king_square - 1, !side, occupancy) == 0ULL &&
+           board_attackers_to(board, king_square - 2, !side, occupancy) == 0ULL)
+        {
+            board_push_moves(moves, moves_count, Piece_King, king_square, BIT64(king_square - 2), 0ULL);
+        }
+    }
+
+    /* Capture or block of a single checker */
+    const uint64_t evasions = checkers ? (checkers | move_gen_between(king_square, (uint32_t)ctz_u64(checkers))) : ~0ULL;
+    const uint64_t targets = allowed & evasions;
+
+    const uint64_t pinned = board_get_pinned(board, side);
+
+    /* A pinned knight can never move */
+    uint64_t knights = board_get_knights(board, side) & ~pinned;
+
+    while(knights)
+    {
+        const uint32_t square = (uint32_t)ctz_u64(knights);
+
+        board_push_moves(moves, moves_count, Piece_Knight, square, move_gen_knight_attacks(square) & targets, enemy_pieces);
+
+        knights = clsb_u64(knights);
+    }
+
+    for(uint32_t piece = Piece_Bishop; piece <= Piece_Queen; piece++)
+    {
+        uint64_t sliders = board_get_pieces(board, piece, side);
+
+        while(sliders)
+        {
+            const uint32_t square = (uint32_t)ctz_u64(sliders);
+
+            uint64_t slider_moves = board_piece_attacks(piece, square, side, occupancy) & targets;
+
+            if(pinned & BIT64(square))
+            {
+                slider_moves &= move_gen_line(king_square, square);
+            }
+
+            board_push_moves(moves, moves_count, piece, square, slider_moves, enemy_pieces);
+
+            sliders = clsb_u64(sliders);
+        }
+    }
+
+    const uint64_t empty = ~occupancy;
+
+    uint64_t pawns = board_get_pawns(board, side);
+
+    while(pawns)
+    {
+        const uint32_t square = (uint32_t)ctz_u64(pawns);
+        const uint64_t pawn = BIT64(square);
+
+        const uint64_t single_push = (side == PIECE_WHITE ? pawn << 8 : pawn >> 8) & empty;
+        const uint64_t double_push = (side == PIECE_WHITE ? (single_push & RANK3) << 8 : (single_push & RANK6) >> 8) & empty;
+        const uint64_t captures = move_gen_pawn_attacks(square, side) & enemy_pieces;
+
+        /* Only the pushes promoting are noisy */
+        const uint64_t pushes = noisy_only ? single_push & (RANK1 | RANK8) : single_push | double_push;
+
+        uint64_t pawn_moves = (pushes | captures) & evasions;
+
+        if(pinned & pawn)
+        {
+            pawn_moves &= move_gen_line(king_square, square);
+        }
+
+        board_push_pawn_moves(moves, moves_count, square, pawn_moves, enemy_pieces);
+
+        pawns = clsb_u64(pawns);
+    }
+
+    if(BOARD_PTR_HAS_EN_PASSANT(board))
+    {
+        const uint32_t en_passant_square = BOARD_PTR_GET_EN_PASSANT_SQUARE(board);
+        const uint64_t captured = side == PIECE_WHITE ? BIT64(en_passant_square - 8) :
+                                                        BIT64(en_passant_square + 8);
+
+        uint64_t capturers = move_gen_pawn_attacks(en_passant_square, !side) & board_get_pawns(board, side);
+
+        while(capturers)
+        {
+            const uint32_t square = (uint32_t)ctz_u64(capturers);
+            const uint64_t occupancy_after = (occupancy ^ BIT64(square) ^ captured) | BIT64(en_passant_square);
+
+            if((board_attackers_to(board, king_square, !side, occupancy_after) & ~captured) == 0ULL)
+            {
+                board_push_moves(moves, moves_count, Piece_Pawn, square, BIT64(en_passant_square), BIT64(en_passant_square));
+            }
+
+            capturers = clsb_u64(capturers);
+        }
+    }
+}
+
+void board_get_legal_moves(Board* board, Move* moves, size_t* moves_count)
+{
+    board_generate_legal_moves(board, moves, moves_count, false);
+}
+
+void board_get_legal_noisy_moves(Board* board, Move* moves, size_t* moves_count)
+{
+    board_generate_legal_moves(board, moves, moves_count, true);
+}
+
+/* Castling rights kept when a piece moves from or to a square */
+
+#define CR_ALL (~(uint32_t)0)
+#define CR_WQ (~(uint32_t)BoardState_WhiteQueenSideCastleAvailable)
+#define CR_WK (~(uint32_t)BoardState_WhiteKingSideCastleAvailable)
+#define CR_W (CR_WQ & CR_WK)
+#define CR_BQ (~(uint32_t)BoardState_BlackQueenSideCastleAvailable)
+#define CR_BK (~(uint32_t)BoardState_BlackKingSideCastleAvailable)
+#define CR_B (CR_BQ & CR_BK)
+
+static const uint32_t _castling_rights_mask[64] = {
+    CR_WQ, CR_ALL, CR_ALL, CR_ALL, CR_W, CR_ALL, CR_ALL, CR_WK,
+    CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL,
+    CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL,
+    CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL,
+    CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL,
+    CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL,
+    CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL, CR_ALL,
+    CR_BQ, CR_ALL, CR_ALL, CR_ALL, CR_B, CR_ALL, CR_ALL, CR_BK,
+};
+
+/*
+    Special moves are deduced from the board: a pawn capturing on an empty
+    square takes en passant, a king moving two squares castles, and a pawn
+    move whose piece is not a pawn promotes to that piece
+*/
+uint32_t board_make_move(Board* board, const Move move)
+{
+    const uint32_t piece = MOVE_GET_PIECE(move);
+    const uint32_t from_square = MOVE_GET_FROM_SQUARE(move);
+    const uint32_t to_square = MOVE_GET_TO_SQUARE(move);
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    const uint64_t from_mask = BIT64(from_square);
+    const uint64_t to_mask = BIT64(to_square);
+
+    const bool is_pawn_move = (board_get_pawns(board, side) & from_mask) != 0ULL;
+    const bool is_capturing = (bool)MOVE_GET_IS_CAPTURING(move);
+
+    /* The piece leaving the origin square, a promotion only sets the promoted piece on the destination */
+    const uint32_t moving_piece = is_pawn_move ? Piece_Pawn : piece;
+
+    /* The castling rights and en passant file are keyed again once updated */
+    uint64_t key = board->key ^ zobrist_castling_keys[board->state & BOARD_STATE_CASTLE_MASK] ^ zobrist_side_key;
+
+    if(zobrist_has_en_passant_key(board))
+    {
+        key ^= zobrist_en_passant_keys[BOARD_PTR_GET_EN_PASSANT_FILE(board)];
+    }
+
+    if(is_capturing)
+    {
+        const bool is_en_passant = is_pawn_move && (board->sides[!side] & to_mask) == 0ULL;
+
+        const uint32_t captured_square = is_en_passant ? (side == PIECE_WHITE ? to_square - 8 : to_square + 8) : to_square;
+        const uint64_t captured_mask = BIT64(captured_square);
+        const uint32_t captured_piece = board_get_piece_on(board, captured_square, !side);
+
+        eval_remove_piece(board, captured_piece, !side, captured_square);
+
+        board->pieces[captured_piece] ^= captured_mask;
+        board->sides[!side] ^= captured_mask;
+
+        key ^= zobrist_get_piece_key(captured_piece, !side, captured_square);
+    }
+
+    board->pieces[moving_piece] ^= from_mask;
+    board->pieces[piece] |= to_mask;
+    board->sides[side] ^= from_mask | to_mask;
+
+    key ^= zobrist_get_piece_key(moving_piece, side, from_square) ^ zobrist_get_piece_key(piece, side, to_square);
+
+    if(moving_piece != piece)
+    {
+        eval_remove_piece(board, Piece_Pawn, side, from_square);
+        eval_add_piece(board, piece, side, to_square);
+    }
+    else
+    {
+        eval_move_piece(board, piece, side, from_square, to_square);
+    }
+
+    if(piece == Piece_King && (to_square == from_square + 2 || from_square == to_square + 2))
+    {
+        const uint32_t rook_from_square = to_square > from_square ? from_square + 3 : from_square - 4;
+        const uint32_t rook_to_square = to_square > from_square ? from_square + 1 : from_square - 1;
+        const uint64_t rook_mask = BIT64(rook_from_square) | BIT64(rook_to_square);
+
+        board->pieces[Piece_Rook] ^= rook_mask;
+        board->sides[side] ^= rook_mask;
+
+        key ^= zobrist_get_piece_key(Piece_Rook, side, rook_from_square) ^ zobrist_get_piece_key(Piece_Rook, side, rook_to_square);
+
+        eval_move_piece(board, Piece_Rook, side, rook_from_square, rook_to_square);
+    }
+
+    BOARD_PTR_CLEAR_EN_PASSANT(board);
+
+    if(is_pawn_move && (from_square ^ to_square) == 16)
+    {
+        BOARD_PTR_SET_EN_PASSANT_FILE(board, BOARD_FILE_FROM_POS(from_square));
+    }
+
+    board->state &= _castling_rights_mask[from_square] & _castling_rights_mask[to_square];
+
+    board->key = key ^ zobrist_castling_keys[board->state & BOARD_STATE_CASTLE_MASK];
+
+    board->halfmove_clock = (is_pawn_move || is_capturing) ? 0 : board->halfmove_clock + 1;
+    board->fullmove_number += side;
+
+    BOARD_TOGGLE_SIDE_TO_PLAY(*board);
+
+    /* Keyed once the pawns that could capture are those of the side to play */
+    if(zobrist_has_en_passant_key(board))
+    {
+        board->key ^= zobrist_en_passant_keys[BOARD_PTR_GET_EN_PASSANT_FILE(board)];
+    }
+
+#if CCHESS_DEBUG
+    CCHESS_ASSERT(eval_board_is_valid(board));
+    CCHESS_ASSERT(board->key == zobrist_hash_board(board));
+#endif /* CCHESS_DEBUG */
+
+    return 0;
+}
+
+void board_make_null_move(Board* board)
+{
+    if(zobrist_has_en_passant_key(board))
+    {
+        board->key ^= zobrist_en_passant_keys[BOARD_PTR_GET_EN_PASSANT_FILE(board)];
+    }
+
+    board->key ^= zobrist_side_key;
+
+    BOARD_PTR_CLEAR_EN_PASSANT(board);
+    BOARD_PTR_TOGGLE_SIDE_TO_PLAY(board);
+
+    board->halfmove_clock++;
+}
+
+bool board_move_is_legal(Board* board, const Move move)
+{
+    const uint32_t piece = MOVE_GET_PIECE(move);
+    const uint32_t from_square = MOVE_GET_FROM_SQUARE(move);
+    const uint32_t to_square = MOVE_GET_TO_SQUARE(move);
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    const uint32_t moving_piece = board_get_piece_on(board, from_square, side);
+
+    if(moving_piece == Piece_None)
+    {
+        return false;
+    }
+
+    const uint64_t own_pieces = board_get_side(board, side);
+    const uint64_t enemy_pieces = board_get_side(board, !side);
+    const uint64_t occupancy = board_get_all(board);
+    const uint64_t to_mask = BIT64(to_square);
+
+    const uint32_t last_rank = side == PIECE_WHITE ? 7 : 0;
+    const bool reaches_last_rank = moving_piece == Piece_Pawn && BOARD_RANK_FROM_POS(to_square) == last_rank;
+
+    if(reaches_last_rank ? (piece < Piece_Knight || piece > Piece_Queen) : (piece != moving_piece))
+    {
+        return false;
+    }
+
+    uint64_t en_passant_mask = 0ULL;
+
+    if(BOARD_PTR_HAS_EN_PASSANT(board))
+    {
+        en_passant_mask = BIT64(BOARD_PTR_GET_EN_PASSANT_SQUARE(board));
+    }
+
+    uint64_t targets = 0ULL;
+
+    switch(moving_piece)
+    {
+        case Piece_Pawn:
+        {
+            const uint64_t single_push = (side == PIECE_WHITE ? BIT64(from_square) << 8 : BIT64(from_square) >> 8) & ~occupancy;
+            const uint64_t double_push = (side == PIECE_WHITE ? (single_push & RANK3) << 8 : (single_push & RANK6) >> 8) & ~occupancy;
+            const uint64_t captures = move_gen_pawn_attacks(from_square, side) & (enemy_pieces | en_passant_mask);
+
+            targets = single_push | double_push | captures;
+            break;
+        }
+        case Piece_King:
+        {
+            targets = move_gen_king_attacks(from_square) & ~own_pieces;
+
+            const uint32_t king_square = side == PIECE_WHITE ? 4 : 60;
+            const uint32_t king_side_flag = side == PIECE_WHITE ? BoardState_WhiteKingSideCastleAvailable :
+                                                                  BoardState_BlackKingSideCastleAvailable;
+            const uint32_t queen_side_flag = side == PIECE_WHITE ? BoardState_WhiteQueenSideCastleAvailable :
+                                                                   BoardState_BlackQueenSideCastleAvailable;
+
+            /* The destination square itself is verified with the other moves below */
+            if(from_square == king_square &&
+               (board->state & king_side_flag) &&
+               (board_get_rooks(board, side) & BIT64(king_square + 3)) &&
+               (occupancy & (BIT64(king_square + 1) | BIT64(king_square + 2))) == 0ULL &&
+               board_attackers_to(board, king_square, !side, occupancy) == 0ULL &&
+               board_attackers_to(board, king_square + 1, !side, occupancy) == 0ULL)
+            {
+                targets |= BIT64(king_square + 2);
+            }
+
+            if(from_square == king_square &&
+               (board->state & queen_side_flag) &&
+               (board_get_rooks(board, side) & BIT64(king_square - 4)) &&
+               (occupancy & (BIT64(king_square - 1) | BIT64(king_square - 2) | BIT64(king_square - 3))) == 0ULL &&
+               board_attackers_to(board, king_square, !side, occupancy) == 0ULL &&
+               board_attackers_to(board, king_square - 1, !side, occupancy) == 0ULL)
+            {
+                targets |= BIT64(king_square - 2);
+            }
+
+            break;
+        }
+        default:
+            targets = board_piece_attacks(moving_piece, from_square, side, occupancy) & ~own_pieces;
+            break;
+    }
+
+    if((targets & to_mask) == 0ULL)
+    {
+        return false;
+    }
+
+    const bool is_capturing = (enemy_pieces & to_mask) || (moving_piece == Piece_Pawn && (en_passant_mask & to_mask));
+
+    if(is_capturing != (bool)MOVE_GET_IS_CAPTURING(move))
+    {
+        return false;
+    }
+
+    Board after = *board;
+    board_make_move(&after, move);
+
+    return board_attackers_to(&after, (uint32_t)ctz_u64(board_get_king(&after, side)), !side, board_get_all(&after)) == 0ULL;
+}
+
+bool board_move_is_legal_algebraic(Board* board, const char* move)
+{
+    Move m;
+
+    return move_from_san(board, move, &m) && board_move_is_legal(board, m);
+}
+
+bool board_make_move_algebraic(Board* board, const char* move)
+{
+    Move m;
+
+    if(!move_from_san(board, move, &m) || !board_move_is_legal(board, m))
+    {
+        return false;
+    }
+
+    board_make_move(board, m);
+
+    return true;
+}
+
+bool board_has_check_from_last_move(Board* board, Move last_move)
+{
+    const uint64_t white_pieces = BOARD_PTR_GET_WHITE_PIECES(board);
+    const uint64_t black_pieces = BOARD_PTR_GET_BLACK_PIECES(board);
+
+    const uint32_t to_square = MOVE_GET_TO_SQUARE(last_move);
+    const uint32_t piece = MOVE_GET_PIECE(last_move);
+    const uint32_t side = BOARD_GET_SIDE_TO_PLAY(*board);
+
+    const uint64_t new_move_mask = __move_gen_funcs[piece](to_square,
+                                                           side,
+                                                           white_pieces,
+                                                           black_pieces);
+
+    const uint64_t king_mask = board_get_king(board, !side);
+
+    return new_move_mask & king_mask;
+}
+
+uint64_t board_attackers_to(Board* board,
+                            const uint32_t square,
+                            const uint32_t side,
+                            const uint64_t occupancy)
+{
+    const uint64_t diagonal_sliders = board_get_bishops(board, side) | board_get_queens(board, side);
+    const uint64_t straight_sliders = board_get_rooks(board, side) | board_get_queens(board, side);
+
+    return (move_gen_pawn_attacks(square, !side) & board_get_pawns(board, side)) |
+           (move_gen_knight_attacks(square) & board_get_knights(board, side)) |
+           (move_gen_bishop_attacks(square, occupancy) & diagonal_sliders) |
+           (move_gen_rook_attacks(square, occupancy) & straight_sliders) |
+           (move_gen_king_attacks(square) & board_get_king(board, side));
+}
+
+uint64_t board_get_checkers(Board* board)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint32_t king_square = (uint32_t)ctz_u64(board_get_king(board, side));
+
+    return board_attackers_to(board, king_square, !side, board_get_all(board));
+}
+
+/* Pieces of blockers_side alone between the king on king_square and a slider of sliders_side */
+static inline uint64_t board_get_line_blockers(Board* board,
+                                               const uint32_t king_square,
+                                               const uint32_t sliders_side,
+                                               const uint32_t blockers_side)
+{
+    /* Sliders that would attack the king on an empty board */
+    uint64_t snipers = (move_gen_bishop_attacks(king_square, 0ULL) & (board_get_bishops(board, sliders_side) | board_get_queens(board, sliders_side))) |
+                       (move_gen_rook_attacks(king_square, 0ULL) & (board_get_rooks(board, sliders_side) | board_get_queens(board, sliders_side)));
+
+    uint64_t line_blockers = 0ULL;
+
+    while(snipers)
+    {
+        const uint32_t sniper_square = (uint32_t)ctz_u64(snipers);
+        const uint64_t blockers = move_gen_between(king_square, sniper_square) & board_get_all(board);
+
+        if(blockers != 0ULL && clsb_u64(blockers) == 0ULL)
+        {
+            line_blockers |= blockers & board_get_side(board, blockers_side);
+        }
+
+        snipers = clsb_u64(snipers);
+    }
+
+    return line_blockers;
 }
 
-#define ASCII_OFFSET 65  
-#define PIECE_LOOKUP_SIZE 57
-
-const int8_t __fen_to_piece[PIECE_LOOKUP_SIZE] = {
-    ['P' - ASCII_OFFSET] = (Piece_Pawn + 1),
-    ['N' - ASCII_OFFSET] = (Piece_Knight + 1),
-    ['B' - ASCII_OFFSET] = (Piece_Bishop + 1),
-    ['R' - ASCII_OFFSET] = (Piece_Rook + 1),
-    ['Q' - ASCII_OFFSET] = (Piece_Queen + 1),
-    ['K' - ASCII_OFFSET] = (Piece_King + 1),
-    ['p' - ASCII_OFFSET] = -(Piece_Pawn + 1),
-    ['n' - ASCII_OFFSET] = -(Piece_Knight + 1),
-    ['b' - ASCII_OFFSET] = -(Piece_Bishop + 1),
-    ['r' - ASCII_OFFSET] = -(Piece_Rook + 1),
-    ['q' - ASCII_OFFSET] = -(Piece_Queen + 1),
-    ['k' - ASCII_OFFSET] = -(Piece_King + 1),
-};
+uint64_t board_get_pinned(Board* board, const uint32_t side)
+{
+    return board_get_line_blockers(board, (uint32_t)ctz_u64(board_get_king(board, side)), !side, side);
+}
 
-Board board_from_fen(const char* fen)
+/*
+    Whether a legal move of the side to play checks the enemy king, directly
+    from its destination or by uncovering a slider. discoverers are the own
+    pieces alone between an own slider and the enemy king. En passant and
+    castling, moving a second piece, are played to be verified
+*/
+CCHESS_FORCE_INLINE bool board_move_gives_check(Board* board,
+                                                const Move move,
+                                                const uint32_t king_square,
+                                                const uint64_t discoverers)
 {
-    Board b;
-    memset(&b, 0, sizeof(b));
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint32_t piece = MOVE_GET_PIECE(move);
+    const uint32_t from_square = MOVE_GET_FROM_SQUARE(move);
+    const uint32_t to_square = MOVE_GET_TO_SQUARE(move);
 
-    uint64_t* b_ptr = (uint64_t*)&b;
+    const uint64_t from_mask = BIT64(from_square);
+    const uint64_t to_mask = BIT64(to_square);
 
-    char* s = (char*)fen;
+    const bool is_en_passant = MOVE_GET_IS_CAPTURING(move) &&
+                               (board_get_pawns(board, side) & from_mask) != 0ULL &&
+                               (board_get_side(board, !side) & to_mask) == 0ULL;
+    const bool is_castling = piece == Piece_King && (to_square == from_square + 2 || from_square == to_square + 2);
+
+    if(is_en_passant || is_castling)
+    {
+        Board child = *board;
+        board_make_move(&child, move);
 
-    int32_t current_rank = 7;
-    int32_t current_file = 0;
+        return board_get_checkers(&child) != 0ULL;
+    }
 
-    while(*s != '\0')
+    if((discoverers & from_mask) != 0ULL && (move_gen_line(king_square, from_square) & to_mask) == 0ULL)
     {
-        if(*s == '/')
-        {
-            current_rank--;
-            current_file = 0;
+        return true;
+    }
 
-            goto end;
-        }
-        else if(is_letter(*s))
-        {
-            const int8_t piece = __fen_to_piece[*s - ASCII_OFFSET];
-            const int8_t side = (piece < 0 ? SIDE_TO_PLAY_BLACK : SIDE_TO_PLAY_WHITE);
-            const uint32_t piece_num = abs_u8(piece) - 1;
-            const uint32_t b_index = (piece_num + side) * 2 - side;
+    /* A promotion attacks as the promoted piece */
+    const uint64_t occupancy = (board_get_all(board) ^ from_mask) | to_mask;
 
-            BOARD_SET_BIT_FROM_FILE_RANK(b_ptr[b_index], current_file, current_rank);
-        }
-        else if(is_digit(*s))
-        {
-            const uint32_t d = to_digit(*s);
+    return (board_piece_attacks(piece, to_square, side, occupancy) & BIT64(king_square)) != 0ULL;
+}
 
-            current_file += d;
+void board_get_legal_checks(Board* board, Move* moves, size_t* moves_count)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint32_t king_square = (uint32_t)ctz_u64(board_get_king(board, !side));
+    const uint64_t discoverers = board_get_line_blockers(board, king_square, side, side);
 
-            goto end;
-        }
-        else if(*s == ' ')
-        {
-            while(*s != '\0')
-            {
-                switch (*s)
-                {
-                    case 'w':
-                        SET_BIT(b.state, BoardState_WhiteToPlay);
-                        break;
-                    case 'K':
-                        SET_BIT(b.state, BoardState_WhiteKingSideCastleAvailable);
-                        break;
-                    case 'Q':
-                        SET_BIT(b.state, BoardState_WhiteQueenSideCastleAvailable);
-                        break;
-                    case 'k':
-                        SET_BIT(b.state, BoardState_BlackKingSideCastleAvailable);
-                        break;
-                    case 'q':
-                        SET_BIT(b.state, BoardState_BlackQueenSideCastleAvailable);
-                        break;
-
-                    // TODO: en passant
-                    
-                    default:
-                        break;
-                }
+    size_t num_moves;
+    board_generate_legal_moves(board, moves, &num_moves, false);
 
-                s++;
-            }
+    *moves_count = 0;
 
-            break;
-        }
-        else
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        if(board_move_gives_check(board, moves[i], king_square, discoverers))
         {
-            break;
+            moves[(*moves_count)++] = moves[i];
         }
-
-        current_file++;
-
-end:
-        s++;
     }
-
-    BOARD_INIT_GROUPED_MASKS(b);
-
-    return b;
 }
 
-/* Moves */
+/* The king is never captured, its value only has to exceed any gain */
+#define BOARD_SEE_KING_VALUE 20000
 
-move_gen_func __move_gen_funcs[6] = {
-    move_gen_pawn,
-    move_gen_knight,
-    move_gen_bishop,
-    move_gen_rook,
-    move_gen_queen,
-    move_gen_king
-};
+/* Longest possible exchange on a square, 16 attackers per side */
+#define BOARD_SEE_MAX_SWAPS 32
 
-uint64_t board_get_move_mask_all_pieces(Board* board, const uint32_t side)
+CCHESS_FORCE_INLINE int32_t board_see_value(const uint32_t piece)
 {
-    const uint64_t pieces_white = BOARD_PTR_GET_WHITE_PIECES(board);
-    const uint64_t pieces_black = BOARD_PTR_GET_BLACK_PIECES(board);
+    return piece == Piece_King ? BOARD_SEE_KING_VALUE : (int32_t)eval_piece_values_mg[piece];
+}
 
-    uint64_t mask = 0;
+int32_t board_see(Board* board, const Move move)
+{
+    uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint32_t from_square = MOVE_GET_FROM_SQUARE(move);
+    const uint32_t to_square = MOVE_GET_TO_SQUARE(move);
 
-    uint64_t* board_as_ptr = (uint64_t*)board;
+    const bool is_promotion = MOVE_GET_PIECE(move) != Piece_Pawn && (board_get_pawns(board, side) & BIT64(from_square));
 
-    for(uint32_t i = 0; i < 6; i++)
+    uint64_t occupancy = board_get_all(board) ^ BIT64(from_square);
+
+    int32_t gains[BOARD_SEE_MAX_SWAPS];
+    gains[0] = 0;
+
+    if(MOVE_GET_IS_CAPTURING(move))
     {
-        uint64_t pieces = board_as_ptr[i * 2 + side];
+        const uint32_t victim = board_get_piece_on(board, to_square, !side);
 
-        while(pieces > 0)
+        /* En passant, the captured pawn leaves the square behind the destination */
+        if(victim == Piece_None)
         {
-            const uint32_t square = ctz_u64(pieces);
+            occupancy ^= BIT64(side == PIECE_WHITE ? to_square - 8 : to_square + 8);
+        }
 
-            mask |= __move_gen_funcs[i](square, side, pieces_white, pieces_black);
+        gains[0] = board_see_value(victim == Piece_None ? Piece_Pawn : victim);
+    }
 
-            UNSET_BIT(pieces, BIT64(square));
-        }
+    if(is_promotion)
+    {
+        gains[0] += board_see_value(MOVE_GET_PIECE(move)) - board_see_value(Piece_Pawn);
     }
 
-    return mask;
-}
+    /* Value of the piece standing on the square, the next one to be captured */
+    int32_t on_square = board_see_value(MOVE_GET_PIECE(move));
 
-void board_get_white_moves(Board* board, Move* moves, size_t* moves_count)
-{
-    *moves_count = 0;
+    const uint64_t diagonal_sliders = board_get_bishops(board, 0) | board_get_bishops(board, 1) | board_get_queens(board, 0) | board_get_queens(board, 1);
+    const uint64_t straight_sliders = board_get_rooks(board, 0) | board_get_rooks(board, 1) | board_get_queens(board, 0) | board_get_queens(board, 1);
 
-    for(uint32_t i = 0; i < 6; i++)
+    uint64_t attackers = (board_attackers_to(board, to_square, PIECE_WHITE, occupancy) |
+                          board_attackers_to(board, to_square, PIECE_BLACK, occupancy)) & occupancy;
+
+    uint32_t num_swaps = 0;
+
+    while(num_swaps + 1 < BOARD_SEE_MAX_SWAPS)
     {
-        const uint32_t b_index = i * 2;
+        side = !side;
 
-        uint64_t b = ((int64_t*)board)[b_index];
+        const uint64_t side_attackers = attackers & board_get_side(board, side);
 
-        const uint32_t piece = i;
-        const uint32_t side = SIDE_TO_PLAY_WHITE;
+        if(side_attackers == 0ULL)
+        {
+            break;
+        }
 
-        MOVE_SET_PIECE(moves[*moves_count], piece);
+        /* Least valuable attacker */
+        uint32_t piece = Piece_Pawn;
+        uint64_t piece_attackers = side_attackers & board_get_pawns(board, side);
 
-        const uint64_t num_pieces = popcount_u64(b);
+        while(piece_attackers == 0ULL)
+        {
+            piece++;
+            piece_attackers = side_attackers & board_get_pieces(board, piece, side);
+        }
 
-        for(uint32_t j = 0; j < num_pieces; j++)
+        /* The king cannot capture a defended piece */
+        if(piece == Piece_King && (attackers & board_get_side(board, !side)) != 0ULL)
         {
-            const uint32_t from_square = ctz_u64(b);
+            break;
+        }
 
-            uint64_t move_mask = __move_gen_funcs[piece](from_square,
-                                                         side,
-                                                         board->whites,
-                                                         board->blacks);
+        /* Balance for the side capturing, if the exchange stops there */
+        num_swaps++;
+        gains[num_swaps] = on_square - gains[num_swaps - 1];
 
-            const uint64_t num_moves = popcount_u64(move_mask);
+        on_square = board_see_value(piece);
+        occupancy ^= piece_attackers & (~piece_attackers + 1);
 
-            while(move_mask)
-            {
-                const uint32_t to_square = ctz_u64(move_mask);
+        /* Sliders behind the attacker, pawns and bishops uncovering diagonals and rooks files and ranks */
+        if(piece == Piece_Pawn || piece == Piece_Bishop || piece == Piece_Queen)
+        {
+            attackers |= move_gen_bishop_attacks(to_square, occupancy) & diagonal_sliders;
+        }
 
-                MOVE_SET_FROM_SQUARE(moves[*moves_count], from_square);
-                MOVE_SET_TO_SQUARE(moves[*moves_count], to_square);
+        if(piece == Piece_Rook || piece == Piece_Queen)
+        {
+            attackers |= move_gen_rook_attacks(to_square, occupancy) & straight_sliders;
+        }
 
-                MOVE_SET_IS_CAPTURING(moves[*moves_count], BIT64(to_square) & board->blacks);
+        attackers &= occupancy;
+    }
 
-                (*moves_count)++;
+    /* Going back, each side either stops or captures, whichever is better for it */
+    while(num_swaps > 0)
+    {
+        num_swaps--;
+        gains[num_swaps] = -(-gains[num_swaps] > gains[num_swaps + 1] ? -gains[num_swaps] : gains[num_swaps + 1]);
+    }
 
-                UNSET_BIT(move_mask, BIT64(to_square));
-            }
+    return gains[0];
+}
 
-            UNSET_BIT(b, BIT64(from_square));
-        }
-    }
+bool board_has_check(Board* board)
+{
+    return board_get_checkers(board) != 0ULL;
 }
 
-void board_get_black_moves(Board* board, Move* moves, size_t* moves_count)
+/* 
+    Looks for any legal move of the side to play, in the order that finds one
+    the fastest: king escapes (the only possible moves in double check), then
+    the other pieces restricted to the capture/block mask of a single checker,
+    pinned pieces being restricted to the line of their pin
+*/
+bool board_has_legal_move_with_checkers(Board* board, const uint64_t checkers)
 {
-    *moves_count = 0;
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint64_t king = board_get_king(board, side);
+    const uint32_t king_square = (uint32_t)ctz_u64(king);
+    const uint64_t own_pieces = board_get_side(board, side);
+    const uint64_t enemy_pieces = board_get_side(board, !side);
+    const uint64_t occupancy = board_get_all(board);
 
-    for(uint32_t i = 0; i < 6; i++)
+    /* The king is removed from the occupancy so it can't hide behind itself from a slider */
+    const uint64_t occupancy_without_king = occupancy ^ king;
+
+    uint64_t escapes = move_gen_king_attacks(king_square) & ~own_pieces;
+
+    while(escapes)
     {
-        const uint32_t b_index = i * 2 + 1;
+        const uint32_t to_square = (uint32_t)ctz_u64(escapes);
 
-        uint64_t b = ((int64_t*)board)[b_index];
+        if(board_attackers_to(board, to_square, !side, occupancy_without_king) == 0ULL)
+        {
+            return true;
+        }
 
-        const uint32_t piece = i;
-        const uint32_t side = SIDE_TO_PLAY_BLACK;
+        escapes = clsb_u64(escapes);
+    }
 
-        MOVE_SET_PIECE(moves[*moves_count], piece);
+    if(clsb_u64(checkers) != 0ULL)
+    {
+        return false;
+    }
 
-        const uint64_t num_pieces = popcount_u64(b);
+    const uint64_t targets = checkers ? (checkers | move_gen_between(king_square, (uint32_t)ctz_u64(checkers))) : 
+                                        ~own_pieces;
 
-        for(uint32_t j = 0; j < num_pieces; j++)
-        {
-            const uint32_t from_square = ctz_u64(b);
+    const uint64_t pinned = board_get_pinned(board, side);
 
-            uint64_t move_mask = __move_gen_funcs[piece](from_square,
-                                                         side,
-                                                         board->whites,
-                                                         board->blacks);
+    /* A pinned knight can never move */
+    uint64_t knights = board_get_knights(board, side) & ~pinned;
 
-            const uint64_t num_moves = popcount_u64(move_mask);
+    while(knights)
+    {
+        if(move_gen_knight_attacks((uint32_t)ctz_u64(knights)) & targets)
+        {
+            return true;
+        }
 
-            while(move_mask)
-            {
-                const uint32_t to_square = ctz_u64(move_mask);
+        knights = clsb_u64(knights);
+    }
 
-                MOVE_SET_FROM_SQUARE(moves[*moves_count], from_square);
-                MOVE_SET_TO_SQUARE(moves[*moves_count], to_square);
+    uint64_t diagonal_sliders = board_get_bishops(board, side) | board_get_queens(board, side);
 
-                MOVE_SET_IS_CAPTURING(moves[*moves_count], BIT64(to_square) & board->whites);
+    while(diagonal_sliders)
+    {
+        const uint32_t square = (uint32_t)ctz_u64(diagonal_sliders);
 
-                (*moves_count)++;
+        uint64_t moves = move_gen_bishop_attacks(square, occupancy) & targets;
 
-                UNSET_BIT(move_mask, BIT64(to_square));
-            }
+        if(pinned & BIT64(square))
+        {
+            moves &= move_gen_line(king_square, square);
+        }
 
-            UNSET_BIT(b, BIT64(from_square));
+        if(moves)
+        {
+            return true;
         }
+
+        diagonal_sliders = clsb_u64(diagonal_sliders);
     }
-}
 
-typedef void (*get_moves_func)(Board*, Move*, size_t*);
+    uint64_t straight_sliders = board_get_rooks(board, side) | board_get_queens(board, side);
 
-get_moves_func moves_func[2] = {
-    board_get_white_moves,
-    board_get_black_moves
-};
+    while(straight_sliders)
+    {
+        const uint32_t square = (uint32_t)ctz_u64(straight_sliders);
 
-void board_get_moves(Board* board, Move* moves, size_t* moves_count)
-{
-    *moves_count = 0;
+        uint64_t moves = move_gen_rook_attacks(square, occupancy) & targets;
 
-    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+        if(pinned & BIT64(square))
+        {
+            moves &= move_gen_line(king_square, square);
+        }
 
-    moves_func[side](board, moves, moves_count);
-}
+        if(moves)
+        {
+            return true;
+        }
 
-uint32_t board_make_move(Board* board, const Move move)
-{
-    const uint32_t piece = MOVE_GET_PIECE(move);
-    const uint32_t from_square = MOVE_GET_FROM_SQUARE(move);
-    const uint32_t to_square = MOVE_GET_TO_SQUARE(move);
-    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+        straight_sliders = clsb_u64(straight_sliders);
+    }
 
-    const uint64_t from_piece_mask = ~BIT64(from_square);
-    const uint64_t to_piece_mask = BIT64(to_square);
+    /* Unpinned pawns are handled all at once */
+    const uint64_t empty = ~occupancy;
+    const uint64_t pawns = board_get_pawns(board, side) & ~pinned;
 
-    uint64_t* board_as_ptr = (uint64_t*)board;
+    uint64_t pawns_moves;
 
-    board_as_ptr[piece * 2UL + side] &= from_piece_mask;
-    board_as_ptr[piece * 2UL + side] |= to_piece_mask;
+    if(side == PIECE_WHITE)
+    {
+        const uint64_t single_push = (pawns << 8) & empty;
+        const uint64_t double_push = ((single_push & RANK3) << 8) & empty;
+        const uint64_t captures = (((pawns & ~FILEA) << 7) | ((pawns & ~FILEH) << 9)) & enemy_pieces;
 
-    board_as_ptr[12UL + side] &= from_piece_mask;
-    board_as_ptr[12UL + side] |= to_piece_mask;
+        pawns_moves = single_push | double_push | captures;
+    }
+    else
+    {
+        const uint64_t single_push = (pawns >> 8) & empty;
+        const uint64_t double_push = ((single_push & RANK6) >> 8) & empty;
+        const uint64_t captures = (((pawns & ~FILEA) >> 9) | ((pawns & ~FILEH) >> 7)) & enemy_pieces;
 
-    const bool is_capturing = (bool)MOVE_GET_IS_CAPTURING(move);
+        pawns_moves = single_push | double_push | captures;
+    }
 
-    if(is_capturing)
+    if(pawns_moves & targets)
+    {
+        return true;
+    }
+
+    uint64_t pinned_pawns = board_get_pawns(board, side) & pinned;
+
+    while(pinned_pawns)
     {
-        bool has_captured = false;
+        const uint32_t square = (uint32_t)ctz_u64(pinned_pawns);
+        const uint64_t pawn = BIT64(square);
 
-        for(uint32_t i = 0; i < 6; i++)
+        const uint64_t single_push = (side == PIECE_WHITE ? pawn << 8 : pawn >> 8) & empty;
+        const uint64_t double_push = (side == PIECE_WHITE ? (single_push & RANK3) << 8 : (single_push & RANK6) >> 8) & empty;
+        const uint64_t captures = move_gen_pawn_attacks(square, side) & enemy_pieces;
+
+        if((single_push | double_push | captures) & targets & move_gen_line(king_square, square))
         {
-            board_as_ptr[i * 2UL + !side] &= ~to_piece_mask;
+            return true;
         }
 
-        board_as_ptr[12UL + !side] &= ~to_piece_mask;
+        pinned_pawns = clsb_u64(pinned_pawns);
     }
 
-    board->all = board->whites | board->blacks;
+    /* 
+        En passant removes two pawns from the same rank, the resulting 
+        position is checked as a whole instead of relying on the masks
+    */
+    if(BOARD_PTR_HAS_EN_PASSANT(board))
+    {
+        const uint32_t en_passant_square = BOARD_PTR_GET_EN_PASSANT_SQUARE(board);
+        const uint64_t captured = side == PIECE_WHITE ? BIT64(en_passant_square - 8) : 
+                                                        BIT64(en_passant_square + 8);
+
+        uint64_t capturers = move_gen_pawn_attacks(en_passant_square, !side) & board_get_pawns(board, side);
 
-    BOARD_TOGGLE_SIDE_TO_PLAY(*board);
+        while(capturers)
+        {
+            const uint64_t capturer = BIT64(ctz_u64(capturers));
+            const uint64_t occupancy_after = (occupancy ^ capturer ^ captured) | BIT64(en_passant_square);
 
-    return 0;
+            if((board_attackers_to(board, king_square, !side, occupancy_after) & ~captured) == 0ULL)
+            {
+                return true;
+            }
+
+            capturers = clsb_u64(capturers);
+        }
+    }
+
+    return false;
 }
 
-bool board_make_move_algebraic(Board* board, const char* move)
+bool board_has_legal_move(Board* board)
 {
-    return false;
+    return board_has_legal_move_with_checkers(board, board_get_checkers(board));
 }
 
-bool board_has_check_from_last_move(Board* board, Move last_move)
+bool board_has_mate_from_last_move(Board* board, const Move last_move)
 {
-    const uint64_t white_pieces = BOARD_PTR_GET_WHITE_PIECES(board);
-    const uint64_t black_pieces = BOARD_PTR_GET_BLACK_PIECES(board);
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint32_t king_square = (uint32_t)ctz_u64(board_get_king(board, side));
 
-    const uint32_t to_square = MOVE_GET_TO_SQUARE(last_move);
     const uint32_t piece = MOVE_GET_PIECE(last_move);
-    const uint32_t side = BOARD_GET_SIDE_TO_PLAY(*board);
-
-    const uint64_t new_move_mask = __move_gen_funcs[piece](to_square,
-                                                           side,
-                                                           white_pieces,
-                                                           black_pieces);
+    const uint32_t from_square = MOVE_GET_FROM_SQUARE(last_move);
+    const uint32_t to_square = MOVE_GET_TO_SQUARE(last_move);
 
-    const uint64_t king_mask = board->kings[!side];
+    /* 
+        A mate needs a check, that can only be given by the moved piece or by 
+        a slider it uncovered on a line going through its origin square
+    */
+    const bool direct_check = board_piece_attacks(piece, to_square, !side, board_get_all(board)) & board_get_king(board, side);
+    const bool discovered_check = move_gen_line(king_square, from_square) != 0ULL;
 
-    return new_move_mask & king_mask;
-}
+    /* Castling checks with the rook, en passant can uncover a check through the captured pawn */
+    const bool special_check = (piece == Piece_King && (to_square == from_square + 2 || from_square == to_square + 2)) ||
+                               (MOVE_GET_IS_CAPTURING(last_move) && 
+                                (board_get_pawns(board, !side) & BIT64(to_square)) &&
+                                move_gen_line(king_square, side == PIECE_WHITE ? to_square + 8 : to_square - 8) != 0ULL);
 
-bool board_has_check(Board* board)
-{
-    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
-    const uint64_t king_mask = board->kings[side];
-    const uint64_t attack_mask = board_get_move_mask_all_pieces(board, !side);
+    if(!direct_check && !discovered_check && !special_check)
+    {
+        return false;
+    }
 
-    return king_mask & attack_mask;
+    return board_has_mate(board);
 }
 
-bool board_has_mate_from_last_move(Board* board, Move last_move)
+bool board_has_mate(Board* board)
 {
-    const uint64_t white_pieces = BOARD_PTR_GET_WHITE_PIECES(board);
-    const uint64_t black_pieces = BOARD_PTR_GET_BLACK_PIECES(board);
+    const uint64_t checkers = board_get_checkers(board);
 
-    const uint32_t to_square = MOVE_GET_TO_SQUARE(last_move);
-    const uint32_t piece = MOVE_GET_PIECE(last_move);
-    const uint32_t side = BOARD_GET_SIDE_TO_PLAY(*board);
+    if(checkers == 0ULL)
+    {
+        return false;
+    }
 
-    return false;
+    return !board_has_legal_move_with_checkers(board, checkers);
 }
 
-bool board_has_mate(Board* board)
+bool board_has_stalemate(Board* board)
 {
-    return false;
+    const uint64_t checkers = board_get_checkers(board);
+
+    if(checkers != 0ULL)
+    {
+        return false;
+    }
+
+    return !board_has_legal_move_with_checkers(board, checkers);
 }
 
 BoardMoveIterator board_move_iterator_init()
@@ -427,9 +1509,7 @@ bool board_legal_moves_iterator(Board* board, Move* move, BoardMoveIterator* it)
     {
         while(it->side < 2)
         {
-            const uint32_t b_index = it->piece_type * 2 + it->side;
-
-            uint64_t b = ((int64_t*)board)[b_index];
+            uint64_t b = board_get_pieces(board, it->piece_type, it->side);
 
             const uint32_t piece = it->piece_type;
             const uint32_t side = it->side;
@@ -476,7 +1556,8 @@ bool board_legal_moves_iterator(Board* board, Move* move, BoardMoveIterator* it)
     return false;
 }
 
-uint64_t board_perft_recurse(Board* board, uint32_t depth, uint32_t max_depth)
+/* The moves of the position are written at moves, in the arena, and the ones of the children after them */
+static uint64_t board_perft_recurse(Board* board, Move* moves, uint32_t depth, uint32_t max_depth)
 {
     if(depth == max_depth)
     {
@@ -485,17 +1566,16 @@ uint64_t board_perft_recurse(Board* board, uint32_t depth, uint32_t max_depth)
 
     uint64_t total_moves = 0;
 
-    uint64_t moves_count = 0;
-    Move moves[BOARD_MAX_MOVES];
+    size_t moves_count = 0;
 
-    board_get_moves(board, moves, &moves_count);
+    board_get_legal_moves(board, moves, &moves_count);
 
     for(size_t i = 0; i < moves_count; i++)
     {
         Board other_board = *board;
         board_make_move(&other_board, moves[i]);
 
-        total_moves += board_perft_recurse(&other_board, depth + 1, max_depth);
+        total_moves += board_perft_recurse(&other_board, moves + moves_count, depth + 1, max_depth);
     }
 
     return total_moves;
@@ -503,13 +1583,23 @@ uint64_t board_perft_recurse(Board* board, uint32_t depth, uint32_t max_depth)
 
 uint64_t board_perft(Board* board, uint32_t num_plies)
 {
-    return board_perft_recurse(board, 0, num_plies);
+    /* Room for the moves of every ply generating them, the leaves don't */
+    MoveStack stack;
+
+    if(!move_stack_init(&stack, ((size_t)num_plies > 0 ? num_plies : 1) * BOARD_MAX_MOVES))
+    {
+        return 0;
+    }
+
+    const uint64_t total_moves = board_perft_recurse(board, move_stack_top(&stack), 0, num_plies);
+
+    move_stack_release(&stack);
+
+    return total_moves;
 }
 
 /* Debug */
 
-#define PIECES_STRING ("PpNnBbRrQqKk")
-
 void board_debug(Board* board)
 {
     char res[SIZEOF_DEBUG_BOARD];
@@ -546,7 +1636,7 @@ void board_debug(Board* board)
         {
             for(uint64_t k = 0; k < 12; k++)
             {
-                const uint64_t b = ((uint64_t*)board)[k];
+                const uint64_t b = board_get_pieces(board, k / 2, k % 2);
 
                 if(BOARD_HAS_BIT_FROM_FILE_RANK(b, ii, jj))
                 {
@@ -575,24 +1665,36 @@ void board_debug(Board* board)
     printf(" - %s to play\n",
            board->state & BoardState_WhiteToPlay ? "White" : "Black");
 
+    if(BOARD_PTR_HAS_EN_PASSANT(board))
+    {
+        const uint32_t en_passant_square = BOARD_PTR_GET_EN_PASSANT_SQUARE(board);
+
+        printf(" - En passant: %c%u\n",
+               'a' + BOARD_FILE_FROM_POS(en_passant_square),
+               1 + BOARD_RANK_FROM_POS(en_passant_square));
+    }
+
+    printf(" - Halfmove clock: %u\n", (uint32_t)board->halfmove_clock);
+    printf(" - Fullmove number: %u\n", (uint32_t)board->fullmove_number);
+
     printf("\n");
 }
 
 void board_debug_move_masks(Board* board)
 {
-    const uint64_t white_pieces = board->pawns[0] |
-                                  board->knights[0] |
-                                  board->bishops[0] |
-                                  board->rooks[0] |
-                                  board->queens[0] |
-                                  board->kings[0];
-
-    const uint64_t black_pieces = board->pawns[1] |
-                                  board->knights[1] |
-                                  board->bishops[1] |
-                                  board->rooks[1] |
-                                  board->queens[1] |
-                                  board->kings[1];
+    const uint64_t white_pieces = board_get_pawns(board, 0) |
+                                  board_get_knights(board, 0) |
+                                  board_get_bishops(board, 0) |
+                                  board_get_rooks(board, 0) |
+                                  board_get_queens(board, 0) |
+                                  board_get_king(board, 0);
+
+    const uint64_t black_pieces = board_get_pawns(board, 1) |
+                                  board_get_knights(board, 1) |
+                                  board_get_bishops(board, 1) |
+                                  board_get_rooks(board, 1) |
+                                  board_get_queens(board, 1) |
+                                  board_get_king(board, 1);
 
     const uint64_t pieces[2] = {
         white_pieces,
@@ -611,9 +1713,7 @@ void board_debug_move_masks(Board* board)
     {
         for(size_t j = 0; j < 2; j++)
         {
-            const uint32_t b_index = (i + j) * 2 - j;
-
-            uint64_t b = ((int64_t*)board)[b_index];
+            uint64_t b = board_get_pieces(board, i, j);
 
             const uint32_t piece = i;
             const uint32_t side = j;
@@ -0,0 +1,520 @@
+#include "cchess/dfpn.h"
+#include "cchess/move_stack.h"
+#include "cchess/platform.h"
+
+#include "libromano/bit.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Entries are 16 bytes, four to a 64 bytes bucket. The low bits of the key
+    index the bucket, the high half is kept in the entry to verify it.
+    Storing in a full bucket replaces the entry that cost the fewest nodes
+    to compute
+*/
+
+#define DFPN_ENTRIES_PER_BUCKET 4
+
+typedef struct
+{
+    uint32_t key;
+    uint32_t pn;
+    uint32_t dn;
+    /* Move proving an OR node */
+    uint16_t move;
+    uint8_t moves_left;
+    /* Log2 of the nodes expanded to compute the entry */
+    uint8_t work;
+} DfpnEntry;
+
+typedef struct
+{
+    DfpnEntry entries[DFPN_ENTRIES_PER_BUCKET];
+} DfpnBucket;
+
+STATIC_ASSERT(sizeof(DfpnBucket) == 64);
+
+typedef struct
+{
+    DfpnBucket* buckets;
+    /* A power of two */
+    uint64_t num_buckets;
+    size_t size;
+    bool huge_pages;
+} DfpnTable;
+
+typedef struct
+{
+    const DfpnLimits* limits;
+    DfpnTable table;
+    /* Moves of the nodes on the path, and the keys of the positions they lead to at the same indices */
+    MoveStack moves;
+    uint64_t* keys;
+    uint64_t nodes;
+    bool stopped;
+} DfpnSolver;
+
+void dfpn_limits_init(DfpnLimits* limits)
+{
+    memset(limits, 0, sizeof(DfpnLimits));
+
+    limits->max_moves = 5;
+    limits->checks_only = true;
+}
+
+/*
+    Table
+*/
+
+static bool dfpn_table_init(DfpnTable* table, const size_t size_mb)
+{
+    memset(table, 0, sizeof(DfpnTable));
+
+    const uint64_t max_buckets = ((uint64_t)size_mb * 1024ULL * 1024ULL) / sizeof(DfpnBucket);
+
+    if(max_buckets == 0)
+    {
+        return false;
+    }
+
+    table->num_buckets = 1ULL << (63 - clz_u64(max_buckets));
+    table->size = (size_t)(table->num_buckets * sizeof(DfpnBucket));
+    table->buckets = (DfpnBucket*)platform_alloc_large(table->size, &table->huge_pages);
+
+    return table->buckets != NULL;
+}
+
+static void dfpn_table_release(DfpnTable* table)
+{
+    platform_free_large(table->buckets, table->size);
+    memset(table, 0, sizeof(DfpnTable));
+}
+
+/* An empty entry has both numbers at 0 */
+CCHESS_FORCE_INLINE DfpnEntry* dfpn_table_probe(const DfpnTable* table, const uint64_t key)
+{
+    DfpnBucket* bucket = table->buckets + (key & (table->num_buckets - 1));
+
+    for(uint32_t i = 0; i < DFPN_ENTRIES_PER_BUCKET; i++)
+    {
+        DfpnEntry* entry = &bucket->entries[i];
+
+        if(entry->key == (uint32_t)(key >> 32) && (entry->pn | entry->dn) != 0)
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+CCHESS_FORCE_INLINE bool dfpn_entry_is_proven(const DfpnEntry* entry, const uint32_t moves_left)
+{
+    return entry != NULL && entry->pn == 0 && entry->moves_left <= moves_left;
+}
+
+/*
+    Numbers of a node with moves_left moves for the attacker. A proof with
+    fewer moves left and a disproof with more hold, numbers computed with
+    another number of moves are not used. Unknown nodes are worth 1 and 1
+*/
+CCHESS_FORCE_INLINE void dfpn_table_lookup(const DfpnTable* table,
+                                           const uint64_t key,
+                                           const uint32_t moves_left,
+                                           uint32_t* pn,
+                                           uint32_t* dn)
+{
+    const DfpnEntry* entry = dfpn_table_probe(table, key);
+
+    *pn = 1;
+    *dn = 1;
+
+    if(entry == NULL)
+    {
+        return;
+    }
+
+    if(dfpn_entry_is_proven(entry, moves_left))
+    {
+        *pn = 0;
+        *dn = DFPN_INFINITE;
+    }
+    else if(entry->dn == 0 && entry->moves_left >= moves_left)
+    {
+        *pn = DFPN_INFINITE;
+        *dn = 0;
+    }
+    else if(entry->moves_left == moves_left)
+    {
+        *pn = entry->pn;
+        *dn = entry->dn;
+    }
+}
+
+static void dfpn_table_store(DfpnTable* table,
+                             const uint64_t key,
+                             const uint32_t moves_left,
+                             const uint32_t pn,
+                             const uint32_t dn,
+                             const Move move,
+                             const uint64_t work)
+{
+    DfpnEntry* entry = dfpn_table_probe(table, key);
+
+    if(entry == NULL)
+    {
+        DfpnBucket* bucket = table->buckets + (key & (table->num_buckets - 1));
+
+        entry = &bucket->entries[0];
+
+        for(uint32_t i = 1; i < DFPN_ENTRIES_PER_BUCKET && (entry->pn | entry->dn) != 0; i++)
+        {
+            DfpnEntry* candidate = &bucket->entries[i];
+
+            if((candidate->pn | candidate->dn) == 0 || candidate->work < entry->work)
+            {
+                entry = candidate;
+            }
+        }
+    }
+
+    entry->key = (uint32_t)(key >> 32);
+    entry->pn = pn;
+    entry->dn = dn;
+    entry->move = move_to_u16(move);
+    entry->moves_left = (uint8_t)moves_left;
+    entry->work = (uint8_t)(64 - clz_u64(work | 1ULL));
+}
+
+/*
+    Search
+*/
+
+/* Thresholds are computed in 64 bits then brought back to the numbers range */
+CCHESS_FORCE_INLINE uint32_t dfpn_clamp(const uint64_t value)
+{
+    return value < DFPN_INFINITE ? (uint32_t)value : DFPN_INFINITE;
+}
+
+/*
+    Expands the node until its numbers reach one of the thresholds, then
+    stores them. At an OR node the child with the smallest proof number is
+    searched, its proof threshold being just above the one of the second
+    best child (by 1 + 1/4, so that two close children do not alternate at
+    every iteration) and its disproof threshold what is left of the node
+    one. At an AND node, the same with the disproof numbers
+*/
+static void dfpn_mid(DfpnSolver* solver,
+                     Board* board,
+                     const uint32_t moves_left,
+                     const bool is_or,
+                     const uint32_t pn_threshold,
+                     const uint32_t dn_threshold)
+{
+    const DfpnLimits* limits = solver->limits;
+    const uint64_t start_nodes = solver->nodes++;
+
+    if(limits->max_nodes > 0 && solver->nodes > limits->max_nodes)
+    {
+        solver->stopped = true;
+        return;
+    }
+
+    Move* moves = move_stack_top(&solver->moves);
+    size_t num_moves = 0;
+
+    if(is_or)
+    {
+        if(moves_left > 0 && limits->checks_only)
+        {
+            board_get_legal_checks(board, moves, &num_moves);
+        }
+        else if(moves_left > 0)
+        {
+            board_get_legal_moves(board, moves, &num_moves);
+        }
+
+        /* With one move left the node is proven by a mate in one, its children are probed without being stored */
+        for(size_t i = 0; moves_left == 1 && i < num_moves; i++)
+        {
+            Board child = *board;
+            board_make_move(&child, moves[i]);
+
+            solver->nodes++;
+
+            if(board_get_checkers(&child) != 0ULL && !board_has_legal_move(&child))
+            {
+                dfpn_table_store(&solver->table, board->key, moves_left, 0, DFPN_INFINITE, moves[i], solver->nodes - start_nodes);
+                return;
+            }
+        }
+
+        if(num_moves == 0 || moves_left == 1)
+        {
+            dfpn_table_store(&solver->table, board->key, moves_left, DFPN_INFINITE, 0, move_from_u16(EMPTY_MOVE), solver->nodes - start_nodes);
+            return;
+        }
+    }
+    else
+    {
+        /* Evasions, the defender being in check after any move with checks_only */
+        board_get_legal_moves(board, moves, &num_moves);
+
+        if(num_moves == 0 && board_get_checkers(board) != 0ULL)
+        {
+            dfpn_table_store(&solver->table, board->key, moves_left, 0, DFPN_INFINITE, move_from_u16(EMPTY_MOVE), 1);
+            return;
+        }
+
+        /* Stalemate, the OR nodes with one move left never reaching an AND node without moves left */
+        if(num_moves == 0)
+        {
+            dfpn_table_store(&solver->table, board->key, moves_left, DFPN_INFINITE, 0, move_from_u16(EMPTY_MOVE), 1);
+            return;
+        }
+    }
+
+    uint64_t* keys = solver->keys + solver->moves.size;
+    move_stack_push(&solver->moves, num_moves);
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        Board child = *board;
+        board_make_move(&child, moves[i]);
+
+        keys[i] = child.key;
+    }
+
+    const uint32_t child_moves_left = is_or ? moves_left - 1 : moves_left;
+
+    /* The numbers the node selects its child by and sums, pn and dn at an OR node */
+    const uint32_t select_threshold = is_or ? pn_threshold : dn_threshold;
+    const uint32_t sum_threshold = is_or ? dn_threshold : pn_threshold;
+
+    uint32_t select;
+    uint32_t sum;
+    size_t best;
+
+    for(;;)
+    {
+        uint64_t total = 0;
+        bool infinite = false;
+
+        uint32_t second = DFPN_INFINITE;
+        uint32_t best_sum = 0;
+
+        select = DFPN_INFINITE + 1;
+        best = 0;
+
+        for(size_t i = 0; i < num_moves; i++)
+        {
+            uint32_t pn;
+            uint32_t dn;
+            dfpn_table_lookup(&solver->table, keys[i], child_moves_left, &pn, &dn);
+
+            const uint32_t child_select = is_or ? pn : dn;
+            const uint32_t child_sum = is_or ? dn : pn;
+
+            total += child_sum;
+            infinite |= child_sum == DFPN_INFINITE;
+
+            if(child_select < select)
+            {
+                second = select;
+                select = child_select;
+                best_sum = child_sum;
+                best = i;
+            }
+            else if(child_select < second)
+            {
+                second = child_select;
+            }
+        }
+
+        second = second > DFPN_INFINITE ? DFPN_INFINITE : second;
+
+        /* A sum reaches infinity only through an infinite child */
+        sum = infinite ? DFPN_INFINITE : dfpn_clamp(total < DFPN_INFINITE ? total : DFPN_INFINITE - 1);
+
+        if(select >= select_threshold || sum >= sum_threshold || solver->stopped)
+        {
+            break;
+        }
+
+        const uint32_t child_select_threshold = dfpn_clamp((uint64_t)second + (second >> 2) + 1);
+        const uint32_t child_select_limit = child_select_threshold < select_threshold ? child_select_threshold : select_threshold;
+        const uint32_t child_sum_limit = dfpn_clamp((uint64_t)sum_threshold - sum + best_sum);
+
+        Board child = *board;
+        board_make_move(&child, moves[best]);
+
+        dfpn_mid(solver,
+                 &child,
+                 child_moves_left,
+                 !is_or,
+                 is_or ? child_select_limit : child_sum_limit,
+                 is_or ? child_sum_limit : child_select_limit);
+    }
+
+    dfpn_table_store(&solver->table,
+                     board->key,
+                     moves_left,
+                     is_or ? select : sum,
+                     is_or ? sum : select,
+                     is_or ? moves[best] : move_from_u16(EMPTY_MOVE),
+                     solver->nodes - start_nodes);
+
+    move_stack_pop(&solver->moves, num_moves);
+}
+
+/*
+    Walks the proof tree of a proven node, adding its nodes to size. line
+    receives the mate from the node, the defender choosing the longest one.
+    An OR node whose entry was replaced is proven again, false is returned
+    if the node budget runs out meanwhile
+*/
+static bool dfpn_walk(DfpnSolver* solver,
+                      Board* board,
+                      const uint32_t moves_left,
+                      const bool is_or,
+                      uint64_t* size,
+                      Move* line,
+                      uint32_t* line_length)
+{
+    (*size)++;
+    *line_length = 0;
+
+    if(is_or)
+    {
+        const DfpnEntry* entry = dfpn_table_probe(&solver->table, board->key);
+
+        if(!dfpn_entry_is_proven(entry, moves_left))
+        {
+            dfpn_mid(solver, board, moves_left, true, DFPN_INFINITE, DFPN_INFINITE);
+
+            entry = dfpn_table_probe(&solver->table, board->key);
+
+            if(!dfpn_entry_is_proven(entry, moves_left))
+            {
+                return false;
+            }
+        }
+
+        /* The entry can be replaced below */
+        const Move move = move_from_u16(entry->move);
+        const uint32_t proven_moves_left = entry->moves_left;
+
+        Board child = *board;
+        board_make_move(&child, move);
+
+        line[0] = move;
+
+        uint32_t child_length;
+
+        if(!dfpn_walk(solver, &child, proven_moves_left - 1, false, size, line + 1, &child_length))
+        {
+            return false;
+        }
+
+        *line_length = 1 + child_length;
+
+        return true;
+    }
+
+    Move* moves = move_stack_top(&solver->moves);
+    size_t num_moves;
+    board_get_legal_moves(board, moves, &num_moves);
+
+    move_stack_push(&solver->moves, num_moves);
+
+    bool proven = true;
+
+    for(size_t i = 0; i < num_moves && proven; i++)
+    {
+        Board child = *board;
+        board_make_move(&child, moves[i]);
+
+        Move child_line[DFPN_MAX_PV];
+        uint32_t child_length;
+
+        proven = dfpn_walk(solver, &child, moves_left, true, size, child_line, &child_length);
+
+        if(proven && (i == 0 || 1 + child_length > *line_length))
+        {
+            line[0] = moves[i];
+            memcpy(line + 1, child_line, child_length * sizeof(Move));
+
+            *line_length = 1 + child_length;
+        }
+    }
+
+    move_stack_pop(&solver->moves, num_moves);
+
+    return proven;
+}
+
+bool dfpn_solve(Board* board, const DfpnLimits* limits, DfpnInfo* info)
+{
+    memset(info, 0, sizeof(DfpnInfo));
+
+    CCHESS_ASSERT(limits->max_moves <= DFPN_MAX_MOVES);
+
+    DfpnSolver solver;
+    memset(&solver, 0, sizeof(DfpnSolver));
+
+    solver.limits = limits;
+
+    /* One ply of moves per ply of the longest mate, and one for the walk of the proof tree re-proving a node */
+    const size_t capacity = (2 * (size_t)limits->max_moves + 2) * BOARD_MAX_MOVES;
+
+    if(!dfpn_table_init(&solver.table, limits->tt_size_mb > 0 ? limits->tt_size_mb : DFPN_DEFAULT_TT_SIZE_MB))
+    {
+        return false;
+    }
+
+    if(!move_stack_init(&solver.moves, capacity))
+    {
+        dfpn_table_release(&solver.table);
+        return false;
+    }
+
+    solver.keys = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+
+    if(solver.keys == NULL)
+    {
+        move_stack_release(&solver.moves);
+        dfpn_table_release(&solver.table);
+        return false;
+    }
+
+    const uint64_t start_ns = platform_get_time_ns();
+
+    Board root = *board;
+
+    dfpn_mid(&solver, &root, limits->max_moves, true, DFPN_INFINITE, DFPN_INFINITE);
+
+    uint32_t pn;
+    uint32_t dn;
+    dfpn_table_lookup(&solver.table, root.key, limits->max_moves, &pn, &dn);
+
+    info->result = pn == 0 ? DfpnResult_Proven : (dn == 0 ? DfpnResult_Disproven : DfpnResult_Unknown);
+
+    if(info->result == DfpnResult_Proven &&
+       !dfpn_walk(&solver, &root, limits->max_moves, true, &info->proof_tree_size, info->pv, &info->pv_length))
+    {
+        info->proof_tree_size = 0;
+        info->pv_length = 0;
+    }
+
+    CCHESS_ASSERT(solver.moves.size == 0);
+
+    info->nodes = solver.nodes;
+    info->elapsed_ns = platform_get_time_ns() - start_ns;
+
+    free(solver.keys);
+    move_stack_release(&solver.moves);
+    dfpn_table_release(&solver.table);
+
+    return true;
+}
@@ -0,0 +1,1259 @@
+#include "cchess/egtb.h"
+#include "cchess/board_macros.h"
+#include "cchess/eval.h"
+#include "cchess/zobrist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Packed values, a draw is also a position not resolved yet during generation */
+#define EGTB_VALUE_DRAW 0
+#define EGTB_VALUE_WIN 1
+#define EGTB_VALUE_LOSS 2
+#define EGTB_VALUE_UNUSED 3
+
+/* Runs of a block are one byte, 2 bits of value and 6 bits of length code */
+#define EGTB_RUN_MAX_SHORT 62
+/* Long runs are followed by their length on 2 bytes */
+#define EGTB_RUN_CODE_LONG 62
+/* The last run of a block goes up to its end */
+#define EGTB_RUN_CODE_END 63
+
+#define EGTB_PIECE_CODE(piece, side) ((uint8_t)((piece) | ((side) << 3)))
+#define EGTB_CODE_PIECE(code) ((uint32_t)(code) & 0x7)
+#define EGTB_CODE_SIDE(code) ((uint32_t)(code) >> 3)
+
+/* Applied in that order */
+#define EGTB_TRANSFORM_FLIP_FILE 0x1
+#define EGTB_TRANSFORM_FLIP_RANK 0x2
+#define EGTB_TRANSFORM_TRANSPOSE 0x4
+
+#define EGTB_RANKS_1_AND_8 0xFF000000000000FFULL
+
+static const char _egtb_piece_chars[5] = { 'P', 'N', 'B', 'R', 'Q' };
+
+/* a1-d1-d4 triangle, the white king squares of the pawnless tables */
+static const uint8_t _egtb_triangle_squares[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+static const int8_t _egtb_triangle_indices[64] = {
+     0,  1,  2,  3, -1, -1, -1, -1,
+    -1,  4,  5,  6, -1, -1, -1, -1,
+    -1, -1,  7,  8, -1, -1, -1, -1,
+    -1, -1, -1,  9, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+/*
+    Material
+*/
+
+/* Number of pieces of each side and type, kings excluded */
+typedef uint32_t EgtbCounts[2][5];
+
+static bool egtb_material_init(EgtbMaterial* material, const EgtbCounts counts)
+{
+    memset(material, 0, sizeof(EgtbMaterial));
+
+    material->pieces[0] = EGTB_PIECE_CODE(Piece_King, PIECE_WHITE);
+    material->pieces[1] = EGTB_PIECE_CODE(Piece_King, PIECE_BLACK);
+    material->num_pieces = 2;
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        for(int32_t piece = Piece_Queen; piece >= Piece_Pawn; piece--)
+        {
+            for(uint32_t i = 0; i < counts[side][piece]; i++)
+            {
+                if(material->num_pieces == EGTB_MAX_PIECES)
+                {
+                    return false;
+                }
+
+                material->pieces[material->num_pieces++] = EGTB_PIECE_CODE(piece, side);
+            }
+
+            material->key |= (uint64_t)counts[side][piece] << (side * 20 + piece * 4);
+            material->key2 |= (uint64_t)counts[side][piece] << ((side ^ 1) * 20 + piece * 4);
+        }
+    }
+
+    material->has_pawns = (counts[0][Piece_Pawn] + counts[1][Piece_Pawn]) > 0;
+    material->num_positions = 2 * (material->has_pawns ? 32 : 10);
+
+    for(uint32_t i = 1; i < material->num_pieces; i++)
+    {
+        material->num_positions *= 64;
+    }
+
+    return true;
+}
+
+static void egtb_material_get_counts(const EgtbMaterial* material, EgtbCounts counts)
+{
+    memset(counts, 0, sizeof(EgtbCounts));
+
+    for(uint32_t i = 2; i < material->num_pieces; i++)
+    {
+        counts[EGTB_CODE_SIDE(material->pieces[i])][EGTB_CODE_PIECE(material->pieces[i])]++;
+    }
+}
+
+bool egtb_parse_material(EgtbMaterial* material, const char* name)
+{
+    EgtbCounts counts;
+    memset(counts, 0, sizeof(EgtbCounts));
+
+    uint32_t side = PIECE_WHITE;
+
+    if(*name++ != 'K')
+    {
+        return false;
+    }
+
+    for(; *name != '\0'; name++)
+    {
+        if(*name == 'v' && side == PIECE_WHITE && name[1] == 'K')
+        {
+            side = PIECE_BLACK;
+            name++;
+            continue;
+        }
+
+        const char* found = memchr(_egtb_piece_chars, *name, sizeof(_egtb_piece_chars));
+
+        if(found == NULL)
+        {
+            return false;
+        }
+
+        counts[side][found - _egtb_piece_chars]++;
+    }
+
+    return side == PIECE_BLACK && egtb_material_init(material, counts) && material->num_pieces > 2;
+}
+
+static uint64_t egtb_board_key(const Board* board)
+{
+    uint64_t key = 0;
+
+    for(uint32_t piece = Piece_Pawn; piece < Piece_King; piece++)
+    {
+        key |= popcount_u64(board_get_pieces(board, piece, PIECE_WHITE)) << (piece * 4);
+        key |= popcount_u64(board_get_pieces(board, piece, PIECE_BLACK)) << (20 + piece * 4);
+    }
+
+    return key;
+}
+
+/*
+    Indexing
+*/
+
+/*
+    Squares of the material pieces in the position and the side to play. The
+    colors are swapped when the position holds the material with swapped
+    colors. Returns false if the material differs
+*/
+static bool egtb_get_squares(const EgtbMaterial* material,
+                             const Board* board,
+                             uint32_t* squares,
+                             uint32_t* side)
+{
+    const uint64_t key = egtb_board_key(board);
+
+    uint32_t flip;
+
+    if(key == material->key)
+    {
+        flip = 0;
+    }
+    else if(key == material->key2)
+    {
+        flip = 1;
+    }
+    else
+    {
+        return false;
+    }
+
+    uint64_t bitboards[12];
+
+    for(uint32_t i = 0; i < 12; i++)
+    {
+        bitboards[i] = board_get_pieces(board, i / 2, i % 2);
+    }
+
+    for(uint32_t i = 0; i < material->num_pieces; i++)
+    {
+        const uint32_t index = EGTB_CODE_PIECE(material->pieces[i]) * 2 + (EGTB_CODE_SIDE(material->pieces[i]) ^ flip);
+
+        squares[i] = (uint32_t)ctz_u64(bitboards[index]) ^ (flip * 56);
+        bitboards[index] = clsb_u64(bitboards[index]);
+    }
+
+    *side = BOARD_PTR_GET_SIDE_TO_PLAY(board) ^ flip;
+
+    return true;
+}
+
+CCHESS_FORCE_INLINE uint32_t egtb_transform_square(uint32_t square, const uint32_t transform)
+{
+    square ^= (transform & EGTB_TRANSFORM_FLIP_FILE) ? 7 : 0;
+    square ^= (transform & EGTB_TRANSFORM_FLIP_RANK) ? 56 : 0;
+
+    return (transform & EGTB_TRANSFORM_TRANSPOSE) ? ((square >> 3) | (square << 3)) & 63 : square;
+}
+
+static uint64_t egtb_index_with_transform(const EgtbMaterial* material,
+                                          const uint32_t* squares,
+                                          const uint32_t side,
+                                          const uint32_t transform)
+{
+    uint32_t transformed[EGTB_MAX_PIECES];
+
+    for(uint32_t i = 0; i < material->num_pieces; i++)
+    {
+        transformed[i] = egtb_transform_square(squares[i], transform);
+    }
+
+    /* Identical pieces are consecutive, they are sorted by square */
+    for(uint32_t i = 3; i < material->num_pieces; i++)
+    {
+        for(uint32_t j = i; j > 2 && material->pieces[j - 1] == material->pieces[j] && transformed[j - 1] > transformed[j]; j--)
+        {
+            const uint32_t square = transformed[j];
+            transformed[j] = transformed[j - 1];
+            transformed[j - 1] = square;
+        }
+    }
+
+    const uint64_t king = material->has_pawns ? BOARD_RANK_FROM_POS(transformed[0]) * 4 + BOARD_FILE_FROM_POS(transformed[0]) :
+                                                (uint64_t)_egtb_triangle_indices[transformed[0]];
+
+    uint64_t index = (uint64_t)side * (material->has_pawns ? 32 : 10) + king;
+
+    for(uint32_t i = 1; i < material->num_pieces; i++)
+    {
+        index = index * 64 + transformed[i];
+    }
+
+    return index;
+}
+
+/*
+    Canonical index of a position, the same for all its mirrored images. When
+    the white king lies on the a1-h8 diagonal both images keeping it in the
+    triangle are indexed, the lowest index is the canonical one
+*/
+static uint64_t egtb_index(const EgtbMaterial* material, const uint32_t* squares, const uint32_t side)
+{
+    const uint32_t king = squares[0];
+
+    uint32_t transform = BOARD_FILE_FROM_POS(king) > 3 ? EGTB_TRANSFORM_FLIP_FILE : 0;
+
+    if(material->has_pawns)
+    {
+        return egtb_index_with_transform(material, squares, side, transform);
+    }
+
+    transform |= BOARD_RANK_FROM_POS(king) > 3 ? EGTB_TRANSFORM_FLIP_RANK : 0;
+
+    const uint32_t square = egtb_transform_square(king, transform);
+
+    if(BOARD_RANK_FROM_POS(square) > BOARD_FILE_FROM_POS(square))
+    {
+        return egtb_index_with_transform(material, squares, side, transform | EGTB_TRANSFORM_TRANSPOSE);
+    }
+
+    const uint64_t index = egtb_index_with_transform(material, squares, side, transform);
+
+    if(BOARD_RANK_FROM_POS(square) == BOARD_FILE_FROM_POS(square))
+    {
+        const uint64_t transposed = egtb_index_with_transform(material, squares, side, transform | EGTB_TRANSFORM_TRANSPOSE);
+
+        return transposed < index ? transposed : index;
+    }
+
+    return index;
+}
+
+static void egtb_decode_index(const EgtbMaterial* material, uint64_t index, uint32_t* squares, uint32_t* side)
+{
+    for(uint32_t i = material->num_pieces - 1; i > 0; i--)
+    {
+        squares[i] = (uint32_t)(index & 63);
+        index >>= 6;
+    }
+
+    const uint64_t num_kings = material->has_pawns ? 32 : 10;
+    const uint32_t king = (uint32_t)(index % num_kings);
+
+    squares[0] = material->has_pawns ? (king / 4) * 8 + king % 4 : _egtb_triangle_squares[king];
+    *side = (uint32_t)(index / num_kings);
+}
+
+/*
+    Builds the position from the squares of the material pieces. Returns
+    false if it is not legal: pieces on the same square, pawns on the first
+    or last rank, or the side not to play in check
+*/
+static bool egtb_set_board(const EgtbMaterial* material, const uint32_t* squares, const uint32_t side, Board* board)
+{
+    memset(board, 0, sizeof(Board));
+
+    for(uint32_t i = 0; i < material->num_pieces; i++)
+    {
+        const uint32_t piece = EGTB_CODE_PIECE(material->pieces[i]);
+        const uint32_t piece_side = EGTB_CODE_SIDE(material->pieces[i]);
+        const uint64_t bit = BIT64(squares[i]);
+
+        if((board_get_all(board) & bit) || (piece == Piece_Pawn && (bit & EGTB_RANKS_1_AND_8)))
+        {
+            return false;
+        }
+
+        board_put_piece(board, piece, piece_side, squares[i]);
+    }
+
+    board->state = side == PIECE_WHITE ? BoardState_WhiteToPlay : 0;
+    board->fullmove_number = 1;
+
+    board_init_derived(board);
+
+    return board_attackers_to(board, (uint32_t)ctz_u64(board_get_king(board, !side)), side, board_get_all(board)) == 0ULL;
+}
+
+CCHESS_FORCE_INLINE bool egtb_has_en_passant_capture(Board* board)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    return BOARD_PTR_HAS_EN_PASSANT(board) &&
+           (move_gen_pawn_attacks(BOARD_PTR_GET_EN_PASSANT_SQUARE(board), !side) & board_get_pawns(board, side)) != 0ULL;
+}
+
+/*
+    Generation
+*/
+
+typedef struct
+{
+    EgtbMaterial material;
+    /* 2 bits per position */
+    uint64_t* values;
+} EgtbGenTable;
+
+typedef struct
+{
+    EgtbGenTable* tables;
+    size_t num_tables;
+} EgtbGenerator;
+
+CCHESS_FORCE_INLINE uint32_t egtb_get_value(const uint64_t* values, const uint64_t index)
+{
+    const uint64_t word = platform_atomic_load_u64((volatile uint64_t*)(values + (index >> 5)));
+
+    return (uint32_t)(word >> ((index & 31) * 2)) & 0x3;
+}
+
+/* Sets the value of a position not resolved yet, returns false if another thread resolved it first */
+static bool egtb_resolve(uint64_t* values, const uint64_t index, const uint64_t value)
+{
+    volatile uint64_t* word = values + (index >> 5);
+    const uint32_t shift = (index & 31) * 2;
+
+    uint64_t current = platform_atomic_load_u64(word);
+
+    while(((current >> shift) & 0x3) == EGTB_VALUE_DRAW)
+    {
+        if(platform_atomic_cas_u64(word, current, current | (value << shift)))
+        {
+            return true;
+        }
+
+        current = platform_atomic_load_u64(word);
+    }
+
+    return false;
+}
+
+static const EgtbGenTable* egtb_generator_find(const EgtbGenerator* generator, const uint64_t key)
+{
+    for(size_t i = 0; i < generator->num_tables; i++)
+    {
+        if(generator->tables[i].material.key == key || generator->tables[i].material.key2 == key)
+        {
+            return &generator->tables[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Value of a position reached by a capture or a promotion, from the smaller tables */
+static uint32_t egtb_child_value(const EgtbGenerator* generator, const Board* board)
+{
+    if(popcount_u64(board_get_all(board)) == 2)
+    {
+        return EGTB_VALUE_DRAW;
+    }
+
+    const EgtbGenTable* table = egtb_generator_find(generator, egtb_board_key(board));
+
+    CCHESS_ASSERT(table != NULL);
+
+    uint32_t squares[EGTB_MAX_PIECES];
+    uint32_t side;
+
+    egtb_get_squares(&table->material, board, squares, &side);
+
+    return egtb_get_value(table->values, egtb_index(&table->material, squares, side));
+}
+
+/* Value of a position of the table being generated, en passant captures are searched */
+static uint32_t egtb_table_value(const EgtbGenerator* generator, const EgtbGenTable* table, Board* board)
+{
+    uint32_t squares[EGTB_MAX_PIECES];
+    uint32_t side;
+
+    egtb_get_squares(&table->material, board, squares, &side);
+
+    uint32_t value = egtb_get_value(table->values, egtb_index(&table->material, squares, side));
+
+    if(value == EGTB_VALUE_WIN || !egtb_has_en_passant_capture(board))
+    {
+        return value;
+    }
+
+    const uint32_t en_passant_square = BOARD_PTR_GET_EN_PASSANT_SQUARE(board);
+
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        if(MOVE_GET_PIECE(moves[i]) != Piece_Pawn || MOVE_GET_TO_SQUARE(moves[i]) != en_passant_square)
+        {
+            continue;
+        }
+
+        Board after = *board;
+        board_make_move(&after, moves[i]);
+
+        const uint32_t child_value = egtb_child_value(generator, &after);
+
+        if(child_value == EGTB_VALUE_LOSS)
+        {
+            return EGTB_VALUE_WIN;
+        }
+
+        value = child_value == EGTB_VALUE_DRAW && value == EGTB_VALUE_LOSS ? EGTB_VALUE_DRAW : value;
+    }
+
+    return value;
+}
+
+CCHESS_FORCE_INLINE bool egtb_move_leaves_table(Board* board, const Move move)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    return MOVE_GET_IS_CAPTURING(move) ||
+           (MOVE_GET_PIECE(move) != Piece_Pawn && (board_get_pawns(board, side) & BIT64(MOVE_GET_FROM_SQUARE(move))));
+}
+
+/* Value of the position reached by the move, for the side to play after it */
+static uint32_t egtb_successor_value(const EgtbGenerator* generator,
+                                     const EgtbGenTable* table,
+                                     Board* board,
+                                     const Move move)
+{
+    const bool leaves_table = egtb_move_leaves_table(board, move);
+
+    Board after = *board;
+    board_make_move(&after, move);
+
+    return leaves_table ? egtb_child_value(generator, &after) : egtb_table_value(generator, table, &after);
+}
+
+/*
+    Value of a position before the retrograde passes: mates and stalemates,
+    positions won by a capture or a promotion, and positions where all the
+    moves leave the table and lose
+*/
+static uint32_t egtb_initial_value(const EgtbGenerator* generator, Board* board)
+{
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    if(num_moves == 0)
+    {
+        return board_get_checkers(board) != 0ULL ? EGTB_VALUE_LOSS : EGTB_VALUE_DRAW;
+    }
+
+    bool all_moves_lose = true;
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        if(!egtb_move_leaves_table(board, moves[i]))
+        {
+            all_moves_lose = false;
+            continue;
+        }
+
+        Board after = *board;
+        board_make_move(&after, moves[i]);
+
+        const uint32_t child_value = egtb_child_value(generator, &after);
+
+        if(child_value == EGTB_VALUE_LOSS)
+        {
+            return EGTB_VALUE_WIN;
+        }
+
+        all_moves_lose &= child_value == EGTB_VALUE_WIN;
+    }
+
+    return all_moves_lose ? EGTB_VALUE_LOSS : EGTB_VALUE_DRAW;
+}
+
+/* A position is lost once all its moves reach a position won for the opponent */
+static bool egtb_all_moves_lose(const EgtbGenerator* generator, const EgtbGenTable* table, Board* board)
+{
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        if(egtb_successor_value(generator, table, board, moves[i]) != EGTB_VALUE_WIN)
+        {
+            return false;
+        }
+    }
+
+    return num_moves > 0;
+}
+
+/*
+    Moves the side which just played can have played to reach the position,
+    captures and promotions excluded as they come from other tables. The from
+    square of an unmove is the square the piece came from
+*/
+static size_t egtb_get_unmoves(Board* board, Move* unmoves)
+{
+    const uint32_t side = !BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint64_t empty = ~board_get_all(board);
+
+    size_t num_unmoves = 0;
+
+    for(uint32_t piece = Piece_Pawn; piece <= Piece_King; piece++)
+    {
+        uint64_t pieces = board_get_pieces(board, piece, side);
+
+        while(pieces)
+        {
+            const uint32_t to = (uint32_t)ctz_u64(pieces);
+
+            uint64_t origins = 0ULL;
+
+            switch(piece)
+            {
+                case Piece_Pawn:
+                {
+                    /* Pushes backwards, pawns never stand on their first rank */
+                    const uint32_t rank = side == PIECE_WHITE ? BOARD_RANK_FROM_POS(to) : 7 - BOARD_RANK_FROM_POS(to);
+                    const uint32_t single = side == PIECE_WHITE ? to - 8 : to + 8;
+
+                    if(rank >= 2 && (empty & BIT64(single)))
+                    {
+                        origins |= BIT64(single);
+
+                        if(rank == 3)
+                        {
+                            origins |= BIT64(side == PIECE_WHITE ? to - 16 : to + 16) & empty;
+                        }
+                    }
+
+                    break;
+                }
+                case Piece_Knight:
+                    origins = move_gen_knight_attacks(to);
+                    break;
+                case Piece_Bishop:
+                    origins = move_gen_bishop_attacks(to, board_get_all(board));
+                    break;
+                case Piece_Rook:
+                    origins = move_gen_rook_attacks(to, board_get_all(board));
+                    break;
+                case Piece_Queen:
+                    origins = move_gen_queen_attacks(to, board_get_all(board));
+                    break;
+                default:
+                    origins = move_gen_king_attacks(to);
+                    break;
+            }
+
+            origins &= empty;
+
+            while(origins)
+            {
+                Move unmove = (Move){ 0 };
+                MOVE_SET_FROM_SQUARE(unmove, (uint32_t)ctz_u64(origins));
+                MOVE_SET_TO_SQUARE(unmove, to);
+                MOVE_SET_PIECE(unmove, piece);
+
+                unmoves[num_unmoves++] = unmove;
+                origins = clsb_u64(origins);
+            }
+
+            pieces = clsb_u64(pieces);
+        }
+    }
+
+    return num_unmoves;
+}
+
+/*
+    Walks back the moves leading to a position resolved by the previous pass.
+    Returns the number of predecessors it resolved, they are flagged in
+    resolved for the next pass
+*/
+static uint64_t egtb_propagate(const EgtbGenerator* generator,
+                               EgtbGenTable* table,
+                               const uint64_t index,
+                               uint64_t* resolved)
+{
+    const EgtbMaterial* material = &table->material;
+
+    uint32_t squares[EGTB_MAX_PIECES];
+    uint32_t side;
+    Board board;
+
+    egtb_decode_index(material, index, squares, &side);
+    egtb_set_board(material, squares, side, &board);
+
+    const uint32_t value = egtb_get_value(table->values, index);
+
+    Move unmoves[BOARD_MAX_MOVES];
+    const size_t num_unmoves = egtb_get_unmoves(&board, unmoves);
+
+    uint64_t num_resolved = 0;
+
+    for(size_t i = 0; i < num_unmoves; i++)
+    {
+        const uint32_t from = MOVE_GET_FROM_SQUARE(unmoves[i]);
+        const uint32_t to = MOVE_GET_TO_SQUARE(unmoves[i]);
+        const uint64_t move_mask = BIT64(from) | BIT64(to);
+
+        const uint32_t piece = MOVE_GET_PIECE(unmoves[i]);
+
+        Board previous = board;
+        previous.pieces[piece] ^= move_mask;
+        previous.sides[!side] ^= move_mask;
+        previous.key ^= zobrist_get_piece_key(piece, !side, from) ^ zobrist_get_piece_key(piece, !side, to) ^ zobrist_side_key;
+        eval_move_piece(&previous, piece, !side, to, from);
+
+        BOARD_TOGGLE_SIDE_TO_PLAY(previous);
+
+        /* The side to play now can't be in check before the move */
+        if(board_attackers_to(&previous, (uint32_t)ctz_u64(board_get_king(&board, side)), !side, board_get_all(&previous)) != 0ULL)
+        {
+            continue;
+        }
+
+        uint32_t previous_squares[EGTB_MAX_PIECES];
+        uint32_t previous_side;
+
+        egtb_get_squares(material, &previous, previous_squares, &previous_side);
+
+        const uint64_t previous_index = egtb_index(material, previous_squares, previous_side);
+
+        if(egtb_get_value(table->values, previous_index) != EGTB_VALUE_DRAW)
+        {
+            continue;
+        }
+
+        uint32_t previous_value = EGTB_VALUE_DRAW;
+
+        if(value == EGTB_VALUE_LOSS)
+        {
+            previous_value = EGTB_VALUE_WIN;
+
+            /* After a double push, an en passant capture can save the loser */
+            if(MOVE_GET_PIECE(unmoves[i]) == Piece_Pawn && (from ^ to) == 16)
+            {
+                Board en_passant = board;
+                BOARD_SET_EN_PASSANT_FILE(en_passant, BOARD_FILE_FROM_POS(to));
+
+                previous_value = egtb_table_value(generator, table, &en_passant) == EGTB_VALUE_LOSS ? EGTB_VALUE_WIN : EGTB_VALUE_DRAW;
+            }
+        }
+        else if(egtb_all_moves_lose(generator, table, &previous))
+        {
+            previous_value = EGTB_VALUE_LOSS;
+        }
+
+        if(previous_value != EGTB_VALUE_DRAW && egtb_resolve(table->values, previous_index, previous_value))
+        {
+            platform_atomic_fetch_or_u64(resolved + (previous_index >> 6), BIT64(previous_index & 63));
+            num_resolved++;
+        }
+    }
+
+    return num_resolved;
+}
+
+static bool egtb_generate_table(EgtbGenerator* generator, const EgtbMaterial* material, EgtbGenStats* stats);
+
+/* Generates the table of the given material, unless it or its colors swapped version exists */
+static bool egtb_generator_require(EgtbGenerator* generator, const EgtbCounts counts, EgtbGenStats* stats)
+{
+    EgtbMaterial material;
+    egtb_material_init(&material, counts);
+
+    if(material.num_pieces == 2 || egtb_generator_find(generator, material.key) != NULL)
+    {
+        return true;
+    }
+
+    return egtb_generate_table(generator, &material, stats);
+}
+
+/* Tables reached by a capture, a promotion, or both */
+static bool egtb_generate_children(EgtbGenerator* generator, const EgtbMaterial* material, EgtbGenStats* stats)
+{
+    EgtbCounts counts;
+    egtb_material_get_counts(material, counts);
+
+    bool generated = true;
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        for(uint32_t piece = Piece_Pawn; piece < Piece_King; piece++)
+        {
+            if(counts[side][piece] == 0)
+            {
+                continue;
+            }
+
+            counts[side][piece]--;
+            generated = generated && egtb_generator_require(generator, counts, stats);
+
+            for(uint32_t promotion = Piece_Knight; piece == Piece_Pawn && promotion < Piece_King; promotion++)
+            {
+                counts[side][promotion]++;
+                generated = generated && egtb_generator_require(generator, counts, stats);
+
+                for(uint32_t captured = Piece_Pawn; captured < Piece_King; captured++)
+                {
+                    if(counts[!side][captured] > 0)
+                    {
+                        counts[!side][captured]--;
+                        generated = generated && egtb_generator_require(generator, counts, stats);
+                        counts[!side][captured]++;
+                    }
+                }
+
+                counts[side][promotion]--;
+            }
+
+            counts[side][piece]++;
+        }
+    }
+
+    return generated;
+}
+
+static bool egtb_generate_table(EgtbGenerator* generator, const EgtbMaterial* material, EgtbGenStats* stats)
+{
+    if(!egtb_generate_children(generator, material, stats))
+    {
+        return false;
+    }
+
+    const uint64_t num_positions = material->num_positions;
+    const int64_t num_chunks = (int64_t)(num_positions / 64);
+
+    uint64_t* values = (uint64_t*)calloc(num_positions / 32, sizeof(uint64_t));
+    uint64_t* resolved = (uint64_t*)calloc((size_t)num_chunks, sizeof(uint64_t));
+    uint64_t* next_resolved = (uint64_t*)calloc((size_t)num_chunks, sizeof(uint64_t));
+    EgtbGenTable* tables = (EgtbGenTable*)realloc(generator->tables, (generator->num_tables + 1) * sizeof(EgtbGenTable));
+
+    if(tables != NULL)
+    {
+        generator->tables = tables;
+    }
+
+    if(values == NULL || resolved == NULL || next_resolved == NULL || tables == NULL)
+    {
+        free(values);
+        free(resolved);
+        free(next_resolved);
+        return false;
+    }
+
+    /* The table is only found by the lookups of its own positions once its values are complete */
+    EgtbGenTable* table = &tables[generator->num_tables];
+    table->material = *material;
+    table->values = values;
+
+    uint64_t num_resolved = 0;
+
+    /* Every iteration owns 64 positions: two values words and one resolved word */
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:num_resolved)
+    for(int64_t i = 0; i < num_chunks; i++)
+    {
+        uint64_t words[2] = { 0ULL, 0ULL };
+        uint64_t chunk_resolved = 0ULL;
+
+        for(uint32_t j = 0; j < 64; j++)
+        {
+            const uint64_t index = (uint64_t)i * 64 + j;
+
+            uint32_t squares[EGTB_MAX_PIECES];
+            uint32_t side;
+            Board board;
+
+            egtb_decode_index(material, index, squares, &side);
+
+            uint64_t value = EGTB_VALUE_UNUSED;
+
+            if(egtb_set_board(material, squares, side, &board) && egtb_index(material, squares, side) == index)
+            {
+                value = egtb_initial_value(generator, &board);
+            }
+
+            words[j >> 5] |= value << ((j & 31) * 2);
+            chunk_resolved |= (uint64_t)(value == EGTB_VALUE_WIN || value == EGTB_VALUE_LOSS) << j;
+        }
+
+        values[i * 2] = words[0];
+        values[i * 2 + 1] = words[1];
+        resolved[i] = chunk_resolved;
+        num_resolved += popcount_u64(chunk_resolved);
+    }
+
+    uint32_t num_passes = 0;
+
+    while(num_resolved > 0)
+    {
+        memset(next_resolved, 0, (size_t)num_chunks * sizeof(uint64_t));
+        num_resolved = 0;
+
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:num_resolved)
+        for(int64_t i = 0; i < num_chunks; i++)
+        {
+            uint64_t positions = resolved[i];
+
+            while(positions)
+            {
+                num_resolved += egtb_propagate(generator, table, (uint64_t)i * 64 + ctz_u64(positions), next_resolved);
+                positions = clsb_u64(positions);
+            }
+        }
+
+        uint64_t* swap = resolved;
+        resolved = next_resolved;
+        next_resolved = swap;
+        num_passes++;
+    }
+
+    free(resolved);
+    free(next_resolved);
+
+    generator->num_tables++;
+
+    uint64_t num_wins = 0;
+    uint64_t num_draws = 0;
+    uint64_t num_losses = 0;
+
+#pragma omp parallel for reduction(+:num_wins, num_draws, num_losses)
+    for(int64_t i = 0; i < (int64_t)num_positions; i++)
+    {
+        const uint32_t value = egtb_get_value(values, (uint64_t)i);
+
+        num_wins += value == EGTB_VALUE_WIN;
+        num_draws += value == EGTB_VALUE_DRAW;
+        num_losses += value == EGTB_VALUE_LOSS;
+    }
+
+    stats->num_positions = num_positions;
+    stats->num_legal = num_wins + num_draws + num_losses;
+    stats->num_wins = num_wins;
+    stats->num_draws = num_draws;
+    stats->num_losses = num_losses;
+    stats->num_passes = num_passes;
+    stats->num_tables++;
+
+    return true;
+}
+
+/*
+    File
+*/
+
+/* Number of positions of a block, the last one can be shorter */
+CCHESS_FORCE_INLINE uint64_t egtb_block_count(const uint64_t num_positions, const uint64_t block)
+{
+    const uint64_t first = block * EGTB_BLOCK_SIZE;
+
+    return num_positions - first < EGTB_BLOCK_SIZE ? num_positions - first : EGTB_BLOCK_SIZE;
+}
+
+/* Appends a run to a block, returns false if the block would not be smaller than its packed values */
+static bool egtb_encode_run(uint8_t* data, uint64_t* size, const uint64_t packed_size, const uint32_t value, const uint64_t length, const bool is_last)
+{
+    const uint64_t run_size = is_last || length <= EGTB_RUN_MAX_SHORT ? 1 : 3;
+
+    if(*size + run_size >= packed_size)
+    {
+        return false;
+    }
+
+    if(is_last)
+    {
+        data[(*size)++] = (uint8_t)(value | (EGTB_RUN_CODE_END << 2));
+    }
+    else if(length <= EGTB_RUN_MAX_SHORT)
+    {
+        data[(*size)++] = (uint8_t)(value | ((length - 1) << 2));
+    }
+    else
+    {
+        data[(*size)++] = (uint8_t)(value | (EGTB_RUN_CODE_LONG << 2));
+        data[(*size)++] = (uint8_t)(length & 0xFF);
+        data[(*size)++] = (uint8_t)(length >> 8);
+    }
+
+    return true;
+}
+
+/*
+    Encodes the positions of a block as runs of values in data, which holds
+    the packed values of the block. Unused positions extend the run they are
+    in, or the first run of the block. Blocks whose runs are not smaller are
+    stored as their packed values. Returns the size of the encoded block
+*/
+static uint64_t egtb_encode_block(const uint64_t* values, const uint64_t first, const uint64_t count, uint8_t* data)
+{
+    const uint64_t packed_size = (count + 3) / 4;
+
+    uint32_t run_value = EGTB_VALUE_UNUSED;
+    uint64_t run_start = 0;
+    uint64_t size = 0;
+    bool encoded = true;
+
+    for(uint64_t i = 0; i < count && encoded; i++)
+    {
+        const uint32_t value = egtb_get_value(values, first + i);
+
+        if(value == EGTB_VALUE_UNUSED || value == run_value)
+        {
+            continue;
+        }
+
+        if(run_value != EGTB_VALUE_UNUSED)
+        {
+            encoded = egtb_encode_run(data, &size, packed_size, run_value, i - run_start, false);
+            run_start = i;
+        }
+
+        run_value = value;
+    }
+
+    /* Blocks of unused positions only are stored as draws */
+    run_value = run_value == EGTB_VALUE_UNUSED ? EGTB_VALUE_DRAW : run_value;
+
+    if(encoded && egtb_encode_run(data, &size, packed_size, run_value, count - run_start, true))
+    {
+        return size;
+    }
+
+    memset(data, 0, (size_t)packed_size);
+
+    for(uint64_t i = 0; i < count; i++)
+    {
+        data[i / 4] |= (uint8_t)(egtb_get_value(values, first + i) << ((i % 4) * 2));
+    }
+
+    return packed_size;
+}
+
+/* Value of a position in an encoded block, EGTB_VALUE_UNUSED if the block is corrupted */
+static uint32_t egtb_decode_block(const uint8_t* data, const uint64_t size, const uint64_t count, const uint64_t position)
+{
+    if(size == (count + 3) / 4)
+    {
+        return (data[position / 4] >> ((position % 4) * 2)) & 0x3;
+    }
+
+    uint64_t run_end = 0;
+
+    for(uint64_t i = 0; i < size;)
+    {
+        const uint32_t value = data[i] & 0x3;
+        const uint32_t code = data[i] >> 2;
+
+        if(code == EGTB_RUN_CODE_END)
+        {
+            return value;
+        }
+
+        if(code == EGTB_RUN_CODE_LONG)
+        {
+            if(i + 3 > size)
+            {
+                break;
+            }
+
+            run_end += (uint64_t)data[i + 1] | ((uint64_t)data[i + 2] << 8);
+            i += 3;
+        }
+        else
+        {
+            run_end += code + 1;
+            i++;
+        }
+
+        if(position < run_end)
+        {
+            return value;
+        }
+    }
+
+    return EGTB_VALUE_UNUSED;
+}
+
+static bool egtb_write(const EgtbGenTable* table, const char* path, EgtbGenStats* stats)
+{
+    const uint64_t num_positions = table->material.num_positions;
+    const uint64_t num_blocks = (num_positions + EGTB_BLOCK_SIZE - 1) / EGTB_BLOCK_SIZE;
+
+    uint32_t* offsets = (uint32_t*)malloc((num_blocks + 1) * sizeof(uint32_t));
+    FILE* file = fopen(path, "wb");
+
+    bool written = offsets != NULL && file != NULL;
+
+    if(written)
+    {
+        /* Blocks are encoded once to size them, and once more when written */
+#pragma omp parallel for
+        for(int64_t i = 0; i < (int64_t)num_blocks; i++)
+        {
+            uint8_t data[EGTB_BLOCK_SIZE / 4];
+
+            offsets[i + 1] = (uint32_t)egtb_encode_block(table->values,
+                                                         (uint64_t)i * EGTB_BLOCK_SIZE,
+                                                         egtb_block_count(num_positions, (uint64_t)i),
+                                                         data);
+        }
+
+        offsets[0] = 0;
+
+        for(uint64_t i = 0; i < num_blocks; i++)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+
+        EgtbHeader header;
+        memset(&header, 0, sizeof(EgtbHeader));
+        header.magic = EGTB_MAGIC;
+        header.version = EGTB_VERSION;
+        header.num_pieces = table->material.num_pieces;
+        memcpy(header.pieces, table->material.pieces, table->material.num_pieces);
+        header.block_size = EGTB_BLOCK_SIZE;
+        header.num_positions = num_positions;
+        header.num_blocks = num_blocks;
+
+        written = fwrite(&header, sizeof(EgtbHeader), 1, file) == 1 &&
+                  fwrite(offsets, sizeof(uint32_t), num_blocks + 1, file) == num_blocks + 1;
+    }
+
+    for(uint64_t i = 0; written && i < num_blocks; i++)
+    {
+        uint8_t data[EGTB_BLOCK_SIZE / 4];
+
+        const uint64_t size = egtb_encode_block(table->values,
+                                                i * EGTB_BLOCK_SIZE,
+                                                egtb_block_count(num_positions, i),
+                                                data);
+
+        written = fwrite(data, 1, (size_t)size, file) == size;
+    }
+
+    if(written)
+    {
+        stats->file_size = sizeof(EgtbHeader) + (num_blocks + 1) * sizeof(uint32_t) + offsets[num_blocks];
+    }
+
+    if(file != NULL)
+    {
+        written &= fclose(file) == 0;
+    }
+
+    free(offsets);
+
+    return written;
+}
+
+bool egtb_generate(const char* material_name, const char* path, EgtbGenStats* stats)
+{
+    const uint64_t start = platform_get_time_ns();
+
+    EgtbGenStats local_stats;
+    stats = stats != NULL ? stats : &local_stats;
+    memset(stats, 0, sizeof(EgtbGenStats));
+
+    EgtbMaterial material;
+
+    if(!egtb_parse_material(&material, material_name))
+    {
+        return false;
+    }
+
+    EgtbGenerator generator = { NULL, 0 };
+
+    bool generated = egtb_generate_table(&generator, &material, stats);
+
+    /* The requested table is the last one generated */
+    generated = generated && egtb_write(&generator.tables[generator.num_tables - 1], path, stats);
+
+    for(size_t i = 0; i < generator.num_tables; i++)
+    {
+        free(generator.tables[i].values);
+    }
+
+    free(generator.tables);
+
+    stats->elapsed_ns = platform_get_time_ns() - start;
+
+    return generated;
+}
+
+/*
+    Probing
+*/
+
+bool egtb_open(Egtb* egtb, const char* path)
+{
+    memset(egtb, 0, sizeof(Egtb));
+
+    if(!platform_map_file(&egtb->mapping, path, FileMappingAccess_Random))
+    {
+        return false;
+    }
+
+    const EgtbHeader* header = (const EgtbHeader*)egtb->mapping.data;
+
+    bool valid = egtb->mapping.size >= sizeof(EgtbHeader) &&
+                 header->magic == EGTB_MAGIC &&
+                 header->version == EGTB_VERSION &&
+                 header->block_size == EGTB_BLOCK_SIZE &&
+                 header->num_pieces > 2 &&
+                 header->num_pieces <= EGTB_MAX_PIECES &&
+                 header->pieces[0] == EGTB_PIECE_CODE(Piece_King, PIECE_WHITE) &&
+                 header->pieces[1] == EGTB_PIECE_CODE(Piece_King, PIECE_BLACK);
+
+    EgtbCounts counts;
+    memset(counts, 0, sizeof(EgtbCounts));
+
+    for(uint32_t i = 2; valid && i < header->num_pieces; i++)
+    {
+        valid = EGTB_CODE_PIECE(header->pieces[i]) < Piece_King && EGTB_CODE_SIDE(header->pieces[i]) < 2;
+        counts[EGTB_CODE_SIDE(header->pieces[i]) & 1][EGTB_CODE_PIECE(header->pieces[i]) % Piece_King]++;
+    }
+
+    valid = valid &&
+            egtb_material_init(&egtb->material, counts) &&
+            memcmp(egtb->material.pieces, header->pieces, header->num_pieces) == 0 &&
+            header->num_positions == egtb->material.num_positions &&
+            header->num_blocks == (header->num_positions + EGTB_BLOCK_SIZE - 1) / EGTB_BLOCK_SIZE;
+
+    const uint64_t data_offset = sizeof(EgtbHeader) + (valid ? header->num_blocks + 1 : 0) * sizeof(uint32_t);
+
+    valid = valid && egtb->mapping.size >= data_offset;
+
+    if(valid)
+    {
+        egtb->header = header;
+        egtb->offsets = (const uint32_t*)(egtb->mapping.data + sizeof(EgtbHeader));
+        egtb->data = (const uint8_t*)egtb->mapping.data + data_offset;
+
+        valid = egtb->offsets[0] == 0 && egtb->offsets[header->num_blocks] <= egtb->mapping.size - data_offset;
+
+        for(uint64_t i = 0; valid && i < header->num_blocks; i++)
+        {
+            const uint64_t size = (uint64_t)egtb->offsets[i + 1] - egtb->offsets[i];
+
+            valid = egtb->offsets[i + 1] > egtb->offsets[i] &&
+                    size <= (egtb_block_count(header->num_positions, i) + 3) / 4;
+        }
+    }
+
+    if(!valid)
+    {
+        egtb_close(egtb);
+    }
+
+    return valid;
+}
+
+void egtb_close(Egtb* egtb)
+{
+    platform_unmap_file(&egtb->mapping);
+    memset(egtb, 0, sizeof(Egtb));
+}
+
+bool egtb_probe_wdl(const Egtb* egtb, Board* board, EgtbWdl* wdl)
+{
+    uint32_t squares[EGTB_MAX_PIECES];
+    uint32_t side;
+
+    if((board->state & BOARD_STATE_CASTLE_MASK) ||
+       !egtb_get_squares(&egtb->material, board, squares, &side) ||
+       egtb_has_en_passant_capture(board))
+    {
+        return false;
+    }
+
+    const uint32_t board_side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    /* The runs cover the unused indices of the illegal positions, they are rejected here */
+    if(((board_get_pawns(board, PIECE_WHITE) | board_get_pawns(board, PIECE_BLACK)) & EGTB_RANKS_1_AND_8) ||
+       board_attackers_to(board, (uint32_t)ctz_u64(board_get_king(board, !board_side)), board_side, board_get_all(board)) != 0ULL)
+    {
+        return false;
+    }
+
+    const uint64_t index = egtb_index(&egtb->material, squares, side);
+    const uint64_t block = index / EGTB_BLOCK_SIZE;
+    const uint64_t offset = egtb->offsets[block];
+
+    const uint32_t value = egtb_decode_block(egtb->data + offset,
+                                             egtb->offsets[block + 1] - offset,
+                                             egtb_block_count(egtb->material.num_positions, block),
+                                             index % EGTB_BLOCK_SIZE);
+
+    switch(value)
+    {
+        case EGTB_VALUE_WIN:
+            *wdl = EgtbWdl_Win;
+            return true;
+        case EGTB_VALUE_LOSS:
+            *wdl = EgtbWdl_Loss;
+            return true;
+        case EGTB_VALUE_DRAW:
+            *wdl = EgtbWdl_Draw;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,380 @@
+#include "cchess/epd.h"
+#include "cchess/char_utils.h"
+#include "cchess/platform.h"
+
+#include "libromano/memory.h"
+
+#include <string.h>
+
+/* Size of the chunks of the file processed by a single thread */
+#define EPD_CHUNK_SIZE ((size_t)1 << 20)
+
+/* Longest prefix of a line copied to be parsed as a null terminated FEN */
+#define EPD_FEN_BUFFER_SIZE 128
+
+CCHESS_FORCE_INLINE bool epd_is_blank(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+CCHESS_FORCE_INLINE uint64_t epd_parse_u64(const char* s, const char* end)
+{
+    uint64_t value = 0;
+
+    while(s < end && is_digit((unsigned char)*s))
+    {
+        value = value * 10 + to_digit((unsigned char)*s);
+        s++;
+    }
+
+    return value;
+}
+
+void epd_parse_operation(EpdRecord* record,
+                         const char* opcode,
+                         const size_t opcode_length,
+                         const char* operands,
+                         const size_t operands_length)
+{
+    if(opcode_length == 2 && opcode[0] == 'b' && opcode[1] == 'm')
+    {
+        record->best_moves = operands;
+        record->best_moves_length = (uint32_t)operands_length;
+    }
+    else if(opcode_length == 2 && opcode[0] == 'a' && opcode[1] == 'm')
+    {
+        record->avoid_moves = operands;
+        record->avoid_moves_length = (uint32_t)operands_length;
+    }
+    else if(opcode_length == 2 && opcode[0] == 'i' && opcode[1] == 'd')
+    {
+        if(operands_length >= 2 && operands[0] == '"' && operands[operands_length - 1] == '"')
+        {
+            record->id = operands + 1;
+            record->id_length = (uint32_t)operands_length - 2;
+        }
+        else
+        {
+            record->id = operands;
+            record->id_length = (uint32_t)operands_length;
+        }
+    }
+    else if(opcode_length >= 2 && opcode[0] == 'D' && is_digit((unsigned char)opcode[1]))
+    {
+        const uint64_t depth = epd_parse_u64(opcode + 1, opcode + opcode_length);
+
+        if(depth >= 1 && depth <= EPD_MAX_PERFT_DEPTH)
+        {
+            record->perft[depth - 1] = epd_parse_u64(operands, operands + operands_length);
+            record->perft_depth = depth > record->perft_depth ? (uint32_t)depth : record->perft_depth;
+        }
+    }
+    else if(opcode_length == 4 && memcmp(opcode, "hmvc", 4) == 0)
+    {
+        record->board.halfmove_clock = (uint16_t)epd_parse_u64(operands, operands + operands_length);
+    }
+    else if(opcode_length == 4 && memcmp(opcode, "fmvn", 4) == 0)
+    {
+        record->board.fullmove_number = (uint16_t)epd_parse_u64(operands, operands + operands_length);
+    }
+}
+
+bool epd_parse_line(EpdRecord* record, const char* line, size_t length)
+{
+    memset(record, 0, sizeof(EpdRecord));
+
+    while(length > 0 && epd_is_blank(*line))
+    {
+        line++;
+        length--;
+    }
+
+    /*
+        The FEN part is copied so it is null terminated, the line itself may
+        end at the end of a memory mapped file
+    */
+    char fen[EPD_FEN_BUFFER_SIZE];
+
+    const size_t fen_length = length < (EPD_FEN_BUFFER_SIZE - 1) ? length : (EPD_FEN_BUFFER_SIZE - 1);
+
+    memcpy(fen, line, fen_length);
+    fen[fen_length] = '\0';
+
+    const size_t consumed = board_parse_fen(&record->board, fen);
+
+    if(consumed == 0)
+    {
+        return false;
+    }
+
+    const char* s = line + consumed;
+    const char* end = line + length;
+
+    while(s < end)
+    {
+        while(s < end && (epd_is_blank(*s) || *s == ';'))
+        {
+            s++;
+        }
+
+        if(s >= end)
+        {
+            break;
+        }
+
+        const char* opcode = s;
+
+        while(s < end && !epd_is_blank(*s) && *s != ';')
+        {
+            s++;
+        }
+
+        const size_t opcode_length = (size_t)(s - opcode);
+
+        while(s < end && epd_is_blank(*s))
+        {
+            s++;
+        }
+
+        const char* operands = s;
+
+        bool in_quotes = false;
+
+        while(s < end && (in_quotes || *s != ';'))
+        {
+            in_quotes ^= (*s == '"');
+            s++;
+        }
+
+        const char* operands_end = s;
+
+        while(operands_end > operands && epd_is_blank(operands_end[-1]))
+        {
+            operands_end--;
+        }
+
+        epd_parse_operation(record, opcode, opcode_length, operands, (size_t)(operands_end - operands));
+    }
+
+    return true;
+}
+
+CCHESS_FORCE_INLINE bool epd_line_is_record(const char* line, const size_t length)
+{
+    size_t i = 0;
+
+    while(i < length && epd_is_blank(line[i]))
+    {
+        i++;
+    }
+
+    return i < length && line[i] != '#';
+}
+
+typedef struct
+{
+    size_t begin;
+    size_t end;
+    size_t first_record;
+    size_t num_records;
+} EpdChunk;
+
+/* Splits the file in chunks starting at the beginning of a line */
+size_t epd_split_chunks(const FileMapping* mapping, EpdChunk** chunks)
+{
+    const size_t max_chunks = mapping->size / EPD_CHUNK_SIZE + 1;
+
+    *chunks = (EpdChunk*)calloc(max_chunks, sizeof(EpdChunk));
+
+    if(*chunks == NULL)
+    {
+        return 0;
+    }
+
+    size_t num_chunks = 0;
+    size_t begin = 0;
+
+    while(begin < mapping->size)
+    {
+        size_t end = begin + EPD_CHUNK_SIZE;
+
+        if(end >= mapping->size)
+        {
+            end = mapping->size;
+        }
+        else
+        {
+            const char* new_line = (const char*)memchr(mapping->data + end, '\n', mapping->size - end);
+            end = new_line != NULL ? (size_t)(new_line - mapping->data) + 1 : mapping->size;
+        }
+
+        (*chunks)[num_chunks].begin = begin;
+        (*chunks)[num_chunks].end = end;
+        num_chunks++;
+
+        begin = end;
+    }
+
+    return num_chunks;
+}
+
+void epd_count_records(const FileMapping* mapping, EpdChunk* chunk)
+{
+    const char* s = mapping->data + chunk->begin;
+    const char* end = mapping->data + chunk->end;
+
+    chunk->num_records = 0;
+
+    while(s < end)
+    {
+        const char* new_line = (const char*)memchr(s, '\n', (size_t)(end - s));
+        const char* line_end = new_line != NULL ? new_line : end;
+
+        chunk->num_records += epd_line_is_record(s, (size_t)(line_end - s));
+
+        s = line_end + 1;
+    }
+}
+
+size_t epd_parse_chunk(const FileMapping* mapping,
+                       const EpdChunk* chunk,
+                       Board* boards,
+                       const size_t max_boards,
+                       epd_record_func func,
+                       void* user_data)
+{
+    const char* s = mapping->data + chunk->begin;
+    const char* end = mapping->data + chunk->end;
+
+    size_t record_index = chunk->first_record;
+    size_t num_errors = 0;
+
+    EpdRecord record;
+
+    while(s < end)
+    {
+        const char* new_line = (const char*)memchr(s, '\n', (size_t)(end - s));
+        const char* line_end = new_line != NULL ? new_line : end;
+        const size_t length = (size_t)(line_end - s);
+
+        if(epd_line_is_record(s, length))
+        {
+            const bool parsed = epd_parse_line(&record, s, length);
+
+            num_errors += !parsed;
+
+            if(boards != NULL && record_index < max_boards)
+            {
+                if(!parsed)
+                {
+                    memset(&record.board, 0, sizeof(Board));
+                }
+
+                boards[record_index] = record.board;
+            }
+
+            if(func != NULL && parsed)
+            {
+                func(&record, record_index, user_data);
+            }
+
+            record_index++;
+        }
+
+        s = line_end + 1;
+    }
+
+    return num_errors;
+}
+
+bool epd_process(const char* path,
+                 Board* boards,
+                 const size_t max_boards,
+                 size_t* num_records,
+                 epd_record_func func,
+                 void* user_data,
+                 EpdLoadStats* stats)
+{
+    const uint64_t start = platform_get_time_ns();
+
+    FileMapping mapping;
+
+    if(!platform_map_file(&mapping, path, FileMappingAccess_Sequential))
+    {
+        return false;
+    }
+
+    EpdChunk* chunks = NULL;
+    const size_t num_chunks = epd_split_chunks(&mapping, &chunks);
+
+    if(chunks == NULL)
+    {
+        platform_unmap_file(&mapping);
+        return false;
+    }
+
+    const int64_t num_chunks_i = (int64_t)num_chunks;
+
+    /* First pass counts the records of each chunk to know where their output begins */
+#pragma omp parallel for schedule(dynamic, 1)
+    for(int64_t i = 0; i < num_chunks_i; i++)
+    {
+        epd_count_records(&mapping, &chunks[i]);
+    }
+
+    size_t total_records = 0;
+
+    for(size_t i = 0; i < num_chunks; i++)
+    {
+        chunks[i].first_record = total_records;
+        total_records += chunks[i].num_records;
+    }
+
+    size_t num_errors = 0;
+
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:num_errors)
+    for(int64_t i = 0; i < num_chunks_i; i++)
+    {
+        num_errors += epd_parse_chunk(&mapping, &chunks[i], boards, max_boards, func, user_data);
+    }
+
+    if(num_records != NULL)
+    {
+        *num_records = total_records;
+    }
+
+    if(stats != NULL)
+    {
+        const uint64_t elapsed = platform_get_time_ns() - start;
+        const double seconds = elapsed > 0 ? (double)elapsed * 1e-9 : 1e-9;
+
+        stats->num_records = total_records;
+        stats->num_errors = num_errors;
+        stats->num_bytes = mapping.size;
+        stats->elapsed_ns = elapsed;
+        stats->records_per_second = (double)total_records / seconds;
+        stats->megabytes_per_second = ((double)mapping.size / (1024.0 * 1024.0)) / seconds;
+    }
+
+    free(chunks);
+    platform_unmap_file(&mapping);
+
+    return true;
+}
+
+bool epd_load_boards(const char* path,
+                     Board* boards,
+                     const size_t max_boards,
+                     size_t* num_boards,
+                     EpdLoadStats* stats)
+{
+    return epd_process(path, boards, max_boards, num_boards, NULL, NULL, stats);
+}
+
+bool epd_load(const char* path,
+              epd_record_func func,
+              void* user_data,
+              EpdLoadStats* stats)
+{
+    return epd_process(path, NULL, 0, NULL, func, user_data, stats);
+}
@@ -0,0 +1,201 @@
+#include "cchess/eval.h"
+
+#include "libromano/bit.h"
+
+/*
+    Piece values and piece-square tables, after the simplified evaluation
+    function of Tomasz Michniewski. In the endgame the pawns and rooks are
+    worth more, and the tables push the pawns and the king forward and the
+    rooks to the seventh rank
+*/
+
+const int16_t eval_piece_values_mg[6] = { 100, 320, 330, 500, 900, 0 };
+const int16_t eval_piece_values_eg[6] = { 120, 300, 320, 540, 940, 0 };
+
+const int32_t eval_phase_weights[6] = { 0, 1, 1, 2, 4, 0 };
+
+/* From the point of view of white, rank 8 first */
+
+const int16_t eval_psqt_mg[6][64] = {
+    /* Pawn */
+    {
+          0,   0,   0,   0,   0,   0,   0,   0,
+         50,  50,  50,  50,  50,  50,  50,  50,
+         10,  10,  20,  30,  30,  20,  10,  10,
+          5,   5,  10,  25,  25,  10,   5,   5,
+          0,   0,   0,  20,  20,   0,   0,   0,
+          5,  -5, -10,   0,   0, -10,  -5,   5,
+          5,  10,  10, -20, -20,  10,  10,   5,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    },
+    /* Knight */
+    {
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50,
+    },
+    /* Bishop */
+    {
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20,
+    },
+    /* Rook */
+    {
+          0,   0,   0,   0,   0,   0,   0,   0,
+          5,  10,  10,  10,  10,  10,  10,   5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+          0,   0,   0,   5,   5,   0,   0,   0,
+    },
+    /* Queen */
+    {
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+    },
+    /* King */
+    {
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+         20,  20,   0,   0,   0,   0,  20,  20,
+         20,  30,  10,   0,   0,  10,  30,  20,
+    },
+};
+
+const int16_t eval_psqt_eg[6][64] = {
+    /* Pawn */
+    {
+          0,   0,   0,   0,   0,   0,   0,   0,
+         80,  80,  80,  80,  80,  80,  80,  80,
+         50,  50,  50,  50,  50,  50,  50,  50,
+         30,  30,  30,  30,  30,  30,  30,  30,
+         15,  15,  15,  15,  15,  15,  15,  15,
+          5,   5,   5,   5,   5,   5,   5,   5,
+          0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    },
+    /* Knight */
+    {
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50,
+    },
+    /* Bishop */
+    {
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20,
+    },
+    /* Rook */
+    {
+         10,  10,  10,  10,  10,  10,  10,  10,
+         15,  15,  15,  15,  15,  15,  15,  15,
+          0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    },
+    /* Queen */
+    {
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+    },
+    /* King */
+    {
+        -50, -40, -30, -20, -20, -30, -40, -50,
+        -30, -20, -10,   0,   0, -10, -20, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -30,   0,   0,   0,   0, -30, -30,
+        -50, -30, -30, -30, -30, -30, -30, -50,
+    },
+};
+
+void eval_compute(const Board* board, int16_t* psqt_mg, int16_t* psqt_eg, int32_t* phase)
+{
+    int32_t mg = 0;
+    int32_t eg = 0;
+    int32_t total_phase = 0;
+
+    for(uint32_t i = 0; i < 12; i++)
+    {
+        const uint32_t piece = i / 2;
+        const uint32_t side = i % 2;
+
+        uint64_t pieces = board_get_pieces(board, piece, side);
+
+        while(pieces)
+        {
+            const uint32_t square = (uint32_t)ctz_u64(pieces);
+
+            mg += eval_get_psqt_mg(piece, side, square);
+            eg += eval_get_psqt_eg(piece, side, square);
+            total_phase += eval_phase_weights[piece];
+
+            pieces = clsb_u64(pieces);
+        }
+    }
+
+    *psqt_mg = (int16_t)mg;
+    *psqt_eg = (int16_t)eg;
+    *phase = total_phase;
+}
+
+void eval_init_board(Board* board)
+{
+    eval_compute(board, &board->psqt_mg, &board->psqt_eg, &board->phase);
+}
+
+bool eval_board_is_valid(const Board* board)
+{
+    int16_t psqt_mg;
+    int16_t psqt_eg;
+    int32_t phase;
+
+    eval_compute(board, &psqt_mg, &psqt_eg, &phase);
+
+    return psqt_mg == board->psqt_mg && psqt_eg == board->psqt_eg && phase == board->phase;
+}
@@ -0,0 +1,514 @@
+#include "cchess/game_db.h"
+#include "cchess/packed_board.h"
+#include "cchess/zobrist.h"
+
+#include "libromano/memory.h"
+
+#define GAME_DB_INDEX_MAGIC 0x49444743 /* CGDI */
+#define GAME_DB_INDEX_VERSION 1
+
+#define GAME_DB_GAME_HAS_START 0x1
+
+/* Number of entries written at once when writing the index */
+#define GAME_DB_WRITE_BUFFER_SIZE 4096
+
+typedef struct
+{
+    uint32_t num_moves;
+    uint8_t result;
+    uint8_t flags;
+    uint16_t reserved;
+} GameDbGameHeader;
+
+STATIC_ASSERT(sizeof(GameDbGameHeader) == 8);
+STATIC_ASSERT(sizeof(GameDbIndexHeader) == 64);
+STATIC_ASSERT(sizeof(Move) == 2);
+
+bool game_db_make_path(char* out, const char* path, const char* extension)
+{
+    const size_t path_length = strlen(path);
+    const size_t extension_length = strlen(extension);
+
+    if(path_length + extension_length >= GAME_DB_MAX_PATH_SIZE)
+    {
+        return false;
+    }
+
+    memcpy(out, path, path_length);
+    memcpy(out + path_length, extension, extension_length + 1);
+
+    return true;
+}
+
+/* Grows an array to hold at least count elements, doubling its capacity */
+bool game_db_reserve(void** data, size_t* capacity, const size_t count, const size_t element_size)
+{
+    if(count <= *capacity)
+    {
+        return true;
+    }
+
+    size_t new_capacity = *capacity > 0 ? *capacity : 1024;
+
+    while(new_capacity < count)
+    {
+        new_capacity *= 2;
+    }
+
+    void* new_data = realloc(*data, new_capacity * element_size);
+
+    if(new_data == NULL)
+    {
+        return false;
+    }
+
+    *data = new_data;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+/* First index i in [0, n] with keys[i] >= key, without unpredictable branches */
+CCHESS_FORCE_INLINE size_t game_db_lower_bound(const uint64_t* keys, size_t n, const uint64_t key)
+{
+    if(n == 0)
+    {
+        return 0;
+    }
+
+    const uint64_t* base = keys;
+
+    while(n > 1)
+    {
+        const size_t half = n / 2;
+        base = base[half] < key ? base + half : base;
+        n -= half;
+    }
+
+    return (size_t)(base - keys) + (*base < key);
+}
+
+bool game_db_map_index(GameDb* db, const char* index_path)
+{
+    if(!platform_map_file(&db->index_mapping, index_path, FileMappingAccess_Random))
+    {
+        return false;
+    }
+
+    const FileMapping* mapping = &db->index_mapping;
+
+    if(mapping->size < sizeof(GameDbIndexHeader))
+    {
+        platform_unmap_file(&db->index_mapping);
+        return false;
+    }
+
+    const GameDbIndexHeader* header = (const GameDbIndexHeader*)mapping->data;
+
+    const uint64_t expected_size = sizeof(GameDbIndexHeader) +
+                                   header->num_games * sizeof(uint64_t) +
+                                   header->num_fences * sizeof(uint64_t) +
+                                   header->num_entries * (sizeof(uint64_t) + sizeof(uint32_t));
+
+    if(header->magic != GAME_DB_INDEX_MAGIC ||
+       header->version != GAME_DB_INDEX_VERSION ||
+       expected_size != (uint64_t)mapping->size)
+    {
+        platform_unmap_file(&db->index_mapping);
+        return false;
+    }
+
+    db->header = header;
+    db->offsets = (const uint64_t*)(mapping->data + sizeof(GameDbIndexHeader));
+    db->fences = db->offsets + header->num_games;
+    db->keys = db->fences + header->num_fences;
+    db->game_ids = (const uint32_t*)(db->keys + header->num_entries);
+
+    return true;
+}
+
+bool game_db_writer_open(GameDbWriter* writer, const char* path)
+{
+    memset(writer, 0, sizeof(GameDbWriter));
+
+    char games_path[GAME_DB_MAX_PATH_SIZE];
+    char index_path[GAME_DB_MAX_PATH_SIZE];
+
+    if(!game_db_make_path(games_path, path, ".games") ||
+       !game_db_make_path(index_path, path, ".index") ||
+       !game_db_make_path(writer->path, path, ""))
+    {
+        return false;
+    }
+
+    /* Existing games are only kept if they are indexed */
+    GameDb db;
+    memset(&db, 0, sizeof(GameDb));
+
+    const bool has_index = game_db_map_index(&db, index_path);
+
+    writer->games_file = fopen(games_path, has_index ? "ab" : "wb");
+
+    if(writer->games_file == NULL)
+    {
+        if(has_index)
+        {
+            platform_unmap_file(&db.index_mapping);
+        }
+
+        return false;
+    }
+
+    fseek(writer->games_file, 0, SEEK_END);
+    writer->games_size = (uint64_t)ftell(writer->games_file);
+
+    if(!has_index)
+    {
+        return true;
+    }
+
+    const size_t num_games = (size_t)db.header->num_games;
+    const size_t num_entries = (size_t)db.header->num_entries;
+
+    if(!game_db_reserve((void**)&writer->offsets, &writer->offsets_capacity, num_games, sizeof(uint64_t)) ||
+       !game_db_reserve((void**)&writer->entries, &writer->entries_capacity, num_entries, sizeof(GameDbEntry)))
+    {
+        platform_unmap_file(&db.index_mapping);
+        fclose(writer->games_file);
+        free(writer->offsets);
+        free(writer->entries);
+        memset(writer, 0, sizeof(GameDbWriter));
+        return false;
+    }
+
+    if(num_games > 0)
+    {
+        memcpy(writer->offsets, db.offsets, num_games * sizeof(uint64_t));
+    }
+
+    for(size_t i = 0; i < num_entries; i++)
+    {
+        writer->entries[i].key = db.keys[i];
+        writer->entries[i].game_id = db.game_ids[i];
+    }
+
+    writer->num_games = num_games;
+    writer->num_entries = num_entries;
+
+    platform_unmap_file(&db.index_mapping);
+
+    return true;
+}
+
+bool game_db_writer_add_game(GameDbWriter* writer,
+                             const Board* start,
+                             const Move* moves,
+                             const uint32_t num_moves,
+                             const PgnResult result)
+{
+    if(writer->games_file == NULL || writer->num_games >= UINT32_MAX)
+    {
+        return false;
+    }
+
+    if(!game_db_reserve((void**)&writer->offsets, &writer->offsets_capacity, writer->num_games + 1, sizeof(uint64_t)) ||
+       !game_db_reserve((void**)&writer->entries, &writer->entries_capacity, writer->num_entries + num_moves + 1, sizeof(GameDbEntry)))
+    {
+        return false;
+    }
+
+    Board board = board_init();
+
+    GameDbGameHeader header;
+    header.num_moves = num_moves;
+    header.result = (uint8_t)result;
+    header.flags = (start != NULL && memcmp(start, &board, sizeof(Board)) != 0) ? GAME_DB_GAME_HAS_START : 0;
+    header.reserved = 0;
+
+    PackedBoard packed;
+
+    if((header.flags & GAME_DB_GAME_HAS_START) && !packed_board_encode(&packed, start))
+    {
+        return false;
+    }
+
+    size_t size = sizeof(GameDbGameHeader) + num_moves * sizeof(Move);
+    bool written = fwrite(&header, sizeof(GameDbGameHeader), 1, writer->games_file) == 1;
+
+    if(header.flags & GAME_DB_GAME_HAS_START)
+    {
+        written &= fwrite(&packed, sizeof(PackedBoard), 1, writer->games_file) == 1;
+        size += sizeof(PackedBoard);
+
+        board = *start;
+    }
+
+    written &= num_moves == 0 || fwrite(moves, sizeof(Move), num_moves, writer->games_file) == num_moves;
+
+    if(!written)
+    {
+        return false;
+    }
+
+    const uint64_t game_id = writer->num_games;
+
+    writer->offsets[writer->num_games++] = writer->games_size;
+    writer->games_size += size;
+
+    GameDbEntry* entries = writer->entries + writer->num_entries;
+
+    entries[0].key = board.key;
+    entries[0].game_id = game_id;
+
+    for(uint32_t i = 0; i < num_moves; i++)
+    {
+        board_make_move(&board, moves[i]);
+
+        entries[i + 1].key = board.key;
+        entries[i + 1].game_id = game_id;
+    }
+
+    writer->num_entries += num_moves + 1;
+
+    return true;
+}
+
+int game_db_entry_compare(const void* a, const void* b)
+{
+    const GameDbEntry* entry_a = (const GameDbEntry*)a;
+    const GameDbEntry* entry_b = (const GameDbEntry*)b;
+
+    if(entry_a->key != entry_b->key)
+    {
+        return entry_a->key < entry_b->key ? -1 : 1;
+    }
+
+    return (entry_a->game_id > entry_b->game_id) - (entry_a->game_id < entry_b->game_id);
+}
+
+bool game_db_write_index(GameDbWriter* writer, FILE* file)
+{
+    /* A game reaching the same position several times is indexed once */
+    size_t num_entries = 0;
+
+    for(size_t i = 0; i < writer->num_entries; i++)
+    {
+        if(num_entries == 0 ||
+           writer->entries[i].key != writer->entries[num_entries - 1].key ||
+           writer->entries[i].game_id != writer->entries[num_entries - 1].game_id)
+        {
+            writer->entries[num_entries++] = writer->entries[i];
+        }
+    }
+
+    GameDbIndexHeader header;
+    memset(&header, 0, sizeof(GameDbIndexHeader));
+
+    header.magic = GAME_DB_INDEX_MAGIC;
+    header.version = GAME_DB_INDEX_VERSION;
+    header.num_games = writer->num_games;
+    header.num_entries = num_entries;
+    header.num_fences = (num_entries + GAME_DB_KEYS_PER_FENCE - 1) / GAME_DB_KEYS_PER_FENCE;
+
+    bool written = fwrite(&header, sizeof(GameDbIndexHeader), 1, file) == 1;
+
+    written &= writer->num_games == 0 ||
+               fwrite(writer->offsets, sizeof(uint64_t), writer->num_games, file) == writer->num_games;
+
+    uint64_t keys[GAME_DB_WRITE_BUFFER_SIZE];
+    uint32_t game_ids[GAME_DB_WRITE_BUFFER_SIZE];
+
+    for(size_t i = 0; written && i < num_entries; i += GAME_DB_KEYS_PER_FENCE)
+    {
+        written &= fwrite(&writer->entries[i].key, sizeof(uint64_t), 1, file) == 1;
+    }
+
+    for(size_t i = 0; written && i < num_entries; i += GAME_DB_WRITE_BUFFER_SIZE)
+    {
+        const size_t count = num_entries - i < GAME_DB_WRITE_BUFFER_SIZE ? num_entries - i : GAME_DB_WRITE_BUFFER_SIZE;
+
+        for(size_t j = 0; j < count; j++)
+        {
+            keys[j] = writer->entries[i + j].key;
+        }
+
+        written &= fwrite(keys, sizeof(uint64_t), count, file) == count;
+    }
+
+    for(size_t i = 0; written && i < num_entries; i += GAME_DB_WRITE_BUFFER_SIZE)
+    {
+        const size_t count = num_entries - i < GAME_DB_WRITE_BUFFER_SIZE ? num_entries - i : GAME_DB_WRITE_BUFFER_SIZE;
+
+        for(size_t j = 0; j < count; j++)
+        {
+            game_ids[j] = (uint32_t)writer->entries[i + j].game_id;
+        }
+
+        written &= fwrite(game_ids, sizeof(uint32_t), count, file) == count;
+    }
+
+    return written;
+}
+
+bool game_db_writer_close(GameDbWriter* writer)
+{
+    bool success = writer->games_file != NULL;
+
+    if(writer->games_file != NULL)
+    {
+        success &= fclose(writer->games_file) == 0;
+        writer->games_file = NULL;
+    }
+
+    if(success)
+    {
+        qsort(writer->entries, writer->num_entries, sizeof(GameDbEntry), game_db_entry_compare);
+
+        char index_path[GAME_DB_MAX_PATH_SIZE];
+        game_db_make_path(index_path, writer->path, ".index");
+
+        FILE* file = fopen(index_path, "wb");
+
+        success = file != NULL && game_db_write_index(writer, file);
+
+        if(file != NULL)
+        {
+            success &= fclose(file) == 0;
+        }
+    }
+
+    free(writer->offsets);
+    free(writer->entries);
+
+    writer->offsets = NULL;
+    writer->entries = NULL;
+    writer->num_games = 0;
+    writer->num_entries = 0;
+    writer->offsets_capacity = 0;
+    writer->entries_capacity = 0;
+
+    return success;
+}
+
+bool game_db_open(GameDb* db, const char* path)
+{
+    memset(db, 0, sizeof(GameDb));
+
+    char games_path[GAME_DB_MAX_PATH_SIZE];
+    char index_path[GAME_DB_MAX_PATH_SIZE];
+
+    if(!game_db_make_path(games_path, path, ".games") ||
+       !game_db_make_path(index_path, path, ".index"))
+    {
+        return false;
+    }
+
+    if(!game_db_map_index(db, index_path))
+    {
+        return false;
+    }
+
+    if(!platform_map_file(&db->games_mapping, games_path, FileMappingAccess_Random))
+    {
+        platform_unmap_file(&db->index_mapping);
+        memset(db, 0, sizeof(GameDb));
+        return false;
+    }
+
+    return true;
+}
+
+void game_db_close(GameDb* db)
+{
+    if(db->header != NULL)
+    {
+        platform_unmap_file(&db->games_mapping);
+        platform_unmap_file(&db->index_mapping);
+    }
+
+    memset(db, 0, sizeof(GameDb));
+}
+
+size_t game_db_find_games(const GameDb* db,
+                          const uint64_t key,
+                          uint32_t* game_ids,
+                          const size_t max_game_ids)
+{
+    if(db->header == NULL || db->header->num_entries == 0)
+    {
+        return 0;
+    }
+
+    const size_t num_entries = (size_t)db->header->num_entries;
+
+    /* The fences give the page of keys holding the first key not lower than the searched one */
+    const size_t fence = game_db_lower_bound(db->fences, (size_t)db->header->num_fences, key);
+
+    const size_t begin = fence == 0 ? 0 : (fence - 1) * GAME_DB_KEYS_PER_FENCE;
+    const size_t end = fence * GAME_DB_KEYS_PER_FENCE < num_entries ? fence * GAME_DB_KEYS_PER_FENCE : num_entries;
+
+    size_t i = begin + game_db_lower_bound(db->keys + begin, end - begin, key);
+    size_t num_found = 0;
+
+    for(; i < num_entries && db->keys[i] == key; i++)
+    {
+        if(num_found < max_game_ids)
+        {
+            game_ids[num_found] = db->game_ids[i];
+        }
+
+        num_found++;
+    }
+
+    return num_found;
+}
+
+bool game_db_get_game(const GameDb* db, const uint32_t game_id, GameDbGame* game)
+{
+    if(db->header == NULL || game_id >= db->header->num_games)
+    {
+        return false;
+    }
+
+    const uint64_t offset = db->offsets[game_id];
+    const uint64_t games_size = (uint64_t)db->games_mapping.size;
+
+    if(offset + sizeof(GameDbGameHeader) > games_size)
+    {
+        return false;
+    }
+
+    const uint8_t* data = (const uint8_t*)db->games_mapping.data + offset;
+
+    GameDbGameHeader header;
+    memcpy(&header, data, sizeof(GameDbGameHeader));
+
+    data += sizeof(GameDbGameHeader);
+
+    const uint64_t start_size = (header.flags & GAME_DB_GAME_HAS_START) ? sizeof(PackedBoard) : 0;
+
+    if(offset + sizeof(GameDbGameHeader) + start_size + header.num_moves * sizeof(Move) > games_size)
+    {
+        return false;
+    }
+
+    if(header.flags & GAME_DB_GAME_HAS_START)
+    {
+        PackedBoard packed;
+        memcpy(&packed, data, sizeof(PackedBoard));
+
+        packed_board_decode(&game->board, &packed);
+
+        data += sizeof(PackedBoard);
+    }
+    else
+    {
+        game->board = board_init();
+    }
+
+    game->result = (PgnResult)header.result;
+    game->num_moves = header.num_moves;
+    game->moves = data;
+
+    return true;
+}
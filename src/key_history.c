@@ -0,0 +1,71 @@
+#include "cchess/key_history.h"
+#include "cchess/zobrist.h"
+
+CCHESS_FORCE_INLINE uint64_t key_history_get(const KeyHistory* history, const uint32_t plies_back)
+{
+    return history->keys[(history->size - 1 - plies_back) & KEY_HISTORY_MASK];
+}
+
+bool key_history_is_repetition(const KeyHistory* history, const uint32_t ply)
+{
+    const uint32_t scan_plies = key_history_scan_plies(history);
+
+    if(scan_plies < 4)
+    {
+        return false;
+    }
+
+    const uint64_t key = key_history_get(history, 0);
+
+    uint32_t num_repetitions = 0;
+
+    for(uint32_t i = 4; i <= scan_plies; i += 2)
+    {
+        if(key_history_get(history, i) == key)
+        {
+            if(i < ply)
+            {
+                return true;
+            }
+
+            if(++num_repetitions == 2)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool key_history_has_upcoming_repetition(const KeyHistory* history, const Board* board, const uint32_t ply)
+{
+    const uint32_t scan_plies = key_history_scan_plies(history);
+
+    if(scan_plies < 3)
+    {
+        return false;
+    }
+
+    const uint64_t key = key_history_get(history, 0);
+    const uint64_t occupancy = board_get_all(board);
+
+    /* The positions an odd number of plies ago have the other side to play, so one move of the side to play away */
+    for(uint32_t i = 3; i <= scan_plies; i += 2)
+    {
+        uint32_t a, b;
+
+        if(!zobrist_cuckoo_find(key ^ key_history_get(history, i), &a, &b))
+        {
+            continue;
+        }
+
+        /* Positions before the root would need a third occurrence, they are left to key_history_is_repetition */
+        if(i < ply && (move_gen_between(a, b) & occupancy) == 0ULL)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
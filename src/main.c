@@ -1,9 +1,578 @@
-#include "cchess/board.h"
+#include "cchess/search.h"
+#include "cchess/notation.h"
+#include "cchess/platform.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    UCI front-end. The main thread reads the commands on stdin and answers
+    them, searches running on a thread of their own that starts the threads
+    of the search. stop, isready and ponderhit are answered while searching,
+    the best move being sent by the search thread when it is done.
+
+    The position is parsed once from its FEN, the moves being played from
+    there. In ponder and infinite modes, the best move is sent only after
+    stop or ponderhit, even if the search ended before. With debug on, the
+    overshoots of the time limits are sent after each timed search
+*/
+
+#define UCI_ENGINE_NAME "cchess"
+#define UCI_ENGINE_AUTHOR "the cchess developers"
+
+/* Enough for a position command of ten thousand moves */
+#define UCI_LINE_SIZE 65536
+#define UCI_TOKEN_SIZE 128
+#define UCI_OUTPUT_SIZE 4096
+
+#define UCI_MAX_HASH_MB 65536
+#define UCI_MAX_THREADS 256
+
+/* Kept on the clock for the communication with the GUI */
+#define UCI_MOVE_OVERHEAD_MS 30
+
+#define UCI_MS_TO_NS 1000000ULL
+
+typedef struct
+{
+    Board position;
+    /* Keys of the positions played before it, since the position command */
+    KeyHistory history;
+
+    TranspositionTable tt;
+    uint32_t hash_mb;
+    uint32_t num_threads;
+
+    /* Copied from the position and limits when the search starts, read by the search thread */
+    Board search_position;
+    SearchLimits limits;
+    bool infinite;
+
+    PlatformThread search_thread;
+    bool searching;
+
+    volatile uint32_t stop;
+    volatile uint32_t ponder;
+
+    /* Set by debug on, the search thread then sends the overshoots of the timed searches */
+    volatile uint32_t debug;
+    /* The search is timed from its start, a pondering one is not */
+    bool timed;
+    TimeStats time_stats;
+} Uci;
+
+/* Writes a whole line at once, the search thread sending lines too */
+static void uci_send(const char* format, ...)
+{
+    char line[UCI_OUTPUT_SIZE];
+
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+
+    if(length < 0)
+    {
+        return;
+    }
+
+    const size_t size = (size_t)length < sizeof(line) - 2 ? (size_t)length : sizeof(line) - 2;
+    line[size] = '\n';
+    line[size + 1] = '\0';
+
+    fputs(line, stdout);
+    fflush(stdout);
+}
+
+/* Copies the next token of the line into token and moves the cursor after it, returns false at the end of the line */
+static bool uci_next_token(const char** cursor, char* token)
+{
+    const char* c = *cursor;
+
+    while(*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n')
+    {
+        c++;
+    }
+
+    size_t length = 0;
+
+    while(*c != '\0' && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n')
+    {
+        if(length < UCI_TOKEN_SIZE - 1)
+        {
+            token[length++] = *c;
+        }
+
+        c++;
+    }
+
+    token[length] = '\0';
+    *cursor = c;
+
+    return length > 0;
+}
+
+static uint64_t uci_next_u64(const char** cursor)
+{
+    char token[UCI_TOKEN_SIZE];
+
+    if(!uci_next_token(cursor, token))
+    {
+        return 0;
+    }
+
+    /* Negative clocks are sent by some GUIs once the time is over */
+    const long long value = strtoll(token, NULL, 10);
+
+    return value > 0 ? (uint64_t)value : 0;
+}
+
+static void uci_send_info(const SearchInfo* info, void* user_data)
+{
+    Uci* uci = (Uci*)user_data;
+
+    char line[UCI_OUTPUT_SIZE];
+    size_t length = 0;
+
+    if(SEARCH_SCORE_IS_MATE(info->score))
+    {
+        const int32_t moves = info->score > 0 ? (SEARCH_SCORE_MATE - info->score + 1) / 2 :
+                                                -(SEARCH_SCORE_MATE + info->score) / 2;
+
+        length += (size_t)snprintf(line, sizeof(line), "info depth %u seldepth %u score mate %d", info->depth, info->selective_depth, moves);
+    }
+    else
+    {
+        length += (size_t)snprintf(line, sizeof(line), "info depth %u seldepth %u score cp %d", info->depth, info->selective_depth, info->score);
+    }
+
+    length += (size_t)snprintf(line + length,
+                               sizeof(line) - length,
+                               " nodes %llu nps %llu hashfull %u time %llu pv",
+                               (unsigned long long)info->nodes,
+                               (unsigned long long)info->nps,
+                               info->hashfull,
+                               (unsigned long long)(info->elapsed_ns / UCI_MS_TO_NS));
+
+    /* Castling is written from the position the move is played in */
+    Board board = uci->search_position;
+
+    for(uint32_t i = 0; i < info->pv_length && length + MOVE_UCI_MAX_SIZE + 1 < sizeof(line); i++)
+    {
+        line[length++] = ' ';
+        length += move_to_uci(&board, info->pv[i], line + length);
+        board_make_move(&board, info->pv[i]);
+    }
+
+    line[length] = '\0';
+
+    uci_send("%s", line);
+}
+
+static void uci_search(void* user_data)
+{
+    Uci* uci = (Uci*)user_data;
+
+    SearchInfo info;
+    const bool searched = search_run(&uci->search_position, &uci->limits, &info);
+
+    /* The GUI expects the best move only once it stopped the search */
+    while((uci->infinite || platform_atomic_load_u32(&uci->ponder) != 0) && platform_atomic_load_u32(&uci->stop) == 0)
+    {
+        platform_sleep_ms(1);
+    }
+
+    if(!searched)
+    {
+        uci_send("bestmove 0000");
+        return;
+    }
+
+    if(uci->timed)
+    {
+        time_stats_add(&uci->time_stats, info.elapsed_ns, info.time_limit_ns);
+
+        if(platform_atomic_load_u32(&uci->debug) != 0)
+        {
+            const TimeStats* stats = &uci->time_stats;
+
+            uci_send("info string time limit %.1f ms, used %.1f ms, overshoot p50 %.2f ms p99 %.2f ms max %.2f ms, %llu of %llu searches over",
+                     (double)info.time_limit_ns / 1e6,
+                     (double)info.elapsed_ns / 1e6,
+                     (double)time_stats_percentile(stats, 50.0) / 1e6,
+                     (double)time_stats_percentile(stats, 99.0) / 1e6,
+                     (double)stats->max_overshoot_ns / 1e6,
+                     (unsigned long long)stats->num_overshoots,
+                     (unsigned long long)stats->num_searches);
+        }
+    }
+
+    Board board = uci->search_position;
+
+    char best_move[MOVE_UCI_MAX_SIZE];
+    move_to_uci(&board, info.pv[0], best_move);
+
+    if(info.pv_length > 1)
+    {
+        board_make_move(&board, info.pv[0]);
+
+        char ponder_move[MOVE_UCI_MAX_SIZE];
+        move_to_uci(&board, info.pv[1], ponder_move);
+
+        uci_send("bestmove %s ponder %s", best_move, ponder_move);
+    }
+    else
+    {
+        uci_send("bestmove %s", best_move);
+    }
+}
+
+static void uci_wait_search(Uci* uci)
+{
+    if(!uci->searching)
+    {
+        return;
+    }
+
+    platform_thread_join(&uci->search_thread);
+    uci->searching = false;
+}
+
+static void uci_stop_search(Uci* uci)
+{
+    if(!uci->searching)
+    {
+        return;
+    }
+
+    platform_atomic_store_u32(&uci->ponder, 0);
+    platform_atomic_store_u32(&uci->stop, 1);
+
+    uci_wait_search(uci);
+}
+
+static bool uci_resize_hash(Uci* uci, const uint32_t hash_mb)
+{
+    tt_release(&uci->tt);
+
+    if(!tt_init(&uci->tt, hash_mb))
+    {
+        return false;
+    }
+
+    tt_clear(&uci->tt);
+    uci->hash_mb = hash_mb;
+
+    return true;
+}
+
+/* position [startpos | fen <fen>] [moves <move>...] */
+static void uci_position(Uci* uci, const char* cursor)
+{
+    char token[UCI_TOKEN_SIZE];
+
+    if(!uci_next_token(&cursor, token))
+    {
+        return;
+    }
+
+    Board position;
+
+    if(strcmp(token, "startpos") == 0)
+    {
+        position = board_init();
+    }
+    else if(strcmp(token, "fen") == 0)
+    {
+        while(*cursor == ' ')
+        {
+            cursor++;
+        }
+
+        const size_t fen_length = board_parse_fen(&position, cursor);
+
+        if(fen_length == 0)
+        {
+            uci_send("info string invalid fen");
+            return;
+        }
+
+        cursor += fen_length;
+    }
+    else
+    {
+        return;
+    }
+
+    KeyHistory history;
+    key_history_reset(&history);
+
+    if(uci_next_token(&cursor, token) && strcmp(token, "moves") == 0)
+    {
+        while(uci_next_token(&cursor, token))
+        {
+            Move move;
+
+            if(!move_from_uci(&position, token, &move) || !board_move_is_legal(&position, move))
+            {
+                uci_send("info string illegal move %s", token);
+                return;
+            }
+
+            key_history_push(&history, position.key, position.halfmove_clock == 0);
+            board_make_move(&position, move);
+        }
+    }
+
+    uci->position = position;
+    memcpy(&uci->history, &history, sizeof(KeyHistory));
+}
+
+/* go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [movetime <ms>] [nodes <n>] [depth <n>] [infinite] [ponder] */
+static void uci_go(Uci* uci, const char* cursor)
+{
+    char token[UCI_TOKEN_SIZE];
+
+    uint64_t times_ms[2] = { 0, 0 };
+    uint64_t increments_ms[2] = { 0, 0 };
+    bool has_time[2] = { false, false };
+    uint64_t moves_to_go = 0;
+    uint64_t move_time_ms = 0;
+
+    SearchLimits* limits = &uci->limits;
+    search_limits_init(limits);
+
+    uci->infinite = false;
+    bool ponder = false;
+
+    while(uci_next_token(&cursor, token))
+    {
+        if(strcmp(token, "wtime") == 0 || strcmp(token, "btime") == 0)
+        {
+            const uint32_t side = token[0] == 'w' ? PIECE_WHITE : PIECE_BLACK;
+            times_ms[side] = uci_next_u64(&cursor);
+            has_time[side] = true;
+        }
+        else if(strcmp(token, "winc") == 0 || strcmp(token, "binc") == 0)
+        {
+            increments_ms[token[0] == 'w' ? PIECE_WHITE : PIECE_BLACK] = uci_next_u64(&cursor);
+        }
+        else if(strcmp(token, "movestogo") == 0)
+        {
+            moves_to_go = uci_next_u64(&cursor);
+        }
+        else if(strcmp(token, "movetime") == 0)
+        {
+            move_time_ms = uci_next_u64(&cursor);
+        }
+        else if(strcmp(token, "nodes") == 0)
+        {
+            limits->max_nodes = uci_next_u64(&cursor);
+        }
+        else if(strcmp(token, "depth") == 0)
+        {
+            const uint64_t depth = uci_next_u64(&cursor);
+            limits->max_depth = depth < SEARCH_MAX_PLY ? (uint32_t)depth : SEARCH_MAX_PLY - 1;
+        }
+        else if(strcmp(token, "infinite") == 0)
+        {
+            uci->infinite = true;
+        }
+        else if(strcmp(token, "ponder") == 0)
+        {
+            ponder = true;
+        }
+    }
+
+    const uint32_t side = BOARD_GET_SIDE_TO_PLAY(uci->position);
+
+    if(!uci->infinite)
+    {
+        TimeControl* control = &limits->time_control;
+
+        control->move_time_ns = move_time_ms * UCI_MS_TO_NS;
+        control->overhead_ns = UCI_MOVE_OVERHEAD_MS * UCI_MS_TO_NS;
+
+        /* An empty clock still asks for a move as fast as possible */
+        if(has_time[side])
+        {
+            control->time_ns = (times_ms[side] > 0 ? times_ms[side] : 1) * UCI_MS_TO_NS;
+            control->increment_ns = increments_ms[side] * UCI_MS_TO_NS;
+            control->moves_to_go = (uint32_t)moves_to_go;
+        }
+    }
+
+    uci->stop = 0;
+    uci->ponder = ponder ? 1 : 0;
+    uci->timed = time_control_is_set(&limits->time_control) && !ponder;
+
+    limits->stop = &uci->stop;
+    limits->ponder = &uci->ponder;
+    limits->callback = uci_send_info;
+    limits->user_data = uci;
+    limits->num_threads = uci->num_threads;
+    limits->tt = &uci->tt;
+    limits->history = &uci->history;
+
+    uci->search_position = uci->position;
+
+    uci->searching = platform_thread_start(&uci->search_thread, uci_search, uci);
+
+    if(!uci->searching)
+    {
+        uci_send("info string could not start the search thread");
+        uci_send("bestmove 0000");
+    }
+}
+
+/* setoption name <name> value <value> */
+static void uci_set_option(Uci* uci, const char* cursor)
+{
+    char token[UCI_TOKEN_SIZE];
+    char name[UCI_TOKEN_SIZE];
+
+    if(!uci_next_token(&cursor, token) || strcmp(token, "name") != 0 || !uci_next_token(&cursor, name))
+    {
+        return;
+    }
+
+    /* Check options have no numeric value */
+    const uint64_t value = uci_next_token(&cursor, token) && strcmp(token, "value") == 0 ? uci_next_u64(&cursor) : 0;
+
+    if(strcmp(name, "Hash") == 0)
+    {
+        const uint32_t hash_mb = value < 1 ? 1 : (value > UCI_MAX_HASH_MB ? UCI_MAX_HASH_MB : (uint32_t)value);
+
+        if(!uci_resize_hash(uci, hash_mb) && !uci_resize_hash(uci, SEARCH_DEFAULT_TT_SIZE_MB))
+        {
+            uci_send("info string could not allocate the hash table");
+        }
+    }
+    else if(strcmp(name, "Threads") == 0)
+    {
+        uci->num_threads = value < 1 ? 1 : (value > UCI_MAX_THREADS ? UCI_MAX_THREADS : (uint32_t)value);
+    }
+    else if(strcmp(name, "Ponder") == 0)
+    {
+        /* Only tells that the GUI may send go ponder */
+    }
+    else
+    {
+        uci_send("info string unknown option %s", name);
+    }
+}
+
+/* Returns false on quit */
+static bool uci_handle_command(Uci* uci, const char* line)
+{
+    const char* cursor = line;
+    char command[UCI_TOKEN_SIZE];
+
+    if(!uci_next_token(&cursor, command))
+    {
+        return true;
+    }
+
+    if(strcmp(command, "uci") == 0)
+    {
+        uci_send("id name %s", UCI_ENGINE_NAME);
+        uci_send("id author %s", UCI_ENGINE_AUTHOR);
+        uci_send("option name Hash type spin default %u min 1 max %u", SEARCH_DEFAULT_TT_SIZE_MB, UCI_MAX_HASH_MB);
+        uci_send("option name Threads type spin default 1 min 1 max %u", UCI_MAX_THREADS);
+        uci_send("option name Ponder type check default false");
+        uci_send("uciok");
+    }
+    else if(strcmp(command, "debug") == 0)
+    {
+        platform_atomic_store_u32(&uci->debug, uci_next_token(&cursor, command) && strcmp(command, "on") == 0);
+    }
+    else if(strcmp(command, "isready") == 0)
+    {
+        uci_send("readyok");
+    }
+    else if(strcmp(command, "stop") == 0)
+    {
+        uci_stop_search(uci);
+    }
+    else if(strcmp(command, "ponderhit") == 0)
+    {
+        /* The search goes on with its time limit, counted from its start */
+        platform_atomic_store_u32(&uci->ponder, 0);
+    }
+    else if(strcmp(command, "quit") == 0)
+    {
+        uci_stop_search(uci);
+        return false;
+    }
+    else if(strcmp(command, "ucinewgame") == 0)
+    {
+        uci_stop_search(uci);
+        tt_clear(&uci->tt);
+    }
+    else if(strcmp(command, "position") == 0)
+    {
+        uci_stop_search(uci);
+        uci_position(uci, cursor);
+    }
+    else if(strcmp(command, "go") == 0)
+    {
+        uci_stop_search(uci);
+        uci_go(uci, cursor);
+    }
+    else if(strcmp(command, "setoption") == 0)
+    {
+        uci_stop_search(uci);
+        uci_set_option(uci, cursor);
+    }
+    else if(strcmp(command, "d") == 0)
+    {
+        board_debug(&uci->position);
+    }
+    else
+    {
+        uci_send("info string unknown command %s", command);
+    }
+
+    return true;
+}
 
 int main(int argc, char** argv)
 {
-    Board b = board_init();
-    board_debug(&b);
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    /* Lives for the whole session, too large for the stack of some platforms */
+    Uci* uci = (Uci*)platform_alloc_aligned(sizeof(Uci), BOARD_ALIGNMENT);
+
+    if(uci == NULL)
+    {
+        return 1;
+    }
+
+    uci->position = board_init();
+    uci->num_threads = 1;
+
+    if(!uci_resize_hash(uci, SEARCH_DEFAULT_TT_SIZE_MB))
+    {
+        platform_free_aligned(uci);
+        return 1;
+    }
+
+    char line[UCI_LINE_SIZE];
+
+    while(fgets(line, sizeof(line), stdin) != NULL)
+    {
+        if(!uci_handle_command(uci, line))
+        {
+            break;
+        }
+    }
+
+    uci_stop_search(uci);
+    tt_release(&uci->tt);
+    platform_free_aligned(uci);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,511 @@
+#include "cchess/mcts.h"
+#include "cchess/eval.h"
+#include "cchess/platform.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Results are summed in fixed point, a win scoring MCTS_SCORE_ONE */
+#define MCTS_SCORE_ONE 1024
+
+/* Values of first_child besides the index of the first child, the root is never a child */
+#define MCTS_NODE_LEAF 0
+#define MCTS_NODE_EXPANDING UINT32_MAX
+/* Expanded without legal move */
+#define MCTS_NODE_TERMINAL (UINT32_MAX - 1)
+
+/* Mean result of the children not visited yet, for PUCT */
+#define MCTS_FIRST_PLAY_URGENCY 0.5f
+
+typedef struct
+{
+    /* Sum of the results of the playouts through the node, for the side that played its move */
+    volatile uint64_t score;
+    /* Playouts through the node, the ones in flight counting the virtual loss each */
+    volatile uint32_t visits;
+    /* Published once the children are set, num_children being written before */
+    volatile uint32_t first_child;
+    uint16_t num_children;
+    Move move;
+    /* Light policy probability of the move, for PUCT */
+    float prior;
+} MctsNode;
+
+typedef struct
+{
+    MctsNode* nodes;
+    volatile uint32_t size;
+    uint32_t capacity;
+    bool huge_pages;
+} MctsPool;
+
+/* State shared by the threads of a search */
+typedef struct
+{
+    const MctsLimits* limits;
+    const Board* root;
+    MctsPool pool;
+    uint64_t start_ns;
+    /* Started, so a playout limit is not overshot */
+    volatile uint64_t playouts;
+    volatile uint64_t playout_plies;
+    volatile uint32_t stopped;
+} MctsShared;
+
+void mcts_limits_init(MctsLimits* limits)
+{
+    memset(limits, 0, sizeof(MctsLimits));
+
+    limits->selection = MctsSelection_Uct;
+    limits->playout = MctsPlayout_Light;
+    limits->exploration = 1.4f;
+    limits->virtual_loss = 1;
+    limits->seed = 0x9E3779B97F4A7C15ULL;
+}
+
+/*
+    Playouts
+*/
+
+/* xorshift64*, the state is never 0 */
+CCHESS_FORCE_INLINE uint64_t mcts_random_next(uint64_t* state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/* Uniform in [0, bound), from the high bits */
+CCHESS_FORCE_INLINE uint32_t mcts_random_below(uint64_t* state, const uint32_t bound)
+{
+    return (uint32_t)(((mcts_random_next(state) >> 32) * bound) >> 32);
+}
+
+/* Light policy weight of a move, captures and promotions weighing more the more they win */
+CCHESS_FORCE_INLINE uint32_t mcts_move_weight(const Board* board, const Move move)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    uint32_t weight = 2;
+
+    if(MOVE_GET_IS_CAPTURING(move))
+    {
+        /* En passant finds no piece on its destination */
+        const uint32_t victim = board_get_piece_on(board, MOVE_GET_TO_SQUARE(move), !side);
+
+        weight += 4 + 2 * (victim == Piece_None ? Piece_Pawn : victim);
+    }
+
+    if(MOVE_GET_PIECE(move) != Piece_Pawn && (board_get_pawns(board, side) & BIT64(MOVE_GET_FROM_SQUARE(move))))
+    {
+        weight += 2 * MOVE_GET_PIECE(move);
+    }
+
+    return weight;
+}
+
+static Move mcts_pick_light(const Board* board, const Move* moves, const size_t num_moves, uint64_t* random)
+{
+    uint32_t weights[BOARD_MAX_MOVES];
+    uint32_t total = 0;
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        weights[i] = mcts_move_weight(board, moves[i]);
+        total += weights[i];
+    }
+
+    uint32_t pick = mcts_random_below(random, total);
+    size_t i = 0;
+
+    while(pick >= weights[i])
+    {
+        pick -= weights[i++];
+    }
+
+    return moves[i];
+}
+
+/* Kings alone, or with a single knight or bishop */
+static bool mcts_is_insufficient_material(const Board* board)
+{
+    const uint64_t heavy = board->pieces[Piece_Pawn] | board->pieces[Piece_Rook] | board->pieces[Piece_Queen];
+
+    return heavy == 0ULL && popcount_u64(board_get_all(board)) <= 3;
+}
+
+/* Result for the side to play of a position without legal move */
+CCHESS_FORCE_INLINE float mcts_terminal_result(Board* board)
+{
+    return board_get_checkers(board) != 0ULL ? 0.0f : 0.5f;
+}
+
+float mcts_playout(const Board* board, const MctsPlayout playout, uint64_t* random, uint32_t* num_plies)
+{
+    Board position = *board;
+
+    Move moves[BOARD_MAX_MOVES];
+
+    float result = -1.0f;
+    uint32_t ply = 0;
+
+    for(; ply < MCTS_PLAYOUT_MAX_PLIES; ply++)
+    {
+        size_t num_moves;
+        board_get_legal_moves(&position, moves, &num_moves);
+
+        if(num_moves == 0)
+        {
+            result = mcts_terminal_result(&position);
+            break;
+        }
+
+        if(position.halfmove_clock >= 100 || mcts_is_insufficient_material(&position))
+        {
+            result = 0.5f;
+            break;
+        }
+
+        const Move move = playout == MctsPlayout_Light ? mcts_pick_light(&position, moves, num_moves, random) :
+                                                         moves[mcts_random_below(random, (uint32_t)num_moves)];
+
+        board_make_move(&position, move);
+    }
+
+    /* Too long, the evaluation is turned into an expected result */
+    if(result < 0.0f)
+    {
+        result = 1.0f / (1.0f + powf(10.0f, -(float)eval_evaluate(&position) / 400.0f));
+    }
+
+    *num_plies = ply;
+
+    return BOARD_GET_SIDE_TO_PLAY(position) == BOARD_PTR_GET_SIDE_TO_PLAY(board) ? result : 1.0f - result;
+}
+
+/*
+    Tree
+*/
+
+/* Reserves count contiguous nodes, returns false if the pool is full */
+static bool mcts_pool_alloc(MctsPool* pool, const uint32_t count, uint32_t* first)
+{
+    for(;;)
+    {
+        const uint32_t size = platform_atomic_load_u32(&pool->size);
+
+        if(count > pool->capacity - size)
+        {
+            return false;
+        }
+
+        if(platform_atomic_cas_u32(&pool->size, size, size + count))
+        {
+            *first = size;
+            return true;
+        }
+    }
+}
+
+/*
+    Creates the children of the node, unless another thread is at it.
+    Returns the new first_child of the node, MCTS_NODE_LEAF if the pool is
+    full
+*/
+static uint32_t mcts_expand(MctsPool* pool, MctsNode* node, Board* board)
+{
+    if(!platform_atomic_cas_u32(&node->first_child, MCTS_NODE_LEAF, MCTS_NODE_EXPANDING))
+    {
+        return platform_atomic_load_u32(&node->first_child);
+    }
+
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    uint32_t first = MCTS_NODE_TERMINAL;
+
+    if(num_moves > 0)
+    {
+        if(!mcts_pool_alloc(pool, (uint32_t)num_moves, &first))
+        {
+            platform_atomic_store_u32(&node->first_child, MCTS_NODE_LEAF);
+            return MCTS_NODE_LEAF;
+        }
+
+        uint32_t weights[BOARD_MAX_MOVES];
+        uint32_t total = 0;
+
+        for(size_t i = 0; i < num_moves; i++)
+        {
+            weights[i] = mcts_move_weight(board, moves[i]);
+            total += weights[i];
+        }
+
+        for(size_t i = 0; i < num_moves; i++)
+        {
+            MctsNode* child = &pool->nodes[first + i];
+
+            child->move = moves[i];
+            child->prior = (float)weights[i] / (float)total;
+        }
+
+        node->num_children = (uint16_t)num_moves;
+    }
+
+    platform_atomic_store_u32(&node->first_child, first);
+
+    return first;
+}
+
+/* Index of the child with the best selection value */
+static uint32_t mcts_select_child(const MctsShared* shared, const MctsNode* node, const MctsNode* children)
+{
+    const MctsLimits* limits = shared->limits;
+
+    const float parent_visits = (float)node->visits;
+    const float uct_numerator = logf(parent_visits + 1.0f);
+    const float puct_numerator = sqrtf(parent_visits);
+
+    uint32_t best = 0;
+    float best_value = -INFINITY;
+
+    for(uint32_t i = 0; i < node->num_children; i++)
+    {
+        const uint32_t visits = children[i].visits;
+        const float mean = visits > 0 ? (float)children[i].score / ((float)visits * MCTS_SCORE_ONE) : MCTS_FIRST_PLAY_URGENCY;
+
+        float value;
+
+        if(limits->selection == MctsSelection_Puct)
+        {
+            value = mean + limits->exploration * children[i].prior * puct_numerator / (float)(1 + visits);
+        }
+        else
+        {
+            /* Every child is tried once first, the likeliest ones first */
+            value = visits > 0 ? mean + limits->exploration * sqrtf(uct_numerator / (float)visits) : 1e6f + children[i].prior;
+        }
+
+        if(value > best_value)
+        {
+            best_value = value;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/* One walk down the tree, a playout from the leaf reached and the backup of its result */
+static void mcts_iterate(MctsShared* shared, uint64_t* random)
+{
+    const MctsLimits* limits = shared->limits;
+    const uint32_t virtual_loss = limits->virtual_loss;
+
+    MctsNode* path[MCTS_MAX_DEPTH + 1];
+    uint32_t depth = 0;
+
+    Board board = *shared->root;
+    MctsNode* node = &shared->pool.nodes[0];
+
+    path[0] = node;
+    platform_atomic_fetch_add_u32(&node->visits, virtual_loss);
+
+    /* For the side to play at the end of the path, negative until known */
+    float result = -1.0f;
+
+    while(depth < MCTS_MAX_DEPTH)
+    {
+        if(depth > 0 && board.halfmove_clock >= 100)
+        {
+            result = 0.5f;
+            break;
+        }
+
+        uint32_t first = platform_atomic_load_u32(&node->first_child);
+
+        /* A leaf is expanded on its second visit, the pool only holding nodes that were played out */
+        if(first == MCTS_NODE_LEAF && node->visits > virtual_loss)
+        {
+            first = mcts_expand(&shared->pool, node, &board);
+        }
+
+        if(first == MCTS_NODE_TERMINAL)
+        {
+            result = mcts_terminal_result(&board);
+            break;
+        }
+
+        if(first == MCTS_NODE_LEAF || first == MCTS_NODE_EXPANDING)
+        {
+            break;
+        }
+
+        MctsNode* children = &shared->pool.nodes[first];
+        node = &children[mcts_select_child(shared, node, children)];
+
+        board_make_move(&board, node->move);
+
+        path[++depth] = node;
+        platform_atomic_fetch_add_u32(&node->visits, virtual_loss);
+    }
+
+    if(result < 0.0f)
+    {
+        uint32_t num_plies;
+        result = mcts_playout(&board, limits->playout, random, &num_plies);
+
+        platform_atomic_fetch_add_u64(&shared->playout_plies, num_plies);
+    }
+
+    /* A node is scored for the side that played its move, which is not the side to play at it */
+    for(uint32_t i = depth + 1; i-- > 0;)
+    {
+        result = 1.0f - result;
+
+        platform_atomic_fetch_add_u64(&path[i]->score, (uint64_t)(result * MCTS_SCORE_ONE + 0.5f));
+        platform_atomic_fetch_add_u32(&path[i]->visits, 1 - virtual_loss);
+    }
+}
+
+static bool mcts_should_stop(MctsShared* shared)
+{
+    const MctsLimits* limits = shared->limits;
+
+    if((limits->stop != NULL && platform_atomic_load_u32(limits->stop) != 0) ||
+       (limits->max_time_ns > 0 && platform_get_time_ns() - shared->start_ns >= limits->max_time_ns))
+    {
+        platform_atomic_store_u32(&shared->stopped, 1);
+    }
+
+    return platform_atomic_load_u32(&shared->stopped) != 0;
+}
+
+static void mcts_thread(MctsShared* shared, const uint32_t thread_index)
+{
+    const MctsLimits* limits = shared->limits;
+
+    uint64_t random = (limits->seed ^ (0xD1B54A32D192ED03ULL * (thread_index + 1))) | 1ULL;
+
+    for(uint64_t i = 0; ; i++)
+    {
+        if((i & (MCTS_CHECK_INTERVAL - 1)) == 0 ? mcts_should_stop(shared) : shared->stopped != 0)
+        {
+            break;
+        }
+
+        const uint64_t playout = platform_atomic_fetch_add_u64(&shared->playouts, 1);
+
+        if(limits->max_playouts > 0 && playout >= limits->max_playouts)
+        {
+            platform_atomic_store_u32(&shared->stopped, 1);
+            break;
+        }
+
+        mcts_iterate(shared, &random);
+    }
+}
+
+/* Most visited child, NULL for a leaf */
+static const MctsNode* mcts_best_child(const MctsPool* pool, const MctsNode* node)
+{
+    const uint32_t first = node->first_child;
+
+    if(first == MCTS_NODE_LEAF || first == MCTS_NODE_EXPANDING || first == MCTS_NODE_TERMINAL)
+    {
+        return NULL;
+    }
+
+    const MctsNode* best = NULL;
+
+    for(uint32_t i = 0; i < node->num_children; i++)
+    {
+        const MctsNode* child = &pool->nodes[first + i];
+
+        if(child->visits > 0 && (best == NULL || child->visits > best->visits))
+        {
+            best = child;
+        }
+    }
+
+    return best;
+}
+
+bool mcts_run(Board* board, const MctsLimits* limits, MctsInfo* info)
+{
+    memset(info, 0, sizeof(MctsInfo));
+
+    CCHESS_ASSERT(limits->virtual_loss > 0);
+
+    MctsShared shared;
+    memset(&shared, 0, sizeof(MctsShared));
+
+    shared.limits = limits;
+    shared.root = board;
+
+    MctsPool* pool = &shared.pool;
+    pool->capacity = limits->max_nodes > 0 ? limits->max_nodes : MCTS_DEFAULT_MAX_NODES;
+    pool->nodes = (MctsNode*)platform_alloc_large((size_t)pool->capacity * sizeof(MctsNode), &pool->huge_pages);
+    pool->size = 1;
+
+    if(pool->nodes == NULL)
+    {
+        return false;
+    }
+
+    /* The root is expanded first, so every thread walks down from it */
+    Board root = *board;
+
+    const uint32_t first = mcts_expand(pool, &pool->nodes[0], &root);
+
+    if(first == MCTS_NODE_TERMINAL || first == MCTS_NODE_LEAF)
+    {
+        platform_free_large(pool->nodes, (size_t)pool->capacity * sizeof(MctsNode));
+        return false;
+    }
+
+    const uint32_t num_threads = limits->num_threads > 1 ? limits->num_threads : 1;
+
+    shared.start_ns = platform_get_time_ns();
+
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+    for(int64_t i = 0; i < (int64_t)num_threads; i++)
+    {
+        mcts_thread(&shared, (uint32_t)i);
+    }
+
+    info->elapsed_ns = platform_get_time_ns() - shared.start_ns;
+
+    const uint64_t started = shared.playouts;
+    info->playouts = limits->max_playouts > 0 && started > limits->max_playouts ? limits->max_playouts : started;
+    info->playout_plies = shared.playout_plies;
+    info->num_nodes = pool->size;
+    info->playouts_per_second = info->elapsed_ns > 0 ? (uint64_t)((double)info->playouts * 1e9 / (double)info->elapsed_ns) : 0;
+
+    const MctsNode* node = &pool->nodes[0];
+
+    while(info->pv_length < MCTS_MAX_PV && (node = mcts_best_child(pool, node)) != NULL)
+    {
+        if(info->pv_length == 0)
+        {
+            info->score = (float)node->score / ((float)node->visits * MCTS_SCORE_ONE);
+        }
+
+        info->pv[info->pv_length++] = node->move;
+    }
+
+    /* Stopped before any playout, any legal move */
+    if(info->pv_length == 0)
+    {
+        info->pv[info->pv_length++] = pool->nodes[first].move;
+        info->score = 0.5f;
+    }
+
+    platform_free_large(pool->nodes, (size_t)pool->capacity * sizeof(MctsNode));
+
+    return true;
+}
@@ -1,4 +1,5 @@
 #include "cchess/move.h"
+#include "cchess/zobrist.h"
 #include "cchess/board_macros.h"
 
 #include "libromano/memory.h"
@@ -217,6 +218,17 @@ CCHESS_FORCE_INLINE uint64_t move_gen_king_mask(const uint32_t square)
 static uint64_t* _rook_moves_lookup = NULL;
 static uint64_t* _bishop_moves_lookup = NULL;
 
+/* Attack tables, independent of the side to move and of friendly blockers */
+
+static uint64_t _pawn_attacks_lookup[2][64];
+static uint64_t _knight_attacks_lookup[64];
+static uint64_t _king_attacks_lookup[64];
+
+static uint64_t _between_lookup[64][64];
+static uint64_t _line_lookup[64][64];
+
+static bool _attacks_lookup_initialized = false;
+
 void gen_blockers(const uint64_t mask, uint64_t* blockers)
 {
     uint64_t bits = popcount_u64(mask);
@@ -244,6 +256,79 @@ void gen_blockers(const uint64_t mask, uint64_t* blockers)
     }
 }
 
+CCHESS_FORCE_INLINE uint64_t move_gen_step_mask(const uint32_t square,
+                                                const int32_t* file_deltas,
+                                                const int32_t* rank_deltas,
+                                                const uint32_t num_deltas)
+{
+    const int32_t rank = (int32_t)BOARD_RANK_FROM_POS(square);
+    const int32_t file = (int32_t)BOARD_FILE_FROM_POS(square);
+
+    uint64_t mask = 0ULL;
+
+    for(uint32_t i = 0; i < num_deltas; i++)
+    {
+        const int32_t f = file + file_deltas[i];
+        const int32_t r = rank + rank_deltas[i];
+
+        if(f >= 0 && f < 8 && r >= 0 && r < 8)
+        {
+            mask |= BOARD_BIT_FROM_FILE_AND_RANK(f, r);
+        }
+    }
+
+    return mask;
+}
+
+void move_gen_init_attacks(void)
+{
+    static const int32_t knight_files[8] = { 1, 2, 2, 1, -1, -2, -2, -1 };
+    static const int32_t knight_ranks[8] = { 2, 1, -1, -2, -2, -1, 1, 2 };
+    static const int32_t king_files[8] = { 1, 1, 1, 0, -1, -1, -1, 0 };
+    static const int32_t king_ranks[8] = { 1, 0, -1, -1, -1, 0, 1, 1 };
+    static const int32_t pawn_files[2] = { -1, 1 };
+    static const int32_t white_pawn_ranks[2] = { 1, 1 };
+    static const int32_t black_pawn_ranks[2] = { -1, -1 };
+
+    for(uint32_t i = 0; i < 64; i++)
+    {
+        _knight_attacks_lookup[i] = move_gen_step_mask(i, knight_files, knight_ranks, 8);
+        _king_attacks_lookup[i] = move_gen_step_mask(i, king_files, king_ranks, 8);
+        _pawn_attacks_lookup[0][i] = move_gen_step_mask(i, pawn_files, white_pawn_ranks, 2);
+        _pawn_attacks_lookup[1][i] = move_gen_step_mask(i, pawn_files, black_pawn_ranks, 2);
+    }
+
+    for(uint32_t i = 0; i < 64; i++)
+    {
+        for(uint32_t j = 0; j < 64; j++)
+        {
+            _between_lookup[i][j] = 0ULL;
+            _line_lookup[i][j] = 0ULL;
+
+            if(i == j)
+            {
+                continue;
+            }
+
+            const uint64_t i_bit = BIT64(i);
+            const uint64_t j_bit = BIT64(j);
+
+            if(move_gen_bishop_attacks(i, 0ULL) & j_bit)
+            {
+                _line_lookup[i][j] = (move_gen_bishop_attacks(i, 0ULL) & move_gen_bishop_attacks(j, 0ULL)) | i_bit | j_bit;
+                _between_lookup[i][j] = move_gen_bishop_attacks(i, j_bit) & move_gen_bishop_attacks(j, i_bit);
+            }
+            else if(move_gen_rook_attacks(i, 0ULL) & j_bit)
+            {
+                _line_lookup[i][j] = (move_gen_rook_attacks(i, 0ULL) & move_gen_rook_attacks(j, 0ULL)) | i_bit | j_bit;
+                _between_lookup[i][j] = move_gen_rook_attacks(i, j_bit) & move_gen_rook_attacks(j, i_bit);
+            }
+        }
+    }
+
+    _attacks_lookup_initialized = true;
+}
+
 void move_gen_init(void)
 {
     if(_rook_moves_lookup == NULL)
@@ -289,6 +374,12 @@ void move_gen_init(void)
             }
         }
     }
+
+    if(!_attacks_lookup_initialized)
+    {
+        move_gen_init_attacks();
+        zobrist_init();
+    }
 }
 
 void move_gen_destroy(void)
@@ -410,4 +501,54 @@ uint64_t move_gen_king(const uint32_t square,
 {
     return move_gen_king_mask(square) & ((side == 0) ? ~blockers_white : 
                                                        ~blockers_black);
-}
\ No newline at end of file
+}
+
+uint64_t move_gen_pawn_attacks(const uint32_t square, const uint32_t side)
+{
+    return _pawn_attacks_lookup[side][square];
+}
+
+uint64_t move_gen_knight_attacks(const uint32_t square)
+{
+    return _knight_attacks_lookup[square];
+}
+
+uint64_t move_gen_bishop_attacks(const uint32_t square, const uint64_t occupancy)
+{
+    CCHESS_ASSERT(_bishop_moves_lookup != NULL && "_bishop_moves_lookup has not been initialized");
+
+    const uint64_t mask = _bishop_moves_lookup[square];
+    const uint64_t index = pext_u64(occupancy & mask, mask);
+
+    return _bishop_moves_lookup[64 + square * BISHOP_NUM_BLOCKERS + index];
+}
+
+uint64_t move_gen_rook_attacks(const uint32_t square, const uint64_t occupancy)
+{
+    CCHESS_ASSERT(_rook_moves_lookup != NULL && "_rook_moves_lookup has not been initialized");
+
+    const uint64_t mask = _rook_moves_lookup[square];
+    const uint64_t index = pext_u64(occupancy & mask, mask);
+
+    return _rook_moves_lookup[64 + square * ROOK_NUM_BLOCKERS + index];
+}
+
+uint64_t move_gen_queen_attacks(const uint32_t square, const uint64_t occupancy)
+{
+    return move_gen_bishop_attacks(square, occupancy) | move_gen_rook_attacks(square, occupancy);
+}
+
+uint64_t move_gen_king_attacks(const uint32_t square)
+{
+    return _king_attacks_lookup[square];
+}
+
+uint64_t move_gen_between(const uint32_t from, const uint32_t to)
+{
+    return _between_lookup[from][to];
+}
+
+uint64_t move_gen_line(const uint32_t from, const uint32_t to)
+{
+    return _line_lookup[from][to];
+}
@@ -0,0 +1,139 @@
+#include "cchess/move_order.h"
+
+#include <string.h>
+
+/* Bonus of a cutoff at depth, quadratic until it is capped */
+#define MOVE_ORDER_MAX_BONUS 1600
+
+void move_order_clear(MoveOrderTables* tables)
+{
+    memset(tables, 0, sizeof(MoveOrderTables));
+}
+
+int32_t move_order_mvv_lva(Board* board, const Move move)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint32_t from_square = MOVE_GET_FROM_SQUARE(move);
+
+    const bool is_promotion = MOVE_GET_PIECE(move) != Piece_Pawn && (board_get_pawns(board, side) & BIT64(from_square));
+    const uint32_t attacker = is_promotion ? Piece_Pawn : MOVE_GET_PIECE(move);
+
+    int32_t score = 0;
+
+    if(MOVE_GET_IS_CAPTURING(move))
+    {
+        /* An en passant capture finds no piece on its destination */
+        const uint32_t victim = board_get_piece_on(board, MOVE_GET_TO_SQUARE(move), !side);
+        score += (int32_t)(victim == Piece_None ? Piece_Pawn : victim) * 8 + (7 - (int32_t)attacker);
+    }
+
+    /* A promotion wins about the promoted piece, the queen ranking with the captures of a queen */
+    if(is_promotion)
+    {
+        score += (int32_t)MOVE_GET_PIECE(move) * 8;
+    }
+
+    return score;
+}
+
+CCHESS_FORCE_INLINE int32_t move_order_history_bonus(const int32_t depth)
+{
+    return depth * depth < MOVE_ORDER_MAX_BONUS ? depth * depth : MOVE_ORDER_MAX_BONUS;
+}
+
+/* The more a score already leans towards the bonus, the less it moves, so it stays within the bound */
+CCHESS_FORCE_INLINE void move_order_update_history(int16_t* history, const int32_t bonus)
+{
+    const int32_t magnitude = bonus < 0 ? -bonus : bonus;
+
+    *history = (int16_t)(*history + bonus - *history * magnitude / MOVE_ORDER_HISTORY_MAX);
+}
+
+void move_order_score_moves(const MoveOrderTables* tables,
+                            Board* board,
+                            const Move* moves,
+                            const size_t num_moves,
+                            const Move* first_move,
+                            const Move* killers,
+                            const Move previous_move,
+                            ScoredMoveList* list)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    const uint16_t first = first_move != NULL ? move_to_u16(*first_move) : EMPTY_MOVE;
+    const uint16_t killer_1 = move_to_u16(killers[0]);
+    const uint16_t killer_2 = move_to_u16(killers[1]);
+    const uint16_t counter = move_to_u16(previous_move) != EMPTY_MOVE ?
+                             move_to_u16(tables->counter_moves[!side][MOVE_GET_PIECE(previous_move)][MOVE_GET_TO_SQUARE(previous_move)]) :
+                             EMPTY_MOVE;
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        const Move move = moves[i];
+        const uint16_t raw = move_to_u16(move);
+
+        int32_t score;
+
+        if(raw == first && first != EMPTY_MOVE)
+        {
+            score = MOVE_ORDER_SCORE_FIRST;
+        }
+        else if(!move_order_is_quiet(board, move))
+        {
+            score = MOVE_ORDER_SCORE_CAPTURE + move_order_mvv_lva(board, move);
+        }
+        else if(raw == killer_1)
+        {
+            score = MOVE_ORDER_SCORE_KILLER_1;
+        }
+        else if(raw == killer_2)
+        {
+            score = MOVE_ORDER_SCORE_KILLER_2;
+        }
+        else if(raw == counter)
+        {
+            score = MOVE_ORDER_SCORE_COUNTER;
+        }
+        else
+        {
+            score = tables->history[side][MOVE_GET_FROM_SQUARE(move)][MOVE_GET_TO_SQUARE(move)];
+        }
+
+        list->moves[i] = scored_move_make(move, score);
+    }
+
+    list->size = (uint32_t)num_moves;
+    list->next = 0;
+}
+
+void move_order_update_quiet(MoveOrderTables* tables,
+                             const Board* board,
+                             Move* killers,
+                             const int32_t depth,
+                             const Move best_move,
+                             const Move* tried_quiets,
+                             const size_t num_tried_quiets,
+                             const Move previous_move)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    if(!move_equal(killers[0], best_move))
+    {
+        killers[1] = killers[0];
+        killers[0] = best_move;
+    }
+
+    if(move_to_u16(previous_move) != EMPTY_MOVE)
+    {
+        tables->counter_moves[!side][MOVE_GET_PIECE(previous_move)][MOVE_GET_TO_SQUARE(previous_move)] = best_move;
+    }
+
+    const int32_t bonus = move_order_history_bonus(depth);
+
+    move_order_update_history(&tables->history[side][MOVE_GET_FROM_SQUARE(best_move)][MOVE_GET_TO_SQUARE(best_move)], bonus);
+
+    for(size_t i = 0; i < num_tried_quiets; i++)
+    {
+        move_order_update_history(&tables->history[side][MOVE_GET_FROM_SQUARE(tried_quiets[i])][MOVE_GET_TO_SQUARE(tried_quiets[i])], -bonus);
+    }
+}
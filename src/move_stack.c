@@ -0,0 +1,23 @@
+#include "cchess/move_stack.h"
+
+#include <stdlib.h>
+
+bool move_stack_init(MoveStack* stack, const size_t capacity)
+{
+    CCHESS_ASSERT(capacity >= BOARD_MAX_MOVES);
+
+    stack->moves = (Move*)malloc(capacity * sizeof(Move));
+    stack->size = 0;
+    stack->capacity = stack->moves != NULL ? capacity : 0;
+
+    return stack->moves != NULL;
+}
+
+void move_stack_release(MoveStack* stack)
+{
+    free(stack->moves);
+
+    stack->moves = NULL;
+    stack->size = 0;
+    stack->capacity = 0;
+}
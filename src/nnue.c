@@ -0,0 +1,545 @@
+#include "cchess/nnue.h"
+#include "cchess/platform.h"
+
+#include "libromano/bit.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif /* defined(__AVX2__) */
+
+/* Features changed by a move for one side, more are handled by a refresh */
+#define NNUE_MAX_CHANGES 8
+
+STATIC_ASSERT(sizeof(NnueHeader) == 32);
+STATIC_ASSERT(NNUE_L1_SIZE % 32 == 0 && NNUE_L2_SIZE % 32 == 0 && NNUE_L3_SIZE % 32 == 0);
+
+CCHESS_FORCE_INLINE uint32_t nnue_piece_features(const NnueFeatureSet feature_set)
+{
+    return feature_set == NnueFeatureSet_HalfKP ? NNUE_HALFKP_PIECE_FEATURES : NNUE_HALFKA_PIECE_FEATURES;
+}
+
+/* Index of a piece of piece_side on square, from the point of view of side with its king on king_square */
+CCHESS_FORCE_INLINE uint32_t nnue_feature_index(const Nnue* nnue,
+                                                const uint32_t side,
+                                                const uint32_t king_square,
+                                                const uint32_t piece,
+                                                const uint32_t piece_side,
+                                                const uint32_t square)
+{
+    const uint32_t flip = side == PIECE_WHITE ? 0 : 56;
+
+    return (king_square ^ flip) * nnue_piece_features(nnue->feature_set) +
+           (piece * 2 + (piece_side != side)) * 64 +
+           (square ^ flip);
+}
+
+CCHESS_FORCE_INLINE bool nnue_has_feature(const Nnue* nnue, const uint32_t piece)
+{
+    return piece != Piece_King || nnue->feature_set == NnueFeatureSet_HalfKA;
+}
+
+/*
+    Kernels
+*/
+
+static void nnue_update_scalar(const Nnue* nnue,
+                               const int16_t* base,
+                               int16_t* values,
+                               const uint32_t* removed,
+                               const uint32_t num_removed,
+                               const uint32_t* added,
+                               const uint32_t num_added)
+{
+    memcpy(values, base, NNUE_L1_SIZE * sizeof(int16_t));
+
+    for(uint32_t j = 0; j < num_removed; j++)
+    {
+        const int16_t* column = nnue->ft_weights + (size_t)removed[j] * NNUE_L1_SIZE;
+
+        for(uint32_t i = 0; i < NNUE_L1_SIZE; i++)
+        {
+            values[i] = (int16_t)(values[i] - column[i]);
+        }
+    }
+
+    for(uint32_t j = 0; j < num_added; j++)
+    {
+        const int16_t* column = nnue->ft_weights + (size_t)added[j] * NNUE_L1_SIZE;
+
+        for(uint32_t i = 0; i < NNUE_L1_SIZE; i++)
+        {
+            values[i] = (int16_t)(values[i] + column[i]);
+        }
+    }
+}
+
+static void nnue_transform_scalar(const int16_t* values, uint8_t* output)
+{
+    for(uint32_t i = 0; i < NNUE_L1_SIZE; i++)
+    {
+        output[i] = (uint8_t)(values[i] < 0 ? 0 : (values[i] > NNUE_CLIP_MAX ? NNUE_CLIP_MAX : values[i]));
+    }
+}
+
+static void nnue_dense_scalar(const uint8_t* input,
+                              const uint32_t input_size,
+                              const int8_t* weights,
+                              const int32_t* biases,
+                              const uint32_t output_size,
+                              uint8_t* output)
+{
+    for(uint32_t o = 0; o < output_size; o++)
+    {
+        int32_t sum = biases[o];
+
+        for(uint32_t i = 0; i < input_size; i++)
+        {
+            sum += (int32_t)weights[o * input_size + i] * (int32_t)input[i];
+        }
+
+        sum >>= NNUE_WEIGHT_SHIFT;
+        output[o] = (uint8_t)(sum < 0 ? 0 : (sum > NNUE_CLIP_MAX ? NNUE_CLIP_MAX : sum));
+    }
+}
+
+#if defined(__AVX2__)
+/* All the removed and added columns are applied to a chunk of 16 values while it is in a register */
+static void nnue_update_avx2(const Nnue* nnue,
+                             const int16_t* base,
+                             int16_t* values,
+                             const uint32_t* removed,
+                             const uint32_t num_removed,
+                             const uint32_t* added,
+                             const uint32_t num_added)
+{
+    for(uint32_t i = 0; i < NNUE_L1_SIZE; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(base + i));
+
+        for(uint32_t j = 0; j < num_removed; j++)
+        {
+            v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i*)(nnue->ft_weights + (size_t)removed[j] * NNUE_L1_SIZE + i)));
+        }
+
+        for(uint32_t j = 0; j < num_added; j++)
+        {
+            v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i*)(nnue->ft_weights + (size_t)added[j] * NNUE_L1_SIZE + i)));
+        }
+
+        _mm256_storeu_si256((__m256i*)(values + i), v);
+    }
+}
+
+/* Saturating pack to int8 and max with 0 clip to [0, 127], the permute undoes the lane interleaving of the pack */
+static void nnue_transform_avx2(const int16_t* values, uint8_t* output)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    for(uint32_t i = 0; i < NNUE_L1_SIZE; i += 32)
+    {
+        const __m256i low = _mm256_loadu_si256((const __m256i*)(values + i));
+        const __m256i high = _mm256_loadu_si256((const __m256i*)(values + i + 16));
+
+        const __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(low, high), zero);
+
+        _mm256_storeu_si256((__m256i*)(output + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+}
+
+/*
+    maddubs multiplies the uint8 inputs by the int8 weights and adds the
+    pairs in int16, which can't saturate with inputs up to 127. madd by ones
+    then adds the pairs of int16 in int32
+*/
+static void nnue_dense_avx2(const uint8_t* input,
+                            const uint32_t input_size,
+                            const int8_t* weights,
+                            const int32_t* biases,
+                            const uint32_t output_size,
+                            uint8_t* output)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    for(uint32_t o = 0; o < output_size; o++)
+    {
+        __m256i sum = _mm256_setzero_si256();
+
+        for(uint32_t i = 0; i < input_size; i += 32)
+        {
+            const __m256i x = _mm256_loadu_si256((const __m256i*)(input + i));
+            const __m256i w = _mm256_loadu_si256((const __m256i*)(weights + o * input_size + i));
+
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+        }
+
+        __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+
+        const int32_t total = (_mm_cvtsi128_si32(sum128) + biases[o]) >> NNUE_WEIGHT_SHIFT;
+
+        output[o] = (uint8_t)(total < 0 ? 0 : (total > NNUE_CLIP_MAX ? NNUE_CLIP_MAX : total));
+    }
+}
+#endif /* defined(__AVX2__) */
+
+static void nnue_update(const Nnue* nnue,
+                        const int16_t* base,
+                        int16_t* values,
+                        const uint32_t* removed,
+                        const uint32_t num_removed,
+                        const uint32_t* added,
+                        const uint32_t num_added)
+{
+#if defined(__AVX2__)
+    if(nnue->use_simd)
+    {
+        nnue_update_avx2(nnue, base, values, removed, num_removed, added, num_added);
+        return;
+    }
+#endif /* defined(__AVX2__) */
+
+    nnue_update_scalar(nnue, base, values, removed, num_removed, added, num_added);
+}
+
+bool nnue_has_simd(void)
+{
+#if defined(__AVX2__)
+    return true;
+#else
+    return false;
+#endif /* defined(__AVX2__) */
+}
+
+/*
+    Accumulators
+*/
+
+static void nnue_refresh(const Nnue* nnue, const Board* board, const uint32_t side, int16_t* values)
+{
+    const uint32_t king_square = (uint32_t)ctz_u64(board_get_king(board, side));
+
+    uint32_t features[64];
+    uint32_t num_features = 0;
+
+    for(uint32_t i = 0; i < 12; i++)
+    {
+        if(!nnue_has_feature(nnue, i / 2))
+        {
+            continue;
+        }
+
+        for(uint64_t pieces = board_get_pieces(board, i / 2, i % 2); pieces != 0ULL; pieces = clsb_u64(pieces))
+        {
+            features[num_features++] = nnue_feature_index(nnue, side, king_square, i / 2, i % 2, (uint32_t)ctz_u64(pieces));
+        }
+    }
+
+    nnue_update(nnue, nnue->ft_biases, values, NULL, 0, features, num_features);
+}
+
+void nnue_compute_accumulator(const Nnue* nnue, const Board* board, const uint32_t side, int16_t* values)
+{
+    nnue_refresh(nnue, board, side, values);
+}
+
+void nnue_stack_reset(const Nnue* nnue, NnueStack* stack, const Board* board)
+{
+    stack->size = 1;
+
+    nnue_refresh(nnue, board, PIECE_WHITE, stack->accumulators[0].values[PIECE_WHITE]);
+    nnue_refresh(nnue, board, PIECE_BLACK, stack->accumulators[0].values[PIECE_BLACK]);
+}
+
+void nnue_stack_push(const Nnue* nnue, NnueStack* stack, const Board* before, const Board* after)
+{
+    CCHESS_ASSERT(stack->size > 0 && stack->size < NNUE_STACK_SIZE);
+
+    const NnueAccumulator* previous = &stack->accumulators[stack->size - 1];
+    NnueAccumulator* accumulator = &stack->accumulators[stack->size];
+
+    stack->size++;
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        if(board_get_king(before, side) != board_get_king(after, side))
+        {
+            nnue_refresh(nnue, after, side, accumulator->values[side]);
+            continue;
+        }
+
+        const uint32_t king_square = (uint32_t)ctz_u64(board_get_king(after, side));
+
+        uint32_t removed[NNUE_MAX_CHANGES];
+        uint32_t added[NNUE_MAX_CHANGES];
+        uint32_t num_removed = 0;
+        uint32_t num_added = 0;
+
+        /* Kings are not in the bitboards compared, the other king being handled below for HalfKA */
+        bool refresh = false;
+
+        for(uint32_t i = 0; i < 10 && !refresh; i++)
+        {
+            const uint64_t before_pieces = board_get_pieces(before, i / 2, i % 2);
+            const uint64_t after_pieces = board_get_pieces(after, i / 2, i % 2);
+            const uint64_t changed = before_pieces ^ after_pieces;
+
+            refresh = popcount_u64(changed) + num_removed + num_added > NNUE_MAX_CHANGES;
+
+            for(uint64_t pieces = changed & before_pieces; pieces != 0ULL && !refresh; pieces = clsb_u64(pieces))
+            {
+                removed[num_removed++] = nnue_feature_index(nnue, side, king_square, i / 2, i % 2, (uint32_t)ctz_u64(pieces));
+            }
+
+            for(uint64_t pieces = changed & after_pieces; pieces != 0ULL && !refresh; pieces = clsb_u64(pieces))
+            {
+                added[num_added++] = nnue_feature_index(nnue, side, king_square, i / 2, i % 2, (uint32_t)ctz_u64(pieces));
+            }
+        }
+
+        if(!refresh && nnue->feature_set == NnueFeatureSet_HalfKA && board_get_king(before, !side) != board_get_king(after, !side))
+        {
+            refresh = num_removed + num_added + 2 > NNUE_MAX_CHANGES;
+
+            if(!refresh)
+            {
+                removed[num_removed++] = nnue_feature_index(nnue, side, king_square, Piece_King, !side, (uint32_t)ctz_u64(board_get_king(before, !side)));
+                added[num_added++] = nnue_feature_index(nnue, side, king_square, Piece_King, !side, (uint32_t)ctz_u64(board_get_king(after, !side)));
+            }
+        }
+
+        if(refresh)
+        {
+            nnue_refresh(nnue, after, side, accumulator->values[side]);
+        }
+        else
+        {
+            nnue_update(nnue, previous->values[side], accumulator->values[side], removed, num_removed, added, num_added);
+        }
+    }
+}
+
+/*
+    Evaluation
+*/
+
+int32_t nnue_evaluate(const Nnue* nnue, const NnueStack* stack, const Board* board)
+{
+    CCHESS_ASSERT(stack->size > 0);
+
+    const NnueAccumulator* accumulator = &stack->accumulators[stack->size - 1];
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    CCHESS_ALIGNED(32) uint8_t input[2 * NNUE_L1_SIZE];
+    CCHESS_ALIGNED(32) uint8_t hidden1[NNUE_L2_SIZE];
+    CCHESS_ALIGNED(32) uint8_t hidden2[NNUE_L3_SIZE];
+
+#if defined(__AVX2__)
+    if(nnue->use_simd)
+    {
+        nnue_transform_avx2(accumulator->values[side], input);
+        nnue_transform_avx2(accumulator->values[!side], input + NNUE_L1_SIZE);
+        nnue_dense_avx2(input, 2 * NNUE_L1_SIZE, &nnue->l1_weights[0][0], nnue->l1_biases, NNUE_L2_SIZE, hidden1);
+        nnue_dense_avx2(hidden1, NNUE_L2_SIZE, &nnue->l2_weights[0][0], nnue->l2_biases, NNUE_L3_SIZE, hidden2);
+    }
+    else
+#endif /* defined(__AVX2__) */
+    {
+        nnue_transform_scalar(accumulator->values[side], input);
+        nnue_transform_scalar(accumulator->values[!side], input + NNUE_L1_SIZE);
+        nnue_dense_scalar(input, 2 * NNUE_L1_SIZE, &nnue->l1_weights[0][0], nnue->l1_biases, NNUE_L2_SIZE, hidden1);
+        nnue_dense_scalar(hidden1, NNUE_L2_SIZE, &nnue->l2_weights[0][0], nnue->l2_biases, NNUE_L3_SIZE, hidden2);
+    }
+
+    int32_t output = nnue->output_bias;
+
+    for(uint32_t i = 0; i < NNUE_L3_SIZE; i++)
+    {
+        output += (int32_t)nnue->output_weights[i] * (int32_t)hidden2[i];
+    }
+
+    return output / NNUE_OUTPUT_SCALE;
+}
+
+/*
+    Networks
+*/
+
+static bool nnue_alloc(Nnue* nnue, const NnueFeatureSet feature_set)
+{
+    memset(nnue, 0, sizeof(Nnue));
+
+    nnue->feature_set = feature_set;
+    nnue->num_features = 64 * nnue_piece_features(feature_set);
+    nnue->ft_weights_size = (size_t)nnue->num_features * NNUE_L1_SIZE * sizeof(int16_t);
+    nnue->ft_weights = (int16_t*)platform_alloc_large(nnue->ft_weights_size, &nnue->huge_pages);
+    nnue->use_simd = nnue_has_simd();
+
+    return nnue->ft_weights != NULL;
+}
+
+void nnue_release(Nnue* nnue)
+{
+    if(nnue->ft_weights != NULL)
+    {
+        platform_free_large(nnue->ft_weights, nnue->ft_weights_size);
+    }
+
+    memset(nnue, 0, sizeof(Nnue));
+}
+
+/* Order of the layers in the files, after the header */
+#define NNUE_FOR_EACH_BLOCK(nnue, X)                                \
+    X(nnue->ft_biases, sizeof(nnue->ft_biases))                     \
+    X(nnue->ft_weights, nnue->ft_weights_size)                      \
+    X(nnue->l1_biases, sizeof(nnue->l1_biases))                     \
+    X(nnue->l1_weights, sizeof(nnue->l1_weights))                   \
+    X(nnue->l2_biases, sizeof(nnue->l2_biases))                     \
+    X(nnue->l2_weights, sizeof(nnue->l2_weights))                   \
+    X(&nnue->output_bias, sizeof(nnue->output_bias))                \
+    X(nnue->output_weights, sizeof(nnue->output_weights))
+
+bool nnue_load(Nnue* nnue, const char* path)
+{
+    memset(nnue, 0, sizeof(Nnue));
+
+    FileMapping mapping;
+
+    if(!platform_map_file(&mapping, path, FileMappingAccess_Sequential))
+    {
+        return false;
+    }
+
+    const NnueHeader* header = (const NnueHeader*)mapping.data;
+
+    bool valid = mapping.size >= sizeof(NnueHeader) &&
+                 header->magic == NNUE_MAGIC &&
+                 header->version == NNUE_VERSION &&
+                 header->feature_set <= NnueFeatureSet_HalfKA &&
+                 header->l1_size == NNUE_L1_SIZE &&
+                 header->l2_size == NNUE_L2_SIZE &&
+                 header->l3_size == NNUE_L3_SIZE;
+
+    valid = valid && nnue_alloc(nnue, (NnueFeatureSet)header->feature_set);
+
+    size_t expected_size = sizeof(NnueHeader);
+
+#define NNUE_ADD_SIZE(data, size) expected_size += (size);
+    NNUE_FOR_EACH_BLOCK(nnue, NNUE_ADD_SIZE)
+#undef NNUE_ADD_SIZE
+
+    valid = valid && mapping.size == expected_size;
+
+    if(valid)
+    {
+        const char* s = (const char*)mapping.data + sizeof(NnueHeader);
+
+#define NNUE_READ(data, size) memcpy((data), s, (size)); s += (size);
+        NNUE_FOR_EACH_BLOCK(nnue, NNUE_READ)
+#undef NNUE_READ
+    }
+
+    platform_unmap_file(&mapping);
+
+    if(!valid)
+    {
+        nnue_release(nnue);
+    }
+
+    return valid;
+}
+
+bool nnue_save(const Nnue* nnue, const char* path)
+{
+    FILE* file = fopen(path, "wb");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    NnueHeader header;
+    memset(&header, 0, sizeof(NnueHeader));
+    header.magic = NNUE_MAGIC;
+    header.version = NNUE_VERSION;
+    header.feature_set = (uint32_t)nnue->feature_set;
+    header.l1_size = NNUE_L1_SIZE;
+    header.l2_size = NNUE_L2_SIZE;
+    header.l3_size = NNUE_L3_SIZE;
+
+    bool written = fwrite(&header, sizeof(NnueHeader), 1, file) == 1;
+
+#define NNUE_WRITE(data, size) written = written && fwrite((data), 1, (size), file) == (size);
+    NNUE_FOR_EACH_BLOCK(nnue, NNUE_WRITE)
+#undef NNUE_WRITE
+
+    written &= fclose(file) == 0;
+
+    return written;
+}
+
+CCHESS_FORCE_INLINE uint64_t nnue_splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/* Uniform in [-range, range] */
+CCHESS_FORCE_INLINE int32_t nnue_random(uint64_t* state, const int32_t range)
+{
+    return (int32_t)(nnue_splitmix64(state) % (uint64_t)(2 * range + 1)) - range;
+}
+
+bool nnue_init_random(Nnue* nnue, const NnueFeatureSet feature_set, uint64_t seed)
+{
+    if(!nnue_alloc(nnue, feature_set))
+    {
+        return false;
+    }
+
+    /* Sized so the activations spread over [0, 127] rather than saturate */
+    for(uint32_t i = 0; i < NNUE_L1_SIZE; i++)
+    {
+        nnue->ft_biases[i] = (int16_t)nnue_random(&seed, 32);
+    }
+
+    for(size_t i = 0; i < (size_t)nnue->num_features * NNUE_L1_SIZE; i++)
+    {
+        nnue->ft_weights[i] = (int16_t)nnue_random(&seed, 32);
+    }
+
+    for(uint32_t o = 0; o < NNUE_L2_SIZE; o++)
+    {
+        nnue->l1_biases[o] = nnue_random(&seed, 1024);
+
+        for(uint32_t i = 0; i < 2 * NNUE_L1_SIZE; i++)
+        {
+            nnue->l1_weights[o][i] = (int8_t)nnue_random(&seed, 8);
+        }
+    }
+
+    for(uint32_t o = 0; o < NNUE_L3_SIZE; o++)
+    {
+        nnue->l2_biases[o] = nnue_random(&seed, 1024);
+
+        for(uint32_t i = 0; i < NNUE_L2_SIZE; i++)
+        {
+            nnue->l2_weights[o][i] = (int8_t)nnue_random(&seed, 16);
+        }
+    }
+
+    nnue->output_bias = nnue_random(&seed, 1024);
+
+    for(uint32_t i = 0; i < NNUE_L3_SIZE; i++)
+    {
+        nnue->output_weights[i] = (int8_t)nnue_random(&seed, 64);
+    }
+
+    return true;
+}
@@ -0,0 +1,473 @@
+#include "cchess/notation.h"
+#include "cchess/board_macros.h"
+
+#include <string.h>
+
+/* UCI */
+
+static const char _uci_promotion_chars[6] = { 0, 'n', 'b', 'r', 'q', 0 };
+
+static const uint8_t _uci_promotion_lookup[256] = {
+    ['n'] = Piece_Knight,
+    ['b'] = Piece_Bishop,
+    ['r'] = Piece_Rook,
+    ['q'] = Piece_Queen,
+};
+
+size_t move_to_uci(Board* board, const Move move, char* uci)
+{
+    const uint32_t from_square = MOVE_GET_FROM_SQUARE(move);
+    const uint32_t to_square = MOVE_GET_TO_SQUARE(move);
+    const uint32_t piece = MOVE_GET_PIECE(move);
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    uci[0] = (char)('a' + BOARD_FILE_FROM_POS(from_square));
+    uci[1] = (char)('1' + BOARD_RANK_FROM_POS(from_square));
+    uci[2] = (char)('a' + BOARD_FILE_FROM_POS(to_square));
+    uci[3] = (char)('1' + BOARD_RANK_FROM_POS(to_square));
+
+    const bool is_promotion = piece != Piece_Pawn && (board_get_pawns(board, side) & BIT64(from_square));
+
+    if(is_promotion)
+    {
+        uci[4] = _uci_promotion_chars[piece];
+        uci[5] = '\0';
+
+        return 5;
+    }
+
+    uci[4] = '\0';
+
+    return 4;
+}
+
+bool move_from_uci(Board* board, const char* uci, Move* move)
+{
+    if(uci[0] == '\0' || uci[1] == '\0' || uci[2] == '\0' || uci[3] == '\0')
+    {
+        return false;
+    }
+
+    const uint32_t from_file = (uint32_t)(uci[0] - 'a');
+    const uint32_t from_rank = (uint32_t)(uci[1] - '1');
+    const uint32_t to_file = (uint32_t)(uci[2] - 'a');
+    const uint32_t to_rank = (uint32_t)(uci[3] - '1');
+
+    if((from_file | from_rank | to_file | to_rank) > 7)
+    {
+        return false;
+    }
+
+    const uint32_t from_square = BOARD_POS_FROM_FILE_AND_RANK(from_file, from_rank);
+    const uint32_t to_square = BOARD_POS_FROM_FILE_AND_RANK(to_file, to_rank);
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    uint32_t piece = board_get_piece_on(board, from_square, side);
+
+    if(piece == Piece_None)
+    {
+        return false;
+    }
+
+    const uint32_t promotion = _uci_promotion_lookup[(unsigned char)uci[4]];
+
+    if(piece == Piece_Pawn && to_rank == (side == PIECE_WHITE ? 7U : 0U))
+    {
+        if(promotion == 0)
+        {
+            return false;
+        }
+
+        piece = promotion;
+    }
+
+    const bool is_en_passant = piece == Piece_Pawn &&
+                               from_file != to_file &&
+                               BOARD_PTR_HAS_EN_PASSANT(board) &&
+                               to_square == BOARD_PTR_GET_EN_PASSANT_SQUARE(board);
+
+    const bool is_capturing = (board_get_side(board, !side) & BIT64(to_square)) || is_en_passant;
+
+    MOVE_SET_PIECE(*move, piece);
+    MOVE_SET_FROM_SQUARE(*move, from_square);
+    MOVE_SET_TO_SQUARE(*move, to_square);
+    MOVE_SET_IS_CAPTURING(*move, is_capturing);
+
+    return true;
+}
+
+/* SAN */
+
+static const char _san_piece_chars[6] = { 0, 'N', 'B', 'R', 'Q', 'K' };
+
+/* Piece + 1 for the piece letters, 0 otherwise */
+static const uint8_t _san_piece_lookup[256] = {
+    ['N'] = Piece_Knight + 1,
+    ['B'] = Piece_Bishop + 1,
+    ['R'] = Piece_Rook + 1,
+    ['Q'] = Piece_Queen + 1,
+    ['K'] = Piece_King + 1,
+};
+
+/* Characters that can be part of a SAN move, annotations included */
+static const bool _san_chars[256] = {
+    ['a'] = true, ['b'] = true, ['c'] = true, ['d'] = true,
+    ['e'] = true, ['f'] = true, ['g'] = true, ['h'] = true,
+    ['1'] = true, ['2'] = true, ['3'] = true, ['4'] = true,
+    ['5'] = true, ['6'] = true, ['7'] = true, ['8'] = true,
+    ['N'] = true, ['B'] = true, ['R'] = true, ['Q'] = true, ['K'] = true,
+    ['O'] = true, ['0'] = true, ['-'] = true,
+    ['x'] = true, ['='] = true,
+    ['+'] = true, ['#'] = true, ['!'] = true, ['?'] = true,
+};
+
+static const bool _san_annotation_chars[256] = {
+    ['+'] = true, ['#'] = true, ['!'] = true, ['?'] = true,
+};
+
+/* Pieces of the same type as the moving one that could also reach the destination */
+CCHESS_FORCE_INLINE uint64_t san_get_origins(Board* board,
+                                             const uint32_t piece,
+                                             const uint32_t to_square,
+                                             const uint32_t side)
+{
+    const uint64_t occupancy = board_get_all(board);
+    const uint64_t pieces = board_get_pieces(board, piece, side);
+
+    switch(piece)
+    {
+        case Piece_Knight:
+            return move_gen_knight_attacks(to_square) & pieces;
+        case Piece_Bishop:
+            return move_gen_bishop_attacks(to_square, occupancy) & pieces;
+        case Piece_Rook:
+            return move_gen_rook_attacks(to_square, occupancy) & pieces;
+        case Piece_Queen:
+            return move_gen_queen_attacks(to_square, occupancy) & pieces;
+        case Piece_King:
+            return move_gen_king_attacks(to_square) & pieces;
+        default:
+            return 0ULL;
+    }
+}
+
+/* Removes the origins pinned on another line than the one of the move */
+static uint64_t san_filter_pinned(Board* board,
+                                  uint64_t origins,
+                                  const uint32_t to_square,
+                                  const uint32_t side)
+{
+    const uint64_t pinned = board_get_pinned(board, side) & origins;
+
+    if(pinned == 0ULL)
+    {
+        return origins;
+    }
+
+    const uint32_t king_square = (uint32_t)ctz_u64(board_get_king(board, side));
+
+    uint64_t pinned_iter = pinned;
+
+    while(pinned_iter)
+    {
+        const uint32_t square = (uint32_t)ctz_u64(pinned_iter);
+
+        if((move_gen_line(king_square, square) & BIT64(to_square)) == 0ULL)
+        {
+            origins &= ~BIT64(square);
+        }
+
+        pinned_iter = clsb_u64(pinned_iter);
+    }
+
+    return origins;
+}
+
+size_t move_to_san(Board* board, const Move move, char* san)
+{
+    const uint32_t piece = MOVE_GET_PIECE(move);
+    const uint32_t from_square = MOVE_GET_FROM_SQUARE(move);
+    const uint32_t to_square = MOVE_GET_TO_SQUARE(move);
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const bool is_capturing = (bool)MOVE_GET_IS_CAPTURING(move);
+
+    const uint32_t moving_piece = (board_get_pawns(board, side) & BIT64(from_square)) ? Piece_Pawn : piece;
+
+    char* s = san;
+
+    if(moving_piece == Piece_King && (to_square == from_square + 2 || from_square == to_square + 2))
+    {
+        memcpy(s, to_square > from_square ? "O-O" : "O-O-O", to_square > from_square ? 3 : 5);
+        s += to_square > from_square ? 3 : 5;
+    }
+    else
+    {
+        if(moving_piece == Piece_Pawn)
+        {
+            if(is_capturing)
+            {
+                *s++ = (char)('a' + BOARD_FILE_FROM_POS(from_square));
+            }
+        }
+        else
+        {
+            *s++ = _san_piece_chars[moving_piece];
+
+            uint64_t others = san_get_origins(board, moving_piece, to_square, side) & ~BIT64(from_square);
+
+            if(others != 0ULL)
+            {
+                others = san_filter_pinned(board, others, to_square, side);
+            }
+
+            if(others != 0ULL)
+            {
+                const uint64_t file = FILEX(BOARD_FILE_FROM_POS(from_square));
+                const uint64_t rank = RANKX(BOARD_RANK_FROM_POS(from_square));
+
+                if((others & file) == 0ULL)
+                {
+                    *s++ = (char)('a' + BOARD_FILE_FROM_POS(from_square));
+                }
+                else if((others & rank) == 0ULL)
+                {
+                    *s++ = (char)('1' + BOARD_RANK_FROM_POS(from_square));
+                }
+                else
+                {
+                    *s++ = (char)('a' + BOARD_FILE_FROM_POS(from_square));
+                    *s++ = (char)('1' + BOARD_RANK_FROM_POS(from_square));
+                }
+            }
+        }
+
+        if(is_capturing)
+        {
+            *s++ = 'x';
+        }
+
+        *s++ = (char)('a' + BOARD_FILE_FROM_POS(to_square));
+        *s++ = (char)('1' + BOARD_RANK_FROM_POS(to_square));
+
+        if(moving_piece == Piece_Pawn && piece != Piece_Pawn)
+        {
+            *s++ = '=';
+            *s++ = _san_piece_chars[piece];
+        }
+    }
+
+    Board after = *board;
+    board_make_move(&after, move);
+
+    if(board_get_checkers(&after) != 0ULL)
+    {
+        *s++ = board_has_mate(&after) ? '#' : '+';
+    }
+
+    *s = '\0';
+
+    return (size_t)(s - san);
+}
+
+bool move_from_san(Board* board, const char* san, Move* move)
+{
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    size_t length = 0;
+
+    while(_san_chars[(unsigned char)san[length]])
+    {
+        length++;
+    }
+
+    while(length > 0 && _san_annotation_chars[(unsigned char)san[length - 1]])
+    {
+        length--;
+    }
+
+    if(length < 2)
+    {
+        return false;
+    }
+
+    /* Castling, O-O or O-O-O, with letters or zeros throughout */
+    if(san[0] == 'O' || san[0] == '0')
+    {
+        const uint32_t king_square = side == PIECE_WHITE ? 4 : 60;
+        const char c = san[0];
+
+        if(length != 3 && length != 5)
+        {
+            return false;
+        }
+
+        if(san[1] != '-' || san[2] != c || (length == 5 && (san[3] != '-' || san[4] != c)))
+        {
+            return false;
+        }
+
+        if((board_get_king(board, side) & BIT64(king_square)) == 0ULL)
+        {
+            return false;
+        }
+
+        MOVE_SET_PIECE(*move, Piece_King);
+        MOVE_SET_FROM_SQUARE(*move, king_square);
+        MOVE_SET_TO_SQUARE(*move, length == 3 ? king_square + 2 : king_square - 2);
+        MOVE_SET_IS_CAPTURING(*move, 0);
+
+        return true;
+    }
+
+    size_t i = 0;
+
+    const uint32_t piece_lookup = _san_piece_lookup[(unsigned char)san[0]];
+    const uint32_t moving_piece = piece_lookup ? piece_lookup - 1 : Piece_Pawn;
+
+    i += piece_lookup != 0;
+
+    /* Promotion, with or without the = sign */
+    uint32_t promotion = Piece_Pawn;
+
+    if(moving_piece == Piece_Pawn && _san_piece_lookup[(unsigned char)san[length - 1]])
+    {
+        promotion = _san_piece_lookup[(unsigned char)san[length - 1]] - 1;
+        length -= 1 + (length >= 2 && san[length - 2] == '=');
+
+        if(promotion == Piece_King)
+        {
+            return false;
+        }
+    }
+
+    if(length < i + 2)
+    {
+        return false;
+    }
+
+    const uint32_t to_file = (uint32_t)(san[length - 2] - 'a');
+    const uint32_t to_rank = (uint32_t)(san[length - 1] - '1');
+
+    if(to_file > 7 || to_rank > 7)
+    {
+        return false;
+    }
+
+    const uint32_t to_square = BOARD_POS_FROM_FILE_AND_RANK(to_file, to_rank);
+
+    /* Disambiguation and capture between the piece and the destination */
+    uint64_t origins_mask = ~0ULL;
+    uint32_t from_file = 8;
+    bool has_capture_sign = false;
+
+    for(; i < length - 2; i++)
+    {
+        const unsigned char c = (unsigned char)san[i];
+
+        if(c >= 'a' && c <= 'h')
+        {
+            from_file = c - 'a';
+            origins_mask &= FILEX(from_file);
+        }
+        else if(c >= '1' && c <= '8')
+        {
+            origins_mask &= RANKX(c - '1');
+        }
+        else if(c == 'x')
+        {
+            has_capture_sign = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    const uint64_t to_mask = BIT64(to_square);
+    const uint64_t enemy_pieces = board_get_side(board, !side);
+
+    uint32_t from_square;
+    bool is_capturing = (enemy_pieces & to_mask) != 0ULL;
+
+    if(moving_piece == Piece_Pawn)
+    {
+        const int32_t forward = side == PIECE_WHITE ? 8 : -8;
+
+        if(from_file < 8 && from_file != to_file)
+        {
+            /* Capture, the origin is given by the file */
+            from_square = (uint32_t)((int32_t)BOARD_POS_FROM_FILE_AND_RANK(from_file, to_rank) - forward);
+
+            if(!is_capturing && BOARD_PTR_HAS_EN_PASSANT(board) && BOARD_PTR_GET_EN_PASSANT_SQUARE(board) == to_square)
+            {
+                is_capturing = true;
+            }
+
+            if(!is_capturing)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            if(is_capturing || (board_get_all(board) & to_mask))
+            {
+                return false;
+            }
+
+            from_square = (uint32_t)((int32_t)to_square - forward);
+
+            const uint32_t double_push_rank = side == PIECE_WHITE ? 3 : 4;
+
+            if((board_get_pawns(board, side) & BIT64(from_square)) == 0ULL &&
+               to_rank == double_push_rank &&
+               (board_get_all(board) & BIT64(from_square)) == 0ULL)
+            {
+                from_square = (uint32_t)((int32_t)from_square - forward);
+            }
+        }
+
+        if(from_square > 63 || (board_get_pawns(board, side) & BIT64(from_square)) == 0ULL)
+        {
+            return false;
+        }
+
+        const bool reaches_last_rank = to_rank == (side == PIECE_WHITE ? 7U : 0U);
+
+        if(reaches_last_rank != (promotion != Piece_Pawn))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if(board_get_side(board, side) & to_mask)
+        {
+            return false;
+        }
+
+        uint64_t origins = san_get_origins(board, moving_piece, to_square, side) & origins_mask;
+
+        if(origins != 0ULL && clsb_u64(origins) != 0ULL)
+        {
+            origins = san_filter_pinned(board, origins, to_square, side);
+        }
+
+        if(origins == 0ULL || clsb_u64(origins) != 0ULL)
+        {
+            return false;
+        }
+
+        from_square = (uint32_t)ctz_u64(origins);
+    }
+
+    /* A capture sign on a quiet move is accepted, the board is what matters */
+    (void)has_capture_sign;
+
+    MOVE_SET_PIECE(*move, moving_piece == Piece_Pawn ? promotion : moving_piece);
+    MOVE_SET_FROM_SQUARE(*move, from_square);
+    MOVE_SET_TO_SQUARE(*move, to_square);
+    MOVE_SET_IS_CAPTURING(*move, is_capturing);
+
+    return true;
+}
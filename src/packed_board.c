@@ -0,0 +1,148 @@
+#include "cchess/packed_board.h"
+#include "cchess/eval.h"
+
+#include "libromano/bit.h"
+
+#include <string.h>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif /* defined(__BMI2__) */
+
+STATIC_ASSERT(sizeof(PackedBoard) == 32);
+
+/* Bulk functions only spread work across threads above this count */
+#define PACKED_BOARD_PARALLEL_THRESHOLD 4096
+
+/* Bit k of every nibble */
+#define NIBBLES_BIT(k) ((uint64_t)0x1111111111111111 << (k))
+
+CCHESS_FORCE_INLINE uint64_t packed_board_pdep_u64(const uint64_t x, uint64_t mask)
+{
+#if defined(__BMI2__)
+    return _pdep_u64(x, mask);
+#else
+    uint64_t res = 0;
+
+    for(uint64_t bit = 1; mask != 0; bit += bit)
+    {
+        if(x & bit)
+        {
+            res |= mask & (~mask + 1);
+        }
+
+        mask &= mask - 1;
+    }
+
+    return res;
+#endif /* defined(__BMI2__) */
+}
+
+/*
+    The piece codes are handled as 4 bit planes: plane k holds the squares of
+    the pieces whose code has bit k set. pext compresses each plane to one
+    bit per occupied square, pdep spreads those bits into the nibbles, and
+    the decoding does the opposite. No loop over the squares is needed
+*/
+
+bool packed_board_encode(PackedBoard* packed, const Board* board)
+{
+    const uint64_t occupancy = board_get_all(board);
+
+    if(popcount_u64(occupancy) > PACKED_BOARD_MAX_PIECES)
+    {
+        return false;
+    }
+
+    /* The code of a piece is piece * 2 + side, so its low bit is the side and the others the piece */
+    const uint64_t planes[4] = {
+        board->sides[PIECE_BLACK],
+        board->pieces[1] | board->pieces[3] | board->pieces[5],
+        board->pieces[2] | board->pieces[3],
+        board->pieces[4] | board->pieces[5],
+    };
+
+    uint64_t pieces_low = 0;
+    uint64_t pieces_high = 0;
+
+    for(uint32_t k = 0; k < 4; k++)
+    {
+        const uint64_t bits = pext_u64(planes[k], occupancy);
+
+        pieces_low |= packed_board_pdep_u64(bits & 0xFFFF, NIBBLES_BIT(k));
+        pieces_high |= packed_board_pdep_u64(bits >> 16, NIBBLES_BIT(k));
+    }
+
+    packed->occupancy = occupancy;
+    packed->pieces[0] = pieces_low;
+    packed->pieces[1] = pieces_high;
+    packed->state = board->state;
+    packed->halfmove_clock = board->halfmove_clock;
+    packed->fullmove_number = board->fullmove_number;
+
+    return true;
+}
+
+void packed_board_decode(Board* board, const PackedBoard* packed)
+{
+    /* Zeroes the padding too, so decoded boards compare equal to parsed ones */
+    memset(board, 0, sizeof(Board));
+
+    const uint64_t occupancy = packed->occupancy;
+
+    uint64_t planes[4];
+
+    for(uint32_t k = 0; k < 4; k++)
+    {
+        const uint64_t bits = pext_u64(packed->pieces[0], NIBBLES_BIT(k)) |
+                              (pext_u64(packed->pieces[1], NIBBLES_BIT(k)) << 16);
+
+        planes[k] = packed_board_pdep_u64(bits, occupancy);
+    }
+
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        board->pieces[i] = occupancy &
+                           ((i & 1) ? planes[1] : ~planes[1]) &
+                           ((i & 2) ? planes[2] : ~planes[2]) &
+                           ((i & 4) ? planes[3] : ~planes[3]);
+    }
+
+    board->sides[PIECE_WHITE] = occupancy & ~planes[0];
+    board->sides[PIECE_BLACK] = occupancy & planes[0];
+    board->state = packed->state;
+    board->halfmove_clock = packed->halfmove_clock;
+    board->fullmove_number = packed->fullmove_number;
+
+    board_init_derived(board);
+}
+
+size_t packed_board_encode_bulk(PackedBoard* packed, const Board* boards, const size_t count)
+{
+    const int64_t count_i = (int64_t)count;
+
+    size_t num_failures = 0;
+
+#pragma omp parallel for if(count >= PACKED_BOARD_PARALLEL_THRESHOLD) reduction(+:num_failures)
+    for(int64_t i = 0; i < count_i; i++)
+    {
+        if(!packed_board_encode(&packed[i], &boards[i]))
+        {
+            memset(&packed[i], 0, sizeof(PackedBoard));
+            num_failures++;
+        }
+    }
+
+    return num_failures;
+}
+
+void packed_board_decode_bulk(Board* boards, const PackedBoard* packed, const size_t count)
+{
+    const int64_t count_i = (int64_t)count;
+
+#pragma omp parallel for if(count >= PACKED_BOARD_PARALLEL_THRESHOLD)
+    for(int64_t i = 0; i < count_i; i++)
+    {
+        packed_board_decode(&boards[i], &packed[i]);
+    }
+}
@@ -0,0 +1,477 @@
+#include "cchess/pgn.h"
+#include "cchess/notation.h"
+#include "cchess/zobrist.h"
+#include "cchess/char_utils.h"
+#include "cchess/platform.h"
+
+#include "libromano/memory.h"
+
+#include <string.h>
+
+/* Size of the chunks of the file processed by a single thread */
+#define PGN_CHUNK_SIZE ((size_t)1 << 20)
+
+/* Longest token copied to be resolved as a null terminated SAN move */
+#define PGN_TOKEN_BUFFER_SIZE 16
+
+/* Longest FEN tag value */
+#define PGN_FEN_BUFFER_SIZE 128
+
+typedef struct
+{
+    const char* tokens[PGN_MAX_PLIES];
+    uint8_t tokens_lengths[PGN_MAX_PLIES];
+    uint32_t num_tokens;
+
+    PgnResult result;
+    PgnResult termination;
+
+    Board board;
+
+    bool has_error;
+} PgnGame;
+
+typedef struct
+{
+    size_t num_games;
+    size_t num_positions;
+    size_t num_errors;
+} PgnCounts;
+
+static const bool _pgn_token_terminators[256] = {
+    [' '] = true, ['\t'] = true, ['\r'] = true, ['\n'] = true,
+    ['{'] = true, ['}'] = true, ['('] = true, [')'] = true,
+    ['['] = true, [']'] = true, [';'] = true, ['$'] = true,
+};
+
+CCHESS_FORCE_INLINE bool pgn_is_space(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+CCHESS_FORCE_INLINE const char* pgn_skip_to(const char* s, const char* end, const char c)
+{
+    const char* found = (const char*)memchr(s, c, (size_t)(end - s));
+
+    return found != NULL ? found + 1 : end;
+}
+
+PgnResult pgn_parse_result(const char* s, const size_t length)
+{
+    if(length == 3 && memcmp(s, "1-0", 3) == 0)
+    {
+        return PgnResult_WhiteWins;
+    }
+
+    if(length == 3 && memcmp(s, "0-1", 3) == 0)
+    {
+        return PgnResult_BlackWins;
+    }
+
+    if(length == 7 && memcmp(s, "1/2-1/2", 7) == 0)
+    {
+        return PgnResult_Draw;
+    }
+
+    return PgnResult_Unknown;
+}
+
+/* Parses a tag line starting at [, returns the position after the line */
+const char* pgn_parse_tag(PgnGame* game, const char* s, const char* end)
+{
+    const char* line_end = (const char*)memchr(s, '\n', (size_t)(end - s));
+    line_end = line_end != NULL ? line_end : end;
+
+    const char* name = s + 1;
+    const char* name_end = name;
+
+    while(name_end < line_end && !pgn_is_space(*name_end) && *name_end != '"')
+    {
+        name_end++;
+    }
+
+    const char* value = (const char*)memchr(name_end, '"', (size_t)(line_end - name_end));
+    const char* value_end = value != NULL ? (const char*)memchr(value + 1, '"', (size_t)(line_end - value - 1)) : NULL;
+
+    if(value == NULL || value_end == NULL)
+    {
+        return line_end;
+    }
+
+    value++;
+
+    const size_t name_length = (size_t)(name_end - name);
+    const size_t value_length = (size_t)(value_end - value);
+
+    if(name_length == 6 && memcmp(name, "Result", 6) == 0)
+    {
+        game->result = pgn_parse_result(value, value_length);
+    }
+    else if(name_length == 3 && memcmp(name, "FEN", 3) == 0)
+    {
+        char fen[PGN_FEN_BUFFER_SIZE];
+
+        if(value_length >= PGN_FEN_BUFFER_SIZE)
+        {
+            game->has_error = true;
+            return line_end;
+        }
+
+        memcpy(fen, value, value_length);
+        fen[value_length] = '\0';
+
+        game->has_error |= board_parse_fen(&game->board, fen) == 0;
+    }
+
+    return line_end;
+}
+
+/*
+    Tokenizes the game starting at s, up to its termination marker or the
+    first tag of the next game. Returns the position after the game
+*/
+const char* pgn_tokenize_game(PgnGame* game, const char* s, const char* end)
+{
+    game->num_tokens = 0;
+    game->result = PgnResult_Unknown;
+    game->termination = PgnResult_Unknown;
+    game->board = board_init();
+    game->has_error = false;
+
+    bool has_movetext = false;
+
+    /* Set once a token can't be kept, the moves after it would be replayed from the wrong position */
+    bool is_truncated = false;
+
+    while(s < end)
+    {
+        const char c = *s;
+
+        if(pgn_is_space(c))
+        {
+            s++;
+            continue;
+        }
+
+        switch(c)
+        {
+            case '[':
+                if(has_movetext)
+                {
+                    return s;
+                }
+
+                s = pgn_parse_tag(game, s, end);
+                continue;
+            case '{':
+                s = pgn_skip_to(s, end, '}');
+                continue;
+            case ';':
+            case '%':
+                s = pgn_skip_to(s, end, '\n');
+                continue;
+            case '(':
+            {
+                uint32_t depth = 0;
+
+                /* Variations can be nested and hold comments with parentheses */
+                while(s < end)
+                {
+                    if(*s == '{')
+                    {
+                        s = pgn_skip_to(s, end, '}');
+                        continue;
+                    }
+
+                    depth += *s == '(';
+                    depth -= *s == ')';
+                    s++;
+
+                    if(depth == 0)
+                    {
+                        break;
+                    }
+                }
+
+                continue;
+            }
+            case ')':
+            case ']':
+            case '}':
+                s++;
+                continue;
+            case '$':
+                s++;
+
+                while(s < end && is_digit((unsigned char)*s))
+                {
+                    s++;
+                }
+
+                continue;
+            default:
+                break;
+        }
+
+        const char* token = s;
+
+        while(s < end && !_pgn_token_terminators[(unsigned char)*s])
+        {
+            s++;
+        }
+
+        size_t length = (size_t)(s - token);
+
+        has_movetext = true;
+
+        if(length == 1 && token[0] == '*')
+        {
+            return s;
+        }
+
+        if(is_digit((unsigned char)token[0]))
+        {
+            const PgnResult termination = pgn_parse_result(token, length);
+
+            if(termination != PgnResult_Unknown)
+            {
+                game->termination = termination;
+                return s;
+            }
+
+            /* Move numbers, possibly glued to the move (1.e4, 12...Nf6). Castling can be written with zeros */
+            if(token[0] != '0')
+            {
+                while(length > 0 && (is_digit((unsigned char)*token) || *token == '.'))
+                {
+                    token++;
+                    length--;
+                }
+
+                if(length == 0)
+                {
+                    continue;
+                }
+            }
+        }
+
+        if(is_truncated)
+        {
+            continue;
+        }
+
+        if(game->num_tokens == PGN_MAX_PLIES || length >= PGN_TOKEN_BUFFER_SIZE)
+        {
+            game->has_error = true;
+            is_truncated = true;
+            continue;
+        }
+
+        game->tokens[game->num_tokens] = token;
+        game->tokens_lengths[game->num_tokens] = (uint8_t)length;
+        game->num_tokens++;
+    }
+
+    return s;
+}
+
+/* Resolves and plays the moves of a tokenized game, returns the number of positions given to func */
+size_t pgn_replay_game(PgnGame* game,
+                       const uint64_t game_offset,
+                       pgn_position_func func,
+                       void* user_data)
+{
+    PgnPosition position;
+    position.board = &game->board;
+    position.result = game->result != PgnResult_Unknown ? game->result : game->termination;
+    position.game_offset = game_offset;
+
+    char san[PGN_TOKEN_BUFFER_SIZE];
+
+    for(uint32_t i = 0; i < game->num_tokens; i++)
+    {
+        memcpy(san, game->tokens[i], game->tokens_lengths[i]);
+        san[game->tokens_lengths[i]] = '\0';
+
+        /* SAN resolution does not check for castling rights, pins or checks */
+        if(!move_from_san(&game->board, san, &position.move) || !board_move_is_legal(&game->board, position.move))
+        {
+            game->has_error = true;
+            return i;
+        }
+
+        if(func != NULL)
+        {
+            position.key = game->board.key;
+            position.ply = (uint16_t)i;
+
+            func(&position, user_data);
+        }
+
+        board_make_move(&game->board, position.move);
+    }
+
+    return game->num_tokens;
+}
+
+void pgn_parse_text(const char* text,
+                    const size_t begin,
+                    const size_t end,
+                    pgn_position_func func,
+                    void* user_data,
+                    PgnCounts* counts)
+{
+    PgnGame* game = (PgnGame*)platform_alloc_aligned(sizeof(PgnGame), BOARD_ALIGNMENT);
+
+    if(game == NULL)
+    {
+        return;
+    }
+
+    const char* s = text + begin;
+    const char* text_end = text + end;
+
+    while(s < text_end)
+    {
+        while(s < text_end && pgn_is_space(*s))
+        {
+            s++;
+        }
+
+        if(s >= text_end)
+        {
+            break;
+        }
+
+        const uint64_t game_offset = (uint64_t)(s - text);
+
+        s = pgn_tokenize_game(game, s, text_end);
+
+        if(game->num_tokens == 0 && game->result == PgnResult_Unknown && !game->has_error)
+        {
+            continue;
+        }
+
+        counts->num_positions += pgn_replay_game(game, game_offset, func, user_data);
+        counts->num_games++;
+        counts->num_errors += game->has_error;
+    }
+
+    platform_free_aligned(game);
+}
+
+/* Offset of the next line starting with [Event at or after offset, size if there is none */
+size_t pgn_find_game_start(const FileMapping* mapping, size_t offset)
+{
+    const char* data = mapping->data;
+
+    while(offset < mapping->size)
+    {
+        const char* bracket = (const char*)memchr(data + offset, '[', mapping->size - offset);
+
+        if(bracket == NULL)
+        {
+            return mapping->size;
+        }
+
+        offset = (size_t)(bracket - data);
+
+        if((offset == 0 || data[offset - 1] == '\n') &&
+           mapping->size - offset >= 7 &&
+           memcmp(bracket, "[Event ", 7) == 0)
+        {
+            return offset;
+        }
+
+        offset++;
+    }
+
+    return mapping->size;
+}
+
+void pgn_fill_stats(PgnLoadStats* stats, const PgnCounts* counts, const size_t num_bytes, const uint64_t start)
+{
+    const uint64_t elapsed = platform_get_time_ns() - start;
+    const double seconds = elapsed > 0 ? (double)elapsed * 1e-9 : 1e-9;
+
+    stats->num_games = counts->num_games;
+    stats->num_positions = counts->num_positions;
+    stats->num_errors = counts->num_errors;
+    stats->num_bytes = num_bytes;
+    stats->elapsed_ns = elapsed;
+    stats->games_per_second = (double)counts->num_games / seconds;
+    stats->positions_per_second = (double)counts->num_positions / seconds;
+    stats->megabytes_per_second = ((double)num_bytes / (1024.0 * 1024.0)) / seconds;
+}
+
+void pgn_parse(const char* text,
+               const size_t length,
+               pgn_position_func func,
+               void* user_data,
+               PgnLoadStats* stats)
+{
+    const uint64_t start = platform_get_time_ns();
+
+    PgnCounts counts;
+    memset(&counts, 0, sizeof(PgnCounts));
+
+    pgn_parse_text(text, 0, length, func, user_data, &counts);
+
+    if(stats != NULL)
+    {
+        pgn_fill_stats(stats, &counts, length, start);
+    }
+}
+
+bool pgn_load(const char* path,
+              pgn_position_func func,
+              void* user_data,
+              PgnLoadStats* stats)
+{
+    const uint64_t start = platform_get_time_ns();
+
+    FileMapping mapping;
+
+    if(!platform_map_file(&mapping, path, FileMappingAccess_Sequential))
+    {
+        return false;
+    }
+
+    /* Chunk i covers the games starting in [i * PGN_CHUNK_SIZE, (i + 1) * PGN_CHUNK_SIZE) */
+    const int64_t num_chunks = (int64_t)(mapping.size / PGN_CHUNK_SIZE + 1);
+
+    size_t num_games = 0;
+    size_t num_positions = 0;
+    size_t num_errors = 0;
+
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:num_games, num_positions, num_errors)
+    for(int64_t i = 0; i < num_chunks; i++)
+    {
+        const size_t begin = i == 0 ? 0 : pgn_find_game_start(&mapping, (size_t)i * PGN_CHUNK_SIZE);
+        const size_t end = pgn_find_game_start(&mapping, (size_t)(i + 1) * PGN_CHUNK_SIZE);
+
+        if(begin >= end)
+        {
+            continue;
+        }
+
+        PgnCounts counts;
+        memset(&counts, 0, sizeof(PgnCounts));
+
+        pgn_parse_text(mapping.data, begin, end, func, user_data, &counts);
+
+        num_games += counts.num_games;
+        num_positions += counts.num_positions;
+        num_errors += counts.num_errors;
+    }
+
+    if(stats != NULL)
+    {
+        const PgnCounts counts = { num_games, num_positions, num_errors };
+        pgn_fill_stats(stats, &counts, mapping.size, start);
+    }
+
+    platform_unmap_file(&mapping);
+
+    return true;
+}
@@ -0,0 +1,368 @@
+#include "cchess/platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(CCHESS_WIN)
+#include <Windows.h>
+#elif defined(CCHESS_LINUX)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif /* defined(CCHESS_WIN) */
+
+bool platform_map_file(FileMapping* mapping,
+                       const char* path,
+                       const FileMappingAccess access)
+{
+    memset(mapping, 0, sizeof(FileMapping));
+
+#if defined(CCHESS_WIN)
+    HANDLE file = CreateFileA(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              NULL,
+                              OPEN_EXISTING,
+                              access == FileMappingAccess_Sequential ? FILE_FLAG_SEQUENTIAL_SCAN :
+                                                                       FILE_FLAG_RANDOM_ACCESS,
+                              NULL);
+
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+
+    if(!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    if(size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return true;
+    }
+
+    HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if(file_mapping == NULL)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if(data == NULL)
+    {
+        CloseHandle(file_mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mapping->data = (const char*)data;
+    mapping->size = (size_t)size.QuadPart;
+    mapping->file_handle = file;
+    mapping->mapping_handle = file_mapping;
+
+    return true;
+#elif defined(CCHESS_LINUX)
+    const int fd = open(path, O_RDONLY);
+
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+
+    if(fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    if(st.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    /* The mapping keeps its own reference to the file */
+    close(fd);
+
+    if(data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    madvise(data, (size_t)st.st_size, access == FileMappingAccess_Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+    mapping->data = (const char*)data;
+    mapping->size = (size_t)st.st_size;
+
+    return true;
+#else
+    return false;
+#endif /* defined(CCHESS_WIN) */
+}
+
+void platform_unmap_file(FileMapping* mapping)
+{
+#if defined(CCHESS_WIN)
+    if(mapping->data != NULL)
+    {
+        UnmapViewOfFile((LPCVOID)mapping->data);
+        CloseHandle((HANDLE)mapping->mapping_handle);
+        CloseHandle((HANDLE)mapping->file_handle);
+    }
+#elif defined(CCHESS_LINUX)
+    if(mapping->data != NULL)
+    {
+        munmap((void*)mapping->data, mapping->size);
+    }
+#endif /* defined(CCHESS_WIN) */
+
+    memset(mapping, 0, sizeof(FileMapping));
+}
+
+uint64_t platform_get_time_ns(void)
+{
+#if defined(CCHESS_WIN)
+    static LARGE_INTEGER frequency = { 0 };
+
+    if(frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t)((double)counter.QuadPart * (1e9 / (double)frequency.QuadPart));
+#elif defined(CCHESS_LINUX)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#else
+    return 0;
+#endif /* defined(CCHESS_WIN) */
+}
+
+uint32_t platform_get_num_cpus(void)
+{
+#if defined(CCHESS_WIN)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return (uint32_t)info.dwNumberOfProcessors;
+#elif defined(CCHESS_LINUX)
+    const long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return num_cpus > 0 ? (uint32_t)num_cpus : 1;
+#else
+    return 1;
+#endif /* defined(CCHESS_WIN) */
+}
+
+void platform_yield_thread(void)
+{
+#if defined(CCHESS_WIN)
+    SwitchToThread();
+#elif defined(CCHESS_LINUX)
+    sched_yield();
+#endif /* defined(CCHESS_WIN) */
+}
+
+void platform_sleep_ms(const uint32_t ms)
+{
+#if defined(CCHESS_WIN)
+    Sleep((DWORD)ms);
+#elif defined(CCHESS_LINUX)
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000);
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+
+    while(nanosleep(&ts, &ts) != 0)
+    {
+        /* Interrupted by a signal, sleeps the remaining time */
+    }
+#endif /* defined(CCHESS_WIN) */
+}
+
+#if defined(CCHESS_WIN)
+static DWORD WINAPI platform_thread_entry(LPVOID param)
+{
+    PlatformThread* thread = (PlatformThread*)param;
+    thread->func(thread->user_data);
+
+    return 0;
+}
+#elif defined(CCHESS_LINUX)
+/* The thread id is kept in the handle pointer */
+STATIC_ASSERT(sizeof(pthread_t) <= sizeof(void*));
+
+static void* platform_thread_entry(void* param)
+{
+    PlatformThread* thread = (PlatformThread*)param;
+    thread->func(thread->user_data);
+
+    return NULL;
+}
+#endif /* defined(CCHESS_WIN) */
+
+bool platform_thread_start(PlatformThread* thread, PlatformThreadFunc func, void* user_data)
+{
+    thread->func = func;
+    thread->user_data = user_data;
+    thread->handle = NULL;
+
+#if defined(CCHESS_WIN)
+    thread->handle = (void*)CreateThread(NULL, 0, platform_thread_entry, thread, 0, NULL);
+
+    return thread->handle != NULL;
+#elif defined(CCHESS_LINUX)
+    pthread_t handle;
+
+    if(pthread_create(&handle, NULL, platform_thread_entry, thread) != 0)
+    {
+        return false;
+    }
+
+    memcpy(&thread->handle, &handle, sizeof(pthread_t));
+
+    return true;
+#else
+    return false;
+#endif /* defined(CCHESS_WIN) */
+}
+
+void platform_thread_join(PlatformThread* thread)
+{
+    if(thread->handle == NULL)
+    {
+        return;
+    }
+
+#if defined(CCHESS_WIN)
+    WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+    CloseHandle((HANDLE)thread->handle);
+#elif defined(CCHESS_LINUX)
+    pthread_t handle;
+    memcpy(&handle, &thread->handle, sizeof(pthread_t));
+
+    pthread_join(handle, NULL);
+#endif /* defined(CCHESS_WIN) */
+
+    thread->handle = NULL;
+}
+
+/* Huge pages are 2MB on the platforms we support */
+#define PLATFORM_HUGE_PAGE_SIZE (2ULL * 1024ULL * 1024ULL)
+
+void* platform_alloc_large(const size_t size, bool* huge_pages)
+{
+    *huge_pages = false;
+
+#if defined(CCHESS_WIN)
+    /* Large pages need the SeLockMemoryPrivilege, granted to few accounts */
+    const size_t large_page_size = GetLargePageMinimum();
+
+    if(large_page_size > 0)
+    {
+        const size_t rounded_size = (size + large_page_size - 1) & ~(large_page_size - 1);
+        void* ptr = VirtualAlloc(NULL, rounded_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+
+        if(ptr != NULL)
+        {
+            *huge_pages = true;
+            return ptr;
+        }
+    }
+
+    return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(CCHESS_LINUX)
+    const size_t rounded_size = (size + PLATFORM_HUGE_PAGE_SIZE - 1) & ~(PLATFORM_HUGE_PAGE_SIZE - 1);
+
+#if defined(MAP_HUGETLB)
+    void* ptr = mmap(NULL, rounded_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if(ptr != MAP_FAILED)
+    {
+        *huge_pages = true;
+        return ptr;
+    }
+#endif /* defined(MAP_HUGETLB) */
+
+    void* pages = mmap(NULL, rounded_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(pages == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+#if defined(MADV_HUGEPAGE)
+    madvise(pages, rounded_size, MADV_HUGEPAGE);
+#endif /* defined(MADV_HUGEPAGE) */
+
+    return pages;
+#else
+    return NULL;
+#endif /* defined(CCHESS_WIN) */
+}
+
+void platform_free_large(void* ptr, const size_t size)
+{
+    if(ptr == NULL)
+    {
+        return;
+    }
+
+#if defined(CCHESS_WIN)
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(CCHESS_LINUX)
+    munmap(ptr, (size + PLATFORM_HUGE_PAGE_SIZE - 1) & ~(PLATFORM_HUGE_PAGE_SIZE - 1));
+#endif /* defined(CCHESS_WIN) */
+}
+
+void* platform_alloc_aligned(const size_t size, const size_t alignment)
+{
+    CCHESS_ASSERT(alignment >= sizeof(void*) && (alignment & (alignment - 1)) == 0);
+
+#if defined(CCHESS_WIN)
+    void* ptr = _aligned_malloc(size, alignment);
+#elif defined(CCHESS_LINUX)
+    void* ptr = NULL;
+
+    if(posix_memalign(&ptr, alignment, size) != 0)
+    {
+        ptr = NULL;
+    }
+#endif /* defined(CCHESS_WIN) */
+
+    if(ptr != NULL)
+    {
+        memset(ptr, 0, size);
+    }
+
+    return ptr;
+}
+
+void platform_free_aligned(void* ptr)
+{
+#if defined(CCHESS_WIN)
+    _aligned_free(ptr);
+#elif defined(CCHESS_LINUX)
+    free(ptr);
+#endif /* defined(CCHESS_WIN) */
+}
@@ -0,0 +1,881 @@
+#include "cchess/search.h"
+#include "cchess/board_macros.h"
+#include "cchess/eval.h"
+#include "cchess/key_history.h"
+#include "cchess/nnue.h"
+#include "cchess/move_order.h"
+#include "cchess/move_stack.h"
+#include "cchess/platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_ASPIRATION_WINDOW 25
+#define SEARCH_ASPIRATION_MIN_DEPTH 4
+
+#define SEARCH_NULL_MOVE_MIN_DEPTH 3
+
+#define SEARCH_LMR_MIN_DEPTH 3
+#define SEARCH_LMR_MIN_MOVES 3
+
+/* Captures that leave the score this far below alpha even after winning their victim are skipped */
+#define SEARCH_DELTA_MARGIN 200
+
+/* Depths skipped by the helper threads, in cycles of size iterations shifted by phase */
+#define SEARCH_SKIP_TABLE_SIZE 20
+
+static const uint32_t _search_skip_size[SEARCH_SKIP_TABLE_SIZE] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const uint32_t _search_skip_phase[SEARCH_SKIP_TABLE_SIZE] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+/* Moves of the plies being searched, the legal moves of a node being followed by the quiet ones it tried */
+#define SEARCH_MOVE_STACK_SIZE (SEARCH_MAX_PLY * 2 * BOARD_MAX_MOVES + BOARD_MAX_MOVES)
+
+typedef struct Searcher Searcher;
+
+/* State of a thread at one ply of the search, preallocated with it instead of living on the C stack */
+typedef struct
+{
+    /*
+        Position searched, copied from the one of the previous ply before
+        playing the move: the position of the previous ply is the undo record
+    */
+    Board board;
+    /* Move leading to the position, EMPTY_MOVE for a null move */
+    Move played;
+    /* Quiet moves that caused a cutoff at the ply, the first one most recent */
+    Move killers[2];
+    /* Evaluation of the position, 0 in check, stand pat of the quiescence search */
+    int32_t static_eval;
+    ScoredMoveList list;
+} SearchPly;
+
+/* State shared by the threads of a search */
+typedef struct
+{
+    const SearchLimits* limits;
+    TranspositionTable* tt;
+    uint64_t start_ns;
+    /* Hard limit of the search, 0 for none */
+    uint64_t max_time_ns;
+    bool has_time_manager;
+    /* Updated by the main thread only */
+    TimeManager time_manager;
+    /* Raised by the main thread when it is done */
+    volatile uint32_t helpers_stop;
+    Searcher* searchers;
+    uint32_t num_threads;
+} SearchShared;
+
+struct Searcher
+{
+    SearchShared* shared;
+    /* 0 for the main thread */
+    uint32_t thread_index;
+    /* Quiescence nodes are counted in both */
+    uint64_t nodes;
+    uint64_t quiescence_nodes;
+    uint32_t selective_depth;
+    bool stopped;
+
+    /* Triangular principal variation table */
+    Move pv[SEARCH_MAX_PLY + 1][SEARCH_MAX_PLY + 1];
+    uint32_t pv_length[SEARCH_MAX_PLY + 1];
+
+    /* Principal variation of the previous iteration, searched first */
+    Move previous_pv[SEARCH_MAX_PLY];
+    uint32_t previous_pv_length;
+
+    /* Last completed iteration */
+    SearchInfo info;
+
+    /* Accumulators of the positions from the root, with a network */
+    NnueStack nnue_stack;
+
+    MoveOrderTables order;
+
+    /* Indexed by ply, the root position is not in it */
+    SearchPly plies[SEARCH_MAX_PLY + 1];
+    MoveStack move_stack;
+
+    /* Keys of the game followed by the ones of the positions from the root, at root_history_size + ply */
+    KeyHistory history;
+    uint32_t root_history_size;
+};
+
+void search_limits_init(SearchLimits* limits)
+{
+    memset(limits, 0, sizeof(SearchLimits));
+}
+
+CCHESS_FORCE_INLINE bool search_is_pondering(const SearchLimits* limits)
+{
+    return limits->ponder != NULL && platform_atomic_load_u32(limits->ponder) != 0;
+}
+
+static bool search_stop_or_timeout(const Searcher* searcher)
+{
+    SearchShared* shared = searcher->shared;
+    const SearchLimits* limits = shared->limits;
+
+    return (limits->stop != NULL && platform_atomic_load_u32(limits->stop) != 0) ||
+           (searcher->thread_index > 0 && platform_atomic_load_u32(&shared->helpers_stop) != 0) ||
+           (shared->max_time_ns > 0 && !search_is_pondering(limits) && platform_get_time_ns() - shared->start_ns >= shared->max_time_ns);
+}
+
+static bool search_should_stop(Searcher* searcher)
+{
+    const SearchLimits* limits = searcher->shared->limits;
+
+    if(searcher->thread_index == 0 && limits->max_nodes > 0 && searcher->nodes >= limits->max_nodes)
+    {
+        searcher->stopped = true;
+    }
+    else if((searcher->nodes & (SEARCH_CHECK_INTERVAL - 1)) == 0)
+    {
+        searcher->stopped = search_stop_or_timeout(searcher);
+    }
+
+    return searcher->stopped;
+}
+
+static int32_t search_evaluate(const Searcher* searcher, const Board* board)
+{
+    const Nnue* nnue = searcher->shared->limits->nnue;
+
+    return nnue != NULL ? nnue_evaluate(nnue, &searcher->nnue_stack, board) : eval_evaluate(board);
+}
+
+/* The network accumulators follow the moves searched */
+CCHESS_FORCE_INLINE void search_push(Searcher* searcher, const Board* board, const Board* child)
+{
+    const Nnue* nnue = searcher->shared->limits->nnue;
+
+    if(nnue != NULL)
+    {
+        nnue_stack_push(nnue, &searcher->nnue_stack, board, child);
+    }
+}
+
+CCHESS_FORCE_INLINE void search_pop(Searcher* searcher)
+{
+    if(searcher->shared->limits->nnue != NULL)
+    {
+        nnue_stack_pop(&searcher->nnue_stack);
+    }
+}
+
+/* Zugzwang positions are frequent with only pawns left, passing is not tried there */
+CCHESS_FORCE_INLINE bool search_has_pieces(const Board* board, const uint32_t side)
+{
+    return (board->sides[side] & ~(board->pieces[Piece_Pawn] | board->pieces[Piece_King])) != 0ULL;
+}
+
+/* Mate scores are stored relative to the node, and not to the root */
+CCHESS_FORCE_INLINE int32_t search_score_to_tt(const int32_t score, const uint32_t ply)
+{
+    return score >= SEARCH_SCORE_MATE_BOUND ? score + (int32_t)ply :
+           score <= -SEARCH_SCORE_MATE_BOUND ? score - (int32_t)ply : score;
+}
+
+CCHESS_FORCE_INLINE int32_t search_score_from_tt(const int32_t score, const uint32_t ply)
+{
+    return score >= SEARCH_SCORE_MATE_BOUND ? score - (int32_t)ply :
+           score <= -SEARCH_SCORE_MATE_BOUND ? score + (int32_t)ply : score;
+}
+
+/*
+    Searches the captures and promotions until the position is quiet, the
+    side to play standing pat on its static evaluation. Captures that can't
+    raise the score up to alpha or that lose material are skipped. In check,
+    all the evasions are searched instead and there is no standing pat
+*/
+static int32_t search_quiescence(Searcher* searcher, Board* board, int32_t alpha, const int32_t beta, const uint32_t ply)
+{
+    searcher->pv_length[ply] = 0;
+
+    if(searcher->stopped)
+    {
+        return 0;
+    }
+
+    searcher->nodes++;
+    searcher->quiescence_nodes++;
+
+    if(search_should_stop(searcher))
+    {
+        return 0;
+    }
+
+    searcher->selective_depth = ply > searcher->selective_depth ? ply : searcher->selective_depth;
+
+    if(ply >= SEARCH_MAX_PLY)
+    {
+        return search_evaluate(searcher, board);
+    }
+
+    const bool in_check = board_get_checkers(board) != 0ULL;
+
+    SearchPly* current = &searcher->plies[ply];
+    Board* child = &searcher->plies[ply + 1].board;
+
+    MoveStack* move_stack = &searcher->move_stack;
+    Move* moves = move_stack_top(move_stack);
+    size_t num_moves;
+
+    int32_t stand_pat = -SEARCH_SCORE_INFINITE;
+    current->static_eval = 0;
+
+    if(in_check)
+    {
+        board_get_legal_moves(board, moves, &num_moves);
+
+        if(num_moves == 0)
+        {
+            return -SEARCH_SCORE_MATE + (int32_t)ply;
+        }
+    }
+    else
+    {
+        stand_pat = search_evaluate(searcher, board);
+        current->static_eval = stand_pat;
+
+        if(stand_pat >= beta)
+        {
+            return stand_pat;
+        }
+
+        alpha = stand_pat > alpha ? stand_pat : alpha;
+
+        board_get_legal_noisy_moves(board, moves, &num_moves);
+    }
+
+    move_stack_push(move_stack, num_moves);
+
+    ScoredMoveList* list = &current->list;
+    move_order_score_moves(&searcher->order, board, moves, num_moves, NULL, current->killers, move_from_u16(EMPTY_MOVE), list);
+
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    int32_t best_score = stand_pat;
+
+    Move move;
+
+    while(move_order_pick(list, &move))
+    {
+        if(!in_check)
+        {
+            const bool is_promotion = MOVE_GET_PIECE(move) != Piece_Pawn && (board_get_pawns(board, side) & BIT64(MOVE_GET_FROM_SQUARE(move)));
+
+            if(!is_promotion)
+            {
+                /* En passant finds no piece on its destination */
+                const uint32_t victim = board_get_piece_on(board, MOVE_GET_TO_SQUARE(move), !side);
+                const int32_t victim_value = eval_piece_values_mg[victim == Piece_None ? Piece_Pawn : victim];
+
+                if(stand_pat + victim_value + SEARCH_DELTA_MARGIN <= alpha)
+                {
+                    continue;
+                }
+            }
+
+            if(board_see(board, move) < 0)
+            {
+                continue;
+            }
+        }
+
+        *child = *board;
+        board_make_move(child, move);
+
+        search_push(searcher, board, child);
+        const int32_t score = -search_quiescence(searcher, child, -beta, -alpha, ply + 1);
+        search_pop(searcher);
+
+        if(searcher->stopped)
+        {
+            move_stack_pop(move_stack, num_moves);
+            return 0;
+        }
+
+        if(score > best_score)
+        {
+            best_score = score;
+
+            if(score > alpha)
+            {
+                alpha = score;
+
+                searcher->pv[ply][0] = move;
+                memcpy(searcher->pv[ply] + 1, searcher->pv[ply + 1], searcher->pv_length[ply + 1] * sizeof(Move));
+                searcher->pv_length[ply] = searcher->pv_length[ply + 1] + 1;
+
+                if(alpha >= beta)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    move_stack_pop(move_stack, num_moves);
+
+    return best_score;
+}
+
+static int32_t search_alpha_beta(Searcher* searcher,
+                                 Board* board,
+                                 int32_t depth,
+                                 int32_t alpha,
+                                 const int32_t beta,
+                                 const uint32_t ply,
+                                 const bool on_pv_path,
+                                 const bool allow_null_move)
+{
+    searcher->pv_length[ply] = 0;
+
+    /* The quiescence search handles the checks at the horizon with the evasions */
+    if(depth <= 0)
+    {
+        return search_quiescence(searcher, board, alpha, beta, ply);
+    }
+
+    searcher->nodes++;
+
+    if(search_should_stop(searcher))
+    {
+        return 0;
+    }
+
+    searcher->selective_depth = ply > searcher->selective_depth ? ply : searcher->selective_depth;
+
+    if(ply >= SEARCH_MAX_PLY)
+    {
+        return search_evaluate(searcher, board);
+    }
+
+    const bool in_check = board_get_checkers(board) != 0ULL;
+
+    /* Unless the move that reached it mated */
+    if(ply > 0 && board->halfmove_clock >= 100 && (!in_check || board_has_legal_move(board)))
+    {
+        return SEARCH_SCORE_DRAW;
+    }
+
+    /* Check extension */
+    depth += in_check;
+
+    const bool is_pv_node = beta - alpha > 1;
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+    const uint64_t key = board->key;
+
+    SearchPly* current = &searcher->plies[ply];
+    SearchPly* next = &searcher->plies[ply + 1];
+
+    KeyHistory* history = &searcher->history;
+    history->size = searcher->root_history_size + ply;
+    key_history_push(history, key, board->halfmove_clock == 0 || (ply > 0 && move_to_u16(current->played) == EMPTY_MOVE));
+
+    if(ply > 0)
+    {
+        if(key_history_is_repetition(history, ply))
+        {
+            return SEARCH_SCORE_DRAW;
+        }
+
+        /* Moving back to a position of the search is at least a draw */
+        if(alpha < SEARCH_SCORE_DRAW && key_history_has_upcoming_repetition(history, board, ply))
+        {
+            alpha = SEARCH_SCORE_DRAW;
+
+            if(alpha >= beta)
+            {
+                return alpha;
+            }
+        }
+    }
+
+    const int32_t original_alpha = alpha;
+
+    TTEntry entry;
+    const bool tt_hit = tt_probe(searcher->shared->tt, key, &entry);
+
+    /* The principal variation is not cut, to be kept whole */
+    if(tt_hit && !is_pv_node && (int32_t)entry.depth >= depth)
+    {
+        const int32_t score = search_score_from_tt(entry.score, ply);
+
+        if(entry.bound == TTBound_Exact ||
+           (entry.bound == TTBound_Lower && score >= beta) ||
+           (entry.bound == TTBound_Upper && score <= alpha))
+        {
+            return score;
+        }
+    }
+
+    current->static_eval = in_check ? 0 : (tt_hit ? entry.eval : search_evaluate(searcher, board));
+
+    if(allow_null_move &&
+       !is_pv_node &&
+       !in_check &&
+       depth >= SEARCH_NULL_MOVE_MIN_DEPTH &&
+       search_has_pieces(board, side) &&
+       current->static_eval >= beta)
+    {
+        Board* passed = &next->board;
+        *passed = *board;
+        board_make_null_move(passed);
+
+        const int32_t reduction = 2 + depth / 4;
+
+        next->played = move_from_u16(EMPTY_MOVE);
+
+        search_push(searcher, board, passed);
+        const int32_t score = -search_alpha_beta(searcher, passed, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false, false);
+        search_pop(searcher);
+
+        if(searcher->stopped)
+        {
+            return 0;
+        }
+
+        if(score >= beta)
+        {
+            /* Mates found after passing are not proven */
+            return score >= SEARCH_SCORE_MATE_BOUND ? beta : score;
+        }
+    }
+
+    MoveStack* move_stack = &searcher->move_stack;
+    Move* moves = move_stack_top(move_stack);
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    if(num_moves == 0)
+    {
+        return in_check ? -SEARCH_SCORE_MATE + (int32_t)ply : SEARCH_SCORE_DRAW;
+    }
+
+    /* The quiet moves tried follow the legal moves, they can't outnumber them */
+    Move* tried_quiets = moves + num_moves;
+    size_t num_tried_quiets = 0;
+
+    move_stack_push(move_stack, 2 * num_moves);
+
+    const bool has_pv_move = on_pv_path && ply < searcher->previous_pv_length;
+    const bool has_tt_move = tt_hit && move_to_u16(entry.move) != EMPTY_MOVE;
+    const Move previous_move = ply > 0 ? current->played : move_from_u16(EMPTY_MOVE);
+
+    ScoredMoveList* list = &current->list;
+    move_order_score_moves(&searcher->order,
+                           board,
+                           moves,
+                           num_moves,
+                           has_pv_move ? &searcher->previous_pv[ply] : (has_tt_move ? &entry.move : NULL),
+                           current->killers,
+                           previous_move,
+                           list);
+
+    int32_t best_score = -SEARCH_SCORE_INFINITE;
+    Move best_move = move_from_u16(EMPTY_MOVE);
+
+    Board* child = &next->board;
+
+    Move move;
+
+    for(size_t i = 0; move_order_pick(list, &move); i++)
+    {
+        const bool is_quiet = move_order_is_quiet(board, move);
+        const bool child_on_pv_path = has_pv_move && i == 0 && move_equal(move, searcher->previous_pv[ply]);
+
+        *child = *board;
+        board_make_move(child, move);
+
+        next->played = move;
+
+        search_push(searcher, board, child);
+
+        int32_t score;
+
+        if(i == 0)
+        {
+            score = -search_alpha_beta(searcher, child, depth - 1, -beta, -alpha, ply + 1, child_on_pv_path, true);
+        }
+        else
+        {
+            int32_t reduction = 0;
+
+            if(depth >= SEARCH_LMR_MIN_DEPTH &&
+               i >= SEARCH_LMR_MIN_MOVES &&
+               is_quiet &&
+               !in_check &&
+               board_get_checkers(child) == 0ULL)
+            {
+                reduction = 1 + (i >= 6) + (depth >= 6);
+                reduction = reduction > depth - 2 ? depth - 2 : reduction;
+            }
+
+            /*
+                Null window search, reduced first, then at full depth and window if it beats alpha.
+                An interrupted search is not searched again, to count no node past the limit
+            */
+            score = -search_alpha_beta(searcher, child, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, false, true);
+
+            if(score > alpha && reduction > 0 && !searcher->stopped)
+            {
+                score = -search_alpha_beta(searcher, child, depth - 1, -alpha - 1, -alpha, ply + 1, false, true);
+            }
+
+            if(score > alpha && score < beta && !searcher->stopped)
+            {
+                score = -search_alpha_beta(searcher, child, depth - 1, -beta, -alpha, ply + 1, false, true);
+            }
+        }
+
+        search_pop(searcher);
+
+        if(searcher->stopped)
+        {
+            move_stack_pop(move_stack, 2 * num_moves);
+            return 0;
+        }
+
+        if(score > best_score)
+        {
+            best_score = score;
+
+            if(score > alpha)
+            {
+                alpha = score;
+                best_move = move;
+
+                searcher->pv[ply][0] = move;
+                memcpy(searcher->pv[ply] + 1, searcher->pv[ply + 1], searcher->pv_length[ply + 1] * sizeof(Move));
+                searcher->pv_length[ply] = searcher->pv_length[ply + 1] + 1;
+
+                if(alpha >= beta)
+                {
+                    if(is_quiet)
+                    {
+                        move_order_update_quiet(&searcher->order, board, current->killers, depth, move, tried_quiets, num_tried_quiets, previous_move);
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        if(is_quiet)
+        {
+            tried_quiets[num_tried_quiets++] = move;
+        }
+    }
+
+    move_stack_pop(move_stack, 2 * num_moves);
+
+    const TTBound bound = best_score >= beta ? TTBound_Lower :
+                          best_score > original_alpha ? TTBound_Exact : TTBound_Upper;
+
+    tt_store(searcher->shared->tt, key, best_move, search_score_to_tt(best_score, ply), current->static_eval, (uint32_t)depth, bound);
+
+    return best_score;
+}
+
+/* Nodes of all the threads, read while they are searching */
+static uint64_t search_get_total_nodes(const SearchShared* shared, const bool quiescence_only)
+{
+    uint64_t nodes = 0;
+
+    for(uint32_t i = 0; i < shared->num_threads; i++)
+    {
+        const Searcher* searcher = &shared->searchers[i];
+
+        nodes += platform_atomic_load_u64((volatile uint64_t*)(quiescence_only ? &searcher->quiescence_nodes : &searcher->nodes));
+    }
+
+    return nodes;
+}
+
+static void search_update_info(const SearchShared* shared, SearchInfo* info)
+{
+    info->nodes = search_get_total_nodes(shared, false);
+    info->quiescence_nodes = search_get_total_nodes(shared, true);
+    info->elapsed_ns = platform_get_time_ns() - shared->start_ns;
+    info->nps = info->elapsed_ns > 0 ? (uint64_t)((double)info->nodes * 1e9 / (double)info->elapsed_ns) : 0;
+    info->hashfull = tt_hashfull(shared->tt);
+}
+
+/* Helpers skip some depths, so they search ahead of the main thread and of each other */
+static bool search_skip_depth(const Searcher* searcher, const uint32_t depth)
+{
+    if(searcher->thread_index == 0)
+    {
+        return false;
+    }
+
+    const uint32_t i = (searcher->thread_index - 1) % SEARCH_SKIP_TABLE_SIZE;
+
+    return ((depth + _search_skip_phase[i]) / _search_skip_size[i]) % 2 != 0;
+}
+
+/* Iterative deepening of one thread, searcher->info holding the last completed iteration */
+static void search_iterate(Searcher* searcher, Board* board)
+{
+    const SearchLimits* limits = searcher->shared->limits;
+    SearchInfo* info = &searcher->info;
+
+    if(limits->nnue != NULL)
+    {
+        nnue_stack_reset(limits->nnue, &searcher->nnue_stack, board);
+    }
+
+    move_order_clear(&searcher->order);
+
+    for(uint32_t i = 0; i <= SEARCH_MAX_PLY; i++)
+    {
+        searcher->plies[i].killers[0] = move_from_u16(EMPTY_MOVE);
+        searcher->plies[i].killers[1] = move_from_u16(EMPTY_MOVE);
+    }
+
+    const uint32_t max_depth = limits->max_depth > 0 && limits->max_depth < SEARCH_MAX_PLY ? limits->max_depth : SEARCH_MAX_PLY - 1;
+
+    int32_t score = 0;
+
+    for(uint32_t depth = 1; depth <= max_depth; depth++)
+    {
+        if(depth > 1 && search_stop_or_timeout(searcher))
+        {
+            break;
+        }
+
+        if(depth > 1 && search_skip_depth(searcher, depth))
+        {
+            continue;
+        }
+
+        int32_t window = SEARCH_ASPIRATION_WINDOW;
+        int32_t alpha = -SEARCH_SCORE_INFINITE;
+        int32_t beta = SEARCH_SCORE_INFINITE;
+
+        if(depth >= SEARCH_ASPIRATION_MIN_DEPTH)
+        {
+            alpha = score - window > -SEARCH_SCORE_INFINITE ? score - window : -SEARCH_SCORE_INFINITE;
+            beta = score + window < SEARCH_SCORE_INFINITE ? score + window : SEARCH_SCORE_INFINITE;
+        }
+
+        int32_t value;
+
+        /* The window is widened on the failing side until the score falls inside */
+        for(;;)
+        {
+            value = search_alpha_beta(searcher, board, (int32_t)depth, alpha, beta, 0, true, false);
+
+            if(searcher->stopped)
+            {
+                break;
+            }
+
+            window *= 2;
+
+            if(value <= alpha)
+            {
+                alpha = value - window > -SEARCH_SCORE_INFINITE ? value - window : -SEARCH_SCORE_INFINITE;
+            }
+            else if(value >= beta)
+            {
+                beta = value + window < SEARCH_SCORE_INFINITE ? value + window : SEARCH_SCORE_INFINITE;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if(searcher->stopped)
+        {
+            break;
+        }
+
+        score = value;
+
+        memcpy(searcher->previous_pv, searcher->pv[0], searcher->pv_length[0] * sizeof(Move));
+        searcher->previous_pv_length = searcher->pv_length[0];
+
+        info->depth = depth;
+        info->score = score;
+        info->selective_depth = searcher->selective_depth;
+        info->pv_length = searcher->pv_length[0];
+        memcpy(info->pv, searcher->pv[0], searcher->pv_length[0] * sizeof(Move));
+
+        if(searcher->thread_index == 0 && limits->callback != NULL)
+        {
+            search_update_info(searcher->shared, info);
+            limits->callback(info, limits->user_data);
+        }
+
+        SearchShared* shared = searcher->shared;
+
+        /* The time manager follows the main thread, while pondering it can't stop the search */
+        if(searcher->thread_index == 0 &&
+           shared->has_time_manager &&
+           time_manager_iteration_done(&shared->time_manager, depth, info->pv[0], score, platform_get_time_ns() - shared->start_ns) &&
+           !search_is_pondering(limits))
+        {
+            break;
+        }
+
+        /* A mate shorter than the depth searched can't be improved */
+        if(SEARCH_SCORE_IS_MATE(score) && SEARCH_SCORE_MATE - abs(score) <= (int32_t)depth)
+        {
+            break;
+        }
+    }
+}
+
+/* Also releases the move stacks allocated, searchers can be NULL */
+static void search_release_searchers(Searcher* searchers, const uint32_t num_threads)
+{
+    if(searchers == NULL)
+    {
+        return;
+    }
+
+    for(uint32_t i = 0; i < num_threads; i++)
+    {
+        move_stack_release(&searchers[i].move_stack);
+    }
+
+    platform_free_aligned(searchers);
+}
+
+bool search_run(Board* board, const SearchLimits* limits, SearchInfo* info)
+{
+    memset(info, 0, sizeof(SearchInfo));
+
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    if(num_moves == 0)
+    {
+        return false;
+    }
+
+    TranspositionTable search_tt;
+    TranspositionTable* tt = limits->tt;
+
+    if(tt == NULL)
+    {
+        if(!tt_init(&search_tt, SEARCH_DEFAULT_TT_SIZE_MB))
+        {
+            return false;
+        }
+
+        tt_clear(&search_tt);
+        tt = &search_tt;
+    }
+
+    const uint32_t num_threads = limits->num_threads > 1 ? limits->num_threads : 1;
+
+    /* Too large for the small stacks of the worker threads, the boards of the plies need the alignment */
+    Searcher* searchers = (Searcher*)platform_alloc_aligned(num_threads * sizeof(Searcher), BOARD_ALIGNMENT);
+    bool allocated = searchers != NULL;
+
+    /* Nothing is allocated once the threads search */
+    for(uint32_t i = 0; allocated && i < num_threads; i++)
+    {
+        allocated = move_stack_init(&searchers[i].move_stack, SEARCH_MOVE_STACK_SIZE);
+    }
+
+    if(!allocated)
+    {
+        search_release_searchers(searchers, num_threads);
+
+        if(tt == &search_tt)
+        {
+            tt_release(&search_tt);
+        }
+
+        return false;
+    }
+
+    tt_new_search(tt);
+
+    SearchShared shared;
+    shared.limits = limits;
+    shared.tt = tt;
+    shared.start_ns = platform_get_time_ns();
+    shared.max_time_ns = limits->max_time_ns;
+    shared.has_time_manager = time_control_is_set(&limits->time_control);
+
+    if(shared.has_time_manager)
+    {
+        time_manager_init(&shared.time_manager, &limits->time_control);
+
+        const uint64_t maximum_ns = shared.time_manager.maximum_ns;
+        shared.max_time_ns = shared.max_time_ns == 0 || maximum_ns < shared.max_time_ns ? maximum_ns : shared.max_time_ns;
+    }
+    shared.helpers_stop = 0;
+    shared.searchers = searchers;
+    shared.num_threads = num_threads;
+
+    for(uint32_t i = 0; i < num_threads; i++)
+    {
+        searchers[i].shared = &shared;
+        searchers[i].thread_index = i;
+
+        if(limits->history != NULL)
+        {
+            memcpy(&searchers[i].history, limits->history, sizeof(KeyHistory));
+        }
+        else
+        {
+            key_history_reset(&searchers[i].history);
+        }
+
+        searchers[i].root_history_size = searchers[i].history.size;
+
+        /* A move is always returned, even if the first iteration is interrupted */
+        searchers[i].info.pv[0] = moves[0];
+        searchers[i].info.pv_length = 1;
+    }
+
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+    for(int64_t i = 0; i < (int64_t)num_threads; i++)
+    {
+        Board root = *board;
+
+        search_iterate(&searchers[i], &root);
+
+        CCHESS_ASSERT(searchers[i].move_stack.size == 0);
+
+        if(i == 0)
+        {
+            platform_atomic_store_u32(&shared.helpers_stop, 1);
+        }
+    }
+
+    /* A helper that completed a deeper iteration with a better score is trusted over the main thread */
+    const Searcher* best = &searchers[0];
+
+    for(uint32_t i = 1; i < num_threads; i++)
+    {
+        if(searchers[i].info.depth > best->info.depth && searchers[i].info.score > best->info.score)
+        {
+            best = &searchers[i];
+        }
+    }
+
+    memcpy(info, &best->info, sizeof(SearchInfo));
+    search_update_info(&shared, info);
+    info->time_limit_ns = shared.max_time_ns;
+
+    search_release_searchers(searchers, num_threads);
+
+    if(tt == &search_tt)
+    {
+        tt_release(&search_tt);
+    }
+
+    return true;
+}
@@ -0,0 +1,1639 @@
+#include "cchess/syzygy.h"
+#include "cchess/board_macros.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYZYGY_MAX_PATH_SIZE 1024
+#define SYZYGY_MAX_DIRECTORIES 16
+#define SYZYGY_MAX_NAME_SIZE 16
+
+/* Holds twice the number of 7 pieces tables, every table being registered under its two material keys */
+#define SYZYGY_HASH_SIZE 8192
+
+#define SYZYGY_WDL 0
+#define SYZYGY_DTZ 1
+
+#if defined(CCHESS_WIN)
+#define SYZYGY_PATH_SEPARATOR ';'
+#else
+#define SYZYGY_PATH_SEPARATOR ':'
+#endif /* defined(CCHESS_WIN) */
+
+/* Table flags, stored in the first byte of every pairs header */
+#define SYZYGY_FLAG_STM 0x1
+#define SYZYGY_FLAG_MAPPED 0x2
+#define SYZYGY_FLAG_WIN_PLIES 0x4
+#define SYZYGY_FLAG_LOSS_PLIES 0x8
+#define SYZYGY_FLAG_WIDE 0x10
+#define SYZYGY_FLAG_SINGLE_VALUE 0x80
+
+/* File flags, stored in the byte following the magic */
+#define SYZYGY_FILE_SPLIT 0x1
+#define SYZYGY_FILE_HAS_PAWNS 0x2
+
+typedef enum
+{
+    SyzygyFileState_Unmapped = 0,
+    SyzygyFileState_Mapping = 1,
+    SyzygyFileState_Ready = 2,
+    SyzygyFileState_Missing = 3,
+} SyzygyFileState;
+
+typedef enum
+{
+    SyzygyProbe_Fail = 0,
+    SyzygyProbe_Ok = 1,
+    /* The DTZ table stores the other side to play */
+    SyzygyProbe_ChangeStm = 2,
+    /* The best move zeroes the fifty-move counter, the DTZ table value can't be used */
+    SyzygyProbe_ZeroingBestMove = 3,
+} SyzygyProbe;
+
+/*
+    Decoding information of one compressed table. The values are stored with
+    a canonical Huffman code over symbols that expand, by recursive pairing,
+    to runs of values. Values are grouped in blocks, a sparse index giving
+    the block of every span-th value
+*/
+typedef struct
+{
+    uint8_t flags;
+    uint8_t max_sym_len;
+    /* Holds the value of single value tables */
+    uint8_t min_sym_len;
+
+    uint32_t num_blocks;
+    uint64_t block_size;
+    uint64_t span;
+
+    /* Lowest symbol of each code length, little-endian uint16 */
+    const uint8_t* lowest_sym;
+    /* Left and right 12 bits children of every symbol */
+    const uint8_t* btree;
+    /* Number of values minus one of each block, little-endian uint16 */
+    const uint8_t* block_length;
+    uint64_t block_length_size;
+    /* Block (uint32) and offset in the block (uint16) of every span-th value */
+    const uint8_t* sparse_index;
+    uint64_t sparse_index_size;
+    const uint8_t* data;
+
+    /* base64[l - min_sym_len] is the lowest code of length l, left aligned on 64 bits */
+    uint64_t* base64;
+    /* Number of values minus one represented by every symbol */
+    uint8_t* symlen;
+    uint32_t num_syms;
+
+    /* Piece codes in encoding order: piece + 1, plus 8 for black */
+    uint8_t pieces[SYZYGY_MAX_PIECES];
+    uint64_t group_idx[SYZYGY_MAX_PIECES + 1];
+    uint32_t group_len[SYZYGY_MAX_PIECES + 1];
+
+    /* Offsets in the DTZ value maps, for win, loss, cursed win and blessed loss */
+    uint16_t map_idx[4];
+} SyzygyPairs;
+
+typedef struct
+{
+    volatile uint32_t state;
+
+    FileMapping mapping;
+
+    /* DTZ value maps */
+    const uint8_t* map;
+
+    /* [side to play][leading pawn file], WDL tables store both sides to play when materials differ */
+    SyzygyPairs pairs[2][4];
+} SyzygyFile;
+
+typedef struct
+{
+    /* Material keys with the first side of the table name as white, and as black */
+    uint64_t key;
+    uint64_t key2;
+
+    uint32_t num_pieces;
+    uint32_t directory;
+
+    bool has_pawns;
+    bool has_unique_pieces;
+
+    /* Pawns of the leading side, and of the other side */
+    uint8_t pawn_count[2];
+
+    char name[SYZYGY_MAX_NAME_SIZE];
+
+    SyzygyFile files[2];
+} SyzygyTable;
+
+typedef struct
+{
+    uint64_t key;
+    /* Index of the table + 1, 0 for empty slots */
+    uint32_t table;
+} SyzygyHashEntry;
+
+static char _syzygy_directories[SYZYGY_MAX_DIRECTORIES][SYZYGY_MAX_PATH_SIZE];
+static uint32_t _syzygy_num_directories = 0;
+
+static SyzygyTable* _syzygy_tables = NULL;
+static size_t _syzygy_num_tables = 0;
+
+static SyzygyHashEntry _syzygy_hash[SYZYGY_HASH_SIZE];
+
+static uint32_t _syzygy_max_pieces = 0;
+
+/* Encoding tables, see syzygy_init_encoding */
+static int32_t _syzygy_map_pawns[64];
+static int32_t _syzygy_map_b1h1h7[64];
+static int32_t _syzygy_map_a1d1d4[64];
+static int32_t _syzygy_map_kk[10][64];
+static int32_t _syzygy_binomial[6][64];
+static int32_t _syzygy_lead_pawn_idx[6][64];
+static int32_t _syzygy_lead_pawns_size[6][4];
+static bool _syzygy_encoding_initialized = false;
+
+static const char _syzygy_piece_chars[5] = { 'P', 'N', 'B', 'R', 'Q' };
+
+static const uint8_t _syzygy_wdl_magic[4] = { 0x71, 0xE8, 0x23, 0x5D };
+static const uint8_t _syzygy_dtz_magic[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+CCHESS_FORCE_INLINE uint32_t syzygy_read_u16(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8);
+}
+
+CCHESS_FORCE_INLINE uint32_t syzygy_read_u32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+CCHESS_FORCE_INLINE uint32_t syzygy_read_u32_be(const uint8_t* data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+CCHESS_FORCE_INLINE int32_t syzygy_off_a1h8(const uint32_t square)
+{
+    return (int32_t)BOARD_RANK_FROM_POS(square) - (int32_t)BOARD_FILE_FROM_POS(square);
+}
+
+CCHESS_FORCE_INLINE int32_t syzygy_sign(const int32_t value)
+{
+    return (value > 0) - (value < 0);
+}
+
+/*
+    Builds the tables used to turn a position into its index in the tables:
+    placements of the leading pieces in the a1-d1-d4 triangle, of the two
+    kings, of the leading pawns, and binomial coefficients to encode groups
+    of identical pieces
+*/
+static void syzygy_init_encoding(void)
+{
+    if(_syzygy_encoding_initialized)
+    {
+        return;
+    }
+
+    /* Squares below the a1-h8 diagonal to 0..27 */
+    int32_t code = 0;
+
+    for(uint32_t s = 0; s < 64; s++)
+    {
+        if(syzygy_off_a1h8(s) < 0)
+        {
+            _syzygy_map_b1h1h7[s] = code++;
+        }
+    }
+
+    /* Squares of the a1-d1-d4 triangle to 0..9, the diagonal ones last */
+    uint32_t diagonal[4];
+    uint32_t num_diagonal = 0;
+
+    code = 0;
+
+    for(uint32_t s = 0; s <= 27; s++)
+    {
+        if(syzygy_off_a1h8(s) < 0 && BOARD_FILE_FROM_POS(s) <= 3)
+        {
+            _syzygy_map_a1d1d4[s] = code++;
+        }
+        else if(syzygy_off_a1h8(s) == 0 && BOARD_FILE_FROM_POS(s) <= 3)
+        {
+            diagonal[num_diagonal++] = s;
+        }
+    }
+
+    for(uint32_t i = 0; i < num_diagonal; i++)
+    {
+        _syzygy_map_a1d1d4[diagonal[i]] = code++;
+    }
+
+    /*
+        The 462 legal placements of two kings, the first one in the a1-d1-d4
+        triangle. When the first king is on the diagonal the second one is
+        not above it, placements with both kings on the diagonal come last
+    */
+    uint32_t both_on_diagonal[64][2];
+    uint32_t num_both_on_diagonal = 0;
+
+    code = 0;
+
+    for(int32_t idx = 0; idx < 10; idx++)
+    {
+        for(uint32_t s1 = 0; s1 <= 27; s1++)
+        {
+            /* b1 is mapped to 0, like the squares outside of the triangle */
+            if(_syzygy_map_a1d1d4[s1] != idx || (idx == 0 && s1 != 1))
+            {
+                continue;
+            }
+
+            for(uint32_t s2 = 0; s2 < 64; s2++)
+            {
+                if((move_gen_king_attacks(s1) | BIT64(s1)) & BIT64(s2))
+                {
+                    continue;
+                }
+                else if(syzygy_off_a1h8(s1) == 0 && syzygy_off_a1h8(s2) > 0)
+                {
+                    continue;
+                }
+                else if(syzygy_off_a1h8(s1) == 0 && syzygy_off_a1h8(s2) == 0)
+                {
+                    both_on_diagonal[num_both_on_diagonal][0] = (uint32_t)idx;
+                    both_on_diagonal[num_both_on_diagonal][1] = s2;
+                    num_both_on_diagonal++;
+                }
+                else
+                {
+                    _syzygy_map_kk[idx][s2] = code++;
+                }
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < num_both_on_diagonal; i++)
+    {
+        _syzygy_map_kk[both_on_diagonal[i][0]][both_on_diagonal[i][1]] = code++;
+    }
+
+    /* Binomial[k][n], ways to choose k squares out of n */
+    _syzygy_binomial[0][0] = 1;
+
+    for(int32_t n = 1; n < 64; n++)
+    {
+        for(int32_t k = 0; k < 6 && k <= n; k++)
+        {
+            _syzygy_binomial[k][n] = (k > 0 ? _syzygy_binomial[k - 1][n - 1] : 0) +
+                                     (k < n ? _syzygy_binomial[k][n - 1] : 0);
+        }
+    }
+
+    /*
+        Pawn squares a2-h7 to 0..47, the leading pawn being the one with the
+        highest value: nearest to the edge and, on a same file, the lowest one.
+        The leading pawns are indexed per file of the leading pawn
+    */
+    int32_t available_squares = 47;
+
+    for(int32_t lead_pawns_count = 1; lead_pawns_count <= 5; lead_pawns_count++)
+    {
+        for(uint32_t file = 0; file < 4; file++)
+        {
+            int32_t idx = 0;
+
+            for(uint32_t rank = 1; rank <= 6; rank++)
+            {
+                const uint32_t square = BOARD_POS_FROM_FILE_AND_RANK(file, rank);
+
+                if(lead_pawns_count == 1)
+                {
+                    _syzygy_map_pawns[square] = available_squares--;
+                    _syzygy_map_pawns[square ^ 7] = available_squares--;
+                }
+
+                _syzygy_lead_pawn_idx[lead_pawns_count][square] = idx;
+                idx += _syzygy_binomial[lead_pawns_count - 1][_syzygy_map_pawns[square]];
+            }
+
+            _syzygy_lead_pawns_size[lead_pawns_count][file] = idx;
+        }
+    }
+
+    _syzygy_encoding_initialized = true;
+}
+
+/* Table lookup */
+
+CCHESS_FORCE_INLINE uint32_t syzygy_hash_slot(const uint64_t key)
+{
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 51) & (SYZYGY_HASH_SIZE - 1);
+}
+
+static void syzygy_hash_insert(const uint64_t key, const uint32_t table)
+{
+    uint32_t slot = syzygy_hash_slot(key);
+
+    while(_syzygy_hash[slot].table != 0 && _syzygy_hash[slot].key != key)
+    {
+        slot = (slot + 1) & (SYZYGY_HASH_SIZE - 1);
+    }
+
+    _syzygy_hash[slot].key = key;
+    _syzygy_hash[slot].table = table;
+}
+
+static SyzygyTable* syzygy_find_table(const uint64_t key)
+{
+    uint32_t slot = syzygy_hash_slot(key);
+
+    while(_syzygy_hash[slot].table != 0)
+    {
+        if(_syzygy_hash[slot].key == key)
+        {
+            return &_syzygy_tables[_syzygy_hash[slot].table - 1];
+        }
+
+        slot = (slot + 1) & (SYZYGY_HASH_SIZE - 1);
+    }
+
+    return NULL;
+}
+
+uint64_t syzygy_material_key(const Board* board)
+{
+    uint64_t key = 0;
+
+    for(uint32_t piece = Piece_Pawn; piece < Piece_King; piece++)
+    {
+        key |= popcount_u64(board_get_pieces(board, piece, PIECE_WHITE)) << (piece * 4);
+        key |= popcount_u64(board_get_pieces(board, piece, PIECE_BLACK)) << (20 + piece * 4);
+    }
+
+    return key;
+}
+
+/* Pieces counts of the table, kings excluded, per side and piece */
+static void syzygy_register_table(const uint32_t counts[2][5], const uint32_t directory)
+{
+    uint64_t key = 0;
+    uint64_t key2 = 0;
+    uint32_t num_pieces = 2;
+
+    for(uint32_t piece = 0; piece < 5; piece++)
+    {
+        key |= (uint64_t)counts[0][piece] << (piece * 4) | (uint64_t)counts[1][piece] << (20 + piece * 4);
+        key2 |= (uint64_t)counts[1][piece] << (piece * 4) | (uint64_t)counts[0][piece] << (20 + piece * 4);
+        num_pieces += counts[0][piece] + counts[1][piece];
+    }
+
+    if(syzygy_find_table(key) != NULL)
+    {
+        return;
+    }
+
+    _syzygy_tables = (SyzygyTable*)realloc(_syzygy_tables, (_syzygy_num_tables + 1) * sizeof(SyzygyTable));
+
+    SyzygyTable* table = &_syzygy_tables[_syzygy_num_tables++];
+    memset(table, 0, sizeof(SyzygyTable));
+
+    table->key = key;
+    table->key2 = key2;
+    table->num_pieces = num_pieces;
+    table->directory = directory;
+    table->has_pawns = counts[0][Piece_Pawn] + counts[1][Piece_Pawn] > 0;
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        for(uint32_t piece = 0; piece < 5; piece++)
+        {
+            table->has_unique_pieces |= counts[side][piece] == 1;
+        }
+    }
+
+    /* The leading side is the one with less pawns, for better compression */
+    const uint32_t white_pawns = counts[0][Piece_Pawn];
+    const uint32_t black_pawns = counts[1][Piece_Pawn];
+    const bool white_leads = black_pawns == 0 || (white_pawns > 0 && black_pawns >= white_pawns);
+
+    table->pawn_count[0] = (uint8_t)(white_leads ? white_pawns : black_pawns);
+    table->pawn_count[1] = (uint8_t)(white_leads ? black_pawns : white_pawns);
+
+    char* name = table->name;
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        *name++ = 'K';
+
+        for(int32_t piece = Piece_Queen; piece >= Piece_Pawn; piece--)
+        {
+            for(uint32_t i = 0; i < counts[side][piece]; i++)
+            {
+                *name++ = _syzygy_piece_chars[piece];
+            }
+        }
+
+        *name++ = side == 0 ? 'v' : '\0';
+    }
+
+    syzygy_hash_insert(key, (uint32_t)_syzygy_num_tables);
+    syzygy_hash_insert(key2, (uint32_t)_syzygy_num_tables);
+
+    _syzygy_max_pieces = num_pieces > _syzygy_max_pieces ? num_pieces : _syzygy_max_pieces;
+}
+
+static bool syzygy_file_exists(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+CCHESS_FORCE_INLINE uint32_t syzygy_counts_size(const uint32_t* counts)
+{
+    return counts[0] + counts[1] + counts[2] + counts[3] + counts[4];
+}
+
+/* Next piece counts vector, in lexicographic order, of at most max_size pieces. Returns false after the last one */
+static bool syzygy_next_counts(uint32_t* counts, const uint32_t max_size)
+{
+    for(uint32_t piece = 0; piece < 5; piece++)
+    {
+        counts[piece]++;
+
+        if(syzygy_counts_size(counts) <= max_size)
+        {
+            return true;
+        }
+
+        counts[piece] = 0;
+    }
+
+    return false;
+}
+
+size_t syzygy_init(const char* paths)
+{
+    syzygy_release();
+    syzygy_init_encoding();
+
+    if(paths == NULL)
+    {
+        return 0;
+    }
+
+    /* Splits the directories */
+    while(*paths != '\0' && _syzygy_num_directories < SYZYGY_MAX_DIRECTORIES)
+    {
+        const char* end = strchr(paths, SYZYGY_PATH_SEPARATOR);
+        const size_t length = end != NULL ? (size_t)(end - paths) : strlen(paths);
+
+        if(length > 0 && length < SYZYGY_MAX_PATH_SIZE - SYZYGY_MAX_NAME_SIZE - 8)
+        {
+            memcpy(_syzygy_directories[_syzygy_num_directories], paths, length);
+            _syzygy_directories[_syzygy_num_directories][length] = '\0';
+            _syzygy_num_directories++;
+        }
+
+        paths += length + (end != NULL);
+    }
+
+    /* Every material combination, only the existence of the WDL file is checked */
+    uint32_t counts[2][5];
+    memset(counts, 0, sizeof(counts));
+
+    const uint32_t max_size = SYZYGY_MAX_PIECES - 2;
+
+    do
+    {
+        memset(counts[1], 0, sizeof(counts[1]));
+
+        do
+        {
+            const uint32_t size = syzygy_counts_size(counts[0]) + syzygy_counts_size(counts[1]);
+
+            if(size == 0 || size > max_size)
+            {
+                continue;
+            }
+
+            char name[SYZYGY_MAX_NAME_SIZE];
+            char* s = name;
+
+            for(uint32_t side = 0; side < 2; side++)
+            {
+                *s++ = 'K';
+
+                for(int32_t piece = Piece_Queen; piece >= Piece_Pawn; piece--)
+                {
+                    for(uint32_t i = 0; i < counts[side][piece]; i++)
+                    {
+                        *s++ = _syzygy_piece_chars[piece];
+                    }
+                }
+
+                *s++ = side == 0 ? 'v' : '\0';
+            }
+
+            for(uint32_t i = 0; i < _syzygy_num_directories; i++)
+            {
+                char path[SYZYGY_MAX_PATH_SIZE];
+                snprintf(path, SYZYGY_MAX_PATH_SIZE, "%s/%s.rtbw", _syzygy_directories[i], name);
+
+                if(syzygy_file_exists(path))
+                {
+                    syzygy_register_table((const uint32_t (*)[5])counts, i);
+                    break;
+                }
+            }
+        } while(syzygy_next_counts(counts[1], max_size));
+    } while(syzygy_next_counts(counts[0], max_size));
+
+    return _syzygy_num_tables;
+}
+
+static void syzygy_release_file(SyzygyFile* file)
+{
+    for(uint32_t i = 0; i < 2; i++)
+    {
+        for(uint32_t f = 0; f < 4; f++)
+        {
+            free(file->pairs[i][f].base64);
+            free(file->pairs[i][f].symlen);
+        }
+    }
+
+    platform_unmap_file(&file->mapping);
+
+    memset(file->pairs, 0, sizeof(file->pairs));
+    file->map = NULL;
+}
+
+void syzygy_release(void)
+{
+    for(size_t i = 0; i < _syzygy_num_tables; i++)
+    {
+        syzygy_release_file(&_syzygy_tables[i].files[SYZYGY_WDL]);
+        syzygy_release_file(&_syzygy_tables[i].files[SYZYGY_DTZ]);
+    }
+
+    free(_syzygy_tables);
+
+    _syzygy_tables = NULL;
+    _syzygy_num_tables = 0;
+    _syzygy_num_directories = 0;
+    _syzygy_max_pieces = 0;
+
+    memset(_syzygy_hash, 0, sizeof(_syzygy_hash));
+}
+
+uint32_t syzygy_get_max_pieces(void)
+{
+    return _syzygy_max_pieces;
+}
+
+/* Table setup */
+
+/*
+    Groups the pieces encoded together: the leading group (leading pawns,
+    or three unique pieces, or the two kings), then the pieces of a same
+    type and color. The order in which the groups are encoded is stored in
+    the table
+*/
+static void syzygy_set_groups(const SyzygyTable* table, SyzygyPairs* d, const uint32_t* order, const uint32_t file)
+{
+    uint32_t n = 0;
+    int32_t first_len = table->has_pawns ? 0 : table->has_unique_pieces ? 3 : 2;
+
+    d->group_len[n] = 1;
+
+    for(uint32_t i = 1; i < table->num_pieces; i++)
+    {
+        if(--first_len > 0 || d->pieces[i] == d->pieces[i - 1])
+        {
+            d->group_len[n]++;
+        }
+        else
+        {
+            d->group_len[++n] = 1;
+        }
+    }
+
+    d->group_len[++n] = 0;
+
+    const bool pawns_on_both_sides = table->has_pawns && table->pawn_count[1] > 0;
+
+    uint32_t next = pawns_on_both_sides ? 2 : 1;
+    uint32_t free_squares = 64 - d->group_len[0] - (pawns_on_both_sides ? d->group_len[1] : 0);
+    uint64_t idx = 1;
+
+    for(uint32_t k = 0; next < n || k == order[0] || k == order[1]; k++)
+    {
+        if(k == order[0])
+        {
+            d->group_idx[0] = idx;
+            idx *= table->has_pawns ? (uint64_t)_syzygy_lead_pawns_size[d->group_len[0]][file] :
+                   table->has_unique_pieces ? 31332 : 462;
+        }
+        else if(k == order[1])
+        {
+            d->group_idx[1] = idx;
+            idx *= (uint64_t)_syzygy_binomial[d->group_len[1]][48 - d->group_len[0]];
+        }
+        else
+        {
+            d->group_idx[next] = idx;
+            idx *= (uint64_t)_syzygy_binomial[d->group_len[next]][free_squares];
+            free_squares -= d->group_len[next++];
+        }
+    }
+
+    d->group_idx[n] = idx;
+}
+
+CCHESS_FORCE_INLINE uint32_t syzygy_btree_left(const SyzygyPairs* d, const uint32_t sym)
+{
+    const uint8_t* lr = d->btree + sym * 3;
+
+    return (((uint32_t)lr[1] & 0xF) << 8) | (uint32_t)lr[0];
+}
+
+CCHESS_FORCE_INLINE uint32_t syzygy_btree_right(const SyzygyPairs* d, const uint32_t sym)
+{
+    const uint8_t* lr = d->btree + sym * 3;
+
+    return ((uint32_t)lr[2] << 4) | ((uint32_t)lr[1] >> 4);
+}
+
+/* Number of values minus one a symbol expands to, the symbols without right child being values */
+static uint8_t syzygy_set_symlen(SyzygyPairs* d, const uint32_t sym, uint8_t* visited)
+{
+    visited[sym] = 1;
+
+    const uint32_t right = syzygy_btree_right(d, sym);
+
+    if(right == 0xFFF)
+    {
+        return 0;
+    }
+
+    const uint32_t left = syzygy_btree_left(d, sym);
+
+    if(left >= d->num_syms || right >= d->num_syms)
+    {
+        return 0;
+    }
+
+    if(!visited[left])
+    {
+        d->symlen[left] = syzygy_set_symlen(d, left, visited);
+    }
+
+    if(!visited[right])
+    {
+        d->symlen[right] = syzygy_set_symlen(d, right, visited);
+    }
+
+    return (uint8_t)(d->symlen[left] + d->symlen[right] + 1);
+}
+
+/* Reads a pairs header, returns NULL if the file is corrupted */
+static const uint8_t* syzygy_set_sizes(SyzygyPairs* d, const uint8_t* data, const uint8_t* end)
+{
+    if(data + 2 > end)
+    {
+        return NULL;
+    }
+
+    d->flags = *data++;
+
+    if(d->flags & SYZYGY_FLAG_SINGLE_VALUE)
+    {
+        d->min_sym_len = *data++;
+        return data;
+    }
+
+    if(data + 10 > end)
+    {
+        return NULL;
+    }
+
+    uint32_t num_groups = 0;
+
+    while(d->group_len[num_groups] != 0)
+    {
+        num_groups++;
+    }
+
+    const uint64_t table_size = d->group_idx[num_groups];
+
+    d->block_size = 1ULL << (data[0] & 63);
+    d->span = 1ULL << (data[1] & 63);
+    d->sparse_index_size = (table_size + d->span - 1) / d->span;
+
+    const uint32_t padding = data[2];
+
+    d->num_blocks = syzygy_read_u32(data + 3);
+    d->block_length_size = (uint64_t)d->num_blocks + padding;
+    d->max_sym_len = data[7];
+    d->min_sym_len = data[8];
+
+    data += 9;
+
+    if(d->min_sym_len == 0 || d->max_sym_len < d->min_sym_len || d->max_sym_len - d->min_sym_len >= 63)
+    {
+        return NULL;
+    }
+
+    const uint32_t base64_size = d->max_sym_len - d->min_sym_len + 1;
+
+    d->lowest_sym = data;
+
+    if(data + base64_size * 2 + 2 > end)
+    {
+        return NULL;
+    }
+
+    d->base64 = (uint64_t*)calloc(base64_size, sizeof(uint64_t));
+
+    /*
+        Canonical code: longer codes have lower values, so base64 decreases
+        with the code length. Codes are then left aligned on 64 bits, a code
+        of length l right-padded to 64 bits lies in [base64[l], base64[l - 1])
+    */
+    for(int32_t i = (int32_t)base64_size - 2; i >= 0; i--)
+    {
+        d->base64[i] = (d->base64[i + 1] + syzygy_read_u16(d->lowest_sym + i * 2) -
+                        syzygy_read_u16(d->lowest_sym + (i + 1) * 2)) / 2;
+    }
+
+    for(uint32_t i = 0; i < base64_size; i++)
+    {
+        d->base64[i] <<= 64 - i - d->min_sym_len;
+    }
+
+    data += base64_size * 2;
+
+    d->num_syms = syzygy_read_u16(data);
+    data += 2;
+
+    d->btree = data;
+
+    if(d->num_syms == 0 || data + d->num_syms * 3 > end)
+    {
+        return NULL;
+    }
+
+    d->symlen = (uint8_t*)calloc(d->num_syms, sizeof(uint8_t));
+    uint8_t* visited = (uint8_t*)calloc(d->num_syms, sizeof(uint8_t));
+
+    for(uint32_t sym = 0; sym < d->num_syms; sym++)
+    {
+        if(!visited[sym])
+        {
+            d->symlen[sym] = syzygy_set_symlen(d, sym, visited);
+        }
+    }
+
+    free(visited);
+
+    return data + d->num_syms * 3 + (d->num_syms & 1);
+}
+
+/* The DTZ values are remapped by decreasing frequency for each of the four results */
+static const uint8_t* syzygy_set_dtz_map(SyzygyFile* file, const uint8_t* data, const uint8_t* end, const uint32_t max_file)
+{
+    file->map = data;
+
+    for(uint32_t f = 0; f <= max_file; f++)
+    {
+        SyzygyPairs* d = &file->pairs[0][f];
+
+        if((d->flags & SYZYGY_FLAG_MAPPED) == 0)
+        {
+            continue;
+        }
+
+        if(d->flags & SYZYGY_FLAG_WIDE)
+        {
+            data += (uintptr_t)data & 1;
+
+            for(uint32_t i = 0; i < 4; i++)
+            {
+                if(data + 2 > end)
+                {
+                    return NULL;
+                }
+
+                d->map_idx[i] = (uint16_t)((data - file->map) / 2 + 1);
+                data += 2 * syzygy_read_u16(data) + 2;
+            }
+        }
+        else
+        {
+            for(uint32_t i = 0; i < 4; i++)
+            {
+                if(data + 1 > end)
+                {
+                    return NULL;
+                }
+
+                d->map_idx[i] = (uint16_t)(data - file->map + 1);
+                data += *data + 1;
+            }
+        }
+    }
+
+    return data + ((uintptr_t)data & 1);
+}
+
+/* Decodes the headers of a freshly mapped file, data pointing after the magic */
+static bool syzygy_setup_file(const SyzygyTable* table, SyzygyFile* file, const uint32_t type, const uint8_t* data, const uint8_t* end)
+{
+    const uint8_t file_flags = *data++;
+
+    if(((file_flags & SYZYGY_FILE_HAS_PAWNS) != 0) != table->has_pawns)
+    {
+        return false;
+    }
+
+    const uint32_t num_sides = type == SYZYGY_WDL && table->key != table->key2 ? 2 : 1;
+    const uint32_t max_file = table->has_pawns ? 3 : 0;
+    const bool pawns_on_both_sides = table->has_pawns && table->pawn_count[1] > 0;
+
+    for(uint32_t f = 0; f <= max_file; f++)
+    {
+        if(data + 1 + pawns_on_both_sides + table->num_pieces > end)
+        {
+            return false;
+        }
+
+        const uint32_t order[2][2] = {
+            { data[0] & 0xF, pawns_on_both_sides ? data[1] & 0xFU : 0xFU },
+            { data[0] >> 4, pawns_on_both_sides ? (uint32_t)data[1] >> 4 : 0xFU },
+        };
+
+        data += 1 + pawns_on_both_sides;
+
+        for(uint32_t k = 0; k < table->num_pieces; k++, data++)
+        {
+            for(uint32_t i = 0; i < num_sides; i++)
+            {
+                file->pairs[i][f].pieces[k] = (uint8_t)(i ? *data >> 4 : *data & 0xF);
+            }
+        }
+
+        for(uint32_t i = 0; i < num_sides; i++)
+        {
+            syzygy_set_groups(table, &file->pairs[i][f], order[i], f);
+        }
+    }
+
+    data += (uintptr_t)data & 1;
+
+    for(uint32_t f = 0; f <= max_file; f++)
+    {
+        for(uint32_t i = 0; i < num_sides; i++)
+        {
+            if((data = syzygy_set_sizes(&file->pairs[i][f], data, end)) == NULL)
+            {
+                return false;
+            }
+        }
+    }
+
+    if(type == SYZYGY_DTZ && (data = syzygy_set_dtz_map(file, data, end, max_file)) == NULL)
+    {
+        return false;
+    }
+
+    for(uint32_t f = 0; f <= max_file; f++)
+    {
+        for(uint32_t i = 0; i < num_sides; i++)
+        {
+            file->pairs[i][f].sparse_index = data;
+            data += file->pairs[i][f].sparse_index_size * 6;
+        }
+    }
+
+    for(uint32_t f = 0; f <= max_file; f++)
+    {
+        for(uint32_t i = 0; i < num_sides; i++)
+        {
+            file->pairs[i][f].block_length = data;
+            data += file->pairs[i][f].block_length_size * 2;
+        }
+    }
+
+    if(data > end)
+    {
+        return false;
+    }
+
+    /* Compressed blocks are aligned on 64 bytes, the mapping itself being page aligned */
+    for(uint32_t f = 0; f <= max_file; f++)
+    {
+        for(uint32_t i = 0; i < num_sides; i++)
+        {
+            SyzygyPairs* d = &file->pairs[i][f];
+
+            if(d->num_blocks == 0)
+            {
+                continue;
+            }
+
+            data = (const uint8_t*)(((uintptr_t)data + 0x3F) & ~(uintptr_t)0x3F);
+            d->data = data;
+            data += (uint64_t)d->num_blocks * d->block_size;
+
+            if(data > end)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool syzygy_map_file(SyzygyTable* table, const uint32_t type)
+{
+    SyzygyFile* file = &table->files[type];
+
+    char path[SYZYGY_MAX_PATH_SIZE];
+    snprintf(path,
+             SYZYGY_MAX_PATH_SIZE,
+             "%s/%s%s",
+             _syzygy_directories[table->directory],
+             table->name,
+             type == SYZYGY_WDL ? ".rtbw" : ".rtbz");
+
+    if(!platform_map_file(&file->mapping, path, FileMappingAccess_Random))
+    {
+        return false;
+    }
+
+    const uint8_t* data = (const uint8_t*)file->mapping.data;
+    const uint8_t* end = data + file->mapping.size;
+    const uint8_t* magic = type == SYZYGY_WDL ? _syzygy_wdl_magic : _syzygy_dtz_magic;
+
+    if(file->mapping.size < 6 ||
+       memcmp(data, magic, 4) != 0 ||
+       !syzygy_setup_file(table, file, type, data + 4, end))
+    {
+        syzygy_release_file(file);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+    Maps and sets up the file at first access. The thread winning the
+    transition from unmapped to mapping does the work, the others wait for
+    the final state. Once set up, this is a single acquire load
+*/
+static bool syzygy_file_ready(SyzygyTable* table, const uint32_t type)
+{
+    SyzygyFile* file = &table->files[type];
+
+    uint32_t state = platform_atomic_load_u32(&file->state);
+
+    if(state == SyzygyFileState_Ready)
+    {
+        return true;
+    }
+
+    if(state == SyzygyFileState_Unmapped &&
+       platform_atomic_cas_u32(&file->state, SyzygyFileState_Unmapped, SyzygyFileState_Mapping))
+    {
+        const bool mapped = syzygy_map_file(table, type);
+
+        platform_atomic_store_u32(&file->state, mapped ? SyzygyFileState_Ready : SyzygyFileState_Missing);
+
+        return mapped;
+    }
+
+    while((state = platform_atomic_load_u32(&file->state)) == SyzygyFileState_Mapping)
+    {
+        platform_yield_thread();
+    }
+
+    return state == SyzygyFileState_Ready;
+}
+
+/* Probing */
+
+/* Value of the idx-th position of the table */
+static int32_t syzygy_decompress_pairs(const SyzygyPairs* d, const uint64_t idx)
+{
+    if(d->flags & SYZYGY_FLAG_SINGLE_VALUE)
+    {
+        return d->min_sym_len;
+    }
+
+    /*
+        The sparse index entry k gives the block and the offset in the block
+        of the value k * span + span / 2, the blocks lengths are then walked
+        to the block holding idx
+    */
+    const uint64_t k = idx / d->span;
+
+    uint32_t block = syzygy_read_u32(d->sparse_index + k * 6);
+    int64_t offset = (int64_t)syzygy_read_u16(d->sparse_index + k * 6 + 4);
+
+    offset += (int64_t)(idx % d->span) - (int64_t)(d->span / 2);
+
+    while(offset < 0)
+    {
+        offset += (int64_t)syzygy_read_u16(d->block_length + (--block) * 2) + 1;
+    }
+
+    while(offset > (int64_t)syzygy_read_u16(d->block_length + block * 2))
+    {
+        offset -= (int64_t)syzygy_read_u16(d->block_length + (block++) * 2) + 1;
+    }
+
+    const uint8_t* ptr = d->data + (uint64_t)block * d->block_size;
+
+    uint64_t buf64 = ((uint64_t)syzygy_read_u32_be(ptr) << 32) | (uint64_t)syzygy_read_u32_be(ptr + 4);
+    int32_t buf64_size = 64;
+
+    ptr += 8;
+
+    uint32_t sym;
+
+    /* Decodes the symbols of the block until the one expanding to the value at offset */
+    while(true)
+    {
+        uint32_t len = 0;
+
+        while(buf64 < d->base64[len])
+        {
+            len++;
+        }
+
+        sym = (uint32_t)((buf64 - d->base64[len]) >> (64 - len - d->min_sym_len));
+        sym = (sym + syzygy_read_u16(d->lowest_sym + len * 2)) & 0xFFFF;
+
+        if(offset < (int64_t)d->symlen[sym] + 1)
+        {
+            break;
+        }
+
+        offset -= (int64_t)d->symlen[sym] + 1;
+        len += d->min_sym_len;
+        buf64 <<= len;
+        buf64_size -= (int32_t)len;
+
+        if(buf64_size <= 32)
+        {
+            buf64_size += 32;
+            buf64 |= (uint64_t)syzygy_read_u32_be(ptr) << (64 - buf64_size);
+            ptr += 4;
+        }
+    }
+
+    /* Expands the pairs down to the value, children being adjacent runs */
+    while(d->symlen[sym] != 0)
+    {
+        const uint32_t left = syzygy_btree_left(d, sym);
+
+        if(offset < (int64_t)d->symlen[left] + 1)
+        {
+            sym = left;
+        }
+        else
+        {
+            offset -= (int64_t)d->symlen[left] + 1;
+            sym = syzygy_btree_right(d, sym);
+        }
+    }
+
+    return (int32_t)syzygy_btree_left(d, sym);
+}
+
+/* Converts a stored DTZ value to plies */
+static int32_t syzygy_map_dtz(const SyzygyFile* file, const uint32_t tb_file, int32_t value, const int32_t wdl)
+{
+    static const int32_t wdl_map[5] = { 1, 3, 0, 2, 0 };
+
+    const SyzygyPairs* d = &file->pairs[0][tb_file];
+    const uint8_t flags = d->flags;
+
+    if(flags & SYZYGY_FLAG_MAPPED)
+    {
+        const uint32_t index = (uint32_t)d->map_idx[wdl_map[wdl + 2]] + (uint32_t)value;
+
+        value = (flags & SYZYGY_FLAG_WIDE) ? (int32_t)syzygy_read_u16(file->map + index * 2) :
+                                             (int32_t)file->map[index];
+    }
+
+    if((wdl == SyzygyWdl_Win && !(flags & SYZYGY_FLAG_WIN_PLIES)) ||
+       (wdl == SyzygyWdl_Loss && !(flags & SYZYGY_FLAG_LOSS_PLIES)) ||
+       wdl == SyzygyWdl_CursedWin ||
+       wdl == SyzygyWdl_BlessedLoss)
+    {
+        value *= 2;
+    }
+
+    return value + 1;
+}
+
+/* Syzygy piece code of the piece on square: piece + 1, plus 8 for black */
+CCHESS_FORCE_INLINE uint32_t syzygy_piece_code(Board* board, const uint32_t square)
+{
+    const uint32_t side = (uint32_t)(board->sides[PIECE_BLACK] >> square) & 1;
+
+    return (board_get_piece_on(board, square, side) + 1) | (side << 3);
+}
+
+/*
+    Computes the index of the position in the table and decodes its value.
+    Tables are stored with the first side of their name as white, positions
+    with the colors reversed are mirrored vertically with the colors swapped.
+    The leading piece is then brought to the a1-d1-d4 triangle (the a-d
+    files for pawns) by symmetry, and the groups of pieces are encoded
+*/
+static int32_t syzygy_probe_index(Board* board,
+                                  SyzygyTable* table,
+                                  const uint32_t type,
+                                  const int32_t wdl,
+                                  SyzygyProbe* result)
+{
+    uint32_t squares[SYZYGY_MAX_PIECES];
+    uint32_t pieces[SYZYGY_MAX_PIECES];
+    uint32_t size = 0;
+    uint32_t lead_pawns_count = 0;
+    uint32_t tb_file = 0;
+    uint64_t lead_pawns = 0ULL;
+    uint64_t idx;
+
+    SyzygyFile* file = &table->files[type];
+
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    /* Symmetric materials only store white to play */
+    const bool symmetric_black_to_play = table->key == table->key2 && side == PIECE_BLACK;
+    const bool black_stronger = syzygy_material_key(board) != table->key;
+    const uint32_t flip = symmetric_black_to_play || black_stronger;
+    const uint32_t flip_color = flip * 8;
+    const uint32_t flip_squares = flip * 56;
+    const uint32_t stm = flip ^ side;
+
+    if(table->has_pawns)
+    {
+        /* Pawns come first in the encoding, with the color of the leading side */
+        const uint32_t pawn_code = file->pairs[0][0].pieces[0] ^ flip_color;
+
+        uint64_t b = lead_pawns = board_get_pawns(board, pawn_code >> 3);
+
+        while(b)
+        {
+            squares[size++] = (uint32_t)ctz_u64(b) ^ flip_squares;
+            b = clsb_u64(b);
+        }
+
+        lead_pawns_count = size;
+
+        uint32_t lead = 0;
+
+        for(uint32_t i = 1; i < lead_pawns_count; i++)
+        {
+            lead = _syzygy_map_pawns[squares[i]] > _syzygy_map_pawns[squares[lead]] ? i : lead;
+        }
+
+        const uint32_t tmp = squares[0];
+        squares[0] = squares[lead];
+        squares[lead] = tmp;
+
+        const uint32_t lead_file = BOARD_FILE_FROM_POS(squares[0]);
+        tb_file = lead_file < 4 ? lead_file : 7 - lead_file;
+    }
+
+    const SyzygyPairs* d = &file->pairs[type == SYZYGY_WDL ? stm : 0][tb_file];
+
+    /* DTZ tables store one side to play only */
+    if(type == SYZYGY_DTZ &&
+       (d->flags & SYZYGY_FLAG_STM) != stm &&
+       !(table->key == table->key2 && !table->has_pawns))
+    {
+        *result = SyzygyProbe_ChangeStm;
+        return 0;
+    }
+
+    uint64_t b = board_get_all(board) ^ lead_pawns;
+
+    while(b)
+    {
+        const uint32_t square = (uint32_t)ctz_u64(b);
+
+        squares[size] = square ^ flip_squares;
+        pieces[size++] = syzygy_piece_code(board, square) ^ flip_color;
+
+        b = clsb_u64(b);
+    }
+
+    /* Same pieces order as the table */
+    for(uint32_t i = lead_pawns_count; i + 1 < size; i++)
+    {
+        for(uint32_t j = i + 1; j < size; j++)
+        {
+            if(d->pieces[i] == pieces[j])
+            {
+                uint32_t tmp = pieces[i];
+                pieces[i] = pieces[j];
+                pieces[j] = tmp;
+
+                tmp = squares[i];
+                squares[i] = squares[j];
+                squares[j] = tmp;
+
+                break;
+            }
+        }
+    }
+
+    if(BOARD_FILE_FROM_POS(squares[0]) > 3)
+    {
+        for(uint32_t i = 0; i < size; i++)
+        {
+            squares[i] ^= 7;
+        }
+    }
+
+    if(table->has_pawns)
+    {
+        idx = (uint64_t)_syzygy_lead_pawn_idx[lead_pawns_count][squares[0]];
+
+        /* The other leading pawns by increasing pawn square value */
+        for(uint32_t i = 2; i < lead_pawns_count; i++)
+        {
+            for(uint32_t j = i; j > 1 && _syzygy_map_pawns[squares[j - 1]] > _syzygy_map_pawns[squares[j]]; j--)
+            {
+                const uint32_t tmp = squares[j];
+                squares[j] = squares[j - 1];
+                squares[j - 1] = tmp;
+            }
+        }
+
+        for(uint32_t i = 1; i < lead_pawns_count; i++)
+        {
+            idx += (uint64_t)_syzygy_binomial[i][_syzygy_map_pawns[squares[i]]];
+        }
+    }
+    else
+    {
+        if(BOARD_RANK_FROM_POS(squares[0]) > 3)
+        {
+            for(uint32_t i = 0; i < size; i++)
+            {
+                squares[i] ^= 56;
+            }
+        }
+
+        /* The first leading piece off the a1-h8 diagonal is brought below it */
+        for(uint32_t i = 0; i < d->group_len[0]; i++)
+        {
+            const int32_t off = syzygy_off_a1h8(squares[i]);
+
+            if(off == 0)
+            {
+                continue;
+            }
+
+            if(off > 0)
+            {
+                for(uint32_t j = i; j < size; j++)
+                {
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+
+            break;
+        }
+
+        if(table->has_unique_pieces)
+        {
+            const uint64_t adjust1 = squares[1] > squares[0];
+            const uint64_t adjust2 = (uint64_t)(squares[2] > squares[0]) + (uint64_t)(squares[2] > squares[1]);
+
+            if(syzygy_off_a1h8(squares[0]))
+            {
+                idx = ((uint64_t)_syzygy_map_a1d1d4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 +
+                      squares[2] - adjust2;
+            }
+            else if(syzygy_off_a1h8(squares[1]))
+            {
+                idx = (6 * 63 + (uint64_t)BOARD_RANK_FROM_POS(squares[0]) * 28 + (uint64_t)_syzygy_map_b1h1h7[squares[1]]) * 62 +
+                      squares[2] - adjust2;
+            }
+            else if(syzygy_off_a1h8(squares[2]))
+            {
+                idx = 6 * 63 * 62 + 4 * 28 * 62 +
+                      (uint64_t)BOARD_RANK_FROM_POS(squares[0]) * 7 * 28 +
+                      ((uint64_t)BOARD_RANK_FROM_POS(squares[1]) - adjust1) * 28 +
+                      (uint64_t)_syzygy_map_b1h1h7[squares[2]];
+            }
+            else
+            {
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 +
+                      (uint64_t)BOARD_RANK_FROM_POS(squares[0]) * 7 * 6 +
+                      ((uint64_t)BOARD_RANK_FROM_POS(squares[1]) - adjust1) * 6 +
+                      ((uint64_t)BOARD_RANK_FROM_POS(squares[2]) - adjust2);
+            }
+        }
+        else
+        {
+            idx = (uint64_t)_syzygy_map_kk[_syzygy_map_a1d1d4[squares[0]]][squares[1]];
+        }
+    }
+
+    idx *= d->group_idx[0];
+
+    uint32_t group_start = d->group_len[0];
+    bool remaining_pawns = table->has_pawns && table->pawn_count[1] > 0;
+
+    /* Other groups, squares going down by the number of squares taken by the previous groups */
+    for(uint32_t next = 1; d->group_len[next] != 0; next++)
+    {
+        const uint32_t group_len = d->group_len[next];
+
+        for(uint32_t i = group_start + 1; i < group_start + group_len; i++)
+        {
+            for(uint32_t j = i; j > group_start && squares[j - 1] > squares[j]; j--)
+            {
+                const uint32_t tmp = squares[j];
+                squares[j] = squares[j - 1];
+                squares[j - 1] = tmp;
+            }
+        }
+
+        uint64_t n = 0;
+
+        for(uint32_t i = 0; i < group_len; i++)
+        {
+            const uint32_t square = squares[group_start + i];
+
+            uint32_t adjust = 0;
+
+            for(uint32_t j = 0; j < group_start; j++)
+            {
+                adjust += square > squares[j];
+            }
+
+            n += (uint64_t)_syzygy_binomial[i + 1][square - adjust - 8 * remaining_pawns];
+        }
+
+        remaining_pawns = false;
+        idx += n * d->group_idx[next];
+        group_start += group_len;
+    }
+
+    const int32_t value = syzygy_decompress_pairs(d, idx);
+
+    return type == SYZYGY_WDL ? value - 2 : syzygy_map_dtz(file, tb_file, value, wdl);
+}
+
+static int32_t syzygy_probe_table(Board* board, const uint32_t type, const int32_t wdl, SyzygyProbe* result)
+{
+    /* King versus king */
+    if(clsb_u64(clsb_u64(board_get_all(board))) == 0ULL)
+    {
+        return SyzygyWdl_Draw;
+    }
+
+    SyzygyTable* table = syzygy_find_table(syzygy_material_key(board));
+
+    if(table == NULL || !syzygy_file_ready(table, type))
+    {
+        *result = SyzygyProbe_Fail;
+        return 0;
+    }
+
+    return syzygy_probe_index(board, table, type, wdl, result);
+}
+
+CCHESS_FORCE_INLINE int32_t syzygy_dtz_before_zeroing(const int32_t wdl)
+{
+    return wdl == SyzygyWdl_Win ? 1 :
+           wdl == SyzygyWdl_CursedWin ? 101 :
+           wdl == SyzygyWdl_BlessedLoss ? -101 :
+           wdl == SyzygyWdl_Loss ? -1 : 0;
+}
+
+/*
+    The tables store "don't care" values for positions with a winning
+    capture, and may store a loss for positions with a drawing capture, so
+    the captures (and the pawn moves for DTZ, that are not stored either)
+    are searched and the best of their values and of the table value is the
+    value of the position
+*/
+static int32_t syzygy_search(Board* board, SyzygyProbe* result, const bool check_zeroing_moves)
+{
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    int32_t best_value = SyzygyWdl_Loss;
+    size_t num_searched = 0;
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        const bool is_pawn_move = (board_get_pawns(board, side) & BIT64(MOVE_GET_FROM_SQUARE(moves[i]))) != 0ULL;
+
+        if(!MOVE_GET_IS_CAPTURING(moves[i]) && (!check_zeroing_moves || !is_pawn_move))
+        {
+            continue;
+        }
+
+        num_searched++;
+
+        Board after = *board;
+        board_make_move(&after, moves[i]);
+
+        const int32_t value = -syzygy_search(&after, result, false);
+
+        if(*result == SyzygyProbe_Fail)
+        {
+            return SyzygyWdl_Draw;
+        }
+
+        if(value > best_value)
+        {
+            best_value = value;
+
+            if(value >= SyzygyWdl_Win)
+            {
+                *result = SyzygyProbe_ZeroingBestMove;
+                return value;
+            }
+        }
+    }
+
+    /* All the moves were searched: the table value may be wrong, en passant positions are not stored for instance */
+    const bool no_more_moves = num_searched > 0 && num_searched == num_moves;
+
+    int32_t value;
+
+    if(no_more_moves)
+    {
+        value = best_value;
+    }
+    else
+    {
+        value = syzygy_probe_table(board, SYZYGY_WDL, SyzygyWdl_Draw, result);
+
+        if(*result == SyzygyProbe_Fail)
+        {
+            return SyzygyWdl_Draw;
+        }
+    }
+
+    if(best_value >= value)
+    {
+        *result = best_value > SyzygyWdl_Draw || no_more_moves ? SyzygyProbe_ZeroingBestMove : SyzygyProbe_Ok;
+        return best_value;
+    }
+
+    *result = SyzygyProbe_Ok;
+
+    return value;
+}
+
+static bool syzygy_can_probe(Board* board)
+{
+    return (board->state & BOARD_STATE_CASTLE_MASK) == 0 &&
+           (uint32_t)popcount_u64(board_get_all(board)) <= _syzygy_max_pieces;
+}
+
+bool syzygy_probe_wdl(Board* board, SyzygyWdl* wdl)
+{
+    if(!syzygy_can_probe(board))
+    {
+        return false;
+    }
+
+    SyzygyProbe result = SyzygyProbe_Ok;
+
+    const int32_t value = syzygy_search(board, &result, false);
+
+    if(result == SyzygyProbe_Fail)
+    {
+        return false;
+    }
+
+    *wdl = (SyzygyWdl)value;
+
+    return true;
+}
+
+static int32_t syzygy_probe_dtz_recurse(Board* board, SyzygyProbe* result)
+{
+    const int32_t wdl = syzygy_search(board, result, true);
+
+    /* DTZ tables do not store draws */
+    if(*result == SyzygyProbe_Fail || wdl == SyzygyWdl_Draw)
+    {
+        return 0;
+    }
+
+    if(*result == SyzygyProbe_ZeroingBestMove)
+    {
+        return syzygy_dtz_before_zeroing(wdl);
+    }
+
+    int32_t dtz = syzygy_probe_table(board, SYZYGY_DTZ, wdl, result);
+
+    if(*result == SyzygyProbe_Fail)
+    {
+        return 0;
+    }
+
+    if(*result != SyzygyProbe_ChangeStm)
+    {
+        return (dtz + 100 * (wdl == SyzygyWdl_BlessedLoss || wdl == SyzygyWdl_CursedWin)) * syzygy_sign(wdl);
+    }
+
+    /* The table stores the other side to play, the best move is found by a one ply search */
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(board);
+
+    int32_t min_dtz = 0xFFFF;
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        const bool zeroing = MOVE_GET_IS_CAPTURING(moves[i]) ||
+                             (board_get_pawns(board, side) & BIT64(MOVE_GET_FROM_SQUARE(moves[i]))) != 0ULL;
+
+        Board after = *board;
+        board_make_move(&after, moves[i]);
+
+        /* Zeroing moves take the distance of the move before them, from the result of the position reached */
+        dtz = zeroing ? -syzygy_dtz_before_zeroing(syzygy_search(&after, result, false)) :
+                        -syzygy_probe_dtz_recurse(&after, result);
+
+        if(dtz == 1 && board_has_mate(&after))
+        {
+            min_dtz = 1;
+        }
+
+        if(!zeroing)
+        {
+            dtz += syzygy_sign(dtz);
+        }
+
+        if(dtz < min_dtz && syzygy_sign(dtz) == syzygy_sign(wdl))
+        {
+            min_dtz = dtz;
+        }
+
+        if(*result == SyzygyProbe_Fail)
+        {
+            return 0;
+        }
+    }
+
+    /* No legal move, the side to play is mated */
+    return min_dtz == 0xFFFF ? -1 : min_dtz;
+}
+
+bool syzygy_probe_dtz(Board* board, int32_t* dtz)
+{
+    if(!syzygy_can_probe(board))
+    {
+        return false;
+    }
+
+    SyzygyProbe result = SyzygyProbe_Ok;
+
+    const int32_t value = syzygy_probe_dtz_recurse(board, &result);
+
+    if(result == SyzygyProbe_Fail)
+    {
+        return false;
+    }
+
+    *dtz = value;
+
+    return true;
+}
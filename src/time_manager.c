@@ -0,0 +1,149 @@
+#include "cchess/time_manager.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Moves to go are capped, the last ones of a long control being played with the increments */
+#define TIME_MANAGER_MAX_MOVES_TO_GO 50
+
+/* Optimum the maximum can grow to, and share of the usable time it can take */
+#define TIME_MANAGER_MAX_RATIO 5
+#define TIME_MANAGER_MAX_USABLE_PERCENT 80
+
+/* An iteration takes about as long as all the previous ones: starting one past this share of the target likely overruns it */
+#define TIME_MANAGER_NEXT_ITERATION_PERCENT 60
+
+/* Scaling of the optimum by the number of iterations since the best move changed, in percent */
+#define TIME_MANAGER_STABILITY_STEPS 5
+
+static const uint32_t _time_manager_stability_percents[TIME_MANAGER_STABILITY_STEPS] = { 140, 110, 95, 85, 75 };
+
+/* A score dropping by this many centipawns doubles the optimum, smaller drops extend it in proportion */
+#define TIME_MANAGER_SCORE_DROP_MAX 50
+
+/* Iterations before the scaling applies, the shallow ones being too unstable */
+#define TIME_MANAGER_MIN_DEPTH 4
+
+void time_manager_init(TimeManager* manager, const TimeControl* control)
+{
+    memset(manager, 0, sizeof(TimeManager));
+
+    const uint64_t overhead_ns = control->overhead_ns > 0 ? control->overhead_ns : TIME_MANAGER_DEFAULT_OVERHEAD_NS;
+
+    if(control->move_time_ns > 0)
+    {
+        const uint64_t move_time_ns = control->move_time_ns > overhead_ns ? control->move_time_ns - overhead_ns :
+                                                                            control->move_time_ns / 2;
+
+        manager->optimum_ns = move_time_ns;
+        manager->maximum_ns = move_time_ns;
+        manager->target_ns = move_time_ns;
+
+        return;
+    }
+
+    /* Even with the clock almost out, a move is needed */
+    const uint64_t usable_ns = control->time_ns > 2 * overhead_ns ? control->time_ns - overhead_ns : control->time_ns / 2;
+
+    uint32_t moves_to_go = control->moves_to_go > 0 ? control->moves_to_go : TIME_MANAGER_DEFAULT_MOVES_TO_GO;
+    moves_to_go = moves_to_go < TIME_MANAGER_MAX_MOVES_TO_GO ? moves_to_go : TIME_MANAGER_MAX_MOVES_TO_GO;
+
+    uint64_t optimum_ns = usable_ns / moves_to_go + control->increment_ns * 3 / 4;
+
+    /* The last move before the control can use all the time left */
+    const uint64_t max_usable_ns = moves_to_go == 1 ? usable_ns : usable_ns * TIME_MANAGER_MAX_USABLE_PERCENT / 100;
+
+    uint64_t maximum_ns = optimum_ns * TIME_MANAGER_MAX_RATIO;
+    maximum_ns = maximum_ns < max_usable_ns ? maximum_ns : max_usable_ns;
+    optimum_ns = optimum_ns < maximum_ns ? optimum_ns : maximum_ns;
+
+    manager->optimum_ns = optimum_ns;
+    manager->maximum_ns = maximum_ns;
+    manager->target_ns = optimum_ns;
+}
+
+bool time_manager_iteration_done(TimeManager* manager,
+                                 const uint32_t depth,
+                                 const Move best_move,
+                                 const int32_t score,
+                                 const uint64_t elapsed_ns)
+{
+    if(manager->has_iteration && move_equal(best_move, manager->best_move))
+    {
+        manager->stability++;
+    }
+    else
+    {
+        manager->stability = 0;
+    }
+
+    const int32_t score_drop = manager->has_iteration ? manager->score - score : 0;
+
+    manager->best_move = best_move;
+    manager->score = score;
+    manager->has_iteration = true;
+
+    if(depth >= TIME_MANAGER_MIN_DEPTH)
+    {
+        const uint32_t stability = manager->stability < TIME_MANAGER_STABILITY_STEPS ? manager->stability :
+                                                                                      TIME_MANAGER_STABILITY_STEPS - 1;
+
+        const int32_t clamped_drop = score_drop < 0 ? 0 : (score_drop > TIME_MANAGER_SCORE_DROP_MAX ? TIME_MANAGER_SCORE_DROP_MAX : score_drop);
+        const uint64_t score_percent = 100 + (uint64_t)clamped_drop * 100 / TIME_MANAGER_SCORE_DROP_MAX;
+
+        const uint64_t target_ns = manager->optimum_ns * _time_manager_stability_percents[stability] / 100 * score_percent / 100;
+
+        manager->target_ns = target_ns < manager->maximum_ns ? target_ns : manager->maximum_ns;
+    }
+
+    return elapsed_ns >= manager->target_ns * TIME_MANAGER_NEXT_ITERATION_PERCENT / 100;
+}
+
+void time_stats_reset(TimeStats* stats)
+{
+    memset(stats, 0, sizeof(TimeStats));
+}
+
+void time_stats_add(TimeStats* stats, const uint64_t elapsed_ns, const uint64_t limit_ns)
+{
+    const int64_t overshoot_ns = (int64_t)elapsed_ns - (int64_t)limit_ns;
+
+    stats->overshoots_ns[stats->next] = overshoot_ns;
+    stats->next = (stats->next + 1) % TIME_STATS_MAX_SAMPLES;
+    stats->num_samples += stats->num_samples < TIME_STATS_MAX_SAMPLES;
+
+    stats->max_overshoot_ns = stats->num_searches == 0 || overshoot_ns > stats->max_overshoot_ns ? overshoot_ns :
+                                                                                                    stats->max_overshoot_ns;
+    stats->num_searches++;
+    stats->num_overshoots += overshoot_ns > 0;
+}
+
+static int time_stats_compare(const void* a, const void* b)
+{
+    const int64_t x = *(const int64_t*)a;
+    const int64_t y = *(const int64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+int64_t time_stats_percentile(const TimeStats* stats, const double percentile)
+{
+    if(stats->num_samples == 0)
+    {
+        return 0;
+    }
+
+    int64_t sorted[TIME_STATS_MAX_SAMPLES];
+    memcpy(sorted, stats->overshoots_ns, stats->num_samples * sizeof(int64_t));
+    qsort(sorted, stats->num_samples, sizeof(int64_t), time_stats_compare);
+
+    /* Nearest rank, the smallest one covering the percentile */
+    const double rank = percentile / 100.0 * (double)stats->num_samples;
+
+    uint32_t index = rank > 0.0 ? (uint32_t)rank : 0;
+    index += (double)index < rank;
+    index = index > 0 ? index - 1 : 0;
+    index = index < stats->num_samples ? index : stats->num_samples - 1;
+
+    return sorted[index];
+}
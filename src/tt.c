@@ -0,0 +1,197 @@
+#include "cchess/tt.h"
+#include "cchess/platform.h"
+
+#include "libromano/bit.h"
+
+#include <string.h>
+
+/* Entry data: move, score, static eval, depth, bound and generation */
+#define TT_DATA_MOVE_SHIFT 0
+#define TT_DATA_SCORE_SHIFT 16
+#define TT_DATA_EVAL_SHIFT 32
+#define TT_DATA_DEPTH_SHIFT 48
+#define TT_DATA_BOUND_SHIFT 56
+#define TT_DATA_GENERATION_SHIFT 58
+
+#define TT_GENERATION_MASK 0x3F
+
+/* Depth an entry loses for each generation it is older than the current one */
+#define TT_AGE_WEIGHT 8
+
+#define TT_HASHFULL_SAMPLES 1000
+
+STATIC_ASSERT(sizeof(TTBucket) == 64);
+
+CCHESS_FORCE_INLINE uint32_t tt_data_bound(const uint64_t data)
+{
+    return (uint32_t)(data >> TT_DATA_BOUND_SHIFT) & 0x3;
+}
+
+CCHESS_FORCE_INLINE uint32_t tt_data_depth(const uint64_t data)
+{
+    return (uint32_t)(data >> TT_DATA_DEPTH_SHIFT) & 0xFF;
+}
+
+CCHESS_FORCE_INLINE uint32_t tt_data_generation(const uint64_t data)
+{
+    return (uint32_t)(data >> TT_DATA_GENERATION_SHIFT) & TT_GENERATION_MASK;
+}
+
+bool tt_init(TranspositionTable* tt, const size_t size_mb)
+{
+    memset(tt, 0, sizeof(TranspositionTable));
+
+    const uint64_t max_buckets = ((uint64_t)size_mb * 1024ULL * 1024ULL) / sizeof(TTBucket);
+
+    if(max_buckets == 0)
+    {
+        return false;
+    }
+
+    tt->num_buckets = 1ULL << (63 - clz_u64(max_buckets));
+    tt->size = (size_t)(tt->num_buckets * sizeof(TTBucket));
+    tt->buckets = (TTBucket*)platform_alloc_large(tt->size, &tt->huge_pages);
+
+    if(tt->buckets == NULL)
+    {
+        memset(tt, 0, sizeof(TranspositionTable));
+        return false;
+    }
+
+    return true;
+}
+
+void tt_release(TranspositionTable* tt)
+{
+    platform_free_large(tt->buckets, tt->size);
+    memset(tt, 0, sizeof(TranspositionTable));
+}
+
+void tt_clear(TranspositionTable* tt)
+{
+    /* 1MB chunks, the pages are touched by the thread that will likely use them most */
+    const size_t chunk_size = 1024 * 1024;
+    const int64_t num_chunks = (int64_t)((tt->size + chunk_size - 1) / chunk_size);
+
+#pragma omp parallel for
+    for(int64_t i = 0; i < num_chunks; i++)
+    {
+        const size_t offset = (size_t)i * chunk_size;
+        const size_t size = tt->size - offset < chunk_size ? tt->size - offset : chunk_size;
+
+        memset((char*)tt->buckets + offset, 0, size);
+    }
+
+    tt->generation = 0;
+}
+
+void tt_new_search(TranspositionTable* tt)
+{
+    tt->generation = (tt->generation + 1) & TT_GENERATION_MASK;
+}
+
+bool tt_probe(const TranspositionTable* tt, const uint64_t key, TTEntry* entry)
+{
+    const TTBucket* bucket = tt_get_bucket(tt, key);
+
+    for(uint32_t i = 0; i < TT_ENTRIES_PER_BUCKET; i++)
+    {
+        const uint64_t data = bucket->slots[i].data;
+
+        if((bucket->slots[i].key ^ data) != key || tt_data_bound(data) == TTBound_None)
+        {
+            continue;
+        }
+
+        entry->move = move_from_u16((uint16_t)(data >> TT_DATA_MOVE_SHIFT));
+        entry->score = (int16_t)(uint16_t)(data >> TT_DATA_SCORE_SHIFT);
+        entry->eval = (int16_t)(uint16_t)(data >> TT_DATA_EVAL_SHIFT);
+        entry->depth = (uint8_t)tt_data_depth(data);
+        entry->bound = (uint8_t)tt_data_bound(data);
+
+        return true;
+    }
+
+    return false;
+}
+
+void tt_store(TranspositionTable* tt,
+              const uint64_t key,
+              const Move move,
+              const int32_t score,
+              const int32_t eval,
+              const uint32_t depth,
+              const TTBound bound)
+{
+    TTBucket* bucket = tt_get_bucket(tt, key);
+    TTSlot* replaced = NULL;
+    int32_t lowest_worth = INT32_MAX;
+
+    uint64_t previous_move = 0;
+
+    for(uint32_t i = 0; i < TT_ENTRIES_PER_BUCKET; i++)
+    {
+        TTSlot* slot = &bucket->slots[i];
+        const uint64_t data = slot->data;
+
+        /* First empty slot, unless the position is found further */
+        if(tt_data_bound(data) == TTBound_None)
+        {
+            if(lowest_worth != INT32_MIN)
+            {
+                lowest_worth = INT32_MIN;
+                replaced = slot;
+            }
+
+            continue;
+        }
+
+        /* The same position is always overwritten, its move kept if the new entry has none */
+        if((slot->key ^ data) == key)
+        {
+            replaced = slot;
+            previous_move = data & 0xFFFF;
+            break;
+        }
+
+        const uint32_t age = (tt->generation - tt_data_generation(data)) & TT_GENERATION_MASK;
+        const int32_t worth = (int32_t)tt_data_depth(data) - (int32_t)(age * TT_AGE_WEIGHT);
+
+        if(worth < lowest_worth)
+        {
+            lowest_worth = worth;
+            replaced = slot;
+        }
+    }
+
+    const uint64_t move_bits = move_to_u16(move) != EMPTY_MOVE ? move_to_u16(move) : previous_move;
+
+    const uint64_t data = (move_bits << TT_DATA_MOVE_SHIFT) |
+                          ((uint64_t)(uint16_t)(int16_t)score << TT_DATA_SCORE_SHIFT) |
+                          ((uint64_t)(uint16_t)(int16_t)eval << TT_DATA_EVAL_SHIFT) |
+                          ((uint64_t)(depth & 0xFF) << TT_DATA_DEPTH_SHIFT) |
+                          ((uint64_t)bound << TT_DATA_BOUND_SHIFT) |
+                          ((uint64_t)tt->generation << TT_DATA_GENERATION_SHIFT);
+
+    replaced->data = data;
+    replaced->key = key ^ data;
+}
+
+uint32_t tt_hashfull(const TranspositionTable* tt)
+{
+    const uint64_t num_samples = tt->num_buckets < TT_HASHFULL_SAMPLES ? tt->num_buckets : TT_HASHFULL_SAMPLES;
+
+    uint64_t num_used = 0;
+
+    for(uint64_t i = 0; i < num_samples; i++)
+    {
+        for(uint32_t j = 0; j < TT_ENTRIES_PER_BUCKET; j++)
+        {
+            const uint64_t data = tt->buckets[i].slots[j].data;
+
+            num_used += tt_data_bound(data) != TTBound_None && tt_data_generation(data) == tt->generation;
+        }
+    }
+
+    return (uint32_t)(num_used * 1000 / (num_samples * TT_ENTRIES_PER_BUCKET));
+}
@@ -0,0 +1,189 @@
+#include "cchess/zobrist.h"
+
+#include "libromano/bit.h"
+
+#define ZOBRIST_SEED 0x9E3779B97F4A7C15ULL
+
+/* Holds the 3668 reversible moves with two slots per key */
+#define ZOBRIST_CUCKOO_SIZE 8192
+#define ZOBRIST_CUCKOO_MASK (ZOBRIST_CUCKOO_SIZE - 1)
+
+uint64_t zobrist_piece_keys[12][64];
+uint64_t zobrist_castling_keys[16];
+uint64_t zobrist_en_passant_keys[8];
+uint64_t zobrist_side_key;
+
+static uint64_t _zobrist_cuckoo_keys[ZOBRIST_CUCKOO_SIZE];
+/* Squares of the move, the first one in the low byte */
+static uint16_t _zobrist_cuckoo_squares[ZOBRIST_CUCKOO_SIZE];
+
+CCHESS_FORCE_INLINE uint64_t zobrist_splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+CCHESS_FORCE_INLINE uint32_t zobrist_cuckoo_hash_1(const uint64_t key)
+{
+    return (uint32_t)key & ZOBRIST_CUCKOO_MASK;
+}
+
+CCHESS_FORCE_INLINE uint32_t zobrist_cuckoo_hash_2(const uint64_t key)
+{
+    return (uint32_t)(key >> 16) & ZOBRIST_CUCKOO_MASK;
+}
+
+/* Needs the attack lookups of move.h */
+static void zobrist_init_cuckoo(void)
+{
+    memset(_zobrist_cuckoo_keys, 0, sizeof(_zobrist_cuckoo_keys));
+    memset(_zobrist_cuckoo_squares, 0, sizeof(_zobrist_cuckoo_squares));
+
+    uint32_t num_moves = 0;
+
+    for(uint32_t piece = Piece_Knight; piece <= Piece_King; piece++)
+    {
+        for(uint32_t side = 0; side < 2; side++)
+        {
+            for(uint32_t a = 0; a < 64; a++)
+            {
+                const uint64_t attacks = piece == Piece_Knight ? move_gen_knight_attacks(a) :
+                                         piece == Piece_Bishop ? move_gen_bishop_attacks(a, 0ULL) :
+                                         piece == Piece_Rook ? move_gen_rook_attacks(a, 0ULL) :
+                                         piece == Piece_Queen ? move_gen_queen_attacks(a, 0ULL) :
+                                                                move_gen_king_attacks(a);
+
+                /* Each pair of squares once */
+                uint64_t targets = attacks & ~((BIT64(a) << 1) - 1ULL);
+
+                while(targets)
+                {
+                    const uint32_t b = (uint32_t)ctz_u64(targets);
+                    targets = clsb_u64(targets);
+
+                    uint64_t key = zobrist_get_piece_key(piece, side, a) ^ zobrist_get_piece_key(piece, side, b) ^ zobrist_side_key;
+                    uint16_t squares = (uint16_t)(a | (b << 8));
+
+                    /* Evicts the entry of the slot to its other slot until one is empty */
+                    uint32_t slot = zobrist_cuckoo_hash_1(key);
+
+                    for(;;)
+                    {
+                        const uint64_t evicted_key = _zobrist_cuckoo_keys[slot];
+                        const uint16_t evicted_squares = _zobrist_cuckoo_squares[slot];
+
+                        _zobrist_cuckoo_keys[slot] = key;
+                        _zobrist_cuckoo_squares[slot] = squares;
+
+                        if(evicted_key == 0ULL)
+                        {
+                            break;
+                        }
+
+                        key = evicted_key;
+                        squares = evicted_squares;
+                        slot = slot == zobrist_cuckoo_hash_1(key) ? zobrist_cuckoo_hash_2(key) : zobrist_cuckoo_hash_1(key);
+                    }
+
+                    num_moves++;
+                }
+            }
+        }
+    }
+
+    CCHESS_ASSERT(num_moves == 3668);
+}
+
+void zobrist_init(void)
+{
+    uint64_t state = ZOBRIST_SEED;
+
+    for(uint32_t i = 0; i < 12; i++)
+    {
+        for(uint32_t j = 0; j < 64; j++)
+        {
+            zobrist_piece_keys[i][j] = zobrist_splitmix64(&state);
+        }
+    }
+
+    /* Castling keys are the xor of the keys of each right, so any combination hashes consistently */
+    uint64_t castling_rights[4];
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        castling_rights[i] = zobrist_splitmix64(&state);
+    }
+
+    for(uint32_t i = 0; i < 16; i++)
+    {
+        zobrist_castling_keys[i] = 0ULL;
+
+        for(uint32_t j = 0; j < 4; j++)
+        {
+            zobrist_castling_keys[i] ^= (i & (1U << j)) ? castling_rights[j] : 0ULL;
+        }
+    }
+
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        zobrist_en_passant_keys[i] = zobrist_splitmix64(&state);
+    }
+
+    zobrist_side_key = zobrist_splitmix64(&state);
+
+    zobrist_init_cuckoo();
+}
+
+uint64_t zobrist_hash_board(const Board* board)
+{
+    uint64_t hash = 0ULL;
+
+    for(uint32_t piece = 0; piece < 6; piece++)
+    {
+        for(uint32_t side = 0; side < 2; side++)
+        {
+            uint64_t pieces = board_get_pieces(board, piece, side);
+
+            while(pieces)
+            {
+                hash ^= zobrist_get_piece_key(piece, side, (uint32_t)ctz_u64(pieces));
+                pieces = clsb_u64(pieces);
+            }
+        }
+    }
+
+    hash ^= zobrist_castling_keys[board->state & BOARD_STATE_CASTLE_MASK];
+
+    if(zobrist_has_en_passant_key(board))
+    {
+        hash ^= zobrist_en_passant_keys[BOARD_PTR_GET_EN_PASSANT_FILE(board)];
+    }
+
+    /* Keyed when black is to play, BOARD_PTR_GET_SIDE_TO_PLAY is 1 for black */
+    hash ^= zobrist_side_key & (0ULL - (uint64_t)BOARD_PTR_GET_SIDE_TO_PLAY(board));
+
+    return hash;
+}
+
+bool zobrist_cuckoo_find(const uint64_t move_key, uint32_t* square_a, uint32_t* square_b)
+{
+    uint32_t slot = zobrist_cuckoo_hash_1(move_key);
+
+    if(_zobrist_cuckoo_keys[slot] != move_key)
+    {
+        slot = zobrist_cuckoo_hash_2(move_key);
+
+        if(_zobrist_cuckoo_keys[slot] != move_key)
+        {
+            return false;
+        }
+    }
+
+    *square_a = _zobrist_cuckoo_squares[slot] & 0xFF;
+    *square_b = _zobrist_cuckoo_squares[slot] >> 8;
+
+    return true;
+}
@@ -1,6 +1,98 @@
 #include "cchess/board.h"
+#include "cchess/notation.h"
+#include "cchess/platform.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+
+/* Larger than the caches once the boards are copied from it */
+#define BENCH_NUM_BOARDS (1 << 18)
+#define BENCH_NUM_HOT_BOARDS 64
+#define BENCH_NUM_COPY_MAKES (1 << 22)
+
+STATIC_ASSERT((BENCH_NUM_BOARDS & (BENCH_NUM_BOARDS - 1)) == 0 && (BENCH_NUM_HOT_BOARDS & (BENCH_NUM_HOT_BOARDS - 1)) == 0);
+
+/* Copies each board in a scattered order and plays its move, returning the nanoseconds per copy-make */
+static double bench_copy_make(const Board* boards, const Move* moves, const size_t num_boards, uint64_t* sink)
+{
+    const uint64_t start = platform_get_time_ns();
+
+    for(size_t i = 0; i < BENCH_NUM_COPY_MAKES; i++)
+    {
+        const size_t index = (i * 2654435761ULL) & (num_boards - 1);
+
+        Board child = boards[index];
+        board_make_move(&child, moves[index]);
+
+        *sink += child.halfmove_clock + board_get_side(&child, PIECE_WHITE);
+    }
+
+    return (double)(platform_get_time_ns() - start) / BENCH_NUM_COPY_MAKES;
+}
+
+/*
+    Copy-make from a few boards staying in the caches, then from many more
+    boards than the caches hold, where the cost is the cache misses of the
+    lines each board spans
+*/
+static void benchmark_copy_make(void)
+{
+    Board* boards = (Board*)platform_alloc_aligned(BENCH_NUM_BOARDS * sizeof(Board), BOARD_ALIGNMENT);
+    Move* moves = (Move*)calloc(BENCH_NUM_BOARDS, sizeof(Move));
+
+    CCHESS_ASSERT(boards != NULL && moves != NULL);
+
+    /* Random games, restarted when over */
+    Board board = board_init();
+    uint64_t random = 0x2545F4914F6CDD1DULL;
+
+    for(size_t i = 0; i < BENCH_NUM_BOARDS; i++)
+    {
+        Move legal_moves[BOARD_MAX_MOVES];
+        size_t num_legal_moves;
+
+        board_get_legal_moves(&board, legal_moves, &num_legal_moves);
+
+        if(num_legal_moves == 0 || board.halfmove_clock >= 100)
+        {
+            board = board_init();
+            board_get_legal_moves(&board, legal_moves, &num_legal_moves);
+        }
+
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+
+        boards[i] = board;
+        moves[i] = legal_moves[random % num_legal_moves];
+
+        board_make_move(&board, moves[i]);
+    }
+
+    uint64_t lines = 0;
+
+    for(size_t i = 0; i < BENCH_NUM_BOARDS; i++)
+    {
+        const uintptr_t address = (uintptr_t)&boards[i];
+
+        lines += ((address + sizeof(Board) - 1) >> 6) - (address >> 6) + 1;
+    }
+
+    uint64_t sink = 0;
+
+    const double hot_ns = bench_copy_make(boards, moves, BENCH_NUM_HOT_BOARDS, &sink);
+    const double cold_ns = bench_copy_make(boards, moves, BENCH_NUM_BOARDS, &sink);
+
+    printf("Board of %zu bytes spanning %.2f cache lines, copy-make: %.2f ns from the caches, %.2f ns from memory (%llu)\n",
+           sizeof(Board),
+           (double)lines / BENCH_NUM_BOARDS,
+           hot_ns,
+           cold_ns,
+           (unsigned long long)(sink & 0xF));
+
+    platform_free_aligned(boards);
+    free(moves);
+}
 
 int main(int argc, char** argv)
 {
@@ -18,6 +110,119 @@ int main(int argc, char** argv)
     board_has_check(&b_check);
 
     CCHESS_ASSERT(board_has_check(&b_check));
+    CCHESS_ASSERT(!board_has_mate(&b_check));
+
+    /* Fool's mate */
+    Board b_fools_mate = board_from_fen("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+
+    CCHESS_ASSERT(board_has_mate(&b_fools_mate));
+    CCHESS_ASSERT(!board_has_stalemate(&b_fools_mate));
+
+    /* Back rank mate, and the same position where the rook on a1 can capture the checker */
+    Board b_back_rank = board_from_fen("3R2k1/5ppp/8/8/8/8/5PPP/6K1 b - - 0 1");
+    Board b_back_rank_defended = board_from_fen("r2R2k1/5ppp/8/8/8/8/5PPP/6K1 b - - 0 1");
+
+    CCHESS_ASSERT(board_has_mate(&b_back_rank));
+    CCHESS_ASSERT(!board_has_mate(&b_back_rank_defended));
+
+    /* Smothered mate */
+    Board b_smothered = board_from_fen("6rk/5Npp/8/8/8/8/8/6K1 b - - 0 1");
+
+    CCHESS_ASSERT(board_has_mate(&b_smothered));
+
+    /* The checker can only be blocked by the knight */
+    Board b_block = board_from_fen("4k3/8/8/8/8/4N3/3PPP2/R1B1K2r w - - 0 1");
+    Board b_no_block = board_from_fen("4k3/8/8/8/8/8/3PPP2/R1B1K2r w - - 0 1");
+
+    CCHESS_ASSERT(!board_has_mate(&b_block));
+    CCHESS_ASSERT(board_has_mate(&b_no_block));
+
+    /* The rook on f2 could block on f1 but is pinned by the bishop on h4 */
+    Board b_pinned = board_from_fen("4k3/8/8/8/7b/8/3PPR2/4K2r w - - 0 1");
+    Board b_not_pinned = board_from_fen("4k3/8/8/8/8/8/3PPR2/4K2r w - - 0 1");
+
+    CCHESS_ASSERT(board_has_mate(&b_pinned));
+    CCHESS_ASSERT(!board_has_mate(&b_not_pinned));
+
+    /* Double check, the rook on a3 could capture the knight but only the king may move */
+    Board b_double_check = board_from_fen("4r1k1/8/8/8/8/R2n4/3P1P2/3QKB2 w - - 0 1");
+
+    CCHESS_ASSERT(board_has_mate(&b_double_check));
+
+    /* Stalemates */
+    Board b_stalemate = board_from_fen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+    Board b_stalemate_pinned = board_from_fen("r7/8/8/8/N7/8/2k5/K1n5 w - - 0 1");
+    Board b_pinned_can_move = board_from_fen("r7/8/8/8/R7/8/2k5/K1n5 w - - 0 1");
+    Board b_not_stalemate = board_from_fen("7k/5Q2/6K1/8/8/8/p7/8 b - - 0 1");
+
+    CCHESS_ASSERT(board_has_stalemate(&b_stalemate));
+    CCHESS_ASSERT(!board_has_mate(&b_stalemate));
+    CCHESS_ASSERT(!board_has_stalemate(&b_not_stalemate));
+    CCHESS_ASSERT(board_has_stalemate(&b_stalemate_pinned));
+    CCHESS_ASSERT(!board_has_stalemate(&b_pinned_can_move));
+
+    /* Mate detection from the last move */
+    Move qh4;
+    MOVE_SET_PIECE(qh4, Piece_Queen);
+    MOVE_SET_FROM_SQUARE(qh4, 59);
+    MOVE_SET_TO_SQUARE(qh4, 31);
+    MOVE_SET_IS_CAPTURING(qh4, 0);
+
+    CCHESS_ASSERT(board_has_mate_from_last_move(&b_fools_mate, qh4));
+
+    /* Static exchange evaluation */
+    const struct
+    {
+        const char* fen;
+        const char* move;
+        int32_t see;
+    } see_cases[] = {
+        /* Free pawn */
+        { "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", 100 },
+        /* Knight for a pawn, the queen behind the rook joining the exchange */
+        { "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", -220 },
+        /* Doubled rooks win the pawn, a single one loses the exchange */
+        { "3rk3/8/8/3p4/8/8/3R4/3RK3 w - - 0 1", "d2d5", 100 },
+        { "3rk3/8/8/3p4/8/8/3R4/4K3 w - - 0 1", "d2d5", -400 },
+        /* The king only takes undefended pieces */
+        { "4k3/8/8/8/3p4/4K3/8/8 w - - 0 1", "e3d4", 100 },
+        { "4k3/8/4p3/3p4/8/8/8/3QK3 w - - 0 1", "d1d5", -800 },
+        { "3rk3/3r4/8/3p4/4K3/8/8/3R4 w - - 0 1", "d1d5", -400 },
+        /* Quiet moves to an attacked or a safe square */
+        { "4k3/8/4p3/8/8/8/8/3QK3 w - - 0 1", "d1d5", -900 },
+        { "4k3/8/4p3/8/8/8/8/3QK3 w - - 0 1", "d1d4", 0 },
+        /* En passant, the rook behind the captured pawn being uncovered */
+        { "4k3/8/8/3pP3/8/8/8/3RK3 w - d6 0 1", "e5d6", 100 },
+        { "4k3/3r4/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 0 },
+        /* Promotions, with and without a recapture */
+        { "4k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7a8q", 800 },
+        { "r3k3/1P6/8/8/8/8/8/4K3 w - - 0 1", "b7a8q", 1300 },
+        { "1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7a8q", -100 },
+        /* Black to play, the bishop defended by the queen behind it */
+        { "4k3/8/8/8/8/8/1b6/q3K1R1 b - - 0 1", "b2g7", 0 },
+        { "4k3/6r1/8/8/8/2B5/1Q6/4K3 b - - 0 1", "g7g2", -500 },
+        { "3qk3/8/8/3p4/4P3/8/8/3QK3 w - - 0 1", "e4d5", 100 },
+    };
+
+    for(size_t i = 0; i < sizeof(see_cases) / sizeof(see_cases[0]); i++)
+    {
+        Board see_board = board_from_fen(see_cases[i].fen);
+        Move see_move;
+
+        const bool found = move_from_uci(&see_board, see_cases[i].move, &see_move) && board_move_is_legal(&see_board, see_move);
+        CCHESS_ASSERT(found);
+
+        const int32_t see = board_see(&see_board, see_move);
+
+        if(see != see_cases[i].see)
+        {
+            printf("SEE of %s in %s: %d, expected %d\n", see_cases[i].move, see_cases[i].fen, see, see_cases[i].see);
+        }
+
+        CCHESS_ASSERT(see == see_cases[i].see);
+    }
+
+    benchmark_copy_make();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "cchess/dfpn.h"
+#include "cchess/search.h"
+#include "cchess/notation.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Checks that the solver proves mates at their exact length and disproves
+    them below it, that the principal variation is a legal mate, that a
+    mate needing a quiet move is only found without checks_only, and that
+    the node budget leaves the result unknown. Then compares the nodes of
+    the solver with the ones alpha-beta needs to find the same mate
+*/
+
+typedef struct
+{
+    const char* fen;
+    uint32_t mate_moves;
+    bool checks_only;
+    const char* first_move;
+} MateCase;
+
+static const MateCase mate_cases[] = {
+    /* Back rank */
+    { "6k1/5ppp/8/8/8/8/5PPP/4R1K1 w - - 0 1", 1, true, "e1e8" },
+    /* Smothered */
+    { "5r1k/6pp/8/6N1/2Q5/8/6PP/6K1 w - - 0 1", 4, true, "g5f7" },
+    /* Black mates the king drawn out */
+    { "r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1", 3, true, NULL },
+    /* Queen and rook ladder */
+    { "8/8/8/3k4/8/8/8/1QR3K1 w - - 0 1", 5, true, NULL },
+    /* Two rooks, the king has to step up first */
+    { "8/8/8/4k3/8/8/R7/1R4K1 w - - 0 1", 6, false, NULL },
+};
+
+#define NUM_MATE_CASES (sizeof(mate_cases) / sizeof(mate_cases[0]))
+
+static void solve(const MateCase* mate_case, const uint32_t max_moves, DfpnInfo* info)
+{
+    Board board = board_from_fen(mate_case->fen);
+
+    DfpnLimits limits;
+    dfpn_limits_init(&limits);
+    limits.max_moves = max_moves;
+    limits.checks_only = mate_case->checks_only;
+
+    const bool solved = dfpn_solve(&board, &limits, info);
+    CCHESS_ASSERT(solved);
+}
+
+static void check_mates(void)
+{
+    for(size_t i = 0; i < NUM_MATE_CASES; i++)
+    {
+        const MateCase* mate_case = &mate_cases[i];
+
+        DfpnInfo info;
+
+        /* No shorter mate, too long to disprove with all the moves of the attacker */
+        if(mate_case->checks_only)
+        {
+            solve(mate_case, mate_case->mate_moves - 1, &info);
+            CCHESS_ASSERT(info.result == DfpnResult_Disproven);
+            CCHESS_ASSERT(info.pv_length == 0 && info.proof_tree_size == 0);
+        }
+
+        solve(mate_case, mate_case->mate_moves, &info);
+        CCHESS_ASSERT(info.result == DfpnResult_Proven);
+        CCHESS_ASSERT(info.pv_length == 2 * mate_case->mate_moves - 1);
+        CCHESS_ASSERT(info.proof_tree_size >= info.pv_length + 1);
+
+        /* The principal variation is legal and ends in a mate */
+        Board board = board_from_fen(mate_case->fen);
+
+        for(uint32_t j = 0; j < info.pv_length; j++)
+        {
+            CCHESS_ASSERT(board_move_is_legal(&board, info.pv[j]));
+            board_make_move(&board, info.pv[j]);
+        }
+
+        CCHESS_ASSERT(board_has_mate(&board));
+
+        char uci[MOVE_UCI_MAX_SIZE];
+        board = board_from_fen(mate_case->fen);
+        move_to_uci(&board, info.pv[0], uci);
+
+        CCHESS_ASSERT(mate_case->first_move == NULL || strcmp(uci, mate_case->first_move) == 0);
+
+        /* Still proven with more moves */
+        solve(mate_case, mate_case->mate_moves + 1, &info);
+        CCHESS_ASSERT(info.result == DfpnResult_Proven);
+    }
+
+    /* The two rooks cannot mate by checks alone */
+    MateCase checks_only = mate_cases[NUM_MATE_CASES - 1];
+    checks_only.checks_only = true;
+
+    DfpnInfo info;
+    solve(&checks_only, checks_only.mate_moves, &info);
+    CCHESS_ASSERT(info.result == DfpnResult_Disproven);
+
+    /* Out of budget */
+    Board board = board_from_fen(mate_cases[3].fen);
+
+    DfpnLimits limits;
+    dfpn_limits_init(&limits);
+    limits.max_nodes = 100;
+
+    const bool solved = dfpn_solve(&board, &limits, &info);
+    CCHESS_ASSERT(solved);
+    CCHESS_ASSERT(info.result == DfpnResult_Unknown && info.pv_length == 0);
+
+    /* Already mated or stalemated */
+    Board mated = board_from_fen("4R1k1/5ppp/8/8/8/8/5PPP/6K1 b - - 1 1");
+    Board stalemated = board_from_fen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+
+    dfpn_solve(&mated, &limits, &info);
+    CCHESS_ASSERT(info.result == DfpnResult_Disproven);
+
+    dfpn_solve(&stalemated, &limits, &info);
+    CCHESS_ASSERT(info.result == DfpnResult_Disproven);
+}
+
+/* Alpha-beta searches deeper until it scores the mate, the shortest one */
+static void compare_alpha_beta(void)
+{
+    for(size_t i = 1; i < NUM_MATE_CASES; i++)
+    {
+        const MateCase* mate_case = &mate_cases[i];
+
+        DfpnInfo info;
+        solve(mate_case, mate_case->mate_moves, &info);
+
+        Board board = board_from_fen(mate_case->fen);
+
+        SearchLimits limits;
+        search_limits_init(&limits);
+
+        SearchInfo search_info;
+
+        do
+        {
+            limits.max_depth++;
+            search_run(&board, &limits, &search_info);
+        }
+        while(search_info.score < SEARCH_SCORE_MATE_BOUND && limits.max_depth < 2 * mate_case->mate_moves + 2);
+
+        CCHESS_ASSERT(search_info.score == SEARCH_SCORE_MATE - (int32_t)info.pv_length);
+
+        printf("mate in %u%s: df-pn %llu nodes, proof tree of %llu nodes, alpha-beta %llu nodes at depth %u (%.1f%%)\n",
+               mate_case->mate_moves,
+               mate_case->checks_only ? " by checks" : "",
+               (unsigned long long)info.nodes,
+               (unsigned long long)info.proof_tree_size,
+               (unsigned long long)search_info.nodes,
+               search_info.depth,
+               100.0 * (double)info.nodes / (double)search_info.nodes);
+
+        CCHESS_ASSERT(info.nodes < search_info.nodes);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    check_mates();
+    compare_alpha_beta();
+
+    return 0;
+}
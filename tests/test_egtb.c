@@ -0,0 +1,258 @@
+#include "cchess/egtb.h"
+#include "cchess/eval.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Generates the 3 pieces tables and verifies them against the endgame
+    theory, and every position of KPvK against the values of its moves
+*/
+
+#define TEST_EGTB_NUM_PROBES 100000
+
+static const char* const _test_materials[5] = { "KQvK", "KRvK", "KBvK", "KNvK", "KPvK" };
+
+static const char* const _test_paths[5] = { "KQvK.egtb", "KRvK.egtb", "KBvK.egtb", "KNvK.egtb", "KPvK.egtb" };
+
+static Egtb _test_tables[5];
+
+/* White king, black king and one white piece */
+static bool set_board(Board* board, const uint32_t white_king, const uint32_t black_king, const uint32_t piece_square, const uint32_t piece, const uint32_t side)
+{
+    memset(board, 0, sizeof(Board));
+
+    if(white_king == black_king || white_king == piece_square || black_king == piece_square)
+    {
+        return false;
+    }
+
+    board_put_piece(board, Piece_King, PIECE_WHITE, white_king);
+    board_put_piece(board, Piece_King, PIECE_BLACK, black_king);
+    board_put_piece(board, piece, PIECE_WHITE, piece_square);
+    board->state = side == PIECE_WHITE ? BoardState_WhiteToPlay : 0;
+    board->fullmove_number = 1;
+
+    board_init_derived(board);
+
+    return true;
+}
+
+static bool probe(Board* board, EgtbWdl* wdl)
+{
+    if(popcount_u64(board_get_all(board)) == 2)
+    {
+        *wdl = EgtbWdl_Draw;
+        return true;
+    }
+
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        if(egtb_probe_wdl(&_test_tables[i], board, wdl))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Value of the position from the values of its moves */
+static EgtbWdl search_wdl(Board* board)
+{
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+
+    if(num_moves == 0)
+    {
+        return board_get_checkers(board) != 0ULL ? EgtbWdl_Loss : EgtbWdl_Draw;
+    }
+
+    EgtbWdl best = EgtbWdl_Loss;
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        Board after = *board;
+        board_make_move(&after, moves[i]);
+
+        EgtbWdl wdl = EgtbWdl_Draw;
+        const bool probed = probe(&after, &wdl);
+        CCHESS_ASSERT(probed);
+
+        best = -wdl > best ? (EgtbWdl)-wdl : best;
+    }
+
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    EgtbMaterial material;
+    const bool parsed = egtb_parse_material(&material, "KRPvKR");
+    CCHESS_ASSERT(parsed);
+    CCHESS_ASSERT(material.num_pieces == 5 && material.has_pawns);
+    CCHESS_ASSERT(material.num_positions == 2ULL * 32 * 64 * 64 * 64 * 64);
+
+    static const char* const invalid_materials[] = { "KvK", "KQRvKRB", "KXvK", "KQ" };
+
+    for(uint32_t i = 0; i < sizeof(invalid_materials) / sizeof(invalid_materials[0]); i++)
+    {
+        const bool invalid_parsed = egtb_parse_material(&material, invalid_materials[i]);
+        CCHESS_ASSERT(!invalid_parsed);
+    }
+
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        EgtbGenStats stats;
+        const bool generated = egtb_generate(_test_materials[i], _test_paths[i], &stats);
+        CCHESS_ASSERT(generated);
+        CCHESS_ASSERT(stats.num_wins + stats.num_draws + stats.num_losses == stats.num_legal);
+
+        printf("%s: %llu positions, %llu legal, %llu wins, %llu draws, %llu losses, %u passes, %u tables, %llu bytes, %.1f ms\n",
+               _test_materials[i],
+               (unsigned long long)stats.num_positions,
+               (unsigned long long)stats.num_legal,
+               (unsigned long long)stats.num_wins,
+               (unsigned long long)stats.num_draws,
+               (unsigned long long)stats.num_losses,
+               stats.num_passes,
+               stats.num_tables,
+               (unsigned long long)stats.file_size,
+               (double)stats.elapsed_ns / 1e6);
+
+        /* Smaller than the packed values, headers included */
+        CCHESS_ASSERT(stats.file_size < stats.num_positions / 4);
+
+        const bool opened = egtb_open(&_test_tables[i], _test_paths[i]);
+        CCHESS_ASSERT(opened);
+    }
+
+    /* The queen and the rook always win with white to play, the minor pieces never do */
+    const uint32_t pieces[4] = { Piece_Queen, Piece_Rook, Piece_Bishop, Piece_Knight };
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        size_t num_positions = 0;
+        size_t num_expected = 0;
+
+        for(uint32_t j = 0; j < 64 * 64 * 64; j++)
+        {
+            Board board;
+            EgtbWdl wdl;
+
+            if(!set_board(&board, j % 64, (j / 64) % 64, j / 4096, pieces[i], PIECE_WHITE) ||
+               !egtb_probe_wdl(&_test_tables[i], &board, &wdl))
+            {
+                continue;
+            }
+
+            num_positions++;
+            num_expected += wdl == (i < 2 ? EgtbWdl_Win : EgtbWdl_Draw);
+        }
+
+        CCHESS_ASSERT(num_positions > 0 && num_expected == num_positions);
+    }
+
+    /* Every KPvK position agrees with the values of its moves */
+    size_t num_checked = 0;
+
+    for(uint32_t j = 0; j < 2 * 64 * 64 * 64; j++)
+    {
+        Board board;
+        EgtbWdl wdl;
+
+        if(!set_board(&board, j % 64, (j / 64) % 64, (j / 4096) % 64, Piece_Pawn, j / (64 * 64 * 64)) ||
+           !egtb_probe_wdl(&_test_tables[4], &board, &wdl))
+        {
+            continue;
+        }
+
+        CCHESS_ASSERT(search_wdl(&board) == wdl);
+        num_checked++;
+    }
+
+    CCHESS_ASSERT(num_checked > 0);
+
+    /* Known positions */
+    const char* const fens[8] = {
+        /* Mated, stalemated */
+        "k7/1Q6/1K6/8/8/8/8/8 b - - 0 1",
+        "k7/2Q5/1K6/8/8/8/8/8 b - - 0 1",
+        /* The queen hangs */
+        "8/8/8/3k4/3Q4/8/8/3K4 b - - 0 1",
+        /* King on the sixth rank in front of its pawn, wins whoever plays */
+        "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1",
+        "4k3/8/4K3/4P3/8/8/8/8 w - - 0 1",
+        /* Pawn on the seventh rank, black to play is stalemated */
+        "4k3/4P3/4K3/8/8/8/8/8 b - - 0 1",
+        /* Rook pawn */
+        "k7/8/K7/P7/8/8/8/8 w - - 0 1",
+        /* Colors swapped */
+        "8/8/8/8/4p3/4k3/8/4K3 w - - 0 1",
+    };
+
+    const EgtbWdl expected[8] = {
+        EgtbWdl_Loss, EgtbWdl_Draw, EgtbWdl_Draw, EgtbWdl_Loss, EgtbWdl_Win, EgtbWdl_Draw, EgtbWdl_Draw, EgtbWdl_Loss,
+    };
+
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        Board board = board_from_fen(fens[i]);
+        EgtbWdl wdl = EgtbWdl_Draw;
+
+        const bool probed = probe(&board, &wdl);
+        CCHESS_ASSERT(probed && wdl == expected[i]);
+    }
+
+    /* Other material, castling rights, corrupted file */
+    Board krvk = board_from_fen("8/8/8/3k4/8/8/2R5/3K4 w - - 0 1");
+    Board castling = board_from_fen("8/8/8/3k4/8/8/8/R3K3 w Q - 0 1");
+    EgtbWdl wdl;
+
+    const bool probed_other = egtb_probe_wdl(&_test_tables[0], &krvk, &wdl);
+    CCHESS_ASSERT(!probed_other);
+
+    const bool probed_castling = egtb_probe_wdl(&_test_tables[1], &castling, &wdl);
+    CCHESS_ASSERT(!probed_castling);
+
+    FILE* file = fopen("corrupted.egtb", "wb");
+    CCHESS_ASSERT(file != NULL);
+    fwrite("EGTB", 1, 4, file);
+    fclose(file);
+
+    Egtb corrupted;
+    const bool opened_corrupted = egtb_open(&corrupted, "corrupted.egtb");
+    CCHESS_ASSERT(!opened_corrupted);
+
+    const bool opened_missing = egtb_open(&corrupted, "does_not_exist.egtb");
+    CCHESS_ASSERT(!opened_missing);
+
+    /* Probes cost */
+    Board kpvk = board_from_fen("8/8/3k4/8/8/3K4/3P4/8 w - - 0 1");
+    const uint64_t start = platform_get_time_ns();
+    size_t total = 0;
+
+    for(size_t i = 0; i < TEST_EGTB_NUM_PROBES; i++)
+    {
+        total += egtb_probe_wdl(&_test_tables[4], &kpvk, &wdl) && wdl == EgtbWdl_Win;
+    }
+
+    printf("EGTB WDL probe: %.1f ns/probe (%zu)\n",
+           (double)(platform_get_time_ns() - start) / TEST_EGTB_NUM_PROBES,
+           total);
+
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        egtb_close(&_test_tables[i]);
+        remove(_test_paths[i]);
+    }
+
+    remove("corrupted.egtb");
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "cchess/epd.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Writes a small EPD file and verifies the positions and operations loaded
+    back from it
+*/
+
+#define TEST_EPD_PATH "test_epd.epd"
+#define TEST_EPD_NUM_COPIES 20000
+
+static const char* const epd_lines[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400 ;D3 8902\n",
+    "# comment line\n",
+    "\n",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - bm Bb5 Bc4; id \"test; 2\";\r\n",
+    "8/8/8/8/8/8/8/k6K b - - hmvc 12; fmvn 40;\n",
+    "not a fen\n",
+};
+
+typedef struct
+{
+    size_t num_records;
+    size_t num_perft;
+    size_t num_ids;
+} TestEpdCounts;
+
+static void count_record(const EpdRecord* record, size_t record_index, void* user_data)
+{
+    TestEpdCounts* counts = (TestEpdCounts*)user_data;
+
+#pragma omp atomic
+    counts->num_records++;
+
+    if(record->perft_depth == 3)
+    {
+        CCHESS_ASSERT(record->perft[0] == 20 && record->perft[1] == 400 && record->perft[2] == 8902);
+
+#pragma omp atomic
+        counts->num_perft++;
+    }
+
+    if(record->id != NULL)
+    {
+        CCHESS_ASSERT(record->id_length == 7 && strncmp(record->id, "test; 2", 7) == 0);
+        CCHESS_ASSERT(record->best_moves_length == 7 && strncmp(record->best_moves, "Bb5 Bc4", 7) == 0);
+
+#pragma omp atomic
+        counts->num_ids++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    FILE* file = fopen(TEST_EPD_PATH, "wb");
+
+    CCHESS_ASSERT(file != NULL && "Cannot write the test EPD file");
+
+    /* Enough copies to span several parsing chunks */
+    for(size_t i = 0; i < TEST_EPD_NUM_COPIES; i++)
+    {
+        for(size_t j = 0; j < sizeof(epd_lines) / sizeof(epd_lines[0]); j++)
+        {
+            fputs(epd_lines[j], file);
+        }
+    }
+
+    fclose(file);
+
+    const size_t num_expected = TEST_EPD_NUM_COPIES * 4;
+
+    Board* boards = (Board*)platform_alloc_aligned(num_expected * sizeof(Board), BOARD_ALIGNMENT);
+
+    size_t num_boards = 0;
+    EpdLoadStats stats;
+
+    const bool loaded = epd_load_boards(TEST_EPD_PATH, boards, num_expected, &num_boards, &stats);
+    CCHESS_ASSERT(loaded);
+
+    printf("Loaded %zu records (%zu errors) in %.3f ms, %.0f records/s, %.1f MB/s\n",
+           stats.num_records,
+           stats.num_errors,
+           (double)stats.elapsed_ns * 1e-6,
+           stats.records_per_second,
+           stats.megabytes_per_second);
+
+    CCHESS_ASSERT(num_boards == num_expected);
+    CCHESS_ASSERT(stats.num_errors == TEST_EPD_NUM_COPIES);
+
+    for(size_t i = 0; i < num_boards; i += 4)
+    {
+        CCHESS_ASSERT(board_get_all(&boards[i]) == 0xFFFF00000000FFFFULL);
+        CCHESS_ASSERT(board_get_knights(&boards[i + 1], 1) == 0x4000040000000000ULL);
+        CCHESS_ASSERT(boards[i + 2].halfmove_clock == 12 && boards[i + 2].fullmove_number == 40);
+        CCHESS_ASSERT(board_get_all(&boards[i + 3]) == 0ULL);
+    }
+
+    platform_free_aligned(boards);
+
+    TestEpdCounts counts;
+    memset(&counts, 0, sizeof(TestEpdCounts));
+
+    const bool parsed = epd_load(TEST_EPD_PATH, count_record, &counts, NULL);
+    CCHESS_ASSERT(parsed);
+
+    CCHESS_ASSERT(counts.num_records == TEST_EPD_NUM_COPIES * 3);
+    CCHESS_ASSERT(counts.num_perft == TEST_EPD_NUM_COPIES);
+    CCHESS_ASSERT(counts.num_ids == TEST_EPD_NUM_COPIES);
+
+    remove(TEST_EPD_PATH);
+
+    return 0;
+}
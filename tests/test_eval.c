@@ -0,0 +1,165 @@
+#include "cchess/eval.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Plays random games from positions with castling, en passant and
+    promotions, checking the incremental scores against a full computation
+    after every move, and that a position and its color mirror evaluate the
+    same for the side to play
+*/
+
+static const char* const fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+#define NUM_FENS (sizeof(fens) / sizeof(fens[0]))
+
+#define TEST_EVAL_NUM_GAMES 200
+#define TEST_EVAL_MAX_PLIES 200
+
+#define BENCH_NUM_EVALS 1000000
+
+static uint64_t splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t flip_ranks(const uint64_t bitboard)
+{
+    uint64_t flipped = 0;
+
+    for(uint32_t rank = 0; rank < 8; rank++)
+    {
+        flipped |= ((bitboard >> (rank * 8)) & 0xFFULL) << ((7 - rank) * 8);
+    }
+
+    return flipped;
+}
+
+/* The same position with the colors swapped, without castling and en passant */
+static Board mirror(const Board* board)
+{
+    Board mirrored;
+    memset(&mirrored, 0, sizeof(Board));
+
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        mirrored.pieces[i] = flip_ranks(board->pieces[i]);
+    }
+
+    mirrored.sides[PIECE_WHITE] = flip_ranks(board->sides[PIECE_BLACK]);
+    mirrored.sides[PIECE_BLACK] = flip_ranks(board->sides[PIECE_WHITE]);
+    mirrored.state = board->state & BoardState_WhiteToPlay ? 0 : BoardState_WhiteToPlay;
+
+    board_init_derived(&mirrored);
+
+    return mirrored;
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    Board start = board_init();
+    CCHESS_ASSERT(start.phase == EVAL_PHASE_MAX && start.psqt_mg == 0 && start.psqt_eg == 0);
+    CCHESS_ASSERT(eval_evaluate(&start) == 0);
+
+    /* An extra queen is worth about a queen */
+    Board extra_queen = board_from_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    board_put_piece(&extra_queen, Piece_Queen, PIECE_WHITE, 19);
+    board_init_derived(&extra_queen);
+
+    CCHESS_ASSERT(eval_evaluate(&extra_queen) > 800 && extra_queen.phase == EVAL_PHASE_MAX + 4);
+
+    uint64_t state = 0;
+    uint64_t num_moves_played = 0;
+    uint64_t num_invalid = 0;
+    uint64_t num_asymmetric = 0;
+
+    Board* positions = (Board*)platform_alloc_aligned((TEST_EVAL_NUM_GAMES * TEST_EVAL_MAX_PLIES) * sizeof(Board), BOARD_ALIGNMENT);
+    size_t num_positions = 0;
+
+    for(uint32_t game = 0; game < TEST_EVAL_NUM_GAMES; game++)
+    {
+        Board board = board_from_fen(fens[game % NUM_FENS]);
+
+        for(uint32_t ply = 0; ply < TEST_EVAL_MAX_PLIES; ply++)
+        {
+            Move moves[BOARD_MAX_MOVES];
+            size_t num_moves;
+
+            board_get_legal_moves(&board, moves, &num_moves);
+
+            if(num_moves == 0)
+            {
+                break;
+            }
+
+            board_make_move(&board, moves[splitmix64(&state) % num_moves]);
+            num_moves_played++;
+
+            num_invalid += !eval_board_is_valid(&board);
+
+            const Board mirrored = mirror(&board);
+            num_asymmetric += eval_evaluate(&mirrored) != eval_evaluate(&board);
+
+            positions[num_positions++] = board;
+        }
+    }
+
+    printf("%llu moves played, %llu invalid, %llu asymmetric\n",
+           (unsigned long long)num_moves_played,
+           (unsigned long long)num_invalid,
+           (unsigned long long)num_asymmetric);
+
+    CCHESS_ASSERT(num_invalid == 0);
+    CCHESS_ASSERT(num_asymmetric == 0);
+
+    /* Incremental evaluation against a full computation */
+    int64_t incremental_sum = 0;
+    int64_t full_sum = 0;
+
+    uint64_t time_start = platform_get_time_ns();
+
+    for(size_t i = 0; i < BENCH_NUM_EVALS; i++)
+    {
+        incremental_sum += eval_evaluate(&positions[i % num_positions]);
+    }
+
+    const uint64_t incremental_ns = platform_get_time_ns() - time_start;
+
+    time_start = platform_get_time_ns();
+
+    for(size_t i = 0; i < BENCH_NUM_EVALS; i++)
+    {
+        Board board = positions[i % num_positions];
+        eval_init_board(&board);
+        full_sum += eval_evaluate(&board);
+    }
+
+    const uint64_t full_ns = platform_get_time_ns() - time_start;
+
+    printf("Evaluation: %.2f ns incremental, %.2f ns full computation (sums %lld and %lld)\n",
+           (double)incremental_ns / BENCH_NUM_EVALS,
+           (double)full_ns / BENCH_NUM_EVALS,
+           (long long)incremental_sum,
+           (long long)full_sum);
+
+    CCHESS_ASSERT(incremental_sum == full_sum);
+
+    platform_free_aligned(positions);
+
+    return 0;
+}
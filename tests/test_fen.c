@@ -0,0 +1,130 @@
+#include "cchess/board.h"
+#include "cchess/board_macros.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Verifies that FEN strings round-trip through board_parse_fen/board_to_fen
+    and that board_make_move keeps the FEN state up to date
+*/
+
+static const char* const fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+    "rnbqkbnr/pppp1ppp/8/8/3Pp3/8/PPP1PPPP/RNBQKBNR b Kq d3 0 3",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "4k3/8/8/8/8/8/8/4K2R b K - 99 250",
+};
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    char fen[BOARD_FEN_MAX_SIZE];
+
+    for(size_t i = 0; i < sizeof(fens) / sizeof(fens[0]); i++)
+    {
+        Board b;
+
+        const size_t consumed = board_parse_fen(&b, fens[i]);
+
+        CCHESS_ASSERT(consumed == strlen(fens[i]) && "FEN not fully parsed");
+
+        const size_t length = board_to_fen(&b, fen);
+
+        printf("%s\n", fen);
+
+        CCHESS_ASSERT(length == strlen(fens[i]) && "Invalid FEN length");
+        CCHESS_ASSERT(strcmp(fen, fens[i]) == 0 && "FEN does not round-trip");
+    }
+
+    /* board_init and the starting FEN must give the same board */
+    Board b_init = board_init();
+    board_to_fen(&b_init, fen);
+
+    CCHESS_ASSERT(strcmp(fen, fens[0]) == 0 && "Invalid initial board FEN");
+
+    /* EPD records have no move counters, parsing stops before the opcodes */
+    Board b_epd;
+    const char* epd = "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 bm e5;";
+
+    const size_t epd_consumed = board_parse_fen(&b_epd, epd);
+
+    CCHESS_ASSERT(strcmp(epd + epd_consumed, " bm e5;") == 0 && "Invalid EPD parsing");
+    CCHESS_ASSERT(BOARD_HAS_EN_PASSANT(b_epd) && BOARD_GET_EN_PASSANT_SQUARE(b_epd) == 20);
+    CCHESS_ASSERT(b_epd.halfmove_clock == 0 && b_epd.fullmove_number == 1);
+
+    /* Invalid positions */
+    static const char* const invalid_fens[] = {
+        /* No black king */
+        "rnbq1bnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        /* Seven ranks */
+        "rnbqkbnr/pppppppp/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        /* Ranks of 7 and 9 squares adding up to 64 */
+        "rnbqkbnr/7/p8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBN w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNRR w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR/ w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e5 0 1",
+        /* En passant square on the rank of the side to play */
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq e3 0 1",
+        "rnbqkbnr/ppp1pppp/8/3p4/8/8/PPPPPPPP/RNBQKBNR b KQkq d6 0 1",
+    };
+
+    for(size_t i = 0; i < sizeof(invalid_fens) / sizeof(invalid_fens[0]); i++)
+    {
+        Board b_invalid;
+
+        const size_t invalid_consumed = board_parse_fen(&b_invalid, invalid_fens[i]);
+        CCHESS_ASSERT(invalid_consumed == 0 && "Invalid FEN accepted");
+    }
+
+    /* State updates of board_make_move */
+    Board b = board_init();
+
+    Move e2e4;
+    MOVE_SET_PIECE(e2e4, Piece_Pawn);
+    MOVE_SET_FROM_SQUARE(e2e4, 12);
+    MOVE_SET_TO_SQUARE(e2e4, 28);
+    MOVE_SET_IS_CAPTURING(e2e4, 0);
+
+    board_make_move(&b, e2e4);
+    board_to_fen(&b, fen);
+
+    CCHESS_ASSERT(strcmp(fen, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1") == 0);
+
+    Move ng8f6;
+    MOVE_SET_PIECE(ng8f6, Piece_Knight);
+    MOVE_SET_FROM_SQUARE(ng8f6, 62);
+    MOVE_SET_TO_SQUARE(ng8f6, 45);
+    MOVE_SET_IS_CAPTURING(ng8f6, 0);
+
+    board_make_move(&b, ng8f6);
+    board_to_fen(&b, fen);
+
+    CCHESS_ASSERT(strcmp(fen, "rnbqkb1r/pppppppp/5n2/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 1 2") == 0);
+
+    Move ke1e2;
+    MOVE_SET_PIECE(ke1e2, Piece_King);
+    MOVE_SET_FROM_SQUARE(ke1e2, 4);
+    MOVE_SET_TO_SQUARE(ke1e2, 12);
+    MOVE_SET_IS_CAPTURING(ke1e2, 0);
+
+    board_make_move(&b, ke1e2);
+    board_to_fen(&b, fen);
+
+    CCHESS_ASSERT(strcmp(fen, "rnbqkb1r/pppppppp/5n2/8/4P3/8/PPPPKPPP/RNBQ1BNR b kq - 2 2") == 0);
+
+    /* The en passant capture is the only legal move */
+    Board b_en_passant = board_from_fen("7k/5K2/6P1/8/3Pp3/4P3/8/8 b - d3 0 1");
+    Board b_no_en_passant = board_from_fen("7k/5K2/6P1/8/3Pp3/4P3/8/8 b - - 0 1");
+
+    CCHESS_ASSERT(!board_has_stalemate(&b_en_passant));
+    CCHESS_ASSERT(board_has_stalemate(&b_no_en_passant));
+
+    return 0;
+}
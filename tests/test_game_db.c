@@ -0,0 +1,183 @@
+#include "cchess/game_db.h"
+#include "cchess/notation.h"
+#include "cchess/zobrist.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Builds a game database in two writing sessions and verifies the games
+    found for some positions, and the games read back
+*/
+
+#define TEST_GAME_DB_PATH "test_game_db"
+#define TEST_GAME_DB_NUM_GAMES 20000
+#define TEST_GAME_DB_NUM_APPENDED 100
+#define BENCH_NUM_QUERIES 1000000
+
+/* Opera game, Morphy - Duke Karl / Count Isouard, Paris 1858 */
+static const char* opera_game[] = {
+    "e4", "e5", "Nf3", "d6", "d4", "Bg4", "dxe5", "Bxf3", "Qxf3", "dxe5",
+    "Bc4", "Nf6", "Qb3", "Qe7", "Nc3", "c6", "Bg5", "b5", "Nxb5", "cxb5",
+    "Bxb5+", "Nbd7", "O-O-O", "Rd8", "Rxd7", "Rxd7", "Rd1", "Qe6", "Bxd7+", "Nxd7",
+    "Qb8+", "Nxb8", "Rd8#",
+};
+
+#define OPERA_GAME_NUM_MOVES (sizeof(opera_game) / sizeof(opera_game[0]))
+
+/* Game i holds the first i % (OPERA_GAME_NUM_MOVES + 1) moves */
+static bool add_games(GameDbWriter* writer, const Move* moves, const size_t first, const size_t count)
+{
+    bool added = true;
+
+    for(size_t i = first; i < first + count; i++)
+    {
+        const uint32_t num_moves = (uint32_t)(i % (OPERA_GAME_NUM_MOVES + 1));
+        const PgnResult result = num_moves == OPERA_GAME_NUM_MOVES ? PgnResult_WhiteWins : PgnResult_Unknown;
+
+        added &= game_db_writer_add_game(writer, NULL, moves, num_moves, result);
+    }
+
+    return added;
+}
+
+static size_t count_games_reaching(const size_t num_games, const size_t ply)
+{
+    size_t count = 0;
+
+    for(size_t i = 0; i < num_games; i++)
+    {
+        count += i % (OPERA_GAME_NUM_MOVES + 1) >= ply;
+    }
+
+    return count;
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    Move moves[OPERA_GAME_NUM_MOVES];
+    uint64_t keys[OPERA_GAME_NUM_MOVES + 1];
+
+    Board b = board_init();
+    keys[0] = zobrist_hash_board(&b);
+
+    for(size_t i = 0; i < OPERA_GAME_NUM_MOVES; i++)
+    {
+        const bool parsed = move_from_san(&b, opera_game[i], &moves[i]);
+        CCHESS_ASSERT(parsed);
+
+        board_make_move(&b, moves[i]);
+        keys[i + 1] = zobrist_hash_board(&b);
+    }
+
+    remove(TEST_GAME_DB_PATH ".games");
+    remove(TEST_GAME_DB_PATH ".index");
+
+    GameDbWriter writer;
+
+    bool written = game_db_writer_open(&writer, TEST_GAME_DB_PATH) &&
+                   add_games(&writer, moves, 0, TEST_GAME_DB_NUM_GAMES);
+
+    /* A game starting from a set up position */
+    Board endgame = board_from_fen("4k3/8/8/8/8/8/4P3/4K3 b - - 0 1");
+    Move endgame_moves[2];
+
+    written &= move_from_san(&endgame, "Kd7", &endgame_moves[0]);
+
+    Board endgame_after = endgame;
+    board_make_move(&endgame_after, endgame_moves[0]);
+
+    written &= move_from_san(&endgame_after, "e4", &endgame_moves[1]);
+    written &= game_db_writer_add_game(&writer, &endgame, endgame_moves, 2, PgnResult_Draw);
+    written &= game_db_writer_close(&writer);
+
+    CCHESS_ASSERT(written);
+
+    /* Second session appending to the database */
+    written = game_db_writer_open(&writer, TEST_GAME_DB_PATH) &&
+              add_games(&writer, moves, TEST_GAME_DB_NUM_GAMES + 1, TEST_GAME_DB_NUM_APPENDED);
+    written &= game_db_writer_close(&writer);
+
+    CCHESS_ASSERT(written);
+
+    const size_t num_games = TEST_GAME_DB_NUM_GAMES + 1 + TEST_GAME_DB_NUM_APPENDED;
+
+    GameDb db;
+    const bool opened = game_db_open(&db, TEST_GAME_DB_PATH);
+
+    CCHESS_ASSERT(opened);
+    CCHESS_ASSERT(game_db_num_games(&db) == num_games);
+
+    uint32_t* game_ids = (uint32_t*)calloc(num_games, sizeof(uint32_t));
+
+    for(size_t ply = 0; ply <= OPERA_GAME_NUM_MOVES; ply++)
+    {
+        const size_t num_found = game_db_find_games(&db, keys[ply], game_ids, num_games);
+
+        /* The endgame game never reaches these positions, appended ids are shifted by it */
+        const size_t num_expected = count_games_reaching(TEST_GAME_DB_NUM_GAMES, ply) +
+                                    count_games_reaching(TEST_GAME_DB_NUM_GAMES + 1 + TEST_GAME_DB_NUM_APPENDED, ply) -
+                                    count_games_reaching(TEST_GAME_DB_NUM_GAMES + 1, ply);
+
+        CCHESS_ASSERT(num_found == num_expected);
+
+        for(size_t i = 1; i < num_found; i++)
+        {
+            CCHESS_ASSERT(game_ids[i - 1] < game_ids[i]);
+        }
+    }
+
+    /* Final position of the full game */
+    size_t num_found = game_db_find_games(&db, keys[OPERA_GAME_NUM_MOVES], game_ids, 4);
+    CCHESS_ASSERT(num_found > 4 && game_ids[0] == OPERA_GAME_NUM_MOVES);
+
+    GameDbGame game;
+    bool read = game_db_get_game(&db, game_ids[0], &game);
+
+    CCHESS_ASSERT(read && game.num_moves == OPERA_GAME_NUM_MOVES && game.result == PgnResult_WhiteWins);
+
+    for(uint32_t i = 0; i < game.num_moves; i++)
+    {
+        const Move move = game_db_game_get_move(&game, i);
+        CCHESS_ASSERT(memcmp(&move, &moves[i], sizeof(Move)) == 0);
+
+        board_make_move(&game.board, move);
+    }
+
+    CCHESS_ASSERT(board_has_mate(&game.board));
+
+    /* Set up position */
+    num_found = game_db_find_games(&db, zobrist_hash_board(&endgame_after), game_ids, num_games);
+    CCHESS_ASSERT(num_found == 1 && game_ids[0] == TEST_GAME_DB_NUM_GAMES);
+
+    read = game_db_get_game(&db, TEST_GAME_DB_NUM_GAMES, &game);
+    CCHESS_ASSERT(read && game.num_moves == 2 && game.result == PgnResult_Draw);
+    CCHESS_ASSERT(memcmp(&game.board, &endgame, sizeof(Board)) == 0);
+
+    CCHESS_ASSERT(game_db_find_games(&db, 0x123456789ABCDEFULL, game_ids, num_games) == 0);
+    CCHESS_ASSERT(!game_db_get_game(&db, (uint32_t)num_games, &game));
+
+    /* Lookups of unknown positions, the cost of a query without scanning the games found */
+    uint64_t start = platform_get_time_ns();
+    size_t total_found = 0;
+
+    for(size_t i = 0; i < BENCH_NUM_QUERIES; i++)
+    {
+        total_found += game_db_find_games(&db, keys[i % (OPERA_GAME_NUM_MOVES + 1)] ^ (i << 1 | 1), game_ids, 1);
+    }
+
+    printf("Game database lookup: %.1f ns/query (%zu)\n",
+           (double)(platform_get_time_ns() - start) / BENCH_NUM_QUERIES,
+           total_found);
+
+    free(game_ids);
+    game_db_close(&db);
+
+    remove(TEST_GAME_DB_PATH ".games");
+    remove(TEST_GAME_DB_PATH ".index");
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include "cchess/key_history.h"
+#include "cchess/search.h"
+#include "cchess/notation.h"
+#include "cchess/zobrist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+    Checks the repetition rules on made up keys, a repetition hiding behind
+    an en passant square, the cuckoo table on real moves, then that the
+    search takes a draw by repetition that saves a lost position
+*/
+
+/* Plays the moves from board, pushing the key of each position left */
+static void play(Board* board, KeyHistory* history, const char* const* moves, const size_t num_moves)
+{
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        Move move;
+        const bool found = move_from_uci(board, moves[i], &move) && board_move_is_legal(board, move);
+        CCHESS_ASSERT(found);
+
+        key_history_push(history, zobrist_hash_board(board), board->halfmove_clock == 0);
+        board_make_move(board, move);
+    }
+}
+
+static void check_repetitions(KeyHistory* history)
+{
+    key_history_reset(history);
+
+    for(uint64_t i = 0; i < 4; i++)
+    {
+        key_history_push(history, 100 + i, false);
+    }
+
+    key_history_push(history, 100, false);
+    CCHESS_ASSERT(key_history_scan_plies(history) == 4);
+
+    /* Once after the root is enough, before it the position must be there for the third time */
+    CCHESS_ASSERT(key_history_is_repetition(history, 5));
+    CCHESS_ASSERT(!key_history_is_repetition(history, 4));
+    CCHESS_ASSERT(!key_history_is_repetition(history, 1));
+
+    for(uint64_t i = 1; i < 4; i++)
+    {
+        key_history_push(history, 100 + i, false);
+    }
+
+    key_history_push(history, 100, false);
+    CCHESS_ASSERT(key_history_is_repetition(history, 1));
+
+    /* The same keys across an irreversible move are not a repetition */
+    key_history_reset(history);
+    key_history_push(history, 100, false);
+    key_history_push(history, 101, true);
+    key_history_push(history, 102, false);
+    key_history_push(history, 103, false);
+    key_history_push(history, 100, false);
+
+    CCHESS_ASSERT(key_history_scan_plies(history) == 3);
+    CCHESS_ASSERT(!key_history_is_repetition(history, 5));
+
+    /* A long game only keeps the last keys */
+    key_history_reset(history);
+
+    for(uint64_t i = 0; i < 3 * KEY_HISTORY_SIZE; i++)
+    {
+        key_history_push(history, 100 + i % 4, false);
+    }
+
+    CCHESS_ASSERT(key_history_scan_plies(history) == KEY_HISTORY_SIZE - 1);
+    CCHESS_ASSERT(key_history_is_repetition(history, 1));
+}
+
+static void check_en_passant_repetition(KeyHistory* history)
+{
+    key_history_reset(history);
+
+    /* 1.e4 Nf6 2.Nf3 Ng8 3.Ng1 repeats the position after 1.e4, no black pawn could take en passant */
+    static const char* const moves[] = { "e2e4", "g8f6", "g1f3", "f6g8", "f3g1" };
+
+    Board board = board_init();
+    play(&board, history, moves, 1);
+
+    const uint64_t e4_key = board.key;
+
+    play(&board, history, moves + 1, 4);
+    key_history_push(history, zobrist_hash_board(&board), board.halfmove_clock == 0);
+
+    CCHESS_ASSERT(board.key == e4_key);
+    CCHESS_ASSERT(key_history_is_repetition(history, 5));
+
+    /* The en passant file is keyed only when a pawn can take */
+    Board pushed = board_from_fen("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1");
+    Board capturable = board_from_fen("4k3/8/8/8/3p4/8/4P3/4K3 w - - 0 1");
+
+    static const char* const push[] = { "e2e4" };
+    play(&pushed, history, push, 1);
+    play(&capturable, history, push, 1);
+
+    const Board without_en_passant = board_from_fen("4k3/8/8/8/4P3/8/8/4K3 b - - 0 1");
+    const Board capturable_without_en_passant = board_from_fen("4k3/8/8/8/3pP3/8/8/4K3 b - - 0 1");
+
+    CCHESS_ASSERT(BOARD_HAS_EN_PASSANT(pushed) && pushed.key == without_en_passant.key);
+    CCHESS_ASSERT(BOARD_HAS_EN_PASSANT(capturable) && capturable.key != capturable_without_en_passant.key);
+}
+
+static void check_upcoming_repetitions(KeyHistory* history)
+{
+    /* The difference of the keys of two positions one reversible move apart is in the table */
+    Board board = board_init();
+    const uint64_t start_key = zobrist_hash_board(&board);
+
+    Move move;
+    const bool found = move_from_uci(&board, "g1f3", &move);
+    CCHESS_ASSERT(found);
+
+    Board after = board;
+    board_make_move(&after, move);
+
+    uint32_t a, b;
+    const bool is_reversible = zobrist_cuckoo_find(start_key ^ zobrist_hash_board(&after), &a, &b);
+    CCHESS_ASSERT(is_reversible && ((a == 6 && b == 21) || (a == 21 && b == 6)));
+
+    /* Pawn moves are not reversible */
+    const bool pawn_found = move_from_uci(&board, "e2e4", &move);
+    CCHESS_ASSERT(pawn_found);
+
+    after = board;
+    board_make_move(&after, move);
+
+    CCHESS_ASSERT(!zobrist_cuckoo_find(start_key ^ zobrist_hash_board(&after), &a, &b));
+
+    /* Black can move its knight back to the starting position */
+    static const char* const knight_moves[] = { "g1f3", "g8f6", "f3g1" };
+
+    key_history_reset(history);
+    play(&board, history, knight_moves, 3);
+    key_history_push(history, zobrist_hash_board(&board), false);
+
+    CCHESS_ASSERT(key_history_has_upcoming_repetition(history, &board, 10));
+    CCHESS_ASSERT(!key_history_is_repetition(history, 10));
+
+    /* Only repetitions after the root count */
+    CCHESS_ASSERT(!key_history_has_upcoming_repetition(history, &board, 3));
+
+    /* Not after a pawn move */
+    static const char* const pawn_moves[] = { "g1f3", "e7e5", "f3g1" };
+
+    board = board_init();
+    key_history_reset(history);
+    play(&board, history, pawn_moves, 3);
+    key_history_push(history, zobrist_hash_board(&board), false);
+
+    CCHESS_ASSERT(!key_history_has_upcoming_repetition(history, &board, 10));
+}
+
+/* Black is a queen down, but plays the knight move reaching a position for the third time */
+static void check_search(KeyHistory* history)
+{
+    static const char* const fen = "1n2k3/8/8/8/8/8/8/3QK3 b - - 0 1";
+    static const char* const moves[] = { "b8c6", "e1e2", "c6b8", "e2e1", "b8c6", "e1e2", "c6b8", "e2e1" };
+
+    Board board = board_from_fen(fen);
+
+    key_history_reset(history);
+    play(&board, history, moves, sizeof(moves) / sizeof(moves[0]));
+
+    SearchLimits limits;
+    search_limits_init(&limits);
+    limits.max_depth = 6;
+
+    SearchInfo lost_info;
+    bool searched = search_run(&board, &limits, &lost_info);
+    CCHESS_ASSERT(searched && lost_info.score < -500);
+
+    limits.history = history;
+
+    SearchInfo info;
+    searched = search_run(&board, &limits, &info);
+    CCHESS_ASSERT(searched);
+
+    char best_move[MOVE_UCI_MAX_SIZE];
+    move_to_uci(&board, info.pv[0], best_move);
+
+    printf("Without the game: score %d, with it: score %d, best move %s, %llu nodes\n",
+           lost_info.score,
+           info.score,
+           best_move,
+           (unsigned long long)info.nodes);
+
+    CCHESS_ASSERT(info.score == SEARCH_SCORE_DRAW);
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    KeyHistory* history = (KeyHistory*)malloc(sizeof(KeyHistory));
+
+    check_repetitions(history);
+    check_en_passant_repetition(history);
+    check_upcoming_repetitions(history);
+    check_search(history);
+
+    free(history);
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "cchess/mcts.h"
+#include "cchess/notation.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Checks the results of the playouts, that both selections find a mate in
+    one, that several threads respect the playout limit, and that a full
+    pool still gives a move, then measures the playouts per second of both
+    policies on one core
+*/
+
+#define TEST_MCTS_MATE_PLAYOUTS 20000
+#define TEST_MCTS_NUM_PLAYOUTS 2000
+
+static const char* const fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+#define NUM_FENS (sizeof(fens) / sizeof(fens[0]))
+
+/* Back rank mate by Re8 */
+static const char* const mate_fen = "6k1/5ppp/8/8/8/8/5PPP/4R1K1 w - - 0 1";
+
+static void check_playouts(void)
+{
+    uint64_t random = 1;
+
+    for(size_t i = 0; i < NUM_FENS; i++)
+    {
+        Board board = board_from_fen(fens[i]);
+
+        for(uint32_t j = 0; j < 100; j++)
+        {
+            uint32_t num_plies;
+            const float result = mcts_playout(&board, j & 1 ? MctsPlayout_Light : MctsPlayout_Random, &random, &num_plies);
+
+            CCHESS_ASSERT(result >= 0.0f && result <= 1.0f);
+            CCHESS_ASSERT(num_plies <= MCTS_PLAYOUT_MAX_PLIES);
+        }
+    }
+
+    /* Mated and stalemated sides lose and draw without playing */
+    Board mated = board_from_fen("4R1k1/5ppp/8/8/8/8/5PPP/6K1 b - - 1 1");
+    Board stalemated = board_from_fen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+
+    uint32_t num_plies;
+    float result = mcts_playout(&mated, MctsPlayout_Light, &random, &num_plies);
+    CCHESS_ASSERT(result == 0.0f && num_plies == 0);
+
+    result = mcts_playout(&stalemated, MctsPlayout_Random, &random, &num_plies);
+    CCHESS_ASSERT(result == 0.5f && num_plies == 0);
+}
+
+static void check_mate(const MctsSelection selection)
+{
+    Board board = board_from_fen(mate_fen);
+
+    MctsLimits limits;
+    mcts_limits_init(&limits);
+    limits.selection = selection;
+    limits.max_playouts = TEST_MCTS_MATE_PLAYOUTS;
+    limits.max_nodes = 1U << 18;
+
+    MctsInfo info;
+    const bool found = mcts_run(&board, &limits, &info);
+    CCHESS_ASSERT(found);
+
+    char uci[MOVE_UCI_MAX_SIZE];
+    move_to_uci(&board, info.pv[0], uci);
+
+    printf("%s: %s, score %.3f, %llu playouts, %u nodes\n",
+           selection == MctsSelection_Uct ? "UCT" : "PUCT",
+           uci,
+           info.score,
+           (unsigned long long)info.playouts,
+           info.num_nodes);
+
+    CCHESS_ASSERT(strcmp(uci, "e1e8") == 0);
+    CCHESS_ASSERT(info.score > 0.9f);
+    CCHESS_ASSERT(info.playouts == TEST_MCTS_MATE_PLAYOUTS);
+}
+
+static void check_threads(void)
+{
+    Board board = board_from_fen(fens[1]);
+
+    MctsLimits limits;
+    mcts_limits_init(&limits);
+    limits.num_threads = 2;
+    limits.virtual_loss = 3;
+    limits.max_playouts = TEST_MCTS_NUM_PLAYOUTS;
+    limits.max_nodes = 1U << 16;
+
+    MctsInfo info;
+    const bool found = mcts_run(&board, &limits, &info);
+    CCHESS_ASSERT(found);
+
+    CCHESS_ASSERT(info.playouts == TEST_MCTS_NUM_PLAYOUTS);
+    CCHESS_ASSERT(info.pv_length > 0 && info.num_nodes > 1);
+    CCHESS_ASSERT(info.score >= 0.0f && info.score <= 1.0f);
+
+    /* Full pool, the leaves are played out without being expanded */
+    limits.num_threads = 1;
+    limits.virtual_loss = 1;
+    limits.max_nodes = 64;
+
+    const bool full = mcts_run(&board, &limits, &info);
+    CCHESS_ASSERT(full);
+
+    CCHESS_ASSERT(info.playouts == TEST_MCTS_NUM_PLAYOUTS && info.num_nodes <= 64);
+    CCHESS_ASSERT(info.pv_length > 0);
+
+    /* No legal move */
+    Board mated = board_from_fen("4R1k1/5ppp/8/8/8/8/5PPP/6K1 b - - 1 1");
+
+    const bool none = mcts_run(&mated, &limits, &info);
+    CCHESS_ASSERT(!none);
+}
+
+static void measure_playouts(const MctsPlayout playout)
+{
+    uint64_t random = 1;
+    uint64_t num_playouts = 0;
+    uint64_t num_plies = 0;
+
+    const uint64_t start = platform_get_time_ns();
+
+    for(size_t i = 0; i < NUM_FENS; i++)
+    {
+        Board board = board_from_fen(fens[i]);
+
+        for(uint32_t j = 0; j < TEST_MCTS_NUM_PLAYOUTS / NUM_FENS; j++)
+        {
+            uint32_t plies;
+            mcts_playout(&board, playout, &random, &plies);
+
+            num_playouts++;
+            num_plies += plies;
+        }
+    }
+
+    const double elapsed = (double)(platform_get_time_ns() - start) / 1e9;
+
+    printf("%s playouts: %.0f playouts/s, %.1f plies per playout, %.2f Mplies/s on one core\n",
+           playout == MctsPlayout_Random ? "random" : "light",
+           (double)num_playouts / elapsed,
+           (double)num_plies / (double)num_playouts,
+           (double)num_plies / elapsed / 1e6);
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    check_playouts();
+
+    check_mate(MctsSelection_Uct);
+    check_mate(MctsSelection_Puct);
+
+    check_threads();
+
+    measure_playouts(MctsPlayout_Random);
+    measure_playouts(MctsPlayout_Light);
+
+    return 0;
+}
@@ -379,6 +379,174 @@ void kings_moves(Board* b)
     }
 }
 
+/* Reference perft positions, covering castling, en passant, promotions and pins */
+typedef struct
+{
+    const char* fen;
+    uint32_t depth;
+    uint64_t nodes;
+} PerftCase;
+
+static const PerftCase perft_cases[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281ULL },
+    { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862ULL },
+    { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624ULL },
+    { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333ULL },
+    { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379ULL },
+    { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3, 89890ULL },
+};
+
+void perft_positions(void)
+{
+    for(size_t i = 0; i < sizeof(perft_cases) / sizeof(perft_cases[0]); i++)
+    {
+        Board b = board_from_fen(perft_cases[i].fen);
+
+        const uint64_t nodes = board_perft(&b, perft_cases[i].depth);
+
+        CCHESS_ASSERT(nodes == perft_cases[i].nodes && "Invalid perft node count");
+    }
+}
+
+/* The noisy moves are exactly the legal captures and promotions, walked over the perft trees */
+static uint64_t noisy_moves_tree(Board* b, const uint32_t depth)
+{
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+    Move noisy_moves[BOARD_MAX_MOVES];
+    size_t num_noisy_moves;
+
+    board_get_legal_moves(b, moves, &num_moves);
+    board_get_legal_noisy_moves(b, noisy_moves, &num_noisy_moves);
+
+    const uint32_t side = BOARD_PTR_GET_SIDE_TO_PLAY(b);
+    size_t num_expected = 0;
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        const bool is_promotion = MOVE_GET_PIECE(moves[i]) != Piece_Pawn &&
+                                  (board_get_pawns(b, side) & (1ULL << MOVE_GET_FROM_SQUARE(moves[i])));
+
+        if(!MOVE_GET_IS_CAPTURING(moves[i]) && !is_promotion)
+        {
+            continue;
+        }
+
+        bool found = false;
+
+        for(size_t j = 0; j < num_noisy_moves && !found; j++)
+        {
+            found = move_equal(moves[i], noisy_moves[j]);
+        }
+
+        CCHESS_ASSERT(found && "Missing noisy move");
+
+        num_expected++;
+    }
+
+    CCHESS_ASSERT(num_noisy_moves == num_expected && "Invalid noisy move count");
+
+    uint64_t num_noisy = num_noisy_moves;
+
+    for(size_t i = 0; depth > 1 && i < num_moves; i++)
+    {
+        Board child = *b;
+        board_make_move(&child, moves[i]);
+
+        num_noisy += noisy_moves_tree(&child, depth - 1);
+    }
+
+    return num_noisy;
+}
+
+void noisy_moves(void)
+{
+    uint64_t num_noisy = 0;
+
+    for(size_t i = 0; i < sizeof(perft_cases) / sizeof(perft_cases[0]); i++)
+    {
+        Board b = board_from_fen(perft_cases[i].fen);
+
+        num_noisy += noisy_moves_tree(&b, 3);
+    }
+
+    CCHESS_ASSERT(num_noisy > 0);
+}
+
+/* The checking moves are exactly the legal moves leaving the enemy king in check */
+static uint64_t checking_moves_tree(Board* b, const uint32_t depth)
+{
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+    Move checks[BOARD_MAX_MOVES];
+    size_t num_checks;
+
+    board_get_legal_moves(b, moves, &num_moves);
+    board_get_legal_checks(b, checks, &num_checks);
+
+    size_t num_expected = 0;
+
+    for(size_t i = 0; i < num_moves; i++)
+    {
+        Board child = *b;
+        board_make_move(&child, moves[i]);
+
+        if(board_get_checkers(&child) == 0ULL)
+        {
+            continue;
+        }
+
+        /* Generated in the order of the legal moves */
+        CCHESS_ASSERT(num_expected < num_checks && move_equal(moves[i], checks[num_expected]) && "Missing checking move");
+
+        num_expected++;
+    }
+
+    CCHESS_ASSERT(num_checks == num_expected && "Invalid checking move count");
+
+    uint64_t num_checking = num_checks;
+
+    for(size_t i = 0; depth > 1 && i < num_moves; i++)
+    {
+        Board child = *b;
+        board_make_move(&child, moves[i]);
+
+        num_checking += checking_moves_tree(&child, depth - 1);
+    }
+
+    return num_checking;
+}
+
+void checking_moves(void)
+{
+    uint64_t num_checking = 0;
+
+    for(size_t i = 0; i < sizeof(perft_cases) / sizeof(perft_cases[0]); i++)
+    {
+        Board b = board_from_fen(perft_cases[i].fen);
+
+        num_checking += checking_moves_tree(&b, 3);
+    }
+
+    /* Castling, en passant and promotion checks, discovered or not */
+    static const char* const fens[] = {
+        "5k2/8/8/8/8/8/8/4K2R w K - 0 1",
+        "8/8/8/1k1pP1R1/8/8/8/4K3 w - d6 0 1",
+        "7k/8/8/K2pP2q/8/8/8/8 w - d6 0 1",
+        "3k4/1P6/8/8/8/8/8/B3K2R w K - 0 1",
+        "1k6/1r6/8/8/8/8/1P1N4/1R2K3 w - - 0 1",
+    };
+
+    for(size_t i = 0; i < sizeof(fens) / sizeof(fens[0]); i++)
+    {
+        Board b = board_from_fen(fens[i]);
+
+        num_checking += checking_moves_tree(&b, 2);
+    }
+
+    CCHESS_ASSERT(num_checking > 0);
+}
+
 int main(int argc, char** argv)
 {
     CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
@@ -395,5 +563,9 @@ int main(int argc, char** argv)
     queens_moves(&b1);
     kings_moves(&b1);
 
+    perft_positions();
+    noisy_moves();
+    checking_moves();
+
     return 0;
 }
\ No newline at end of file
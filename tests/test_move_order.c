@@ -0,0 +1,215 @@
+#include "cchess/move_order.h"
+#include "cchess/search.h"
+#include "cchess/notation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Checks the ranking of captures and promotions, that every move is picked
+    once by decreasing score, the killer, counter and history updates, and
+    that the history stays within its bound
+*/
+
+/* Killers of the plies, kept by the search in its stack */
+static Move _test_killers[16][2];
+
+static Move find_move(Board* board, const char* uci)
+{
+    Move move = move_from_u16(EMPTY_MOVE);
+
+    const bool found = move_from_uci(board, uci, &move) && board_move_is_legal(board, move);
+    CCHESS_ASSERT(found);
+
+    return move;
+}
+
+static void score_all(const MoveOrderTables* tables,
+                      Board* board,
+                      const Move* first_move,
+                      const uint32_t ply,
+                      const Move previous_move,
+                      ScoredMoveList* list)
+{
+    Move moves[BOARD_MAX_MOVES];
+    size_t num_moves;
+
+    board_get_legal_moves(board, moves, &num_moves);
+    move_order_score_moves(tables, board, moves, num_moves, first_move, _test_killers[ply], previous_move, list);
+}
+
+static int32_t score_of(const ScoredMoveList* list, const Move move)
+{
+    for(uint32_t i = 0; i < list->size; i++)
+    {
+        if(move_equal(scored_move_get_move(list->moves[i]), move))
+        {
+            return scored_move_get_score(list->moves[i]);
+        }
+    }
+
+    return INT32_MIN;
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    /* Packing keeps the order of the scores, negative ones included */
+    const Move some_move = move_from_u16(0xFFFF);
+    CCHESS_ASSERT(scored_move_get_score(scored_move_make(some_move, -300)) == -300);
+    CCHESS_ASSERT(move_equal(scored_move_get_move(scored_move_make(some_move, -300)), some_move));
+    CCHESS_ASSERT(scored_move_make(some_move, -300) < scored_move_make(move_from_u16(0), -299));
+    CCHESS_ASSERT(scored_move_make(move_from_u16(0), 20) > scored_move_make(some_move, 19));
+
+    MoveOrderTables* tables = (MoveOrderTables*)malloc(sizeof(MoveOrderTables));
+    move_order_clear(tables);
+
+    /* The queen is taken first, by the least valuable attacker */
+    Board board = board_from_fen("3r3k/5B2/8/3q4/2P5/4N3/7K/3R4 w - - 0 1");
+
+    const Move pawn_takes_queen = find_move(&board, "c4d5");
+    const Move knight_takes_queen = find_move(&board, "e3d5");
+    const Move bishop_takes_queen = find_move(&board, "f7d5");
+    const Move rook_takes_queen = find_move(&board, "d1d5");
+
+    CCHESS_ASSERT(move_order_mvv_lva(&board, pawn_takes_queen) > move_order_mvv_lva(&board, knight_takes_queen));
+    CCHESS_ASSERT(move_order_mvv_lva(&board, knight_takes_queen) > move_order_mvv_lva(&board, bishop_takes_queen));
+    CCHESS_ASSERT(move_order_mvv_lva(&board, bishop_takes_queen) > move_order_mvv_lva(&board, rook_takes_queen));
+
+    ScoredMoveList list;
+    score_all(tables, &board, NULL, 0, move_from_u16(EMPTY_MOVE), &list);
+
+    Move move;
+    int32_t previous_score = INT32_MAX;
+    uint32_t num_picked = 0;
+    uint32_t num_captures = 0;
+    bool quiet_picked = false;
+
+    while(move_order_pick(&list, &move))
+    {
+        const int32_t score = scored_move_get_score(list.moves[list.next - 1]);
+        CCHESS_ASSERT(score <= previous_score);
+        previous_score = score;
+
+        /* Captures come before the quiet moves */
+        const bool is_quiet = move_order_is_quiet(&board, move);
+        CCHESS_ASSERT(is_quiet || !quiet_picked);
+
+        quiet_picked |= is_quiet;
+        num_captures += !is_quiet;
+
+        if(num_picked == 0)
+        {
+            CCHESS_ASSERT(move_equal(move, pawn_takes_queen));
+        }
+
+        num_picked++;
+    }
+
+    CCHESS_ASSERT(num_picked == list.size && num_captures == 4);
+
+    /* Every move is picked once */
+    for(uint32_t i = 0; i < list.size; i++)
+    {
+        for(uint32_t j = i + 1; j < list.size; j++)
+        {
+            CCHESS_ASSERT(!move_equal(scored_move_get_move(list.moves[i]), scored_move_get_move(list.moves[j])));
+        }
+    }
+
+    /* The first move beats the captures, a queen promotion ranks with the captures of a queen */
+    const Move quiet_move = find_move(&board, "h2g1");
+
+    score_all(tables, &board, &quiet_move, 0, move_from_u16(EMPTY_MOVE), &list);
+    const bool picked = move_order_pick(&list, &move);
+    CCHESS_ASSERT(picked && move_equal(move, quiet_move));
+
+    Board promotion = board_from_fen("1n5k/P7/8/8/8/8/8/7K w - - 0 1");
+    const Move to_queen = find_move(&promotion, "a7a8q");
+    const Move takes_to_queen = find_move(&promotion, "a7b8q");
+    const Move to_knight = find_move(&promotion, "a7a8n");
+
+    CCHESS_ASSERT(move_order_mvv_lva(&promotion, takes_to_queen) > move_order_mvv_lva(&promotion, to_queen));
+    CCHESS_ASSERT(move_order_mvv_lva(&promotion, to_queen) > move_order_mvv_lva(&promotion, to_knight));
+    CCHESS_ASSERT(!move_order_is_quiet(&promotion, to_knight));
+
+    /* Killers, counter move and history */
+    Board start = board_init();
+    const Move e2e4 = find_move(&start, "e2e4");
+    const Move g1f3 = find_move(&start, "g1f3");
+    const Move b1c3 = find_move(&start, "b1c3");
+    const Move d2d4 = find_move(&start, "d2d4");
+    const Move a2a3 = find_move(&start, "a2a3");
+
+    const Move tried[] = { a2a3 };
+
+    move_order_update_quiet(tables, &start, _test_killers[3], 6, g1f3, tried, 1, move_from_u16(EMPTY_MOVE));
+    move_order_update_quiet(tables, &start, _test_killers[3], 6, e2e4, NULL, 0, move_from_u16(EMPTY_MOVE));
+
+    score_all(tables, &start, NULL, 3, move_from_u16(EMPTY_MOVE), &list);
+    CCHESS_ASSERT(score_of(&list, e2e4) == MOVE_ORDER_SCORE_KILLER_1);
+    CCHESS_ASSERT(score_of(&list, g1f3) == MOVE_ORDER_SCORE_KILLER_2);
+    CCHESS_ASSERT(score_of(&list, a2a3) < 0 && score_of(&list, d2d4) == 0);
+
+    /* Killers are per ply, the history is not */
+    score_all(tables, &start, NULL, 4, move_from_u16(EMPTY_MOVE), &list);
+    CCHESS_ASSERT(score_of(&list, e2e4) > 0 && score_of(&list, e2e4) < MOVE_ORDER_SCORE_COUNTER);
+
+    /* The counter move answers the previous move */
+    Board after_e4 = start;
+    board_make_move(&after_e4, e2e4);
+
+    const Move e7e5 = find_move(&after_e4, "e7e5");
+    const Move d7d5 = find_move(&after_e4, "d7d5");
+
+    move_order_update_quiet(tables, &after_e4, _test_killers[10], 2, e7e5, NULL, 0, e2e4);
+
+    score_all(tables, &after_e4, NULL, 11, e2e4, &list);
+    CCHESS_ASSERT(score_of(&list, e7e5) == MOVE_ORDER_SCORE_COUNTER);
+    score_all(tables, &after_e4, NULL, 11, move_from_u16(EMPTY_MOVE), &list);
+    CCHESS_ASSERT(score_of(&list, e7e5) < MOVE_ORDER_SCORE_COUNTER);
+    CCHESS_ASSERT(score_of(&list, d7d5) == 0);
+
+    /* The history saturates within its bound */
+    for(uint32_t i = 0; i < 10000; i++)
+    {
+        move_order_update_quiet(tables, &start, _test_killers[0], 40, b1c3, tried, 1, move_from_u16(EMPTY_MOVE));
+    }
+
+    const int16_t high = tables->history[0][MOVE_GET_FROM_SQUARE(b1c3)][MOVE_GET_TO_SQUARE(b1c3)];
+    const int16_t low = tables->history[0][MOVE_GET_FROM_SQUARE(a2a3)][MOVE_GET_TO_SQUARE(a2a3)];
+
+    printf("Saturated history: %d and %d\n", high, low);
+
+    CCHESS_ASSERT(high > 0 && high <= MOVE_ORDER_HISTORY_MAX);
+    CCHESS_ASSERT(low < 0 && low >= -MOVE_ORDER_HISTORY_MAX);
+
+    free(tables);
+
+    /* Nodes needed by the search with this ordering */
+    static const char* const fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8",
+    };
+
+    for(size_t i = 0; i < sizeof(fens) / sizeof(fens[0]); i++)
+    {
+        Board position = board_from_fen(fens[i]);
+
+        SearchLimits limits;
+        search_limits_init(&limits);
+        limits.max_depth = 6;
+
+        SearchInfo info;
+        bool searched = search_run(&position, &limits, &info);
+        CCHESS_ASSERT(searched);
+
+        printf("Depth %u: %llu nodes, score %d\n", info.depth, (unsigned long long)info.nodes, info.score);
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "cchess/move_stack.h"
+#include "cchess/notation.h"
+
+#include <stdio.h>
+
+/*
+    Checks that the moves of consecutive plies are packed in the arena and
+    popped back, and that perft, walking its tree on the arena, still finds
+    the known leaf counts
+*/
+
+#define TEST_NUM_PLIES 6
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    MoveStack stack;
+    const bool initialized = move_stack_init(&stack, TEST_NUM_PLIES * BOARD_MAX_MOVES);
+    CCHESS_ASSERT(initialized);
+
+    Board boards[TEST_NUM_PLIES + 1];
+    Move* plies[TEST_NUM_PLIES];
+    size_t num_moves[TEST_NUM_PLIES];
+
+    boards[0] = board_init();
+
+    /* Plays the first move of each ply, the next ply starting right after the moves of the previous one */
+    for(size_t i = 0; i < TEST_NUM_PLIES; i++)
+    {
+        plies[i] = move_stack_top(&stack);
+        board_get_legal_moves(&boards[i], plies[i], &num_moves[i]);
+        move_stack_push(&stack, num_moves[i]);
+
+        CCHESS_ASSERT(num_moves[i] > 0);
+        CCHESS_ASSERT(i == 0 || plies[i] == plies[i - 1] + num_moves[i - 1]);
+
+        boards[i + 1] = boards[i];
+        board_make_move(&boards[i + 1], plies[i][0]);
+    }
+
+    printf("%zu moves for %d plies in the arena, %zu bytes\n", stack.size, TEST_NUM_PLIES, stack.size * sizeof(Move));
+
+    CCHESS_ASSERT(stack.size < 2 * BOARD_MAX_MOVES);
+
+    /* The moves of the first ply are untouched by the deeper ones */
+    Move first_moves[BOARD_MAX_MOVES];
+    size_t num_first_moves;
+    board_get_legal_moves(&boards[0], first_moves, &num_first_moves);
+
+    CCHESS_ASSERT(num_first_moves == num_moves[0] && memcmp(first_moves, plies[0], num_first_moves * sizeof(Move)) == 0);
+
+    for(size_t i = TEST_NUM_PLIES; i > 0; i--)
+    {
+        move_stack_pop(&stack, num_moves[i - 1]);
+    }
+
+    CCHESS_ASSERT(stack.size == 0 && move_stack_top(&stack) == plies[0]);
+
+    move_stack_release(&stack);
+
+    /* Kiwipete */
+    Board kiwipete = board_from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+    CCHESS_ASSERT(board_perft(&kiwipete, 0) == 1);
+    CCHESS_ASSERT(board_perft(&kiwipete, 1) == 48);
+    CCHESS_ASSERT(board_perft(&kiwipete, 3) == 97862);
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include "cchess/nnue.h"
+#include "cchess/search.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Runs random networks of both feature sets through save and load, then
+    plays random games checking the incremental accumulators against a full
+    computation after every push and pop, and the AVX2 kernels against the
+    scalar ones
+*/
+
+static const char* const fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+};
+
+#define NUM_FENS (sizeof(fens) / sizeof(fens[0]))
+
+#define TEST_NNUE_NUM_GAMES 20
+#define TEST_NNUE_MAX_PLIES 120
+
+#define BENCH_NUM_EVALS 10000
+
+static uint64_t splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static bool accumulator_is_valid(const Nnue* nnue, const NnueStack* stack, const Board* board)
+{
+    int16_t values[NNUE_L1_SIZE];
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        nnue_compute_accumulator(nnue, board, side, values);
+
+        if(memcmp(values, stack->accumulators[stack->size - 1].values[side], sizeof(values)) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void check_network(const NnueFeatureSet feature_set, const char* path)
+{
+    Nnue random_nnue;
+    bool initialized = nnue_init_random(&random_nnue, feature_set, 42);
+    CCHESS_ASSERT(initialized);
+
+    bool saved = nnue_save(&random_nnue, path);
+    CCHESS_ASSERT(saved);
+
+    Nnue nnue;
+    bool loaded = nnue_load(&nnue, path);
+    CCHESS_ASSERT(loaded);
+    CCHESS_ASSERT(nnue.feature_set == feature_set && nnue.num_features == random_nnue.num_features);
+    CCHESS_ASSERT(memcmp(nnue.ft_weights, random_nnue.ft_weights, nnue.ft_weights_size) == 0);
+    CCHESS_ASSERT(memcmp(nnue.l1_weights, random_nnue.l1_weights, sizeof(nnue.l1_weights)) == 0);
+    CCHESS_ASSERT(nnue.output_bias == random_nnue.output_bias);
+
+    nnue_release(&random_nnue);
+
+    printf("%s: %zu bytes of feature weights, huge pages: %s, simd: %s\n",
+           feature_set == NnueFeatureSet_HalfKP ? "HalfKP" : "HalfKA",
+           nnue.ft_weights_size,
+           nnue.huge_pages ? "yes" : "no",
+           nnue.use_simd ? "yes" : "no");
+
+    NnueStack* stack = (NnueStack*)calloc(1, sizeof(NnueStack));
+    Board* boards = (Board*)platform_alloc_aligned((TEST_NNUE_MAX_PLIES + 1) * sizeof(Board), BOARD_ALIGNMENT);
+
+    uint64_t state = 0;
+    uint64_t num_pushes = 0;
+    uint64_t num_invalid = 0;
+    uint64_t num_simd_mismatches = 0;
+    int32_t min_score = INT32_MAX;
+    int32_t max_score = INT32_MIN;
+
+    for(uint32_t game = 0; game < TEST_NNUE_NUM_GAMES; game++)
+    {
+        boards[0] = board_from_fen(fens[game % NUM_FENS]);
+        nnue_stack_reset(&nnue, stack, &boards[0]);
+
+        uint32_t ply = 0;
+
+        while(ply < TEST_NNUE_MAX_PLIES)
+        {
+            Move moves[BOARD_MAX_MOVES];
+            size_t num_moves;
+
+            board_get_legal_moves(&boards[ply], moves, &num_moves);
+
+            if(num_moves == 0)
+            {
+                break;
+            }
+
+            boards[ply + 1] = boards[ply];
+            board_make_move(&boards[ply + 1], moves[splitmix64(&state) % num_moves]);
+
+            nnue_stack_push(&nnue, stack, &boards[ply], &boards[ply + 1]);
+            ply++;
+            num_pushes++;
+
+            num_invalid += !accumulator_is_valid(&nnue, stack, &boards[ply]);
+
+            const int32_t score = nnue_evaluate(&nnue, stack, &boards[ply]);
+
+            if(nnue.use_simd)
+            {
+                nnue.use_simd = false;
+                num_simd_mismatches += nnue_evaluate(&nnue, stack, &boards[ply]) != score;
+                nnue.use_simd = true;
+            }
+
+            min_score = score < min_score ? score : min_score;
+            max_score = score > max_score ? score : max_score;
+        }
+
+        /* Back to the root */
+        while(ply > 0)
+        {
+            nnue_stack_pop(stack);
+            ply--;
+
+            num_invalid += !accumulator_is_valid(&nnue, stack, &boards[ply]);
+        }
+    }
+
+    printf("%llu pushes, %llu invalid accumulators, %llu simd mismatches, scores in [%d, %d]\n",
+           (unsigned long long)num_pushes,
+           (unsigned long long)num_invalid,
+           (unsigned long long)num_simd_mismatches,
+           min_score,
+           max_score);
+
+    CCHESS_ASSERT(num_invalid == 0);
+    CCHESS_ASSERT(num_simd_mismatches == 0);
+    CCHESS_ASSERT(min_score < max_score);
+
+    /* Push and evaluate, with the enabled and the scalar kernels */
+    Board start = board_init();
+    Board after = start;
+    board_make_move_algebraic(&after, "g1f3");
+
+    for(uint32_t simd = 0; simd < 2; simd++)
+    {
+        const bool use_simd = nnue.use_simd;
+        nnue.use_simd = simd == 0 && use_simd;
+
+        nnue_stack_reset(&nnue, stack, &start);
+
+        int64_t sum = 0;
+        const uint64_t time_start = platform_get_time_ns();
+
+        for(uint32_t i = 0; i < BENCH_NUM_EVALS; i++)
+        {
+            nnue_stack_push(&nnue, stack, &start, &after);
+            sum += nnue_evaluate(&nnue, stack, &after);
+            nnue_stack_pop(stack);
+        }
+
+        const uint64_t elapsed_ns = platform_get_time_ns() - time_start;
+
+        printf("%s kernels: %.1f ns per push and evaluation (sum %lld)\n",
+               nnue.use_simd ? "AVX2" : "Scalar",
+               (double)elapsed_ns / BENCH_NUM_EVALS,
+               (long long)sum);
+
+        nnue.use_simd = use_simd;
+    }
+
+    /* Search with the network */
+    SearchLimits limits;
+    search_limits_init(&limits);
+    limits.max_depth = 4;
+    limits.nnue = &nnue;
+
+    SearchInfo info;
+    bool searched = search_run(&start, &limits, &info);
+    CCHESS_ASSERT(searched);
+    CCHESS_ASSERT(info.depth == 4 && board_move_is_legal(&start, info.pv[0]));
+
+    platform_free_aligned(boards);
+    free(stack);
+    nnue_release(&nnue);
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    check_network(NnueFeatureSet_HalfKP, "halfkp.nnue");
+    check_network(NnueFeatureSet_HalfKA, "halfka.nnue");
+
+    /* Truncated file */
+    FILE* file = fopen("truncated.nnue", "wb");
+    CCHESS_ASSERT(file != NULL);
+
+    NnueHeader header;
+    memset(&header, 0, sizeof(NnueHeader));
+    header.magic = NNUE_MAGIC;
+    header.version = NNUE_VERSION;
+    header.l1_size = NNUE_L1_SIZE;
+    header.l2_size = NNUE_L2_SIZE;
+    header.l3_size = NNUE_L3_SIZE;
+
+    fwrite(&header, sizeof(NnueHeader), 1, file);
+    fclose(file);
+
+    Nnue nnue;
+    bool loaded = nnue_load(&nnue, "truncated.nnue");
+    CCHESS_ASSERT(!loaded);
+
+    loaded = nnue_load(&nnue, "missing.nnue");
+    CCHESS_ASSERT(!loaded);
+
+    remove("halfkp.nnue");
+    remove("halfka.nnue");
+    remove("truncated.nnue");
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+#include "cchess/notation.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Verifies move text conversions, and that the special moves they produce
+    are played correctly
+*/
+
+typedef struct
+{
+    const char* fen;
+    const char* move;
+    const char* fen_after;
+    bool is_legal;
+} NotationTestCase;
+
+static const NotationTestCase uci_cases[] = {
+    {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "e2e4",
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+        true,
+    },
+    {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "e1g1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R4RK1 b kq - 1 1",
+        true,
+    },
+    {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1",
+        "e8c8",
+        "2kr3r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQ - 1 2",
+        true,
+    },
+    {
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "e5f6",
+        "rnbqkbnr/ppp1p1pp/5P2/3p4/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 3",
+        true,
+    },
+    {
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+        "g2h1q",
+        "n1n5/PPPk4/8/8/8/8/4Kp1p/5N1q w - - 0 2",
+        true,
+    },
+    {
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1",
+        "b7c8n",
+        "n1N5/P1Pk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+        true,
+    },
+    /* Castling through an attacked square */
+    {
+        "r3k2r/8/8/8/8/8/8/R3K1r1 w KQkq - 0 1",
+        "e1c1",
+        NULL,
+        false,
+    },
+    /* The knight is pinned */
+    {
+        "4k3/4r3/8/8/8/8/4N3/4K3 w - - 0 1",
+        "e2c3",
+        NULL,
+        false,
+    },
+    /* En passant uncovering a check on the rank */
+    {
+        "8/8/8/K2pP2r/8/8/8/7k w - d6 0 1",
+        "e5d6",
+        NULL,
+        false,
+    },
+};
+
+static const NotationTestCase san_cases[] = {
+    {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "Nf3",
+        "rnbqkbnr/pppppppp/8/8/8/5N2/PPPPPPPP/RNBQKB1R b KQkq - 1 1",
+        true,
+    },
+    {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1",
+        "O-O-O",
+        "2kr3r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQ - 1 2",
+        true,
+    },
+    {
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "exf6",
+        "rnbqkbnr/ppp1p1pp/5P2/3p4/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 3",
+        true,
+    },
+    {
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+        "gxh1=Q",
+        "n1n5/PPPk4/8/8/8/8/4Kp1p/5N1q w - - 0 2",
+        true,
+    },
+    {
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1",
+        "bxc8=N",
+        "n1N5/P1Pk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+        true,
+    },
+    /* Disambiguation by file, rank, and both */
+    {
+        "1k6/8/8/8/4Q2Q/8/K7/4Q3 w - - 0 1",
+        "Qe4h1",
+        "1k6/8/8/8/7Q/8/K7/4Q2Q b - - 1 1",
+        true,
+    },
+    {
+        "1k6/8/8/8/4Q2Q/8/K7/4Q3 w - - 0 1",
+        "Qhh1",
+        "1k6/8/8/8/4Q3/8/K7/4Q2Q b - - 1 1",
+        true,
+    },
+    {
+        "1k6/8/8/8/4Q2Q/8/K7/4Q3 w - - 0 1",
+        "Q1h1",
+        "1k6/8/8/8/4Q2Q/8/K7/7Q b - - 1 1",
+        true,
+    },
+    /* The knight on c3 is pinned, Ne2 is not ambiguous */
+    {
+        "4k3/8/8/b7/8/2N5/8/4K1N1 w - - 0 1",
+        "Ne2",
+        "4k3/8/8/b7/8/2N5/4N3/4K3 b - - 1 1",
+        true,
+    },
+    /* Castling through an attacked square */
+    {
+        "r3k2r/8/8/8/8/8/8/R3K1r1 w KQkq - 0 1",
+        "O-O-O",
+        NULL,
+        false,
+    },
+};
+
+/* Opera game, Morphy - Duke Karl / Count Isouard, Paris 1858 */
+static const char* opera_game[] = {
+    "e4", "e5", "Nf3", "d6", "d4", "Bg4", "dxe5", "Bxf3", "Qxf3", "dxe5",
+    "Bc4", "Nf6", "Qb3", "Qe7", "Nc3", "c6", "Bg5", "b5", "Nxb5", "cxb5",
+    "Bxb5+", "Nbd7", "O-O-O", "Rd8", "Rxd7", "Rxd7", "Rd1", "Qe6", "Bxd7+", "Nxd7",
+    "Qb8+", "Nxb8", "Rd8#",
+};
+
+#define OPERA_GAME_NUM_MOVES (sizeof(opera_game) / sizeof(opera_game[0]))
+
+#define BENCH_NUM_ITERATIONS 1000000
+
+#define BENCH_SAN_NUM_GAMES 20000
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    char fen[BOARD_FEN_MAX_SIZE];
+    char uci[MOVE_UCI_MAX_SIZE];
+
+    for(size_t i = 0; i < sizeof(uci_cases) / sizeof(uci_cases[0]); i++)
+    {
+        const NotationTestCase* test_case = &uci_cases[i];
+
+        Board b = board_from_fen(test_case->fen);
+
+        Move move;
+        const bool parsed = move_from_uci(&b, test_case->move, &move);
+        CCHESS_ASSERT(parsed);
+
+        CCHESS_ASSERT(board_move_is_legal(&b, move) == test_case->is_legal);
+
+        move_to_uci(&b, move, uci);
+
+        CCHESS_ASSERT(strcmp(uci, test_case->move) == 0 && "UCI move does not round-trip");
+
+        if(test_case->fen_after != NULL)
+        {
+            board_make_move(&b, move);
+            board_to_fen(&b, fen);
+
+            printf("%s %s\n", test_case->move, fen);
+
+            CCHESS_ASSERT(strcmp(fen, test_case->fen_after) == 0 && "Invalid position after the move");
+        }
+    }
+
+    Board b = board_init();
+    Move move;
+
+    static const char* const invalid_uci[] = { "e3e4", "e2", "i2i4", "0000" };
+
+    for(size_t i = 0; i < sizeof(invalid_uci) / sizeof(invalid_uci[0]); i++)
+    {
+        const bool invalid_parsed = move_from_uci(&b, invalid_uci[i], &move);
+        CCHESS_ASSERT(!invalid_parsed);
+    }
+
+    /* Promotions need the promoted piece */
+    Board b_promotion = board_from_fen("n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1");
+    const bool promotion_parsed = move_from_uci(&b_promotion, "b7c8", &move);
+    CCHESS_ASSERT(!promotion_parsed);
+
+    char san[MOVE_SAN_MAX_SIZE];
+
+    for(size_t i = 0; i < sizeof(san_cases) / sizeof(san_cases[0]); i++)
+    {
+        const NotationTestCase* test_case = &san_cases[i];
+
+        Board b = board_from_fen(test_case->fen);
+
+        Move move;
+        const bool parsed = move_from_san(&b, test_case->move, &move);
+        CCHESS_ASSERT(parsed);
+
+        CCHESS_ASSERT(board_move_is_legal(&b, move) == test_case->is_legal);
+        CCHESS_ASSERT(board_move_is_legal_algebraic(&b, test_case->move) == test_case->is_legal);
+
+        if(test_case->fen_after != NULL)
+        {
+            move_to_san(&b, move, san);
+
+            CCHESS_ASSERT(strcmp(san, test_case->move) == 0 && "SAN move does not round-trip");
+
+            const bool played = board_make_move_algebraic(&b, test_case->move);
+            CCHESS_ASSERT(played);
+            board_to_fen(&b, fen);
+
+            printf("%s %s\n", test_case->move, fen);
+
+            CCHESS_ASSERT(strcmp(fen, test_case->fen_after) == 0 && "Invalid position after the move");
+        }
+        else
+        {
+            const bool played = board_make_move_algebraic(&b, test_case->move);
+            CCHESS_ASSERT(!played);
+        }
+    }
+
+    /* Full game, every move written back must match the score, check and mate included */
+    Board game = board_init();
+
+    for(size_t i = 0; i < OPERA_GAME_NUM_MOVES; i++)
+    {
+        Move move;
+        const bool parsed = move_from_san(&game, opera_game[i], &move);
+        CCHESS_ASSERT(parsed);
+        CCHESS_ASSERT(board_move_is_legal(&game, move));
+
+        move_to_san(&game, move, san);
+
+        CCHESS_ASSERT(strcmp(san, opera_game[i]) == 0 && "SAN move does not round-trip");
+
+        board_make_move(&game, move);
+    }
+
+    CCHESS_ASSERT(board_has_mate(&game));
+
+    Board b_san = board_init();
+
+    static const char* const invalid_san[] = { "e5", "Nd2", "Ke2", "e", "O-X", "0ab-c", "O-0", "OOO", "O-O-0" };
+
+    for(size_t i = 0; i < sizeof(invalid_san) / sizeof(invalid_san[0]); i++)
+    {
+        const bool invalid_parsed = move_from_san(&b_san, invalid_san[i], &move);
+        CCHESS_ASSERT(!invalid_parsed);
+    }
+
+    const bool annotated_parsed = move_from_san(&b_san, "e4!? ", &move);
+    CCHESS_ASSERT(annotated_parsed);
+
+    /* Castling with letters or zeros, followed or not by a check */
+    Board b_castling = board_from_fen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+
+    static const char* const castling_san[] = { "O-O", "0-0", "O-O-O+", "0-0-0#" };
+
+    for(size_t i = 0; i < sizeof(castling_san) / sizeof(castling_san[0]); i++)
+    {
+        const bool castling_parsed = move_from_san(&b_castling, castling_san[i], &move);
+        CCHESS_ASSERT(castling_parsed && MOVE_GET_TO_SQUARE(move) == (i < 2 ? 6U : 2U));
+    }
+
+    /* Ambiguous without disambiguation */
+    Board b_ambiguous = board_from_fen("1k6/8/8/8/4Q2Q/8/K7/4Q3 w - - 0 1");
+
+    static const char* const ambiguous_san[] = { "Qh1", "Qeh1" };
+
+    for(size_t i = 0; i < sizeof(ambiguous_san) / sizeof(ambiguous_san[0]); i++)
+    {
+        const bool ambiguous_parsed = move_from_san(&b_ambiguous, ambiguous_san[i], &move);
+        CCHESS_ASSERT(!ambiguous_parsed);
+    }
+
+    uint64_t start = platform_get_time_ns();
+    size_t total_length = 0;
+
+    for(size_t i = 0; i < BENCH_SAN_NUM_GAMES; i++)
+    {
+        Board bench = board_init();
+
+        for(size_t j = 0; j < OPERA_GAME_NUM_MOVES; j++)
+        {
+            total_length += board_make_move_algebraic(&bench, opera_game[j]);
+        }
+    }
+
+    printf("SAN parsing and playing: %.0f moves/s (%zu)\n",
+           (double)(BENCH_SAN_NUM_GAMES * OPERA_GAME_NUM_MOVES) * 1e9 / (double)(platform_get_time_ns() - start),
+           total_length);
+
+    start = platform_get_time_ns();
+    total_length = 0;
+
+    for(size_t i = 0; i < BENCH_NUM_ITERATIONS; i++)
+    {
+        move_from_uci(&b, (i & 1) ? "g1f3" : "e2e4", &move);
+        total_length += move_to_uci(&b, move, uci);
+    }
+
+    printf("UCI round-trip: %.1f ns/move (%zu)\n",
+           (double)(platform_get_time_ns() - start) / BENCH_NUM_ITERATIONS,
+           total_length);
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "cchess/packed_board.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Verifies that boards round-trip exactly through the packed format, and
+    compares the decoding speed with FEN parsing
+*/
+
+static const char* const fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "4k3/8/8/8/8/8/8/4K2R b K - 99 250",
+    "Kb1n4/1P2r3/R5Pp/3k4/pp5p/4Pp2/PR2pQn1/1b1Br3 w - - 0 1",
+};
+
+#define NUM_FENS (sizeof(fens) / sizeof(fens[0]))
+
+#define BENCH_NUM_BOARDS 100000
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    for(size_t i = 0; i < NUM_FENS; i++)
+    {
+        Board b = board_from_fen(fens[i]);
+
+        PackedBoard packed;
+        const bool encoded = packed_board_encode(&packed, &b);
+        CCHESS_ASSERT(encoded);
+
+        Board decoded;
+        memset(&decoded, 0xFF, sizeof(Board));
+        packed_board_decode(&decoded, &packed);
+
+        CCHESS_ASSERT(memcmp(&b, &decoded, sizeof(Board)) == 0 && "Board does not round-trip");
+    }
+
+    /* More than 32 pieces can't be packed */
+    Board b_too_many = board_from_fen("k7/PPPPPPPP/PPPPPPPP/PPPPPPPP/PPPPPPPP/8/8/7K w - - 0 1");
+
+    PackedBoard packed_too_many;
+    const bool encoded_too_many = packed_board_encode(&packed_too_many, &b_too_many);
+    CCHESS_ASSERT(!encoded_too_many);
+
+    /* Bulk round-trip */
+    Board* boards = (Board*)platform_alloc_aligned(BENCH_NUM_BOARDS * sizeof(Board), BOARD_ALIGNMENT);
+    Board* decoded = (Board*)platform_alloc_aligned(BENCH_NUM_BOARDS * sizeof(Board), BOARD_ALIGNMENT);
+    PackedBoard* packed = (PackedBoard*)calloc(BENCH_NUM_BOARDS, sizeof(PackedBoard));
+
+    uint64_t start = platform_get_time_ns();
+
+    for(size_t i = 0; i < BENCH_NUM_BOARDS; i++)
+    {
+        board_parse_fen(&boards[i], fens[i % NUM_FENS]);
+    }
+
+    const uint64_t fen_ns = platform_get_time_ns() - start;
+
+    const size_t num_failed = packed_board_encode_bulk(packed, boards, BENCH_NUM_BOARDS);
+    CCHESS_ASSERT(num_failed == 0);
+
+    start = platform_get_time_ns();
+
+    packed_board_decode_bulk(decoded, packed, BENCH_NUM_BOARDS);
+
+    const uint64_t decode_ns = platform_get_time_ns() - start;
+
+    CCHESS_ASSERT(memcmp(boards, decoded, BENCH_NUM_BOARDS * sizeof(Board)) == 0 && "Bulk round-trip failed");
+
+    printf("FEN parsing: %.1f ns/board, packed decoding: %.1f ns/board (%zu bytes vs %zu bytes)\n",
+           (double)fen_ns / BENCH_NUM_BOARDS,
+           (double)decode_ns / BENCH_NUM_BOARDS,
+           sizeof(PackedBoard),
+           sizeof(Board));
+
+    platform_free_aligned(boards);
+    platform_free_aligned(decoded);
+    free(packed);
+
+    return 0;
+}
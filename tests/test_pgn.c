@@ -0,0 +1,206 @@
+#include "cchess/pgn.h"
+#include "cchess/notation.h"
+#include "cchess/zobrist.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Writes a PGN file spanning several parsing chunks and verifies the
+    positions, keys and results given back while replaying its games
+*/
+
+#define TEST_PGN_PATH "test_pgn.pgn"
+#define TEST_PGN_NUM_COPIES 5000
+
+static const char* const pgn_games[] = {
+    "[Event \"Paris\"]\n"
+    "[Site \"Paris FRA\"]\n"
+    "[Date \"1858.??.??\"]\n"
+    "[White \"Paul Morphy\"]\n"
+    "[Black \"Duke Karl / Count Isouard\"]\n"
+    "[Result \"1-0\"]\n"
+    "\n"
+    "1. e4 e5 2. Nf3 d6 3. d4 Bg4 {This is a weak move already.} 4. dxe5 Bxf3 5. Qxf3\n"
+    "dxe5 6. Bc4 Nf6 7. Qb3 Qe7 8. Nc3 c6 9. Bg5 b5 $6 (9... Qb4 10. Qxb4 (10. Bxf6))\n"
+    "10. Nxb5 cxb5 11. Bxb5+ Nbd7 12. O-O-O Rd8 13. Rxd7 Rxd7 14. Rd1 Qe6\n"
+    "15. Bxd7+ Nxd7 16. Qb8+ Nxb8 17. Rd8# 1-0\n"
+    "\n",
+
+    "[Event \"Endgame\"]\n"
+    "[SetUp \"1\"]\n"
+    "[FEN \"4k3/8/8/8/8/8/4P3/4K3 b - - 0 1\"]\n"
+    "\n"
+    "1... Kd7 2.e4 Kd6 1/2-1/2\n"
+    "\n",
+
+    "[Event \"Broken\"]\n"
+    "[Result \"*\"]\n"
+    "\n"
+    "; escaped comment line\n"
+    "1. e4 e5 2. Ke3 Nc6 *\n"
+    "\n",
+};
+
+#define NUM_POSITIONS_PER_COPY (33 + 3 + 2)
+
+typedef struct
+{
+    size_t num_positions;
+    size_t num_white_wins;
+    size_t num_draws;
+    size_t num_unknown;
+    size_t num_start_keys;
+} TestPgnCounts;
+
+static uint64_t start_key;
+
+static void count_position(const PgnPosition* position, void* user_data)
+{
+    TestPgnCounts* counts = (TestPgnCounts*)user_data;
+
+    CCHESS_ASSERT(position->key == zobrist_hash_board(position->board));
+    CCHESS_ASSERT(board_move_is_legal((Board*)position->board, position->move));
+
+#pragma omp atomic
+    counts->num_positions++;
+
+    switch(position->result)
+    {
+        case PgnResult_WhiteWins:
+#pragma omp atomic
+            counts->num_white_wins++;
+            break;
+        case PgnResult_Draw:
+#pragma omp atomic
+            counts->num_draws++;
+            break;
+        default:
+#pragma omp atomic
+            counts->num_unknown++;
+            break;
+    }
+
+    if(position->ply == 0 && position->key == start_key)
+    {
+#pragma omp atomic
+        counts->num_start_keys++;
+    }
+}
+
+typedef struct
+{
+    char moves[64][MOVE_SAN_MAX_SIZE];
+    size_t num_moves;
+} TestPgnMoves;
+
+static void record_move(const PgnPosition* position, void* user_data)
+{
+    TestPgnMoves* moves = (TestPgnMoves*)user_data;
+
+    CCHESS_ASSERT(position->ply == moves->num_moves);
+
+    move_to_san((Board*)position->board, position->move, moves->moves[moves->num_moves++]);
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    Board b = board_init();
+    start_key = zobrist_hash_board(&b);
+
+    /* Transpositions hash the same, the side to play does not */
+    bool played = board_make_move_algebraic(&b, "Nf3");
+    CCHESS_ASSERT(played && zobrist_hash_board(&b) != start_key);
+
+    played = board_make_move_algebraic(&b, "Nf6") &&
+             board_make_move_algebraic(&b, "Ng1") &&
+             board_make_move_algebraic(&b, "Ng8");
+    CCHESS_ASSERT(played && zobrist_hash_board(&b) == start_key);
+
+    /* In memory, single game, moves come back in order */
+    TestPgnMoves moves;
+    memset(&moves, 0, sizeof(TestPgnMoves));
+
+    PgnLoadStats stats;
+    pgn_parse(pgn_games[0], strlen(pgn_games[0]), record_move, &moves, &stats);
+
+    CCHESS_ASSERT(stats.num_games == 1 && stats.num_positions == 33 && stats.num_errors == 0);
+    CCHESS_ASSERT(moves.num_moves == 33);
+    CCHESS_ASSERT(strcmp(moves.moves[5], "Bg4") == 0);
+    CCHESS_ASSERT(strcmp(moves.moves[17], "b5") == 0);
+    CCHESS_ASSERT(strcmp(moves.moves[18], "Nxb5") == 0);
+    CCHESS_ASSERT(strcmp(moves.moves[32], "Rd8#") == 0);
+
+    /* Illegal moves end their game with an error, after the positions before them */
+    static const char* const illegal_games[] = {
+        /* Castling through the bishop and the knight */
+        "1. e4 e5 2. O-O *\n\n",
+        /* Castling without the rights */
+        "[SetUp \"1\"]\n[FEN \"4k3/8/8/8/8/8/8/4K2R w - - 0 1\"]\n\n1. O-O *\n\n",
+        /* Knight pinned by the rook */
+        "[SetUp \"1\"]\n[FEN \"4k3/4r3/8/8/8/8/4N3/4K3 w - - 0 1\"]\n\n1. Nc3 *\n\n",
+        /* Token too long to be a move, black's Ra4 must not be played by the white rook */
+        "[SetUp \"1\"]\n[FEN \"4k3/r7/8/8/8/8/R7/4K3 w - - 0 1\"]\n\n1. Ra3!!!!!!!!!!!!!!! Ra4 *\n\n",
+    };
+
+    static const size_t illegal_num_positions[] = { 2, 0, 0, 0 };
+
+    for(size_t i = 0; i < sizeof(illegal_games) / sizeof(illegal_games[0]); i++)
+    {
+        memset(&moves, 0, sizeof(TestPgnMoves));
+
+        pgn_parse(illegal_games[i], strlen(illegal_games[i]), record_move, &moves, &stats);
+
+        CCHESS_ASSERT(stats.num_games == 1 && stats.num_errors == 1);
+        CCHESS_ASSERT(stats.num_positions == illegal_num_positions[i] && moves.num_moves == illegal_num_positions[i]);
+    }
+
+    FILE* file = fopen(TEST_PGN_PATH, "wb");
+
+    CCHESS_ASSERT(file != NULL && "Cannot write the test PGN file");
+
+    /* Enough copies to span several parsing chunks */
+    for(size_t i = 0; i < TEST_PGN_NUM_COPIES; i++)
+    {
+        for(size_t j = 0; j < sizeof(pgn_games) / sizeof(pgn_games[0]); j++)
+        {
+            fputs(pgn_games[j], file);
+        }
+    }
+
+    fclose(file);
+
+    TestPgnCounts counts;
+    memset(&counts, 0, sizeof(TestPgnCounts));
+
+    const bool loaded = pgn_load(TEST_PGN_PATH, count_position, &counts, &stats);
+    CCHESS_ASSERT(loaded);
+
+    printf("PGN: %zu games, %zu positions, %zu errors, %.0f games/s, %.0f positions/s, %.1f MB/s\n",
+           stats.num_games,
+           stats.num_positions,
+           stats.num_errors,
+           stats.games_per_second,
+           stats.positions_per_second,
+           stats.megabytes_per_second);
+
+    CCHESS_ASSERT(stats.num_games == TEST_PGN_NUM_COPIES * 3);
+    CCHESS_ASSERT(stats.num_errors == TEST_PGN_NUM_COPIES);
+    CCHESS_ASSERT(stats.num_positions == TEST_PGN_NUM_COPIES * NUM_POSITIONS_PER_COPY);
+
+    CCHESS_ASSERT(counts.num_positions == TEST_PGN_NUM_COPIES * NUM_POSITIONS_PER_COPY);
+    CCHESS_ASSERT(counts.num_white_wins == TEST_PGN_NUM_COPIES * 33);
+    CCHESS_ASSERT(counts.num_draws == TEST_PGN_NUM_COPIES * 3);
+    CCHESS_ASSERT(counts.num_unknown == TEST_PGN_NUM_COPIES * 2);
+    CCHESS_ASSERT(counts.num_start_keys == TEST_PGN_NUM_COPIES * 2);
+
+    const bool loaded_missing = pgn_load("does_not_exist.pgn", count_position, &counts, NULL);
+    CCHESS_ASSERT(!loaded_missing);
+
+    remove(TEST_PGN_PATH);
+
+    return 0;
+}
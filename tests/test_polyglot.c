@@ -0,0 +1,264 @@
+#include "cchess/polyglot.h"
+#include "cchess/notation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Checks the keys of the specification test positions with the built-in
+    random values, that other values are not taken for them, then writes a
+    small book and verifies the moves probed from it
+*/
+
+#define TEST_POLYGLOT_PATH "test_polyglot.bin"
+#define TEST_POLYGLOT_NUM_FILLERS 10000
+#define BENCH_NUM_PROBES 1000000
+
+typedef struct
+{
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t order;
+} TestBookEntry;
+
+static uint64_t splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+static uint16_t encode_move(const char* uci, const uint32_t promotion)
+{
+    return (uint16_t)((uci[2] - 'a') | ((uci[3] - '1') << 3) | ((uci[0] - 'a') << 6) | ((uci[1] - '1') << 9) | (promotion << 12));
+}
+
+static int compare_entries(const void* a, const void* b)
+{
+    const TestBookEntry* entry_a = (const TestBookEntry*)a;
+    const TestBookEntry* entry_b = (const TestBookEntry*)b;
+
+    if(entry_a->key != entry_b->key)
+    {
+        return entry_a->key < entry_b->key ? -1 : 1;
+    }
+
+    return (entry_a->order > entry_b->order) - (entry_a->order < entry_b->order);
+}
+
+static void write_entry(FILE* file, const TestBookEntry* entry)
+{
+    uint8_t bytes[16];
+
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        bytes[i] = (uint8_t)(entry->key >> (56 - i * 8));
+    }
+
+    bytes[8] = (uint8_t)(entry->move >> 8);
+    bytes[9] = (uint8_t)entry->move;
+    bytes[10] = (uint8_t)(entry->weight >> 8);
+    bytes[11] = (uint8_t)entry->weight;
+    memset(bytes + 12, 0, 4);
+
+    fwrite(bytes, 1, 16, file);
+}
+
+typedef struct
+{
+    const char* moves[8];
+    uint64_t keys[8];
+} TestKeySequence;
+
+/* Moves played from the starting position and the keys of the positions reached, 0 where the specification gives none */
+static const TestKeySequence key_sequences[2] = {
+    {
+        { "e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7", NULL },
+        { 0x823C9B50FD114196ULL, 0x0756B94461C50FB0ULL, 0x662FAFB965DB29D4ULL, 0x22A48B5A8E47FF78ULL,
+          0x652A607CA3F242C1ULL, 0x00FDD303C946BDD9ULL },
+    },
+    {
+        { "a2a4", "b7b5", "h2h4", "b5b4", "c2c4", "b4c3", "a1a3", NULL },
+        { 0, 0, 0, 0, 0x3C8123EA7B067637ULL, 0, 0x5C3F9B829B279560ULL },
+    },
+};
+
+static void check_keys(void)
+{
+    Board board = board_init();
+    const uint64_t start_key = polyglot_hash_board(&board);
+    CCHESS_ASSERT(start_key == 0x463B96181691FC9CULL);
+
+    for(size_t i = 0; i < 2; i++)
+    {
+        board = board_init();
+
+        for(size_t j = 0; key_sequences[i].moves[j] != NULL; j++)
+        {
+            Move move;
+            const bool found = move_from_uci(&board, key_sequences[i].moves[j], &move) && board_move_is_legal(&board, move);
+            CCHESS_ASSERT(found);
+
+            board_make_move(&board, move);
+
+            const uint64_t key = polyglot_hash_board(&board);
+            CCHESS_ASSERT(key_sequences[i].keys[j] == 0 || key == key_sequences[i].keys[j]);
+        }
+    }
+}
+
+static bool uci_equals(Board* board, const Move move, const char* expected)
+{
+    char uci[MOVE_UCI_MAX_SIZE];
+    move_to_uci(board, move, uci);
+
+    return strcmp(uci, expected) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    check_keys();
+
+    /* Other values are installed but not standard, NULL gives the built-in ones back */
+    uint64_t state = 42;
+    uint64_t random64[POLYGLOT_NUM_RANDOM64];
+
+    for(size_t i = 0; i < POLYGLOT_NUM_RANDOM64; i++)
+    {
+        random64[i] = splitmix64(&state);
+    }
+
+    Board b_initial = board_init();
+    const uint64_t standard_key = polyglot_hash_board(&b_initial);
+
+    const bool is_custom_standard = polyglot_init(random64);
+    CCHESS_ASSERT(!is_custom_standard && polyglot_hash_board(&b_initial) != standard_key);
+
+    const bool is_standard = polyglot_init(NULL);
+    CCHESS_ASSERT(is_standard && polyglot_hash_board(&b_initial) == standard_key);
+
+    /* The en passant file only counts when the capture is possible */
+    Board b_e4 = board_from_fen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+    Board b_e4_no_ep = board_from_fen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+    CCHESS_ASSERT(polyglot_hash_board(&b_e4) == polyglot_hash_board(&b_e4_no_ep));
+
+    Board b_f5 = board_from_fen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3");
+    Board b_f5_no_ep = board_from_fen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 3");
+    CCHESS_ASSERT(polyglot_hash_board(&b_f5) != polyglot_hash_board(&b_f5_no_ep));
+
+    Board b_start = board_init();
+    Board b_castle = board_from_fen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    Board b_promotion = board_from_fen("8/P6k/8/8/8/8/8/K7 w - - 0 1");
+
+    const uint64_t start_key = polyglot_hash_board(&b_start);
+    const uint64_t castle_key = polyglot_hash_board(&b_castle);
+    const uint64_t promotion_key = polyglot_hash_board(&b_promotion);
+
+    const size_t num_entries = TEST_POLYGLOT_NUM_FILLERS + 6;
+
+    TestBookEntry* entries = (TestBookEntry*)calloc(num_entries, sizeof(TestBookEntry));
+
+    for(size_t i = 0; i < TEST_POLYGLOT_NUM_FILLERS; i++)
+    {
+        entries[i].key = splitmix64(&state);
+        entries[i].move = encode_move("a2a3", 0);
+        entries[i].weight = 1;
+    }
+
+    const TestBookEntry book_entries[6] = {
+        { start_key, encode_move("e2e4", 0), 10, 0 },
+        { start_key, encode_move("d2d4", 0), 5, 0 },
+        { start_key, encode_move("g1f3", 0), 1, 0 },
+        { castle_key, encode_move("e1h1", 0), 1, 0 },
+        { castle_key, encode_move("e1a1", 0), 1, 0 },
+        { promotion_key, encode_move("a7a8", 4), 1, 0 },
+    };
+
+    memcpy(entries + TEST_POLYGLOT_NUM_FILLERS, book_entries, sizeof(book_entries));
+
+    /* Moves of a position keep the order they are given in */
+    for(size_t i = 0; i < num_entries; i++)
+    {
+        entries[i].order = (uint32_t)i;
+    }
+
+    qsort(entries, num_entries, sizeof(TestBookEntry), compare_entries);
+
+    FILE* file = fopen(TEST_POLYGLOT_PATH, "wb");
+    CCHESS_ASSERT(file != NULL && "Cannot write the test book");
+
+    for(size_t i = 0; i < num_entries; i++)
+    {
+        write_entry(file, &entries[i]);
+    }
+
+    fclose(file);
+    free(entries);
+
+    PolyglotBook book;
+    const bool opened = polyglot_book_open(&book, TEST_POLYGLOT_PATH);
+
+    CCHESS_ASSERT(opened && book.num_entries == num_entries);
+
+    PolyglotMove moves[8];
+
+    size_t num_found = polyglot_book_probe(&book, &b_start, moves, 8);
+
+    CCHESS_ASSERT(num_found == 3);
+    CCHESS_ASSERT(uci_equals(&b_start, moves[0].move, "e2e4") && moves[0].weight == 10);
+    CCHESS_ASSERT(uci_equals(&b_start, moves[1].move, "d2d4") && moves[1].weight == 5);
+    CCHESS_ASSERT(uci_equals(&b_start, moves[2].move, "g1f3") && moves[2].weight == 1);
+    CCHESS_ASSERT(MOVE_GET_PIECE(moves[2].move) == Piece_Knight);
+
+    num_found = polyglot_book_probe(&book, &b_castle, moves, 8);
+
+    CCHESS_ASSERT(num_found == 2);
+    CCHESS_ASSERT(uci_equals(&b_castle, moves[0].move, "e1g1"));
+    CCHESS_ASSERT(uci_equals(&b_castle, moves[1].move, "e1c1"));
+    CCHESS_ASSERT(board_move_is_legal(&b_castle, moves[0].move) && board_move_is_legal(&b_castle, moves[1].move));
+
+    num_found = polyglot_book_probe(&book, &b_promotion, moves, 8);
+
+    CCHESS_ASSERT(num_found == 1 && uci_equals(&b_promotion, moves[0].move, "a7a8q"));
+
+    CCHESS_ASSERT(polyglot_book_probe(&book, &b_e4, moves, 8) == 0);
+
+    /* Weighted picks, 10/16 e2e4, 5/16 d2d4, 1/16 g1f3 */
+    Move move;
+    bool picked = polyglot_book_pick_move(&book, &b_start, 9, &move);
+    CCHESS_ASSERT(picked && uci_equals(&b_start, move, "e2e4"));
+
+    picked = polyglot_book_pick_move(&book, &b_start, 16 + 10, &move);
+    CCHESS_ASSERT(picked && uci_equals(&b_start, move, "d2d4"));
+
+    picked = polyglot_book_pick_move(&book, &b_start, 15, &move);
+    CCHESS_ASSERT(picked && uci_equals(&b_start, move, "g1f3"));
+
+    picked = polyglot_book_pick_move(&book, &b_e4, 0, &move);
+    CCHESS_ASSERT(!picked);
+
+    uint64_t start = platform_get_time_ns();
+    size_t total_found = 0;
+
+    for(size_t i = 0; i < BENCH_NUM_PROBES; i++)
+    {
+        total_found += polyglot_book_probe(&book, (i & 1) ? &b_start : &b_castle, moves, 8);
+    }
+
+    printf("Polyglot probe: %.1f ns/probe (%zu)\n",
+           (double)(platform_get_time_ns() - start) / BENCH_NUM_PROBES,
+           total_found);
+
+    polyglot_book_close(&book);
+
+    remove(TEST_POLYGLOT_PATH);
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "cchess/search.h"
+#include "cchess/notation.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+    uint32_t num_calls;
+    uint32_t last_depth;
+    bool pv_is_legal;
+    Board board;
+} TestSearchReport;
+
+static void report_iteration(const SearchInfo* info, void* user_data)
+{
+    TestSearchReport* report = (TestSearchReport*)user_data;
+
+    report->pv_is_legal &= info->depth == report->last_depth + 1 && info->pv_length > 0;
+    report->last_depth = info->depth;
+    report->num_calls++;
+
+    Board board = report->board;
+
+    for(uint32_t i = 0; i < info->pv_length; i++)
+    {
+        report->pv_is_legal &= board_move_is_legal(&board, info->pv[i]);
+        board_make_move(&board, info->pv[i]);
+    }
+}
+
+static bool best_move_is(Board* board, const SearchLimits* limits, const char* expected, int32_t* score)
+{
+    SearchInfo info;
+
+    if(!search_run(board, limits, &info))
+    {
+        return false;
+    }
+
+    char uci[MOVE_UCI_MAX_SIZE];
+    move_to_uci(board, info.pv[0], uci);
+
+    *score = info.score;
+
+    return strcmp(uci, expected) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    SearchLimits limits;
+    search_limits_init(&limits);
+    limits.max_depth = 5;
+
+    int32_t score = 0;
+
+    /* Back rank mate */
+    Board mate_in_one = board_from_fen("6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+    bool found = best_move_is(&mate_in_one, &limits, "a1a8", &score);
+    CCHESS_ASSERT(found);
+    CCHESS_ASSERT(score == SEARCH_SCORE_MATE - 1);
+
+    SearchInfo info;
+
+    /* Hanging queen */
+    Board hanging_queen = board_from_fen("4k3/8/8/3q4/8/8/8/3QK3 w - - 0 1");
+    found = best_move_is(&hanging_queen, &limits, "d1d5", &score);
+    CCHESS_ASSERT(found);
+    CCHESS_ASSERT(score >= 800);
+
+    /* Defended pawn, taking it loses the queen after the horizon of a one ply search */
+    Board defended_pawn = board_from_fen("4k3/8/4p3/3p4/8/8/8/3QK3 w - - 0 1");
+
+    limits.max_depth = 1;
+    bool searched = search_run(&defended_pawn, &limits, &info);
+    CCHESS_ASSERT(searched);
+
+    char uci[MOVE_UCI_MAX_SIZE];
+    move_to_uci(&defended_pawn, info.pv[0], uci);
+    CCHESS_ASSERT(strcmp(uci, "d1d5") != 0 && info.score > 500);
+    CCHESS_ASSERT(info.quiescence_nodes > 0 && info.quiescence_nodes < info.nodes);
+
+    limits.max_depth = 5;
+
+    /* No legal move */
+    Board stalemate = board_from_fen("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1");
+    searched = search_run(&stalemate, &limits, &info);
+    CCHESS_ASSERT(!searched);
+
+    /* Iterations are reported in order with legal principal variations */
+    TestSearchReport report;
+    memset(&report, 0, sizeof(TestSearchReport));
+    report.pv_is_legal = true;
+    report.board = board_init();
+
+    limits.callback = report_iteration;
+    limits.user_data = &report;
+
+    Board start = board_init();
+    searched = search_run(&start, &limits, &info);
+    CCHESS_ASSERT(searched);
+    CCHESS_ASSERT(report.num_calls == 5 && report.pv_is_legal && info.depth == 5);
+
+    printf("Depth %u: score %d, %llu nodes (%.1f%% in quiescence), %llu nps\n",
+           info.depth,
+           info.score,
+           (unsigned long long)info.nodes,
+           100.0 * (double)info.quiescence_nodes / (double)info.nodes,
+           (unsigned long long)info.nps);
+
+    /* Node limit */
+    search_limits_init(&limits);
+    limits.max_nodes = 20000;
+
+    searched = search_run(&start, &limits, &info);
+    CCHESS_ASSERT(searched);
+    CCHESS_ASSERT(info.nodes <= limits.max_nodes && info.pv_length > 0);
+
+    /* Time limit */
+    search_limits_init(&limits);
+    limits.max_time_ns = 50000000;
+
+    const uint64_t time_start = platform_get_time_ns();
+    searched = search_run(&start, &limits, &info);
+    const uint64_t elapsed_ns = platform_get_time_ns() - time_start;
+
+    CCHESS_ASSERT(searched && elapsed_ns < 1000000000ULL && info.depth > 0);
+
+    printf("Time limit 50 ms: stopped after %.1f ms at depth %u\n", (double)elapsed_ns / 1e6, info.depth);
+
+    /* Raised stop flag, a legal move is still returned */
+    volatile uint32_t stop = 1;
+
+    search_limits_init(&limits);
+    limits.stop = &stop;
+
+    searched = search_run(&start, &limits, &info);
+    CCHESS_ASSERT(searched);
+    CCHESS_ASSERT(info.pv_length == 1 && board_move_is_legal(&start, info.pv[0]));
+
+    /* Several threads sharing a table kept between searches */
+    TranspositionTable tt;
+    bool initialized = tt_init(&tt, 16);
+    CCHESS_ASSERT(initialized);
+
+    search_limits_init(&limits);
+    limits.max_depth = 5;
+    limits.num_threads = 4;
+    limits.tt = &tt;
+
+    tt_clear(&tt);
+    found = best_move_is(&mate_in_one, &limits, "a1a8", &score);
+    CCHESS_ASSERT(found);
+    CCHESS_ASSERT(score == SEARCH_SCORE_MATE - 1);
+
+    found = best_move_is(&hanging_queen, &limits, "d1d5", &score);
+    CCHESS_ASSERT(found);
+    CCHESS_ASSERT(score >= 800);
+
+    /* Time to depth and nodes per second by number of threads */
+    Board middlegame = board_from_fen("r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8");
+
+    const uint32_t max_threads = platform_get_num_cpus() * 2 < 64 ? platform_get_num_cpus() * 2 : 64;
+    uint64_t single_thread_ns = 0;
+
+    limits.max_depth = 9;
+
+    for(uint32_t num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+    {
+        limits.num_threads = num_threads;
+        tt_clear(&tt);
+
+        searched = search_run(&middlegame, &limits, &info);
+        CCHESS_ASSERT(searched);
+        CCHESS_ASSERT(info.depth == 9 && board_move_is_legal(&middlegame, info.pv[0]));
+
+        single_thread_ns = num_threads == 1 ? info.elapsed_ns : single_thread_ns;
+
+        printf("%u threads: depth %u in %.1f ms (speedup %.2f), %llu nodes (%.1f%% in quiescence), %llu nps, hashfull %u\n",
+               num_threads,
+               info.depth,
+               (double)info.elapsed_ns / 1e6,
+               (double)single_thread_ns / (double)info.elapsed_ns,
+               (unsigned long long)info.nodes,
+               100.0 * (double)info.quiescence_nodes / (double)info.nodes,
+               (unsigned long long)info.nps,
+               info.hashfull);
+    }
+
+    printf("Table of %zu bytes, huge pages: %s\n", tt.size, tt.huge_pages ? "yes" : "no");
+
+    tt_release(&tt);
+
+    return 0;
+}
@@ -0,0 +1,586 @@
+#include "cchess/syzygy.h"
+#include "cchess/egtb.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Writes small single value tables (every position of the table holds the
+    same value) and verifies the table registration, the lazy mapping from
+    several threads, the captures resolution and the DTZ one ply search.
+    No real tablebase is available to the tests, so a KRvK table is then
+    written in the compressed format (Huffman coded pairs, blocks and sparse
+    index) from the values of the endgame tables generator, and every KRvK
+    position is probed against them
+*/
+
+#define TEST_SYZYGY_NUM_PROBES 10000
+
+/* Three unique pieces: 10 * 63 * 62 placements minus the symmetric ones */
+#define TEST_KRVK_SIZE 31332
+
+#define TEST_KRVK_BLOCK_SIZE_LOG 6
+#define TEST_KRVK_BLOCK_SIZE (1U << TEST_KRVK_BLOCK_SIZE_LOG)
+#define TEST_KRVK_SPAN_LOG 8
+#define TEST_KRVK_SPAN (1U << TEST_KRVK_SPAN_LOG)
+#define TEST_KRVK_NUM_SYMS 7
+
+static bool write_file(const char* path, const uint8_t* data, const size_t size)
+{
+    FILE* file = fopen(path, "wb");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    const bool written = fwrite(data, 1, size, file) == size;
+    fclose(file);
+
+    return written;
+}
+
+/* KQvK, white to play wins and black to play loses */
+static const uint8_t kqvk_wdl[] = {
+    0x71, 0xE8, 0x23, 0x5D, /* magic */
+    0x01,                   /* split, the two sides to play are stored */
+    0x00,                   /* groups order */
+    0x55, 0x66, 0xEE,       /* white queen, white king, black king, for both sides to play */
+    0x00,                   /* alignment */
+    0x80, 0x04,             /* white to play, single value win */
+    0x80, 0x00,             /* black to play, single value loss */
+};
+
+/* KQvK distance to zeroing, white to play only, 5 moves */
+static const uint8_t kqvk_dtz[] = {
+    0xD7, 0x66, 0x0C, 0xA5,
+    0x01,
+    0x00,
+    0x05, 0x06, 0x0E,
+    0x00,
+    0x80, 0x05,
+};
+
+/* Corrupted magic */
+static const uint8_t krvk_wdl[] = {
+    0x00, 0x00, 0x00, 0x00, 0x01,
+};
+
+/*
+    Symbols of the compressed KRvK table, each one a run of a stored value
+    (0 loss, 2 draw, 4 win). The first three are values, the others pairs of
+    symbols, the last one a pair of pairs. Codes are canonical, the longest
+    ones being the lowest and given to the first symbols
+*/
+static const uint32_t krvk_sym_left[TEST_KRVK_NUM_SYMS] = { 0, 2, 4, 0, 1, 2, 5 };
+static const uint32_t krvk_sym_right[TEST_KRVK_NUM_SYMS] = { 0xFFF, 0xFFF, 0xFFF, 0, 1, 2, 5 };
+static const uint8_t krvk_sym_value[TEST_KRVK_NUM_SYMS] = { 0, 2, 4, 0, 2, 4, 4 };
+static const uint32_t krvk_sym_run[TEST_KRVK_NUM_SYMS] = { 1, 1, 1, 2, 2, 2, 4 };
+static const uint32_t krvk_sym_code[TEST_KRVK_NUM_SYMS] = { 0x0, 0x1, 0x1, 0x2, 0x3, 0x2, 0x3 };
+static const uint32_t krvk_sym_code_length[TEST_KRVK_NUM_SYMS] = { 4, 4, 3, 3, 3, 2, 2 };
+
+/* Lowest symbol of the code lengths 2, 3 and 4 */
+static const uint16_t krvk_lowest_sym[3] = { 5, 2, 0 };
+
+/*
+    Pieces in encoding order: white king, white rook and black king with
+    white to play, white rook, black king and white king with black to play.
+    Piece codes are piece + 1, plus 8 for black
+*/
+static const uint8_t krvk_pieces[2][3] = { { 6, 4, 14 }, { 4, 14, 6 } };
+
+typedef struct
+{
+    uint8_t* data;
+    size_t size;
+} TestBuffer;
+
+static void buffer_put(TestBuffer* buffer, const uint64_t value, const uint32_t num_bytes)
+{
+    for(uint32_t i = 0; i < num_bytes; i++)
+    {
+        buffer->data[buffer->size++] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static void buffer_align(TestBuffer* buffer, const size_t alignment)
+{
+    while(buffer->size % alignment)
+    {
+        buffer->data[buffer->size++] = 0;
+    }
+}
+
+/*
+    Squares of the pieces of every index of a table of three unique pieces,
+    by enumerating the placements in the order of the format: the first
+    piece below the a1-h8 diagonal in the a1-d1-d4 triangle, then on the
+    diagonal with the second one below it, then the first two on the
+    diagonal with the third one below it, then the three on the diagonal
+*/
+static void krvk_set_placements(uint8_t (*placements)[3])
+{
+    static const uint32_t triangle[6] = { 1, 2, 3, 10, 11, 19 };
+
+    uint32_t below[28];
+    uint32_t num_below = 0;
+
+    for(uint32_t square = 0; square < 64; square++)
+    {
+        if(square / 8 < square % 8)
+        {
+            below[num_below++] = square;
+        }
+    }
+
+    uint32_t idx = 0;
+
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        for(uint32_t s1 = 0; s1 < 64; s1++)
+        {
+            for(uint32_t s2 = 0; s2 < 64; s2++)
+            {
+                if(s1 != triangle[i] && s2 != triangle[i] && s2 != s1)
+                {
+                    placements[idx][0] = (uint8_t)triangle[i];
+                    placements[idx][1] = (uint8_t)s1;
+                    placements[idx++][2] = (uint8_t)s2;
+                }
+            }
+        }
+    }
+
+    for(uint32_t r0 = 0; r0 < 4; r0++)
+    {
+        for(uint32_t i = 0; i < 28; i++)
+        {
+            for(uint32_t s2 = 0; s2 < 64; s2++)
+            {
+                if(s2 != r0 * 9 && s2 != below[i])
+                {
+                    placements[idx][0] = (uint8_t)(r0 * 9);
+                    placements[idx][1] = (uint8_t)below[i];
+                    placements[idx++][2] = (uint8_t)s2;
+                }
+            }
+        }
+    }
+
+    for(uint32_t r0 = 0; r0 < 4; r0++)
+    {
+        for(uint32_t r1 = 0; r1 < 8; r1++)
+        {
+            for(uint32_t i = 0; i < 28 && r1 != r0; i++)
+            {
+                placements[idx][0] = (uint8_t)(r0 * 9);
+                placements[idx][1] = (uint8_t)(r1 * 9);
+                placements[idx++][2] = (uint8_t)below[i];
+            }
+        }
+    }
+
+    for(uint32_t r0 = 0; r0 < 4; r0++)
+    {
+        for(uint32_t r1 = 0; r1 < 8; r1++)
+        {
+            for(uint32_t r2 = 0; r2 < 8; r2++)
+            {
+                if(r1 != r0 && r2 != r0 && r2 != r1)
+                {
+                    placements[idx][0] = (uint8_t)(r0 * 9);
+                    placements[idx][1] = (uint8_t)(r1 * 9);
+                    placements[idx++][2] = (uint8_t)(r2 * 9);
+                }
+            }
+        }
+    }
+
+    CCHESS_ASSERT(idx == TEST_KRVK_SIZE);
+}
+
+/* King, rook and king, the rook side being white or black */
+static void set_krvk_board(Board* board, const uint32_t rook_king, const uint32_t rook, const uint32_t other_king, const uint32_t rook_side, const uint32_t side)
+{
+    memset(board, 0, sizeof(Board));
+
+    board_put_piece(board, Piece_King, rook_side, rook_king);
+    board_put_piece(board, Piece_Rook, rook_side, rook);
+    board_put_piece(board, Piece_King, !rook_side, other_king);
+    board->state = side == PIECE_WHITE ? BoardState_WhiteToPlay : 0;
+    board->fullmove_number = 1;
+
+    board_init_derived(board);
+}
+
+/* Stored value of the position, 0 loss, 2 draw, 4 win. Returns false if it is not legal */
+static bool krvk_reference_value(const Egtb* egtb, Board* board, uint8_t* value)
+{
+    EgtbWdl wdl;
+
+    if(!egtb_probe_wdl(egtb, board, &wdl))
+    {
+        return false;
+    }
+
+    *value = (uint8_t)(2 + 2 * (int32_t)wdl);
+
+    return true;
+}
+
+/*
+    Compresses the values of one side to play in blocks of whole symbols,
+    leaving the last 8 bytes of every block unused as the decoder reads
+    ahead. Returns the number of blocks
+*/
+static uint32_t krvk_compress(const uint8_t* values, uint8_t* blocks, uint16_t* block_lengths, uint32_t* block_starts)
+{
+    const uint32_t max_bits = TEST_KRVK_BLOCK_SIZE * 8 - 64;
+
+    uint32_t num_blocks = 0;
+    uint32_t num_bits = max_bits;
+
+    for(uint32_t i = 0; i < TEST_KRVK_SIZE;)
+    {
+        uint32_t sym = 0;
+
+        for(uint32_t s = 0; s < TEST_KRVK_NUM_SYMS; s++)
+        {
+            bool matches = krvk_sym_value[s] == values[i] && i + krvk_sym_run[s] <= TEST_KRVK_SIZE;
+
+            for(uint32_t j = 1; matches && j < krvk_sym_run[s]; j++)
+            {
+                matches = values[i + j] == values[i];
+            }
+
+            sym = matches && krvk_sym_run[s] >= krvk_sym_run[sym] ? s : sym;
+        }
+
+        if(num_bits + krvk_sym_code_length[sym] > max_bits)
+        {
+            block_starts[num_blocks] = i;
+            block_lengths[num_blocks] = 0xFFFF;
+            num_blocks++;
+            num_bits = 0;
+        }
+
+        uint8_t* block = blocks + (num_blocks - 1) * TEST_KRVK_BLOCK_SIZE;
+
+        for(uint32_t b = 0; b < krvk_sym_code_length[sym]; b++, num_bits++)
+        {
+            const uint32_t bit = (krvk_sym_code[sym] >> (krvk_sym_code_length[sym] - 1 - b)) & 1;
+            block[num_bits / 8] |= (uint8_t)(bit << (7 - num_bits % 8));
+        }
+
+        block_lengths[num_blocks - 1] = (uint16_t)(block_lengths[num_blocks - 1] + krvk_sym_run[sym]);
+        i += krvk_sym_run[sym];
+    }
+
+    return num_blocks;
+}
+
+/* Writes the KRvK WDL table, the values being indexed by side to play and index */
+static bool write_krvk_table(const char* path, uint8_t (*values)[TEST_KRVK_SIZE])
+{
+    const uint32_t max_blocks = TEST_KRVK_SIZE;
+    const uint32_t num_sparse = (TEST_KRVK_SIZE + TEST_KRVK_SPAN - 1) / TEST_KRVK_SPAN;
+
+    uint8_t* blocks[2];
+    uint16_t* block_lengths[2];
+    uint32_t* block_starts[2];
+    uint32_t num_blocks[2];
+
+    TestBuffer file;
+    file.data = (uint8_t*)calloc(2 * (size_t)max_blocks * TEST_KRVK_BLOCK_SIZE, 1);
+    file.size = 0;
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        blocks[side] = (uint8_t*)calloc((size_t)max_blocks * TEST_KRVK_BLOCK_SIZE, 1);
+        block_lengths[side] = (uint16_t*)calloc(max_blocks, sizeof(uint16_t));
+        block_starts[side] = (uint32_t*)calloc(max_blocks, sizeof(uint32_t));
+        num_blocks[side] = krvk_compress(values[side], blocks[side], block_lengths[side], block_starts[side]);
+    }
+
+    /* Magic, both sides to play stored, groups order and pieces */
+    buffer_put(&file, 0x5D23E871, 4);
+    buffer_put(&file, 0x01, 1);
+    buffer_put(&file, 0x00, 1);
+
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        buffer_put(&file, krvk_pieces[0][i] | (krvk_pieces[1][i] << 4), 1);
+    }
+
+    buffer_align(&file, 2);
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        buffer_put(&file, 0x00, 1);
+        buffer_put(&file, TEST_KRVK_BLOCK_SIZE_LOG, 1);
+        buffer_put(&file, TEST_KRVK_SPAN_LOG, 1);
+        buffer_put(&file, 0, 1);
+        buffer_put(&file, num_blocks[side], 4);
+        /* Longest and shortest codes */
+        buffer_put(&file, 4, 1);
+        buffer_put(&file, 2, 1);
+
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            buffer_put(&file, krvk_lowest_sym[i], 2);
+        }
+
+        buffer_put(&file, TEST_KRVK_NUM_SYMS, 2);
+
+        for(uint32_t sym = 0; sym < TEST_KRVK_NUM_SYMS; sym++)
+        {
+            buffer_put(&file, krvk_sym_left[sym] | (krvk_sym_right[sym] << 12), 3);
+        }
+
+        buffer_align(&file, 2);
+    }
+
+    /* Block and offset in the block of the value in the middle of every span */
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        uint32_t block = 0;
+
+        for(uint32_t k = 0; k < num_sparse; k++)
+        {
+            const uint32_t idx = k * TEST_KRVK_SPAN + TEST_KRVK_SPAN / 2;
+
+            while(block + 1 < num_blocks[side] && block_starts[side][block + 1] <= idx)
+            {
+                block++;
+            }
+
+            buffer_put(&file, block, 4);
+            buffer_put(&file, idx - block_starts[side][block], 2);
+        }
+    }
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        for(uint32_t i = 0; i < num_blocks[side]; i++)
+        {
+            buffer_put(&file, block_lengths[side][i], 2);
+        }
+    }
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        buffer_align(&file, 64);
+
+        memcpy(file.data + file.size, blocks[side], (size_t)num_blocks[side] * TEST_KRVK_BLOCK_SIZE);
+        file.size += (size_t)num_blocks[side] * TEST_KRVK_BLOCK_SIZE;
+    }
+
+    const bool written = write_file(path, file.data, file.size);
+
+    printf("Syzygy KRvK: %u + %u blocks, %zu bytes\n", num_blocks[0], num_blocks[1], file.size);
+
+    free(file.data);
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        free(blocks[side]);
+        free(block_lengths[side]);
+        free(block_starts[side]);
+    }
+
+    return written;
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    bool written = write_file("KQvK.rtbw", kqvk_wdl, sizeof(kqvk_wdl)) &&
+                   write_file("KQvK.rtbz", kqvk_dtz, sizeof(kqvk_dtz)) &&
+                   write_file("KRvK.rtbw", krvk_wdl, sizeof(krvk_wdl));
+
+    CCHESS_ASSERT(written);
+
+    /* Material signatures, kings excluded */
+    Board b = board_from_fen("8/8/8/3k4/8/8/2Q5/3K4 w - - 0 1");
+    Board flipped = board_from_fen("3k4/2q5/8/8/3K4/8/8/8 b - - 0 1");
+
+    CCHESS_ASSERT(syzygy_material_key(&b) == (1ULL << (Piece_Queen * 4)));
+    CCHESS_ASSERT(syzygy_material_key(&flipped) == (1ULL << (20 + Piece_Queen * 4)));
+
+    size_t num_tables = syzygy_init("does_not_exist");
+    CCHESS_ASSERT(num_tables == 0 && syzygy_get_max_pieces() == 0);
+
+    num_tables = syzygy_init(".");
+    CCHESS_ASSERT(num_tables == 2 && syzygy_get_max_pieces() == 3);
+
+    /* The first probes map the table concurrently */
+    size_t num_wins = 0;
+
+#pragma omp parallel for reduction(+:num_wins)
+    for(int64_t i = 0; i < TEST_SYZYGY_NUM_PROBES; i++)
+    {
+        Board board = board_from_fen("8/8/8/3k4/8/8/2Q5/3K4 w - - 0 1");
+        SyzygyWdl wdl;
+
+        if(syzygy_probe_wdl(&board, &wdl) && wdl == SyzygyWdl_Win)
+        {
+            num_wins++;
+        }
+    }
+
+    CCHESS_ASSERT(num_wins == TEST_SYZYGY_NUM_PROBES);
+
+    SyzygyWdl wdl = SyzygyWdl_Draw;
+    bool probed = syzygy_probe_wdl(&flipped, &wdl);
+    CCHESS_ASSERT(probed && wdl == SyzygyWdl_Win);
+
+    Board black_to_play = board_from_fen("8/8/8/3k4/8/8/2Q5/3K4 b - - 0 1");
+    probed = syzygy_probe_wdl(&black_to_play, &wdl);
+    CCHESS_ASSERT(probed && wdl == SyzygyWdl_Loss);
+
+    /* The queen can be captured, the table value is overridden by the capture */
+    Board hanging_queen = board_from_fen("8/8/8/3k4/3Q4/8/8/3K4 b - - 0 1");
+    probed = syzygy_probe_wdl(&hanging_queen, &wdl);
+    CCHESS_ASSERT(probed && wdl == SyzygyWdl_Draw);
+
+    Board kings_only = board_from_fen("8/8/8/3k4/8/8/8/3K4 w - - 0 1");
+    probed = syzygy_probe_wdl(&kings_only, &wdl);
+    CCHESS_ASSERT(probed && wdl == SyzygyWdl_Draw);
+
+    /* Missing, corrupted and too large materials, castling rights */
+    Board kbvk = board_from_fen("8/8/8/3k4/8/8/2B5/3K4 w - - 0 1");
+    Board krvk = board_from_fen("8/8/8/3k4/8/8/2R5/3K4 w - - 0 1");
+    Board krrvk = board_from_fen("8/8/8/3k4/8/8/2RR4/3K4 w - - 0 1");
+    Board castling = board_from_fen("8/8/8/3k4/8/8/8/R3K3 w Q - 0 1");
+
+    probed = syzygy_probe_wdl(&kbvk, &wdl);
+    CCHESS_ASSERT(!probed);
+    probed = syzygy_probe_wdl(&krvk, &wdl);
+    CCHESS_ASSERT(!probed);
+    probed = syzygy_probe_wdl(&krvk, &wdl);
+    CCHESS_ASSERT(!probed);
+    probed = syzygy_probe_wdl(&krrvk, &wdl);
+    CCHESS_ASSERT(!probed);
+    probed = syzygy_probe_wdl(&castling, &wdl);
+    CCHESS_ASSERT(!probed);
+
+    /* Distance to zeroing: stored for white to play, searched one ply deeper for black */
+    int32_t dtz = 0;
+    probed = syzygy_probe_dtz(&b, &dtz);
+    CCHESS_ASSERT(probed && dtz == 11);
+
+    probed = syzygy_probe_dtz(&black_to_play, &dtz);
+    CCHESS_ASSERT(probed && dtz == -12);
+
+    probed = syzygy_probe_dtz(&hanging_queen, &dtz);
+    CCHESS_ASSERT(probed && dtz == 0);
+
+    /* Probes cost once the table is mapped */
+    uint64_t start = platform_get_time_ns();
+    size_t total = 0;
+
+    for(size_t i = 0; i < TEST_SYZYGY_NUM_PROBES; i++)
+    {
+        total += syzygy_probe_wdl(&b, &wdl) && wdl == SyzygyWdl_Win;
+    }
+
+    printf("Syzygy WDL probe: %.1f ns/probe (%zu)\n",
+           (double)(platform_get_time_ns() - start) / TEST_SYZYGY_NUM_PROBES,
+           total);
+
+    /* Compressed KRvK table, replacing the corrupted one, from the generated endgame table */
+    EgtbGenStats stats;
+    const bool generated = egtb_generate("KRvK", "KRvK.egtb", &stats);
+    CCHESS_ASSERT(generated);
+
+    Egtb egtb;
+    const bool opened = egtb_open(&egtb, "KRvK.egtb");
+    CCHESS_ASSERT(opened);
+
+    uint8_t (*placements)[3] = (uint8_t (*)[3])malloc(TEST_KRVK_SIZE * sizeof(placements[0]));
+    uint8_t (*values)[TEST_KRVK_SIZE] = (uint8_t (*)[TEST_KRVK_SIZE])malloc(2 * sizeof(values[0]));
+    CCHESS_ASSERT(placements != NULL && values != NULL);
+
+    krvk_set_placements(placements);
+
+    size_t num_legal = 0;
+
+    for(uint32_t side = 0; side < 2; side++)
+    {
+        /* Illegal positions are not probed, they continue the run before them */
+        uint8_t value = 2;
+
+        for(uint32_t idx = 0; idx < TEST_KRVK_SIZE; idx++)
+        {
+            uint32_t squares[15];
+
+            for(uint32_t i = 0; i < 3; i++)
+            {
+                squares[krvk_pieces[side][i]] = placements[idx][i];
+            }
+
+            Board board;
+            set_krvk_board(&board, squares[6], squares[4], squares[14], PIECE_WHITE, side);
+
+            num_legal += krvk_reference_value(&egtb, &board, &value);
+            values[side][idx] = value;
+        }
+    }
+
+    CCHESS_ASSERT(num_legal > 0);
+
+    written = write_krvk_table("KRvK.rtbw", values);
+    CCHESS_ASSERT(written);
+
+    num_tables = syzygy_init(".");
+    CCHESS_ASSERT(num_tables == 2);
+
+    /* Every position, with the rook on either side and either side to play */
+    size_t num_checked = 0;
+
+    for(uint32_t j = 0; j < 64 * 64 * 64 * 4; j++)
+    {
+        const uint32_t rook_king = j % 64;
+        const uint32_t rook = (j / 64) % 64;
+        const uint32_t other_king = (j / 4096) % 64;
+
+        if(rook_king == rook || rook_king == other_king || rook == other_king)
+        {
+            continue;
+        }
+
+        Board board;
+        set_krvk_board(&board, rook_king, rook, other_king, (j >> 18) & 1, j >> 19);
+
+        uint8_t value;
+
+        if(!krvk_reference_value(&egtb, &board, &value))
+        {
+            continue;
+        }
+
+        probed = syzygy_probe_wdl(&board, &wdl);
+        CCHESS_ASSERT(probed && (int32_t)wdl == (int32_t)value - 2);
+        num_checked++;
+    }
+
+    CCHESS_ASSERT(num_checked > 0);
+
+    free(placements);
+    free(values);
+
+    egtb_close(&egtb);
+
+    syzygy_release();
+
+    remove("KQvK.rtbw");
+    remove("KQvK.rtbz");
+    remove("KRvK.rtbw");
+    remove("KRvK.egtb");
+
+    return 0;
+}
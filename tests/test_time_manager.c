@@ -0,0 +1,250 @@
+#include "cchess/time_manager.h"
+#include "cchess/search.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Checks the limits computed from clocks, the scaling of the target by the
+    stability of the best move and by score drops, the percentiles of the
+    overshoot statistics, then measures the overshoots of timed searches
+*/
+
+#define MS_TO_NS 1000000ULL
+
+#define TEST_TIME_MANAGER_NUM_SEARCHES 20
+
+/* Very loose, for loaded machines and sanitized builds */
+#define TEST_TIME_MANAGER_MAX_OVERSHOOT_NS (100 * MS_TO_NS)
+
+static const char* const fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+#define NUM_FENS (sizeof(fens) / sizeof(fens[0]))
+
+static void check_limits(void)
+{
+    TimeManager manager;
+    TimeControl control;
+
+    /* Fixed time, minus the overhead */
+    memset(&control, 0, sizeof(TimeControl));
+    control.move_time_ns = 1000 * MS_TO_NS;
+    CCHESS_ASSERT(time_control_is_set(&control));
+
+    time_manager_init(&manager, &control);
+    CCHESS_ASSERT(manager.optimum_ns == 1000 * MS_TO_NS - TIME_MANAGER_DEFAULT_OVERHEAD_NS);
+    CCHESS_ASSERT(manager.maximum_ns == manager.optimum_ns);
+
+    /* Sudden death */
+    memset(&control, 0, sizeof(TimeControl));
+    control.time_ns = 60000 * MS_TO_NS;
+    control.overhead_ns = 10 * MS_TO_NS;
+
+    time_manager_init(&manager, &control);
+    CCHESS_ASSERT(manager.optimum_ns == (60000 - 10) * MS_TO_NS / TIME_MANAGER_DEFAULT_MOVES_TO_GO);
+    CCHESS_ASSERT(manager.maximum_ns > manager.optimum_ns && manager.maximum_ns < control.time_ns / 2);
+
+    /* The increment is mostly spent */
+    const uint64_t optimum_ns = manager.optimum_ns;
+    control.increment_ns = 1000 * MS_TO_NS;
+
+    time_manager_init(&manager, &control);
+    CCHESS_ASSERT(manager.optimum_ns == optimum_ns + 750 * MS_TO_NS);
+
+    /* The last move before the control can use all the time */
+    control.increment_ns = 0;
+    control.moves_to_go = 1;
+
+    time_manager_init(&manager, &control);
+    CCHESS_ASSERT(manager.maximum_ns == control.time_ns - control.overhead_ns);
+
+    /* The limits never exceed the clock, even almost empty */
+    for(uint64_t time_ms = 1; time_ms < 1000000; time_ms = time_ms * 3 + 1)
+    {
+        for(uint32_t moves_to_go = 0; moves_to_go < 60; moves_to_go += 7)
+        {
+            memset(&control, 0, sizeof(TimeControl));
+            control.time_ns = time_ms * MS_TO_NS;
+            control.increment_ns = time_ms * MS_TO_NS / 10;
+            control.moves_to_go = moves_to_go;
+
+            time_manager_init(&manager, &control);
+
+            CCHESS_ASSERT(manager.optimum_ns > 0);
+            CCHESS_ASSERT(manager.optimum_ns <= manager.maximum_ns && manager.maximum_ns < control.time_ns);
+        }
+    }
+}
+
+static void check_scaling(void)
+{
+    TimeManager manager;
+    TimeControl control;
+
+    memset(&control, 0, sizeof(TimeControl));
+    control.time_ns = 30000 * MS_TO_NS;
+
+    const Move move = move_from_u16(0x1234);
+    const Move other_move = move_from_u16(0x4321);
+
+    /* A stable best move shrinks the target */
+    time_manager_init(&manager, &control);
+
+    for(uint32_t depth = 1; depth <= 10; depth++)
+    {
+        const bool stop = time_manager_iteration_done(&manager, depth, move, 20, 0);
+        CCHESS_ASSERT(!stop);
+    }
+
+    CCHESS_ASSERT(manager.target_ns < manager.optimum_ns);
+
+    /* A new one extends it */
+    time_manager_iteration_done(&manager, 11, other_move, 20, 0);
+    CCHESS_ASSERT(manager.target_ns > manager.optimum_ns);
+
+    const uint64_t changed_target_ns = manager.target_ns;
+
+    /* A dropping score too, even with the same best move */
+    time_manager_init(&manager, &control);
+
+    for(uint32_t depth = 1; depth <= 10; depth++)
+    {
+        time_manager_iteration_done(&manager, depth, move, 20, 0);
+    }
+
+    time_manager_iteration_done(&manager, 11, move, -40, 0);
+    CCHESS_ASSERT(manager.target_ns > manager.optimum_ns && manager.target_ns > changed_target_ns);
+    CCHESS_ASSERT(manager.target_ns <= manager.maximum_ns);
+
+    /* No iteration is started once most of the target is used */
+    const uint64_t target_ns = manager.target_ns;
+
+    const bool early_stop = time_manager_iteration_done(&manager, 12, move, -40, target_ns / 4);
+    const bool late_stop = time_manager_iteration_done(&manager, 13, move, -40, target_ns);
+    CCHESS_ASSERT(!early_stop && late_stop);
+}
+
+static void check_stats(void)
+{
+    TimeStats* stats = (TimeStats*)malloc(sizeof(TimeStats));
+    time_stats_reset(stats);
+
+    CCHESS_ASSERT(time_stats_percentile(stats, 99.0) == 0);
+
+    /* Overshoots from -99 to 0 */
+    for(uint64_t i = 0; i < 100; i++)
+    {
+        time_stats_add(stats, 1000 + i, 1099);
+    }
+
+    CCHESS_ASSERT(time_stats_percentile(stats, 50.0) == -50);
+    CCHESS_ASSERT(time_stats_percentile(stats, 99.0) == -1);
+    CCHESS_ASSERT(time_stats_percentile(stats, 100.0) == 0);
+    CCHESS_ASSERT(time_stats_percentile(stats, 0.0) == -99);
+    CCHESS_ASSERT(stats->num_overshoots == 0 && stats->max_overshoot_ns == 0);
+
+    time_stats_add(stats, 1500, 1000);
+    CCHESS_ASSERT(stats->num_overshoots == 1 && stats->max_overshoot_ns == 500);
+    CCHESS_ASSERT(time_stats_percentile(stats, 100.0) == 500);
+
+    /* Only the last samples are kept */
+    for(uint32_t i = 0; i < TIME_STATS_MAX_SAMPLES; i++)
+    {
+        time_stats_add(stats, 10, 20);
+    }
+
+    CCHESS_ASSERT(stats->num_samples == TIME_STATS_MAX_SAMPLES && stats->num_searches == 101 + TIME_STATS_MAX_SAMPLES);
+    CCHESS_ASSERT(time_stats_percentile(stats, 100.0) == -10 && stats->max_overshoot_ns == 500);
+
+    free(stats);
+}
+
+/* Searches under a fixed time and under a clock, recording the overshoots of their limits */
+static void check_searches(void)
+{
+    TimeStats* stats = (TimeStats*)malloc(sizeof(TimeStats));
+    time_stats_reset(stats);
+
+    TranspositionTable tt;
+    bool initialized = tt_init(&tt, 16);
+    CCHESS_ASSERT(initialized);
+
+    uint64_t clock_elapsed_ns = 0;
+    uint64_t clock_maximum_ns = 0;
+
+    for(uint32_t i = 0; i < TEST_TIME_MANAGER_NUM_SEARCHES; i++)
+    {
+        Board board = board_from_fen(fens[i % NUM_FENS]);
+
+        SearchLimits limits;
+        search_limits_init(&limits);
+        limits.tt = &tt;
+        limits.time_control.overhead_ns = 1;
+
+        const bool fixed_time = i % 2 == 0;
+
+        if(fixed_time)
+        {
+            limits.time_control.move_time_ns = 20 * MS_TO_NS;
+        }
+        else
+        {
+            limits.time_control.time_ns = 1000 * MS_TO_NS;
+            limits.time_control.increment_ns = 10 * MS_TO_NS;
+        }
+
+        tt_clear(&tt);
+
+        SearchInfo info;
+        const bool searched = search_run(&board, &limits, &info);
+        CCHESS_ASSERT(searched && info.depth > 0);
+        CCHESS_ASSERT(info.time_limit_ns > 0);
+
+        time_stats_add(stats, info.elapsed_ns, info.time_limit_ns);
+
+        if(!fixed_time)
+        {
+            clock_elapsed_ns += info.elapsed_ns;
+            clock_maximum_ns += info.time_limit_ns;
+        }
+    }
+
+    tt_release(&tt);
+
+    printf("%llu searches, %llu over their limit, overshoot p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+           (unsigned long long)stats->num_searches,
+           (unsigned long long)stats->num_overshoots,
+           (double)time_stats_percentile(stats, 50.0) / 1e6,
+           (double)time_stats_percentile(stats, 99.0) / 1e6,
+           (double)stats->max_overshoot_ns / 1e6);
+
+    printf("Under a clock: %.1f ms used on average, for a maximum of %.1f ms\n",
+           (double)clock_elapsed_ns / 1e6 / (TEST_TIME_MANAGER_NUM_SEARCHES / 2),
+           (double)clock_maximum_ns / 1e6 / (TEST_TIME_MANAGER_NUM_SEARCHES / 2));
+
+    CCHESS_ASSERT(stats->max_overshoot_ns < (int64_t)TEST_TIME_MANAGER_MAX_OVERSHOOT_NS);
+
+    /* The soft limit stops most searches well before the hard one */
+    CCHESS_ASSERT(clock_elapsed_ns < clock_maximum_ns);
+
+    free(stats);
+}
+
+int main(int argc, char** argv)
+{
+    CCHESS_ATEXIT_REGISTER(move_gen_destroy, true);
+    move_gen_init();
+
+    check_limits();
+    check_scaling();
+    check_stats();
+    check_searches();
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "cchess/tt.h"
+#include "cchess/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Stores and probes entries, checks the replacement in full buckets, and
+    hammers a small table from several threads, every entry read having to
+    match the data written for its key
+*/
+
+#define TEST_TT_NUM_WRITES 1000000
+#define TEST_TT_NUM_KEYS 100000
+
+/* The data written for a key, to detect torn entries */
+static int16_t key_score(const uint64_t key)
+{
+    return (int16_t)((key >> 17) & 0x3FFF) - 0x2000;
+}
+
+static uint64_t next_key(uint64_t* state)
+{
+    /* splitmix64 */
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int main(int argc, char** argv)
+{
+    TranspositionTable tt;
+
+    bool initialized = tt_init(&tt, 1);
+    CCHESS_ASSERT(initialized);
+    CCHESS_ASSERT(tt.num_buckets == 1024 * 1024 / sizeof(TTBucket));
+
+    printf("Table of %zu bytes, huge pages: %s\n", tt.size, tt.huge_pages ? "yes" : "no");
+
+    tt_clear(&tt);
+    tt_new_search(&tt);
+
+    TTEntry entry;
+
+    /* Store and probe */
+    const uint64_t key = 0x0123456789ABCDEFULL;
+    const Move move = move_from_u16(0x1234);
+
+    bool hit = tt_probe(&tt, key, &entry);
+    CCHESS_ASSERT(!hit);
+
+    tt_store(&tt, key, move, -31990, 125, 12, TTBound_Lower);
+
+    hit = tt_probe(&tt, key, &entry);
+    CCHESS_ASSERT(hit);
+    CCHESS_ASSERT(move_equal(entry.move, move) && entry.score == -31990 && entry.eval == 125);
+    CCHESS_ASSERT(entry.depth == 12 && entry.bound == TTBound_Lower);
+
+    /* Same bucket, other key */
+    hit = tt_probe(&tt, key ^ (tt.num_buckets << 4), &entry);
+    CCHESS_ASSERT(!hit);
+
+    /* Overwriting without a move keeps the previous one */
+    tt_store(&tt, key, move_from_u16(EMPTY_MOVE), 40, 125, 3, TTBound_Upper);
+
+    hit = tt_probe(&tt, key, &entry);
+    CCHESS_ASSERT(hit);
+    CCHESS_ASSERT(move_equal(entry.move, move) && entry.score == 40 && entry.depth == 3 && entry.bound == TTBound_Upper);
+
+    /* A torn entry no longer verifies */
+    TTBucket* bucket = tt_get_bucket(&tt, key);
+    const uint64_t data = bucket->slots[0].data;
+    bucket->slots[0].data = data ^ (1ULL << 20);
+
+    hit = tt_probe(&tt, key, &entry);
+    CCHESS_ASSERT(!hit);
+
+    bucket->slots[0].data = data;
+
+    /* Full bucket: the shallowest entry is replaced */
+    tt_clear(&tt);
+    tt_new_search(&tt);
+
+    for(uint64_t i = 0; i < TT_ENTRIES_PER_BUCKET; i++)
+    {
+        tt_store(&tt, 7 + (i + 1) * tt.num_buckets, move, 0, 0, 10 + (uint32_t)i, TTBound_Exact);
+    }
+
+    tt_store(&tt, 7, move, 0, 0, 20, TTBound_Exact);
+
+    hit = tt_probe(&tt, 7 + tt.num_buckets, &entry);
+    CCHESS_ASSERT(!hit);
+    hit = tt_probe(&tt, 7, &entry);
+    CCHESS_ASSERT(hit && entry.depth == 20);
+
+    /* Entries of past searches are replaced first, even if deeper */
+    tt_new_search(&tt);
+    tt_new_search(&tt);
+
+    tt_store(&tt, 7 + 8 * tt.num_buckets, move, 0, 0, 1, TTBound_Exact);
+    tt_store(&tt, 7 + 9 * tt.num_buckets, move, 0, 0, 1, TTBound_Exact);
+
+    hit = tt_probe(&tt, 7 + 9 * tt.num_buckets, &entry);
+    CCHESS_ASSERT(hit);
+    hit = tt_probe(&tt, 7 + 8 * tt.num_buckets, &entry);
+    CCHESS_ASSERT(hit);
+
+    uint32_t num_old = 0;
+
+    for(uint64_t i = 0; i < TT_ENTRIES_PER_BUCKET; i++)
+    {
+        num_old += tt_probe(&tt, 7 + (i + 1) * tt.num_buckets, &entry);
+    }
+
+    num_old += tt_probe(&tt, 7, &entry);
+    CCHESS_ASSERT(num_old == 2);
+
+    CCHESS_ASSERT(tt_hashfull(&tt) <= 1);
+
+    /* Concurrent writers and readers on a small table */
+    tt_clear(&tt);
+    tt_new_search(&tt);
+
+    const int64_t num_threads = (int64_t)platform_get_num_cpus() * 2;
+    uint64_t num_hits = 0;
+    uint64_t num_corrupted = 0;
+
+    const uint64_t time_start = platform_get_time_ns();
+
+#pragma omp parallel for num_threads(num_threads) reduction(+ : num_hits, num_corrupted)
+    for(int64_t t = 0; t < num_threads; t++)
+    {
+        uint64_t state = (uint64_t)t;
+
+        for(uint32_t i = 0; i < TEST_TT_NUM_WRITES / (uint32_t)num_threads; i++)
+        {
+            /* Threads draw from the same keys, so they write the same entries */
+            uint64_t key_index = next_key(&state) % TEST_TT_NUM_KEYS;
+            const uint64_t k = next_key(&key_index);
+            const int16_t score = key_score(k);
+
+            TTEntry probed;
+
+            if(tt_probe(&tt, k, &probed))
+            {
+                num_hits++;
+                num_corrupted += probed.score != score || probed.eval != -score || probed.depth != (k & 0x3F);
+            }
+
+            tt_store(&tt, k, move_from_u16((uint16_t)k), score, -score, (uint32_t)(k & 0x3F), TTBound_Exact);
+        }
+    }
+
+    const uint64_t elapsed_ns = platform_get_time_ns() - time_start;
+
+    printf("%lld threads: %llu hits, %llu corrupted, %.1f ns per probe and store, hashfull %u\n",
+           (long long)num_threads,
+           (unsigned long long)num_hits,
+           (unsigned long long)num_corrupted,
+           (double)elapsed_ns / (double)TEST_TT_NUM_WRITES,
+           tt_hashfull(&tt));
+
+    CCHESS_ASSERT(num_corrupted == 0);
+    CCHESS_ASSERT(tt_hashfull(&tt) > 0);
+
+    tt_release(&tt);
+
+    return 0;
+}